@@ -21,9 +21,10 @@ use File::Basename;
 
 my $file = dirname($0)."/../src/schema.tmpl";	# name the file
 
-my ($state, %output, $eol, $fk_bol, $fk_eol, $ltab, $pkey, $table_name);
-my ($szcol1, $szcol2, $szcol3, $szcol4, $sequences, $sql_suffix);
+my ($state, %output, $eol, $fk_bol, $fk_eol, $ltab, $pkey, $table_name, $table_key);
+my ($szcol1, $szcol2, $szcol3, $szcol4, $sequences, $triggers, $sql_suffix);
 my ($fkeys, $fkeys_prefix, $fkeys_suffix, $uniq);
+my (@changelog_fields, $changelog_nodata);
 
 my %c = (
 	"type"		=>	"code",
@@ -171,7 +172,7 @@ sub newstate
 
 	if ($state eq "field")
 	{
-		if ($output{"type"} eq "sql" && ($new eq "index" || $new eq "table" || $new eq "row"))
+		if ($output{"type"} eq "sql" && ($new eq "index" || $new eq "table" || $new eq "row" || $new eq "changelog"))
 		{
 			print "${pkey}${eol}\n)$output{'table_options'};${eol}\n";
 		}
@@ -205,6 +206,9 @@ sub process_table
 	newstate("table");
 
 	($table_name, $pkey, $flags) = split(/\|/, $line, 3);
+	$table_key = $pkey;
+	@changelog_fields = ();
+	$changelog_nodata = 0;
 
 	if ($output{"type"} eq "code")
 	{
@@ -265,6 +269,16 @@ sub process_field
 	($name, $type, $default, $null, $flags, $relN, $fk_table, $fk_field, $fk_flags) = split(/\|/, $line, 9);
 	my ($type_short, $length) = split(/\(/, $type, 2);
 
+	# runtime fields (ZBX_NODATA) must not be tracked by configuration changelog
+	if ($flags =~ /ZBX_NODATA/)
+	{
+		$changelog_nodata = 1;
+	}
+	elsif ($name ne $table_key)
+	{
+		push(@changelog_fields, $name);
+	}
+
 	if ($output{"type"} eq "code")
 	{
 		$type = $output{$type_short};
@@ -295,8 +309,6 @@ sub process_field
 
 		for ($flags)
 		{
-			# do not output ZBX_NODATA, remove it
-			s/ZBX_NODATA//;
 			s/,+$//;
 			s/^,+//;
 			s/,+/ \| /g;
@@ -394,7 +406,7 @@ sub process_field
 				$sequences = "${sequences}BEFORE INSERT ON ${table_name}${eol}\n";
 				$sequences = "${sequences}FOR EACH ROW${eol}\n";
 				$sequences = "${sequences}BEGIN${eol}\n";
-				$sequences = "${sequences}SELECT ${table_name}_seq.nextval INTO :new.id FROM dual;${eol}\n";
+				$sequences = "${sequences}SELECT ${table_name}_seq.nextval INTO :new.${name} FROM dual;${eol}\n";
 				$sequences = "${sequences}END;${eol}\n/${eol}\n";
 			}
 		}
@@ -594,6 +606,87 @@ sub process_row
 	print "INSERT INTO $table_name VALUES $values;${eol}\n";
 }
 
+sub process_changelog
+{
+	my $line = $_[0];
+
+	newstate("changelog");
+
+	if ($output{"type"} eq "code")
+	{
+		return;
+	}
+
+	my ($object) = split(/\|/, $line, 2);
+	my %operations = ("insert" => 1, "update" => 2, "delete" => 3);
+
+	foreach my $operation ("insert", "update", "delete")
+	{
+		my $row = ($operation eq "delete" ? "old" : "new");
+		my $values = "${object},${row}.${table_key},$operations{$operation}";
+		my $trigger = "${table_name}_${operation}";
+		my $event = "\U${operation}\E";
+		my $condition = "";
+
+		# tables with runtime fields record only updates of configuration fields
+		if ($operation eq "update" && $changelog_nodata)
+		{
+			$event = "UPDATE OF ".join(",", @changelog_fields);
+			$condition = join(" AND ", map { "old.$_<=>new.$_" } @changelog_fields);
+		}
+
+		if ($output{"database"} eq "mysql")
+		{
+			$triggers = "${triggers}CREATE TRIGGER `${trigger}` AFTER \U${operation}\E ON `${table_name}`${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+
+			if ($condition ne "")
+			{
+				# MySQL does not support UPDATE OF, compare configuration fields instead
+				$triggers = "${triggers}SELECT ${values},unix_timestamp() FROM DUAL${eol}\n";
+				$triggers = "${triggers}WHERE NOT (${condition});${eol}\n";
+			}
+			else
+			{
+				$triggers = "${triggers}VALUES (${values},unix_timestamp());${eol}\n";
+			}
+		}
+		elsif ($output{"database"} eq "postgresql")
+		{
+			$triggers = "${triggers}CREATE FUNCTION changelog_${trigger}() RETURNS TRIGGER AS \$\$${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES (${values},cast(extract(epoch FROM now()) AS int));${eol}\n";
+			$triggers = "${triggers}RETURN ${row};${eol}\n";
+			$triggers = "${triggers}END;${eol}\n";
+			$triggers = "${triggers}\$\$ LANGUAGE plpgsql;${eol}\n";
+			$triggers = "${triggers}CREATE TRIGGER ${trigger} AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW EXECUTE PROCEDURE changelog_${trigger}();${eol}\n";
+		}
+		elsif ($output{"database"} eq "oracle")
+		{
+			$triggers = "${triggers}CREATE TRIGGER ${trigger}${eol}\n";
+			$triggers = "${triggers}AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES (${object},:${row}.${table_key},$operations{$operation},${eol}\n";
+			$triggers = "${triggers}(cast(sys_extract_utc(systimestamp) AS date)-date'1970-01-01')*86400);${eol}\n";
+			$triggers = "${triggers}END;${eol}\n/${eol}\n";
+		}
+		elsif ($output{"database"} eq "sqlite3")
+		{
+			$triggers = "${triggers}CREATE TRIGGER ${trigger} AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES (${values},cast(strftime('%s','now') AS integer));${eol}\n";
+			$triggers = "${triggers}END;${eol}\n";
+		}
+	}
+}
+
 sub timescaledb
 {
 	print<<EOF
@@ -697,6 +790,7 @@ sub process
 	$state = "bof";
 	$fkeys = "";
 	$sequences = "";
+	$triggers = "";
 	$uniq = "";
 	my ($type, $line);
 
@@ -717,13 +811,14 @@ sub process
 			elsif ($type eq 'INDEX')	{ process_index($line, 0); }
 			elsif ($type eq 'TABLE')	{ process_table($line); }
 			elsif ($type eq 'UNIQUE')	{ process_index($line, 1); }
+			elsif ($type eq 'CHANGELOG')	{ process_changelog($line); }
 			elsif ($type eq 'ROW' && $output{"type"} ne "code")		{ process_row($line); }
 		}
 	}
 
 	newstate("table");
 
-	print $sequences.$sql_suffix;
+	print $sequences.$triggers.$sql_suffix;
 	print $fkeys_prefix.$fkeys.$fkeys_suffix;
 	print $output{"after"};
 }
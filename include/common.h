@@ -1720,6 +1720,9 @@ zbx_function_type_t;
 
 zbx_function_type_t	zbx_get_function_type(const char *func);
 int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg);
+int	zbx_xml_doc_open(const char *data, void **xml_doc, char **errmsg);
+void	zbx_xml_doc_close(void *xml_doc);
+int	zbx_query_xpath_doc(void *xml_doc, zbx_variant_t *value, const char *params, char **errmsg);
 int	zbx_xml_to_json(char *xml_data, char **jstr, char **errmsg);
 int	zbx_json_to_xml(char *json_data, char **xstr, char **errmsg);
 #ifdef HAVE_LIBXML2
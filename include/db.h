@@ -501,6 +501,9 @@ void	DBstatement_prepare(const char *sql);
 #endif
 int		DBexecute(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 int		DBexecute_once(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
+#ifdef HAVE_POSTGRESQL
+int		DBexecute_prepared(const char *sql, const char * const *params, int params_num);
+#endif
 DB_RESULT	DBselect_once(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 DB_RESULT	DBselect(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 DB_RESULT	DBselectN(const char *query, int n);
@@ -708,6 +711,9 @@ void	zbx_db_insert_prepare(zbx_db_insert_t *self, const char *table, ...);
 void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *self, const zbx_db_value_t **values, int values_num);
 void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...);
 int	zbx_db_insert_execute(zbx_db_insert_t *self);
+#ifdef HAVE_POSTGRESQL
+int	zbx_db_insert_pipeline(const zbx_db_insert_t *self);
+#endif
 void	zbx_db_insert_clean(zbx_db_insert_t *self);
 void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name);
 int	zbx_db_get_database_type(void);
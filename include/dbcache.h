@@ -234,6 +234,8 @@ typedef struct _DC_TRIGGER
 	/* temporary values, allocated during processing and freed right after */
 	char			*expression;
 	char			*recovery_expression;
+	unsigned char		*expression_code;
+	unsigned char		*recovery_expression_code;
 
 	char			*error;
 	char			*new_error;
@@ -663,6 +665,7 @@ void	DCconfig_get_functions_by_functionids(DC_FUNCTION *functions,
 		zbx_uint64_t *functionids, int *errcodes, size_t num);
 void	DCconfig_clean_functions(DC_FUNCTION *functions, int *errcodes, size_t num);
 void	DCconfig_clean_triggers(DC_TRIGGER *triggers, int *errcodes, size_t num);
+void	DCconfig_get_items_syncgroups(const zbx_uint64_t *itemids, zbx_uint64_t *syncgroupids, int num);
 int	DCconfig_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items, zbx_vector_uint64_t *triggerids);
 void	DCconfig_lock_triggers_by_triggerids(zbx_vector_uint64_t *triggerids_in, zbx_vector_uint64_t *triggerids_out);
 void	DCconfig_unlock_triggers(const zbx_vector_uint64_t *triggerids);
@@ -714,6 +717,7 @@ int	DCget_host_inventory_value_by_hostid(zbx_uint64_t hostid, char **replace_to,
 #define ZBX_CONFSTATS_BUFFER_FREE	3
 #define ZBX_CONFSTATS_BUFFER_PUSED	4
 #define ZBX_CONFSTATS_BUFFER_PFREE	5
+#define ZBX_CONFSTATS_SYNC_LOCK_MAX	6
 void	*DCconfig_get_stats(int request);
 
 int	DCconfig_get_last_sync_time(void);
@@ -843,6 +847,7 @@ typedef struct
 	zbx_uint64_t	itemid;
 	unsigned char	status;
 	int		values_num;
+	int		syncer;		/* the index of history syncer processing item values */
 
 	zbx_hc_data_t	*tail;
 	zbx_hc_data_t	*head;
@@ -23,6 +23,7 @@
 /* flags */
 #define ZBX_NOTNULL		0x01
 #define ZBX_PROXY		0x02
+#define ZBX_NODATA		0x04	/* runtime data, not exported and not tracked by configuration changelog */
 
 /* FK flags */
 #define ZBX_FK_CASCADE_DELETE	0x01
@@ -37,6 +38,7 @@
 #define	ZBX_TYPE_ID		6
 #define	ZBX_TYPE_SHORTTEXT	7
 #define	ZBX_TYPE_LONGTEXT	8
+#define	ZBX_TYPE_SERIAL		9	/* auto incremented ID, supported only by database upgrade */
 
 #define ZBX_MAX_FIELDS		106 /* maximum number of fields in a table plus one for null terminator in dbschema.c */
 #define ZBX_TABLENAME_LEN	26
@@ -29,11 +29,23 @@
 #define MEM_MAX_BUCKET_SIZE	256 /* starting from this size all free chunks are put into the same bucket */
 #define MEM_BUCKET_COUNT	((MEM_MAX_BUCKET_SIZE - MEM_MIN_BUCKET_SIZE) / 8 + 1)
 
+#define MEM_SLAB_SIZE		16384	/* small objects are allocated in slabs of this size */
+#define MEM_SLAB_MIN_OBJECT	16
+#define MEM_SLAB_MAX_OBJECT	256	/* larger objects are allocated as chunks */
+#define MEM_SLAB_COUNT		((MEM_SLAB_MAX_OBJECT - MEM_SLAB_MIN_OBJECT) / 8 + 1)
+
 typedef struct
 {
 	void		**buckets;
 	void		*lo_bound;
 	void		*hi_bound;
+
+	/* slabs with free objects by object size, slabs are allocated downwards from */
+	/* slabs_hi_bound and the chunk memory ends at hi_bound                        */
+	void		*slabs[MEM_SLAB_COUNT];
+	void		*slabs_empty;
+	void		*slabs_hi_bound;
+
 	zbx_uint64_t	free_size;
 	zbx_uint64_t	used_size;
 	zbx_uint64_t	orig_size;
@@ -60,6 +72,8 @@ typedef struct
 	unsigned int	chunks_num[MEM_BUCKET_COUNT];
 	unsigned int	free_chunks;
 	unsigned int	used_chunks;
+	unsigned int	slabs_num;
+	unsigned int	slab_objects;
 }
 zbx_mem_stats_t;
 
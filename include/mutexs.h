@@ -33,6 +33,9 @@ typedef enum
 {
 	ZBX_MUTEX_LOG = 0,
 	ZBX_MUTEX_CACHE,
+	ZBX_MUTEX_CACHE_1,
+	ZBX_MUTEX_CACHE_2,
+	ZBX_MUTEX_CACHE_3,
 	ZBX_MUTEX_TRENDS,
 	ZBX_MUTEX_CACHE_IDS,
 	ZBX_MUTEX_SELFMON,
@@ -41,12 +41,26 @@ typedef struct
 }
 zbx_preproc_item_stats_t;
 
+/* per process compiled data cache statistics */
+typedef struct
+{
+	zbx_uint64_t	regexp_hits;
+	zbx_uint64_t	regexp_misses;
+	zbx_uint64_t	script_hits;
+	zbx_uint64_t	script_misses;
+	zbx_uint64_t	jsonpath_hits;
+	zbx_uint64_t	jsonpath_misses;
+}
+zbx_preproc_cache_stats_t;
+
 /* the following functions are implemented differently for server and proxy */
 
 void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigned char item_value_type, unsigned char item_flags,
 		AGENT_RESULT *result, zbx_timespec_t *ts, unsigned char state, char *error);
 void	zbx_preprocessor_flush(void);
 zbx_uint64_t	zbx_preprocessor_get_queue_size(void);
+int	zbx_preprocessor_init_rings(int processes_num, int (*get_process_info)(int local_server_num,
+		unsigned char *local_process_type, int *local_process_num), char **error);
 
 void	zbx_preproc_op_free(zbx_preproc_op_t *op);
 void	zbx_preproc_result_free(zbx_preproc_result_t *result);
@@ -55,7 +69,8 @@ int	zbx_preprocessor_test(unsigned char value_type, const char *value, const zbx
 		const zbx_vector_ptr_t *steps, zbx_vector_ptr_t *results, zbx_vector_ptr_t *history,
 		char **preproc_error, char **error);
 
-int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num, char **error);
+int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num,
+		zbx_preproc_cache_stats_t *cache_stats, zbx_vector_uint64_pair_t *managers, char **error);
 
 
 int	zbx_preprocessor_get_top_items(int limit, zbx_vector_ptr_t *items, char **error);
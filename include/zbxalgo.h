@@ -122,9 +122,21 @@ ZBX_HASHSET_ENTRY_T
 	char			data[1];
 };
 
+/* open addressing hashset slot, keeps entry hash to avoid dereferencing entries while probing */
+typedef struct
+{
+	zbx_hash_t		hash;
+	ZBX_HASHSET_ENTRY_T	*entry;
+}
+zbx_hashset_cell_t;
+
+#define ZBX_HASHSET_CHAINED	0
+#define ZBX_HASHSET_OPEN	1
+
 typedef struct
 {
 	ZBX_HASHSET_ENTRY_T	**slots;
+	zbx_hashset_cell_t	*cells;
 	int			num_slots;
 	int			num_data;
 	zbx_hash_func_t		hash_func;
@@ -133,6 +145,7 @@ typedef struct
 	zbx_mem_malloc_func_t	mem_malloc_func;
 	zbx_mem_realloc_func_t	mem_realloc_func;
 	zbx_mem_free_func_t	mem_free_func;
+	unsigned char		type;
 }
 zbx_hashset_t;
 
@@ -148,6 +161,13 @@ void	zbx_hashset_create_ext(zbx_hashset_t *hs, size_t init_size,
 				zbx_mem_malloc_func_t mem_malloc_func,
 				zbx_mem_realloc_func_t mem_realloc_func,
 				zbx_mem_free_func_t mem_free_func);
+void	zbx_hashset_create_open_ext(zbx_hashset_t *hs, size_t init_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func,
+				zbx_clean_func_t clean_func,
+				zbx_mem_malloc_func_t mem_malloc_func,
+				zbx_mem_realloc_func_t mem_realloc_func,
+				zbx_mem_free_func_t mem_free_func);
 void	zbx_hashset_destroy(zbx_hashset_t *hs);
 
 int	zbx_hashset_reserve(zbx_hashset_t *hs, int num_slots_req);
@@ -163,6 +183,7 @@ typedef struct
 {
 	zbx_hashset_t		*hashset;
 	int			slot;
+	int			last;
 	ZBX_HASHSET_ENTRY_T	*entry;
 }
 zbx_hashset_iter_t;
@@ -171,6 +192,39 @@ void	zbx_hashset_iter_reset(zbx_hashset_t *hs, zbx_hashset_iter_t *iter);
 void	*zbx_hashset_iter_next(zbx_hashset_iter_t *iter);
 void	zbx_hashset_iter_remove(zbx_hashset_iter_t *iter);
 
+/* least recently used cache */
+
+/* the cached data must start with the link, the cache keeps it in most to least recently used order */
+typedef struct zbx_lrucache_link
+{
+	struct zbx_lrucache_link	*prev;
+	struct zbx_lrucache_link	*next;
+}
+zbx_lrucache_link_t;
+
+typedef struct
+{
+	zbx_hashset_t		entries;
+	zbx_lrucache_link_t	*head;		/* the most recently used entry */
+	zbx_lrucache_link_t	*tail;		/* the least recently used entry */
+	int			max_size;
+	zbx_hash_func_t		hash_func;
+	zbx_compare_func_t	compare_func;
+	zbx_clean_func_t	clean_func;
+	zbx_uint64_t		hits;
+	zbx_uint64_t		misses;
+	zbx_uint64_t		evictions;
+}
+zbx_lrucache_t;
+
+/* the entries are allocated on the first insert, so static and thread local caches need no initialization */
+#define ZBX_LRUCACHE_INITIALIZER(max_size, hash_func, compare_func, clean_func)				\
+		{{NULL}, NULL, NULL, max_size, hash_func, compare_func, clean_func, 0, 0, 0}
+
+void	*zbx_lrucache_search(zbx_lrucache_t *cache, const void *data);
+void	*zbx_lrucache_insert(zbx_lrucache_t *cache, const void *data, size_t size);
+void	zbx_lrucache_destroy(zbx_lrucache_t *cache);
+
 /* hashmap */
 
 /* currently, we only have a very specialized hashmap */
@@ -359,6 +413,19 @@ int	evaluate(double *value, const char *expression, char *error, size_t max_erro
 int	evaluate_unknown(const char *expression, double *value, char *error, size_t max_error_len);
 double	evaluate_string_to_double(const char *in);
 
+/* compiled expressions */
+
+#define ZBX_EVAL_TRIGGER_VALUE_ID	0	/* function identifier reserved for {TRIGGER.VALUE} macro */
+
+/* returns textual value of the specified function or NULL if the value is not available */
+typedef const char	*(*zbx_eval_value_func_t)(zbx_uint64_t functionid, void *data);
+
+int	zbx_eval_compile(const char *expression, unsigned char **code, size_t *code_size);
+size_t	zbx_eval_code_size(const unsigned char *code);
+void	zbx_eval_get_functionids(const unsigned char *code, zbx_vector_uint64_t *functionids);
+int	zbx_eval_execute(const unsigned char *code, zbx_eval_value_func_t value_func, void *data, double *value,
+		char *error, size_t max_error_len, zbx_vector_ptr_t *unknown_msgs);
+
 /* forecasting */
 
 #define ZBX_MATH_ERROR	-1.0
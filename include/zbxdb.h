@@ -127,6 +127,17 @@ void		zbx_db_clean_bind_context(zbx_db_bind_context_t *context);
 int		zbx_db_statement_execute(int iters);
 #endif
 int		zbx_db_vexecute(const char *fmt, va_list args);
+#if defined(HAVE_POSTGRESQL)
+int		zbx_db_copy_start(const char *sql);
+int		zbx_db_copy_put(const char *data, size_t data_len);
+int		zbx_db_copy_end(const char *sql);
+int		zbx_db_execute_prepared(const char *sql, const char * const *params, int params_num);
+int		zbx_db_pipeline_available(void);
+int		zbx_db_pipeline_execute(const char *sql);
+int		zbx_db_pipeline_sync(void);
+int		zbx_db_pipeline_wait(void);
+int		zbx_db_pipeline_unconfirmed(zbx_uint64_t *xid);
+#endif
 DB_RESULT	zbx_db_vselect(const char *fmt, va_list args);
 DB_RESULT	zbx_db_select_n(const char *query, int n);
 
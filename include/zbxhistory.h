@@ -46,15 +46,26 @@ void	zbx_history_value_print(char *buffer, size_t size, const history_value_t *v
 /* mirrors the vector creation function to vector destroying function.                    */
 #define zbx_history_record_vector_create(vector)	zbx_vector_history_record_create(vector)
 
+/* history aggregate functions */
+#define ZBX_HISTORY_AGGREGATE_SUM	0
+#define ZBX_HISTORY_AGGREGATE_AVG	1
+#define ZBX_HISTORY_AGGREGATE_MIN	2
+#define ZBX_HISTORY_AGGREGATE_MAX	3
+#define ZBX_HISTORY_AGGREGATE_COUNT	4
+
 
 int	zbx_history_init(char **error);
 void	zbx_history_destroy(void);
 
-int	zbx_history_add_values(const zbx_vector_ptr_t *history);
+int	zbx_history_add_values(const zbx_vector_ptr_t *history, zbx_vector_uint64_t *failed_itemids);
+void	zbx_history_wait(zbx_vector_uint64_t *failed_itemids);
 int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
+int	zbx_history_get_aggregate(zbx_uint64_t itemid, int value_type, int func, int start, const zbx_timespec_t *end,
+		history_value_t *value, int *values_num);
 
 int	zbx_history_requires_trends(int value_type);
+int	zbx_history_aggregate_available(int value_type, int func, int seconds);
 
 
 #endif
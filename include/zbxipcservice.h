@@ -78,6 +78,9 @@ typedef struct
 
 	/* the clients with messages */
 	zbx_queue_ptr_t		clients_recv;
+
+	/* the number of messages returned from queue without dispatching socket events */
+	int			recv_num;
 }
 zbx_ipc_service_t;
 
@@ -92,6 +95,31 @@ typedef struct
 }
 zbx_ipc_async_socket_t;
 
+/* shared memory ring buffer requires compiler support for memory barriers */
+#if defined(__GNUC__)
+#	define ZBX_IPC_RING_ENABLED
+#endif
+
+#define ZBX_IPC_RING_CACHELINE	64
+
+/* Single producer, single consumer ring buffer for passing data between processes */
+/* through shared memory. The data buffer follows the header.                      */
+typedef struct
+{
+	/* the write offset, updated only by producer */
+	volatile zbx_uint32_t	head;
+	char			head_pad[ZBX_IPC_RING_CACHELINE - sizeof(zbx_uint32_t)];
+
+	/* the read offset, updated only by consumer */
+	volatile zbx_uint32_t	tail;
+	char			tail_pad[ZBX_IPC_RING_CACHELINE - sizeof(zbx_uint32_t)];
+
+	/* the data buffer size */
+	zbx_uint32_t		size;
+	char			size_pad[ZBX_IPC_RING_CACHELINE - sizeof(zbx_uint32_t)];
+}
+zbx_ipc_ring_t;
+
 int	zbx_ipc_service_init_env(const char *path, char **error);
 void	zbx_ipc_service_free_env(void);
 int	zbx_ipc_service_start(zbx_ipc_service_t *service, const char *service_name, char **error);
@@ -127,6 +155,15 @@ int	zbx_ipc_async_socket_connected(zbx_ipc_async_socket_t *asocket);
 int	zbx_ipc_async_exchange(const char *service_name, zbx_uint32_t code, int timeout, const unsigned char *data,
 		zbx_uint32_t size, unsigned char **out, char **error);
 
+#ifdef ZBX_IPC_RING_ENABLED
+zbx_uint64_t	zbx_ipc_ring_required_size(zbx_uint32_t size);
+void		zbx_ipc_ring_init(zbx_ipc_ring_t *ring, zbx_uint32_t size);
+zbx_uint32_t	zbx_ipc_ring_max_record(const zbx_ipc_ring_t *ring);
+int		zbx_ipc_ring_write(zbx_ipc_ring_t *ring, const unsigned char *data, zbx_uint32_t size, int *wakeup);
+unsigned char	*zbx_ipc_ring_peek(zbx_ipc_ring_t *ring, zbx_uint32_t *size);
+void		zbx_ipc_ring_pop(zbx_ipc_ring_t *ring);
+int		zbx_ipc_ring_is_empty(const zbx_ipc_ring_t *ring);
+#endif
 
 void	zbx_ipc_message_free(zbx_ipc_message_t *message);
 void	zbx_ipc_message_clean(zbx_ipc_message_t *message);
@@ -286,6 +286,7 @@ int		zbx_json_count(const struct zbx_json_parse *jp);
 const char	*zbx_json_decodevalue(const char *p, char *string, size_t size, zbx_json_type_t *type);
 const char	*zbx_json_decodevalue_dyn(const char *p, char **string, size_t *string_alloc, zbx_json_type_t *type);
 void		zbx_json_escape(char **string);
+void		zbx_json_strcpy_alloc(char **data, size_t *data_alloc, size_t *data_offset, const char *string);
 int		zbx_json_open_path(const struct zbx_json_parse *jp, const char *path, struct zbx_json_parse *out);
 zbx_json_type_t	zbx_json_valuetype(const char *p);
 
@@ -308,6 +309,11 @@ zbx_jsonpath_t;
 
 void	zbx_jsonpath_clear(zbx_jsonpath_t *jsonpath);
 int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath);
+int	zbx_jsonpath_compile_cached(const char *path, const zbx_jsonpath_t **jsonpath);
+void	zbx_jsonpath_cache_get_stats(zbx_uint64_t *hits, zbx_uint64_t *misses);
 int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output);
+int	zbx_jsonpath_query_compiled(const struct zbx_json_parse *jp, const zbx_jsonpath_t *jsonpath, char **output);
+void	zbx_jsonpath_query_multi(const struct zbx_json_parse *jp, const char **paths, int paths_num, char **outputs,
+		char **errors);
 
 #endif /* ZABBIX_ZJSON_H */
@@ -20,10 +20,19 @@
 #ifndef ZABBIX_ZBXPROMETHEUS_H
 #define ZABBIX_ZBXPROMETHEUS_H
 
+typedef struct zbx_prometheus zbx_prometheus_t;
+
 int	zbx_prometheus_pattern(const char *data, const char *filter_data, const char *output, char **value,
 		char **error);
 int	zbx_prometheus_to_json(const char *data, const char *filter_data, char **value, char **error);
 
+int	zbx_prometheus_index_create(zbx_prometheus_t **prom, const char *data, char **error);
+void	zbx_prometheus_index_free(zbx_prometheus_t *prom);
+int	zbx_prometheus_index_pattern(zbx_prometheus_t *prom, const char *filter_data, const char *output,
+		char **value, char **error);
+int	zbx_prometheus_index_to_json(zbx_prometheus_t *prom, const char *filter_data, char **value,
+		char **error);
+
 int	zbx_prometheus_validate_filter(const char *pattern, char **error);
 int	zbx_prometheus_validate_label(const char *label);
 
@@ -952,6 +952,48 @@ static zbx_variant_t	evaluate_term1(int *unknown_idx)
 	return res;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: evaluate_unknown_error                                           *
+ *                                                                            *
+ * Purpose: map Unknown expression result to error message                    *
+ *                                                                            *
+ * Comments: Callers currently do not operate with ZBX_UNKNOWN.               *
+ *                                                                            *
+ ******************************************************************************/
+static void	evaluate_unknown_error(int unknown_idx, const char *expression, char *error, size_t max_error_len,
+		const zbx_vector_ptr_t *unknown_msgs)
+{
+	if (NULL != unknown_msgs)
+	{
+		if (0 > unknown_idx)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			zabbix_log(LOG_LEVEL_WARNING, "%s() internal error: " ZBX_UNKNOWN_STR " index:%d"
+					" expression:'%s'", __func__, unknown_idx, expression);
+			zbx_snprintf(error, max_error_len, "Internal error: " ZBX_UNKNOWN_STR " index %d."
+					" Please report this to Zabbix developers.", unknown_idx);
+		}
+		else if (unknown_msgs->values_num > unknown_idx)
+		{
+			zbx_snprintf(error, max_error_len, "Cannot evaluate expression: \"%s\".",
+					(char *)(unknown_msgs->values[unknown_idx]));
+		}
+		else
+		{
+			zbx_snprintf(error, max_error_len, "Cannot evaluate expression: unsupported "
+					ZBX_UNKNOWN_STR "%d value.", unknown_idx);
+		}
+	}
+	else
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		/* do not leave garbage in error buffer, write something helpful */
+		zbx_snprintf(error, max_error_len, "%s(): internal error: no message for unknown result",
+				__func__);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate an expression like "(26.416>10) or (0=1)"                *
@@ -998,36 +1040,7 @@ int	evaluate(double *value, const char *expression, char *error, size_t max_erro
 
 	if (ZBX_UNKNOWN == *value)
 	{
-		/* Map Unknown result to error. Callers currently do not operate with ZBX_UNKNOWN. */
-		if (NULL != unknown_msgs)
-		{
-			if (0 > unknown_idx)
-			{
-				THIS_SHOULD_NEVER_HAPPEN;
-				zabbix_log(LOG_LEVEL_WARNING, "%s() internal error: " ZBX_UNKNOWN_STR " index:%d"
-						" expression:'%s'", __func__, unknown_idx, expression);
-				zbx_snprintf(error, max_error_len, "Internal error: " ZBX_UNKNOWN_STR " index %d."
-						" Please report this to Zabbix developers.", unknown_idx);
-			}
-			else if (unknown_msgs->values_num > unknown_idx)
-			{
-				zbx_snprintf(error, max_error_len, "Cannot evaluate expression: \"%s\".",
-						(char *)(unknown_msgs->values[unknown_idx]));
-			}
-			else
-			{
-				zbx_snprintf(error, max_error_len, "Cannot evaluate expression: unsupported "
-						ZBX_UNKNOWN_STR "%d value.", unknown_idx);
-			}
-		}
-		else
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			/* do not leave garbage in error buffer, write something helpful */
-			zbx_snprintf(error, max_error_len, "%s(): internal error: no message for unknown result",
-					__func__);
-		}
-
+		evaluate_unknown_error(unknown_idx, expression, error, max_error_len, unknown_msgs);
 		*value = ZBX_INFINITY;
 	}
 
@@ -1128,3 +1141,999 @@ double	evaluate_string_to_double(const char *in)
 
 	return result_double_value;
 }
+
+/******************************************************************************
+ *                                                                            *
+ *                    Module for compiling expressions                        *
+ *                  ---------------------------------------                   *
+ *                                                                            *
+ * Trigger expressions can be compiled into a flat postfix code which is      *
+ * executed without parsing the expression text on every evaluation. The code *
+ * is relocatable, so it can be copied to shared memory as is:                *
+ *                                                                            *
+ *   zbx_eval_header_t | zbx_eval_op_t[ops_num] | string constants            *
+ *                                                                            *
+ * The compiler follows the grammar of evaluate_termX() functions and fails   *
+ * on anything it cannot reproduce exactly - syntax errors, 'unknown' tokens  *
+ * and macros other than function references and {TRIGGER.VALUE}. Such       *
+ * expressions must be substituted and evaluated as text.                     *
+ *                                                                            *
+ ******************************************************************************/
+
+#define ZBX_EVAL_TRIGGER_VALUE_MACRO	"{TRIGGER.VALUE}"
+
+#define ZBX_EVAL_OP_NUMBER	0
+#define ZBX_EVAL_OP_STRING	1
+#define ZBX_EVAL_OP_FUNCTION	2
+#define ZBX_EVAL_OP_TODOUBLE	3
+#define ZBX_EVAL_OP_NEG		4
+#define ZBX_EVAL_OP_NOT		5
+/* binary operators */
+#define ZBX_EVAL_OP_MUL		6
+#define ZBX_EVAL_OP_DIV		7
+#define ZBX_EVAL_OP_ADD		8
+#define ZBX_EVAL_OP_SUB		9
+#define ZBX_EVAL_OP_LT		10
+#define ZBX_EVAL_OP_LE		11
+#define ZBX_EVAL_OP_GE		12
+#define ZBX_EVAL_OP_GT		13
+#define ZBX_EVAL_OP_EQ		14
+#define ZBX_EVAL_OP_NE		15
+#define ZBX_EVAL_OP_AND		16
+#define ZBX_EVAL_OP_OR		17
+
+typedef struct
+{
+	zbx_uint32_t	size;		/* total code size in bytes       */
+	zbx_uint32_t	ops_num;	/* number of operations           */
+	zbx_uint32_t	stack_size;	/* maximum evaluation stack depth */
+	zbx_uint32_t	reserved;
+}
+zbx_eval_header_t;
+
+typedef struct
+{
+	zbx_uint32_t	type;
+	zbx_uint32_t	level;			/* nesting level of function reference      */
+	union
+	{
+		double		dbl;
+		zbx_uint64_t	functionid;
+		zbx_uint64_t	offset;		/* string constant offset from code start   */
+	}
+	data;
+}
+zbx_eval_op_t;
+
+typedef struct
+{
+	const char	*ptr;
+	int		level;
+	int		depth;
+	int		depth_max;
+	zbx_eval_op_t	*ops;
+	int		ops_num;
+	int		ops_alloc;
+	char		*strings;
+	size_t		strings_alloc;
+	size_t		strings_offset;
+}
+zbx_eval_compiler_t;
+
+typedef struct
+{
+	zbx_variant_t	value;
+	int		unknown_idx;
+}
+zbx_eval_value_t;
+
+static void	eval_compile_skip_spaces(zbx_eval_compiler_t *ctx)
+{
+	while (' ' == *ctx->ptr || '\r' == *ctx->ptr || '\n' == *ctx->ptr || '\t' == *ctx->ptr)
+		ctx->ptr++;
+}
+
+static zbx_eval_op_t	*eval_compile_add_op(zbx_eval_compiler_t *ctx, zbx_uint32_t type)
+{
+	zbx_eval_op_t	*op;
+
+	if (ctx->ops_num == ctx->ops_alloc)
+	{
+		ctx->ops_alloc = (0 == ctx->ops_alloc ? 16 : ctx->ops_alloc * 2);
+		ctx->ops = (zbx_eval_op_t *)zbx_realloc(ctx->ops, sizeof(zbx_eval_op_t) * ctx->ops_alloc);
+	}
+
+	op = &ctx->ops[ctx->ops_num++];
+	op->type = type;
+	op->level = 0;
+	op->data.functionid = 0;
+
+	if (ZBX_EVAL_OP_FUNCTION >= type)
+	{
+		if (++ctx->depth > ctx->depth_max)
+			ctx->depth_max = ctx->depth;
+	}
+	else if (ZBX_EVAL_OP_MUL <= type)
+		ctx->depth--;
+
+	return op;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile a quoted string, see evaluate_string()                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_string(zbx_eval_compiler_t *ctx)
+{
+	const char	*start;
+	zbx_eval_op_t	*op;
+
+	for (start = ctx->ptr; '"' != *ctx->ptr; ctx->ptr++)
+	{
+		/* text evaluation would substitute function references inside strings */
+		if ('{' == *ctx->ptr)
+			return FAIL;
+
+		if ('\\' == *ctx->ptr)
+		{
+			ctx->ptr++;
+
+			if ('\\' != *ctx->ptr && '"' != *ctx->ptr)
+				return FAIL;
+		}
+
+		if ('\0' == *ctx->ptr)
+			return FAIL;
+	}
+
+	op = eval_compile_add_op(ctx, ZBX_EVAL_OP_STRING);
+	op->data.offset = ctx->strings_offset;
+
+	for (; start != ctx->ptr; start++)
+	{
+		switch (*start)
+		{
+			case '\\':
+				start++;
+				break;
+			case '\r':
+				continue;
+		}
+		zbx_chrcpy_alloc(&ctx->strings, &ctx->strings_alloc, &ctx->strings_offset, *start);
+	}
+
+	/* ensure the buffer is allocated and include terminating zero into constant */
+	zbx_chrcpy_alloc(&ctx->strings, &ctx->strings_alloc, &ctx->strings_offset, '\0');
+	ctx->strings_offset++;
+
+	ctx->ptr++;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile function reference {<functionid>} or {TRIGGER.VALUE}      *
+ *          macro                                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_function(zbx_eval_compiler_t *ctx)
+{
+	const char	*br;
+	zbx_uint64_t	functionid;
+	zbx_eval_op_t	*op;
+
+	if (NULL == (br = strchr(ctx->ptr, '}')))
+		return FAIL;
+
+	if (SUCCEED == is_uint64_n(ctx->ptr + 1, br - ctx->ptr - 1, &functionid))
+	{
+		if (ZBX_EVAL_TRIGGER_VALUE_ID == functionid)
+			return FAIL;
+	}
+	else if (ZBX_CONST_STRLEN(ZBX_EVAL_TRIGGER_VALUE_MACRO) == br - ctx->ptr + 1 &&
+			0 == strncmp(ctx->ptr, ZBX_EVAL_TRIGGER_VALUE_MACRO, br - ctx->ptr + 1))
+	{
+		functionid = ZBX_EVAL_TRIGGER_VALUE_ID;
+	}
+	else
+		return FAIL;
+
+	/* numeric values are substituted without parentheses and must be followed by a delimiter */
+	if (SUCCEED != is_number_delimiter(br[1]))
+		return FAIL;
+
+	op = eval_compile_add_op(ctx, ZBX_EVAL_OP_FUNCTION);
+	op->data.functionid = functionid;
+	op->level = ctx->level;
+
+	ctx->ptr = br + 1;
+
+	return SUCCEED;
+}
+
+static int	eval_compile_term1(zbx_eval_compiler_t *ctx);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile a suffixed number, quoted string, function reference or   *
+ *          a parenthesized expression, see evaluate_term9()                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term9(zbx_eval_compiler_t *ctx)
+{
+	eval_compile_skip_spaces(ctx);
+
+	if ('(' == *ctx->ptr)
+	{
+		ctx->ptr++;
+
+		if (SUCCEED != eval_compile_term1(ctx) || ')' != *ctx->ptr)
+			return FAIL;
+
+		ctx->ptr++;
+	}
+	else if ('"' == *ctx->ptr)
+	{
+		ctx->ptr++;
+
+		if (SUCCEED != eval_compile_string(ctx))
+			return FAIL;
+
+		if (FAIL == is_operator_delimiter(*ctx->ptr) && FAIL == is_number_delimiter(*ctx->ptr))
+			return FAIL;
+	}
+	else if ('{' == *ctx->ptr)
+	{
+		if (SUCCEED != eval_compile_function(ctx))
+			return FAIL;
+	}
+	else
+	{
+		int	len;
+		double	value;
+
+		if (0 == strncmp(ZBX_UNKNOWN_STR, ctx->ptr, ZBX_UNKNOWN_STR_LEN))
+			return FAIL;
+
+		if (SUCCEED != zbx_suffixed_number_parse(ctx->ptr, &len) ||
+				SUCCEED != is_number_delimiter(ctx->ptr[len]))
+		{
+			return FAIL;
+		}
+
+		if (ZBX_INFINITY == (value = atof(ctx->ptr) * suffix2factor(ctx->ptr[len - 1])))
+			return FAIL;
+
+		eval_compile_add_op(ctx, ZBX_EVAL_OP_NUMBER)->data.dbl = value;
+		ctx->ptr += len;
+	}
+
+	eval_compile_skip_spaces(ctx);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "-" (unary), see evaluate_term8()                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term8(zbx_eval_compiler_t *ctx)
+{
+	eval_compile_skip_spaces(ctx);
+
+	if ('-' != *ctx->ptr)
+		return eval_compile_term9(ctx);
+
+	ctx->ptr++;
+
+	if (SUCCEED != eval_compile_term9(ctx))
+		return FAIL;
+
+	eval_compile_add_op(ctx, ZBX_EVAL_OP_NEG);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "not", see evaluate_term7()                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term7(zbx_eval_compiler_t *ctx)
+{
+	const char	*p;
+
+	eval_compile_skip_spaces(ctx);
+	p = ctx->ptr;
+
+	if ('n' != p[0] || 'o' != p[1] || 't' != p[2] || SUCCEED != is_operator_delimiter(p[3]))
+		return eval_compile_term8(ctx);
+
+	ctx->ptr += 3;
+
+	if (SUCCEED != eval_compile_term8(ctx))
+		return FAIL;
+
+	eval_compile_add_op(ctx, ZBX_EVAL_OP_NOT);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "*" and "/", see evaluate_term6()                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term6(zbx_eval_compiler_t *ctx)
+{
+	if (SUCCEED != eval_compile_term7(ctx))
+		return FAIL;
+
+	while ('*' == *ctx->ptr || '/' == *ctx->ptr)
+	{
+		zbx_uint32_t	type = ('*' == *ctx->ptr ? ZBX_EVAL_OP_MUL : ZBX_EVAL_OP_DIV);
+
+		/* left operand is converted before the right operand is evaluated */
+		eval_compile_add_op(ctx, ZBX_EVAL_OP_TODOUBLE);
+		ctx->ptr++;
+
+		if (SUCCEED != eval_compile_term7(ctx))
+			return FAIL;
+
+		eval_compile_add_op(ctx, type);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "+" and "-", see evaluate_term5()                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term5(zbx_eval_compiler_t *ctx)
+{
+	if (SUCCEED != eval_compile_term6(ctx))
+		return FAIL;
+
+	while ('+' == *ctx->ptr || '-' == *ctx->ptr)
+	{
+		zbx_uint32_t	type = ('+' == *ctx->ptr ? ZBX_EVAL_OP_ADD : ZBX_EVAL_OP_SUB);
+
+		eval_compile_add_op(ctx, ZBX_EVAL_OP_TODOUBLE);
+		ctx->ptr++;
+
+		if (SUCCEED != eval_compile_term6(ctx))
+			return FAIL;
+
+		eval_compile_add_op(ctx, type);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "<", "<=", ">=", ">", see evaluate_term4()                *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term4(zbx_eval_compiler_t *ctx)
+{
+	if (SUCCEED != eval_compile_term5(ctx))
+		return FAIL;
+
+	while (1)
+	{
+		zbx_uint32_t	type;
+		const char	*p = ctx->ptr;
+
+		if ('<' == p[0] && '=' == p[1])
+		{
+			type = ZBX_EVAL_OP_LE;
+			ctx->ptr += 2;
+		}
+		else if ('>' == p[0] && '=' == p[1])
+		{
+			type = ZBX_EVAL_OP_GE;
+			ctx->ptr += 2;
+		}
+		else if ('<' == p[0] && '>' != p[1])
+		{
+			type = ZBX_EVAL_OP_LT;
+			ctx->ptr++;
+		}
+		else if ('>' == p[0])
+		{
+			type = ZBX_EVAL_OP_GT;
+			ctx->ptr++;
+		}
+		else
+			break;
+
+		eval_compile_add_op(ctx, ZBX_EVAL_OP_TODOUBLE);
+
+		if (SUCCEED != eval_compile_term5(ctx))
+			return FAIL;
+
+		eval_compile_add_op(ctx, type);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "=" and "<>", see evaluate_term3()                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term3(zbx_eval_compiler_t *ctx)
+{
+	if (SUCCEED != eval_compile_term4(ctx))
+		return FAIL;
+
+	while (1)
+	{
+		zbx_uint32_t	type;
+
+		if ('=' == *ctx->ptr)
+		{
+			type = ZBX_EVAL_OP_EQ;
+			ctx->ptr++;
+		}
+		else if ('<' == ctx->ptr[0] && '>' == ctx->ptr[1])
+		{
+			type = ZBX_EVAL_OP_NE;
+			ctx->ptr += 2;
+		}
+		else
+			break;
+
+		/* operands are compared without conversion */
+		if (SUCCEED != eval_compile_term4(ctx))
+			return FAIL;
+
+		eval_compile_add_op(ctx, type);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "and", see evaluate_term2()                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term2(zbx_eval_compiler_t *ctx)
+{
+	if (SUCCEED != eval_compile_term3(ctx))
+		return FAIL;
+
+	while ('a' == ctx->ptr[0] && 'n' == ctx->ptr[1] && 'd' == ctx->ptr[2] &&
+			SUCCEED == is_operator_delimiter(ctx->ptr[3]))
+	{
+		ctx->ptr += 3;
+		eval_compile_add_op(ctx, ZBX_EVAL_OP_TODOUBLE);
+
+		if (SUCCEED != eval_compile_term3(ctx))
+			return FAIL;
+
+		eval_compile_add_op(ctx, ZBX_EVAL_OP_AND);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "or", see evaluate_term1()                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_compile_term1(zbx_eval_compiler_t *ctx)
+{
+	if (32 < ++ctx->level)
+		return FAIL;
+
+	if (SUCCEED != eval_compile_term2(ctx))
+		return FAIL;
+
+	while ('o' == ctx->ptr[0] && 'r' == ctx->ptr[1] && SUCCEED == is_operator_delimiter(ctx->ptr[2]))
+	{
+		ctx->ptr += 2;
+		eval_compile_add_op(ctx, ZBX_EVAL_OP_TODOUBLE);
+
+		if (SUCCEED != eval_compile_term2(ctx))
+			return FAIL;
+
+		eval_compile_add_op(ctx, ZBX_EVAL_OP_OR);
+	}
+
+	ctx->level--;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_eval_compile                                                 *
+ *                                                                            *
+ * Purpose: compile expression like "({15}>10) or ({123}=1)" into postfix     *
+ *          code                                                              *
+ *                                                                            *
+ * Parameters: expression - [IN] the expression to compile                   *
+ *             code       - [OUT] the compiled code, must be freed by caller  *
+ *             code_size  - [OUT] the compiled code size                      *
+ *                                                                            *
+ * Return value: SUCCEED - the expression was compiled successfully           *
+ *               FAIL    - the expression cannot be compiled and must be      *
+ *                         evaluated as text                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_eval_compile(const char *expression, unsigned char **code, size_t *code_size)
+{
+	zbx_eval_compiler_t	ctx;
+	zbx_eval_header_t	*header;
+	size_t			ops_size;
+	int			i, ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() expression:'%s'", __func__, expression);
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.ptr = expression;
+
+	if (SUCCEED != eval_compile_term1(&ctx) || '\0' != *ctx.ptr)
+		goto out;
+
+	ops_size = sizeof(zbx_eval_op_t) * (size_t)ctx.ops_num;
+	*code_size = sizeof(zbx_eval_header_t) + ops_size + ctx.strings_offset;
+	*code = (unsigned char *)zbx_malloc(NULL, *code_size);
+
+	header = (zbx_eval_header_t *)*code;
+	header->size = (zbx_uint32_t)*code_size;
+	header->ops_num = (zbx_uint32_t)ctx.ops_num;
+	header->stack_size = (zbx_uint32_t)ctx.depth_max;
+	header->reserved = 0;
+
+	for (i = 0; i < ctx.ops_num; i++)
+	{
+		if (ZBX_EVAL_OP_STRING == ctx.ops[i].type)
+			ctx.ops[i].data.offset += sizeof(zbx_eval_header_t) + ops_size;
+	}
+
+	memcpy(*code + sizeof(zbx_eval_header_t), ctx.ops, ops_size);
+
+	if (0 != ctx.strings_offset)
+		memcpy(*code + sizeof(zbx_eval_header_t) + ops_size, ctx.strings, ctx.strings_offset);
+
+	ret = SUCCEED;
+out:
+	zbx_free(ctx.ops);
+	zbx_free(ctx.strings);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s ops_num:%d", __func__, zbx_result_string(ret), ctx.ops_num);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_eval_code_size                                               *
+ *                                                                            *
+ * Purpose: return size of the compiled code in bytes                         *
+ *                                                                            *
+ ******************************************************************************/
+size_t	zbx_eval_code_size(const unsigned char *code)
+{
+	return ((const zbx_eval_header_t *)code)->size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_eval_get_functionids                                         *
+ *                                                                            *
+ * Purpose: get identifiers of functions referenced by the compiled code in   *
+ *          the order they appear in expression                               *
+ *                                                                            *
+ * Parameters: code        - [IN] the compiled code                           *
+ *             functionids - [OUT] the function identifiers                   *
+ *                                                                            *
+ * Comments: {TRIGGER.VALUE} macro references are not returned.               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_eval_get_functionids(const unsigned char *code, zbx_vector_uint64_t *functionids)
+{
+	const zbx_eval_header_t	*header = (const zbx_eval_header_t *)code;
+	const zbx_eval_op_t	*op;
+	zbx_uint32_t		i;
+
+	op = (const zbx_eval_op_t *)(code + sizeof(zbx_eval_header_t));
+
+	for (i = 0; i < header->ops_num; i++, op++)
+	{
+		if (ZBX_EVAL_OP_FUNCTION == op->type && ZBX_EVAL_TRIGGER_VALUE_ID != op->data.functionid)
+			zbx_vector_uint64_append(functionids, op->data.functionid);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: convert string operand to double                                  *
+ *                                                                            *
+ * Return value: SUCCEED      - the operand was converted                     *
+ *               FAIL         - the operand is not numeric, error is set      *
+ *               NOTSUPPORTED - the conversion result would be treated as     *
+ *                              'unknown' by text evaluation                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_execute_todouble(zbx_eval_value_t *operand)
+{
+	if (ZBX_VARIANT_STR != operand->value.type)
+		return SUCCEED;
+
+	variant_convert_to_double(&operand->value);
+
+	if (ZBX_INFINITY == operand->value.data.dbl)
+		return FAIL;
+
+	if (ZBX_UNKNOWN == operand->value.data.dbl)
+		return NOTSUPPORTED;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get function value as it would be parsed after substitution into  *
+ *          expression text                                                   *
+ *                                                                            *
+ * Parameters: op      - [IN] the function reference operation                *
+ *             text    - [IN] the function value                              *
+ *             operand - [OUT] the parsed value                               *
+ *                                                                            *
+ * Return value: SUCCEED      - the value was parsed                          *
+ *               NOTSUPPORTED - the value is not available or cannot be       *
+ *                              evaluated in isolation from the rest of       *
+ *                              expression text                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_execute_function(const zbx_eval_op_t *op, const char *text, zbx_eval_value_t *operand)
+{
+	operand->unknown_idx = -1;
+
+	if (NULL == text)
+		return NOTSUPPORTED;
+
+	/* numeric values are substituted as is, others are enclosed in parentheses */
+	if (SUCCEED == is_double_suffix(text, ZBX_FLAG_DOUBLE_SUFFIX) && '-' != *text)
+	{
+		int	len;
+		double	value;
+
+		if (SUCCEED != zbx_suffixed_number_parse(text, &len) || '\0' != text[len])
+			return NOTSUPPORTED;
+
+		if (ZBX_INFINITY == (value = atof(text) * suffix2factor(text[len - 1])))
+			return NOTSUPPORTED;
+
+		zbx_variant_set_dbl(&operand->value, value);
+
+		return SUCCEED;
+	}
+
+	ptr = text;
+	level = (int)op->level;
+	operand->value = evaluate_term1(&operand->unknown_idx);
+
+	if ('\0' != *ptr || (ZBX_VARIANT_DBL == operand->value.type && (ZBX_INFINITY == operand->value.data.dbl ||
+			(ZBX_UNKNOWN == operand->value.data.dbl && 0 > operand->unknown_idx))))
+	{
+		zbx_variant_clear(&operand->value);
+		return NOTSUPPORTED;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compare operands, see evaluate_term3()                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	eval_execute_equal(zbx_uint32_t type, zbx_eval_value_t *left, zbx_eval_value_t *right)
+{
+	double	value, left_dbl, right_dbl;
+
+	if (ZBX_VARIANT_DBL == left->value.type && ZBX_UNKNOWN == left->value.data.dbl)
+		return;
+
+	if (ZBX_VARIANT_DBL == right->value.type && ZBX_UNKNOWN == right->value.data.dbl)
+	{
+		zbx_variant_clear(&left->value);
+		*left = *right;
+		return;
+	}
+
+	left_dbl = variant_get_double(&left->value);
+	right_dbl = variant_get_double(&right->value);
+
+	if (ZBX_INFINITY != left_dbl && ZBX_INFINITY != right_dbl)
+		value = (SUCCEED == zbx_double_compare(left_dbl, right_dbl) ? 1 : 0);
+	else if (ZBX_VARIANT_DBL == left->value.type || ZBX_VARIANT_DBL == right->value.type)
+		value = 0;
+	else
+		value = !strcmp(left->value.data.str, right->value.data.str);
+
+	if (ZBX_EVAL_OP_NE == type)
+		value = (SUCCEED == zbx_double_compare(value, 0.0) ? 1.0 : 0.0);
+
+	zbx_variant_clear(&left->value);
+	zbx_variant_set_dbl(&left->value, value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: apply "and", "or" operators, see evaluate_term2(),                *
+ *          evaluate_term1()                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	eval_execute_logical(zbx_uint32_t type, zbx_eval_value_t *left, const zbx_eval_value_t *right)
+{
+	double	left_dbl = left->value.data.dbl, right_dbl = right->value.data.dbl;
+	double	absorbing = (ZBX_EVAL_OP_AND == type ? 0.0 : 1.0);
+
+	if (ZBX_UNKNOWN == left_dbl)
+	{
+		if (ZBX_UNKNOWN == right_dbl)
+			left->unknown_idx = right->unknown_idx;
+		else if ((SUCCEED == zbx_double_compare(right_dbl, 0.0)) == (ZBX_EVAL_OP_AND == type))
+			left->value.data.dbl = absorbing;
+	}
+	else if (ZBX_UNKNOWN == right_dbl)
+	{
+		if ((SUCCEED == zbx_double_compare(left_dbl, 0.0)) == (ZBX_EVAL_OP_AND == type))
+		{
+			left->value.data.dbl = absorbing;
+		}
+		else
+		{
+			left->value.data.dbl = ZBX_UNKNOWN;
+			left->unknown_idx = right->unknown_idx;
+		}
+	}
+	else if (ZBX_EVAL_OP_AND == type)
+	{
+		left->value.data.dbl = (SUCCEED != zbx_double_compare(left_dbl, 0.0) &&
+				SUCCEED != zbx_double_compare(right_dbl, 0.0));
+	}
+	else
+	{
+		left->value.data.dbl = (SUCCEED != zbx_double_compare(left_dbl, 0.0) ||
+				SUCCEED != zbx_double_compare(right_dbl, 0.0));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: apply binary operator to the operands, storing result in the left *
+ *          operand                                                           *
+ *                                                                            *
+ * Return value: SUCCEED      - the operator was applied                      *
+ *               FAIL         - evaluation error, error is set                *
+ *               NOTSUPPORTED - the result is out of range                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_execute_binary(zbx_uint32_t type, zbx_eval_value_t *left, zbx_eval_value_t *right)
+{
+	double	left_dbl, right_dbl, value;
+	int	ret;
+
+	if (ZBX_EVAL_OP_EQ == type || ZBX_EVAL_OP_NE == type)
+	{
+		eval_execute_equal(type, left, right);
+		return SUCCEED;
+	}
+
+	if (SUCCEED != (ret = eval_execute_todouble(right)))
+		return ret;
+
+	if (ZBX_EVAL_OP_AND == type || ZBX_EVAL_OP_OR == type)
+	{
+		eval_execute_logical(type, left, right);
+		return SUCCEED;
+	}
+
+	left_dbl = left->value.data.dbl;
+	right_dbl = right->value.data.dbl;
+
+	/* catch division by 0 even if 1st operand is Unknown */
+	if (ZBX_EVAL_OP_DIV == type && ZBX_UNKNOWN != right_dbl && SUCCEED == zbx_double_compare(right_dbl, 0.0))
+	{
+		zbx_strlcpy(buffer, "Cannot evaluate expression: division by zero.", max_buffer_len);
+		return FAIL;
+	}
+
+	if (ZBX_UNKNOWN == right_dbl)
+	{
+		left->value.data.dbl = ZBX_UNKNOWN;
+		left->unknown_idx = right->unknown_idx;
+		return SUCCEED;
+	}
+
+	if (ZBX_UNKNOWN == left_dbl)
+		return SUCCEED;
+
+	switch (type)
+	{
+		case ZBX_EVAL_OP_MUL:
+			value = left_dbl * right_dbl;
+			break;
+		case ZBX_EVAL_OP_DIV:
+			value = left_dbl / right_dbl;
+			break;
+		case ZBX_EVAL_OP_ADD:
+			value = left_dbl + right_dbl;
+			break;
+		case ZBX_EVAL_OP_SUB:
+			value = left_dbl - right_dbl;
+			break;
+		case ZBX_EVAL_OP_LT:
+			value = (left_dbl < right_dbl - ZBX_DOUBLE_EPSILON);
+			break;
+		case ZBX_EVAL_OP_LE:
+			value = (left_dbl <= right_dbl + ZBX_DOUBLE_EPSILON);
+			break;
+		case ZBX_EVAL_OP_GE:
+			value = (left_dbl >= right_dbl - ZBX_DOUBLE_EPSILON);
+			break;
+		default:
+			value = (left_dbl > right_dbl + ZBX_DOUBLE_EPSILON);
+			break;
+	}
+
+	/* overflows are reported as errors or unknown values by text evaluation */
+	if (ZBX_INFINITY == value || ZBX_UNKNOWN == value)
+		return NOTSUPPORTED;
+
+	left->value.data.dbl = value;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_eval_execute                                                 *
+ *                                                                            *
+ * Purpose: evaluate compiled expression                                      *
+ *                                                                            *
+ * Parameters: code          - [IN] the compiled code                         *
+ *             value_func    - [IN] callback returning function values        *
+ *             data          - [IN] the callback data                         *
+ *             value         - [OUT] expression evaluation result             *
+ *             error         - [OUT] error message buffer                     *
+ *             max_error_len - [IN] error buffer size                         *
+ *             unknown_msgs  - [IN] messages about origins of 'unknown'       *
+ *                                  function values                           *
+ *                                                                            *
+ * Return value: SUCCEED      - expression evaluated successfully             *
+ *               FAIL         - expression evaluation failed, the error is    *
+ *                              the same as evaluate() would return for the   *
+ *                              substituted expression text                   *
+ *               NOTSUPPORTED - expression must be substituted and evaluated  *
+ *                              as text                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_eval_execute(const unsigned char *code, zbx_eval_value_func_t value_func, void *data, double *value,
+		char *error, size_t max_error_len, zbx_vector_ptr_t *unknown_msgs)
+{
+	const zbx_eval_header_t	*header = (const zbx_eval_header_t *)code;
+	const zbx_eval_op_t	*op, *op_end;
+	zbx_eval_value_t	*stack, *operand;
+	int			depth = 0, ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() ops_num:%u", __func__, header->ops_num);
+
+	buffer = error;
+	max_buffer_len = max_error_len;
+
+	stack = (zbx_eval_value_t *)zbx_malloc(NULL, sizeof(zbx_eval_value_t) * header->stack_size);
+
+	op = (const zbx_eval_op_t *)(code + sizeof(zbx_eval_header_t));
+
+	for (op_end = op + header->ops_num; op < op_end; op++)
+	{
+		switch (op->type)
+		{
+			case ZBX_EVAL_OP_NUMBER:
+				operand = &stack[depth++];
+				zbx_variant_set_dbl(&operand->value, op->data.dbl);
+				operand->unknown_idx = -1;
+				break;
+			case ZBX_EVAL_OP_STRING:
+				operand = &stack[depth++];
+				zbx_variant_set_str(&operand->value,
+						zbx_strdup(NULL, (const char *)code + op->data.offset));
+				operand->unknown_idx = -1;
+				break;
+			case ZBX_EVAL_OP_FUNCTION:
+				if (SUCCEED != (ret = eval_execute_function(op, value_func(op->data.functionid, data),
+						&stack[depth])))
+				{
+					goto out;
+				}
+				depth++;
+				break;
+			case ZBX_EVAL_OP_TODOUBLE:
+				if (SUCCEED != (ret = eval_execute_todouble(&stack[depth - 1])))
+					goto out;
+				break;
+			case ZBX_EVAL_OP_NEG:
+			case ZBX_EVAL_OP_NOT:
+				operand = &stack[depth - 1];
+
+				if (SUCCEED != (ret = eval_execute_todouble(operand)))
+					goto out;
+
+				if (ZBX_UNKNOWN == operand->value.data.dbl)
+					break;
+
+				if (ZBX_EVAL_OP_NEG == op->type)
+					operand->value.data.dbl = -operand->value.data.dbl;
+				else if (SUCCEED == zbx_double_compare(operand->value.data.dbl, 0.0))
+					operand->value.data.dbl = 1.0;
+				else
+					operand->value.data.dbl = 0.0;
+				break;
+			default:
+				ret = eval_execute_binary(op->type, &stack[depth - 2], &stack[depth - 1]);
+				zbx_variant_clear(&stack[--depth].value);
+
+				if (SUCCEED != ret)
+					goto out;
+		}
+	}
+
+	operand = &stack[0];
+
+	if (ZBX_VARIANT_STR == operand->value.type)
+	{
+		if ('\0' == *operand->value.data.str)
+		{
+			zbx_strlcpy(error, "Cannot evaluate expression: unexpected end of expression.", max_error_len);
+			ret = FAIL;
+			goto out;
+		}
+
+		if (SUCCEED != (ret = eval_execute_todouble(operand)))
+			goto out;
+	}
+
+	if (ZBX_UNKNOWN == operand->value.data.dbl)
+	{
+		if (0 > operand->unknown_idx)
+		{
+			ret = NOTSUPPORTED;
+			goto out;
+		}
+
+		evaluate_unknown_error(operand->unknown_idx, NULL, error, max_error_len, unknown_msgs);
+		ret = FAIL;
+		goto out;
+	}
+
+	*value = operand->value.data.dbl;
+	ret = SUCCEED;
+out:
+	while (0 < depth)
+		zbx_variant_clear(&stack[--depth].value);
+
+	zbx_free(stack);
+
+	if (SUCCEED == ret)
+		zabbix_log(LOG_LEVEL_DEBUG, "End of %s() value:" ZBX_FS_DBL, __func__, *value);
+	else
+		zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
@@ -25,9 +25,14 @@
 static void	__hashset_free_entry(zbx_hashset_t *hs, ZBX_HASHSET_ENTRY_T *entry);
 
 #define	CRIT_LOAD_FACTOR	4/5
+#define	OPEN_CRIT_LOAD_FACTOR	3/4
 #define	SLOT_GROWTH_FACTOR	3/2
 
 #define ZBX_HASHSET_DEFAULT_SLOTS	10
+#define ZBX_HASHSET_OPEN_MIN_SLOTS	16
+
+#define	ITER_START	(-1)
+#define	ITER_FINISH	(-2)
 
 /* private hashset functions */
 
@@ -39,12 +44,267 @@ static void	__hashset_free_entry(zbx_hashset_t *hs, ZBX_HASHSET_ENTRY_T *entry)
 	hs->mem_free_func(entry);
 }
 
+/* private open addressing hashset functions */
+
+/******************************************************************************
+ *                                                                            *
+ * Open addressing hashset keeps entries allocated separately, like chained   *
+ * hashset does, so the data pointers returned to the user stay valid until   *
+ * removal. Instead of slot lists it has a power of two array of cells with   *
+ * entry pointers and hashes, using linear probing with Robin Hood insertion  *
+ * and backward shift deletion. Collisions are resolved by comparing hashes   *
+ * within the cell array, entries are dereferenced only on hash match.        *
+ *                                                                            *
+ ******************************************************************************/
+
+#define HASHSET_OPEN_DISTANCE(pos, hash, mask)	((int)((zbx_hash_t)(pos) - ((hash) & (mask))) & (mask))
+
+static int	hashset_open_slots_num(int num_data)
+{
+	int	num_slots = ZBX_HASHSET_OPEN_MIN_SLOTS;
+
+	while (num_data >= num_slots * OPEN_CRIT_LOAD_FACTOR)
+		num_slots <<= 1;
+
+	return num_slots;
+}
+
+static int	hashset_open_init_cells(zbx_hashset_t *hs, int num_data)
+{
+	int	num_slots;
+
+	num_slots = hashset_open_slots_num(num_data);
+
+	if (NULL == (hs->cells = (zbx_hashset_cell_t *)hs->mem_malloc_func(NULL,
+			num_slots * sizeof(zbx_hashset_cell_t))))
+	{
+		return FAIL;
+	}
+
+	memset(hs->cells, 0, num_slots * sizeof(zbx_hashset_cell_t));
+	hs->num_slots = num_slots;
+
+	return SUCCEED;
+}
+
+static void	hashset_open_place(zbx_hashset_cell_t *cells, int mask, zbx_hash_t hash, ZBX_HASHSET_ENTRY_T *entry)
+{
+	int			pos, dist, cell_dist;
+	zbx_hashset_cell_t	tmp;
+
+	for (pos = (int)(hash & mask), dist = 0; NULL != cells[pos].entry; pos = (pos + 1) & mask, dist++)
+	{
+		/* move the richer entry further to keep probe sequences short */
+		if ((cell_dist = HASHSET_OPEN_DISTANCE(pos, cells[pos].hash, mask)) < dist)
+		{
+			tmp = cells[pos];
+			cells[pos].hash = hash;
+			cells[pos].entry = entry;
+			hash = tmp.hash;
+			entry = tmp.entry;
+			dist = cell_dist;
+		}
+	}
+
+	cells[pos].hash = hash;
+	cells[pos].entry = entry;
+}
+
+static int	hashset_open_find(const zbx_hashset_t *hs, zbx_hash_t hash, const void *data)
+{
+	int				pos, dist, mask = hs->num_slots - 1;
+	const zbx_hashset_cell_t	*cell;
+
+	for (pos = (int)(hash & mask), dist = 0;; pos = (pos + 1) & mask, dist++)
+	{
+		cell = &hs->cells[pos];
+
+		if (NULL == cell->entry)
+			return FAIL;
+
+		if (cell->hash == hash && 0 == hs->compare_func(cell->entry->data, data))
+			return pos;
+
+		if (dist > HASHSET_OPEN_DISTANCE(pos, cell->hash, mask))
+			return FAIL;
+	}
+}
+
+static int	hashset_open_reserve(zbx_hashset_t *hs, int num_slots_req)
+{
+	int			i, num_slots;
+	zbx_hashset_cell_t	*cells;
+
+	if (0 == hs->num_slots)
+		return hashset_open_init_cells(hs, MAX(ZBX_HASHSET_DEFAULT_SLOTS, num_slots_req));
+
+	if (num_slots_req < hs->num_slots * OPEN_CRIT_LOAD_FACTOR)
+		return SUCCEED;
+
+	num_slots = hashset_open_slots_num(num_slots_req);
+
+	if (NULL == (cells = (zbx_hashset_cell_t *)hs->mem_malloc_func(NULL, num_slots * sizeof(zbx_hashset_cell_t))))
+		return FAIL;
+
+	memset(cells, 0, num_slots * sizeof(zbx_hashset_cell_t));
+
+	for (i = 0; i < hs->num_slots; i++)
+	{
+		if (NULL != hs->cells[i].entry)
+			hashset_open_place(cells, num_slots - 1, hs->cells[i].hash, hs->cells[i].entry);
+	}
+
+	hs->mem_free_func(hs->cells);
+	hs->cells = cells;
+	hs->num_slots = num_slots;
+
+	return SUCCEED;
+}
+
+static void	hashset_open_remove_cell(zbx_hashset_t *hs, int pos)
+{
+	int			next, mask = hs->num_slots - 1;
+	ZBX_HASHSET_ENTRY_T	*entry = hs->cells[pos].entry;
+
+	for (next = (pos + 1) & mask; NULL != hs->cells[next].entry &&
+			0 != HASHSET_OPEN_DISTANCE(next, hs->cells[next].hash, mask); next = (next + 1) & mask)
+	{
+		hs->cells[pos] = hs->cells[next];
+		pos = next;
+	}
+
+	hs->cells[pos].entry = NULL;
+	hs->num_data--;
+
+	__hashset_free_entry(hs, entry);
+}
+
+static void	*hashset_open_insert(zbx_hashset_t *hs, const void *data, size_t size, size_t offset)
+{
+	int			pos;
+	zbx_hash_t		hash;
+	ZBX_HASHSET_ENTRY_T	*entry;
+
+	if (0 == hs->num_slots && SUCCEED != hashset_open_init_cells(hs, ZBX_HASHSET_DEFAULT_SLOTS))
+		return NULL;
+
+	hash = hs->hash_func(data);
+
+	if (FAIL != (pos = hashset_open_find(hs, hash, data)))
+		return hs->cells[pos].entry->data;
+
+	if (SUCCEED != hashset_open_reserve(hs, hs->num_data + 1))
+		return NULL;
+
+	if (NULL == (entry = (ZBX_HASHSET_ENTRY_T *)hs->mem_malloc_func(NULL, ZBX_HASHSET_ENTRY_OFFSET + size)))
+		return NULL;
+
+	memcpy((char *)entry->data + offset, (const char *)data + offset, size - offset);
+	entry->hash = hash;
+	entry->next = NULL;
+
+	hashset_open_place(hs->cells, hs->num_slots - 1, hash, entry);
+	hs->num_data++;
+
+	return entry->data;
+}
+
+static void	hashset_open_remove_direct(zbx_hashset_t *hs, const void *data)
+{
+	int			pos, mask = hs->num_slots - 1;
+	ZBX_HASHSET_ENTRY_T	*data_entry;
+
+	data_entry = (ZBX_HASHSET_ENTRY_T *)((const char *)data - ZBX_HASHSET_ENTRY_OFFSET);
+
+	for (pos = (int)(data_entry->hash & mask); NULL != hs->cells[pos].entry; pos = (pos + 1) & mask)
+	{
+		if (hs->cells[pos].entry == data_entry)
+		{
+			hashset_open_remove_cell(hs, pos);
+			break;
+		}
+	}
+}
+
+static void	hashset_open_clear(zbx_hashset_t *hs)
+{
+	int	i;
+
+	for (i = 0; i < hs->num_slots; i++)
+	{
+		if (NULL != hs->cells[i].entry)
+		{
+			__hashset_free_entry(hs, hs->cells[i].entry);
+			hs->cells[i].entry = NULL;
+		}
+	}
+
+	hs->num_data = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hashset_open_iter_next                                           *
+ *                                                                            *
+ * Comments: Iteration starts after an empty cell and wraps around to it, so  *
+ *           backward shifts done by iterator removal move only entries that  *
+ *           are not visited yet.                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	*hashset_open_iter_next(zbx_hashset_iter_t *iter)
+{
+	zbx_hashset_t	*hs = iter->hashset;
+	int		mask = hs->num_slots - 1;
+
+	if (ITER_START == iter->slot)
+	{
+		if (0 == hs->num_data)
+		{
+			iter->slot = ITER_FINISH;
+			return NULL;
+		}
+
+		for (iter->last = 0; NULL != hs->cells[iter->last].entry; iter->last++)
+			;
+
+		iter->slot = iter->last;
+	}
+
+	while (1)
+	{
+		iter->slot = (iter->slot + 1) & mask;
+
+		if (iter->slot == iter->last)
+		{
+			iter->slot = ITER_FINISH;
+			return NULL;
+		}
+
+		if (NULL != (iter->entry = hs->cells[iter->slot].entry))
+			return iter->entry->data;
+	}
+}
+
+static void	hashset_open_iter_remove(zbx_hashset_iter_t *iter)
+{
+	hashset_open_remove_cell(iter->hashset, iter->slot);
+
+	/* the next entry might be shifted into the current cell */
+	iter->slot = (iter->slot - 1) & (iter->hashset->num_slots - 1);
+	iter->entry = NULL;
+}
+
+/* private chained hashset functions */
+
 static int	zbx_hashset_init_slots(zbx_hashset_t *hs, size_t init_size)
 {
 	hs->num_data = 0;
 
 	if (0 < init_size)
 	{
+		if (ZBX_HASHSET_OPEN == hs->type)
+			return hashset_open_init_cells(hs, (int)init_size);
+
 		hs->num_slots = next_prime(init_size);
 
 		if (NULL == (hs->slots = (ZBX_HASHSET_ENTRY_T **)hs->mem_malloc_func(NULL, hs->num_slots * sizeof(ZBX_HASHSET_ENTRY_T *))))
@@ -56,6 +316,7 @@ static int	zbx_hashset_init_slots(zbx_hashset_t *hs, size_t init_size)
 	{
 		hs->num_slots = 0;
 		hs->slots = NULL;
+		hs->cells = NULL;
 	}
 
 	return SUCCEED;
@@ -87,6 +348,41 @@ void	zbx_hashset_create_ext(zbx_hashset_t *hs, size_t init_size,
 	hs->mem_malloc_func = mem_malloc_func;
 	hs->mem_realloc_func = mem_realloc_func;
 	hs->mem_free_func = mem_free_func;
+	hs->type = ZBX_HASHSET_CHAINED;
+	hs->cells = NULL;
+
+	zbx_hashset_init_slots(hs, init_size);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hashset_create_open_ext                                      *
+ *                                                                            *
+ * Purpose: creates open addressing hashset                                   *
+ *                                                                            *
+ * Comments: Open addressing hashset has the same interface and guarantees as *
+ *           chained one, but has better lookup locality. It's intended for   *
+ *           large and frequently searched sets.                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hashset_create_open_ext(zbx_hashset_t *hs, size_t init_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func,
+				zbx_clean_func_t clean_func,
+				zbx_mem_malloc_func_t mem_malloc_func,
+				zbx_mem_realloc_func_t mem_realloc_func,
+				zbx_mem_free_func_t mem_free_func)
+{
+	hs->hash_func = hash_func;
+	hs->compare_func = compare_func;
+	hs->clean_func = clean_func;
+	hs->mem_malloc_func = mem_malloc_func;
+	hs->mem_realloc_func = mem_realloc_func;
+	hs->mem_free_func = mem_free_func;
+	hs->type = ZBX_HASHSET_OPEN;
+	hs->slots = NULL;
+	hs->cells = NULL;
+	hs->num_slots = 0;
 
 	zbx_hashset_init_slots(hs, init_size);
 }
@@ -96,7 +392,18 @@ void	zbx_hashset_destroy(zbx_hashset_t *hs)
 	int			i;
 	ZBX_HASHSET_ENTRY_T	*entry, *next_entry;
 
-	for (i = 0; i < hs->num_slots; i++)
+	if (ZBX_HASHSET_OPEN == hs->type)
+	{
+		hashset_open_clear(hs);
+
+		if (NULL != hs->cells)
+		{
+			hs->mem_free_func(hs->cells);
+			hs->cells = NULL;
+		}
+	}
+
+	for (i = 0; NULL != hs->slots && i < hs->num_slots; i++)
 	{
 		entry = hs->slots[i];
 
@@ -136,6 +443,9 @@ void	zbx_hashset_destroy(zbx_hashset_t *hs)
  ******************************************************************************/
 int	zbx_hashset_reserve(zbx_hashset_t *hs, int num_slots_req)
 {
+	if (ZBX_HASHSET_OPEN == hs->type)
+		return hashset_open_reserve(hs, num_slots_req);
+
 	if (0 == hs->num_slots)
 	{
 		/* correction for prevent the second relocation in the case that requires the same number of slots */
@@ -201,6 +511,9 @@ void	*zbx_hashset_insert_ext(zbx_hashset_t *hs, const void *data, size_t size, s
 	zbx_hash_t		hash;
 	ZBX_HASHSET_ENTRY_T	*entry;
 
+	if (ZBX_HASHSET_OPEN == hs->type)
+		return hashset_open_insert(hs, data, size, offset);
+
 	if (0 == hs->num_slots && SUCCEED != zbx_hashset_init_slots(hs, ZBX_HASHSET_DEFAULT_SLOTS))
 		return NULL;
 
@@ -249,6 +562,14 @@ void	*zbx_hashset_search(zbx_hashset_t *hs, const void *data)
 
 	hash = hs->hash_func(data);
 
+	if (ZBX_HASHSET_OPEN == hs->type)
+	{
+		if (FAIL == (slot = hashset_open_find(hs, hash, data)))
+			return NULL;
+
+		return hs->cells[slot].entry->data;
+	}
+
 	slot = hash % hs->num_slots;
 	entry = hs->slots[slot];
 
@@ -279,6 +600,14 @@ void	zbx_hashset_remove(zbx_hashset_t *hs, const void *data)
 
 	hash = hs->hash_func(data);
 
+	if (ZBX_HASHSET_OPEN == hs->type)
+	{
+		if (FAIL != (slot = hashset_open_find(hs, hash, data)))
+			hashset_open_remove_cell(hs, slot);
+
+		return;
+	}
+
 	slot = hash % hs->num_slots;
 	entry = hs->slots[slot];
 
@@ -328,6 +657,12 @@ void	zbx_hashset_remove_direct(zbx_hashset_t *hs, const void *data)
 	if (0 == hs->num_slots)
 		return;
 
+	if (ZBX_HASHSET_OPEN == hs->type)
+	{
+		hashset_open_remove_direct(hs, data);
+		return;
+	}
+
 	data_entry = (ZBX_HASHSET_ENTRY_T *)((const char *)data - ZBX_HASHSET_ENTRY_OFFSET);
 
 	slot = data_entry->hash % hs->num_slots;
@@ -364,6 +699,12 @@ void	zbx_hashset_clear(zbx_hashset_t *hs)
 	int			slot;
 	ZBX_HASHSET_ENTRY_T	*entry;
 
+	if (ZBX_HASHSET_OPEN == hs->type)
+	{
+		hashset_open_clear(hs);
+		return;
+	}
+
 	for (slot = 0; slot < hs->num_slots; slot++)
 	{
 		while (NULL != hs->slots[slot])
@@ -377,9 +718,6 @@ void	zbx_hashset_clear(zbx_hashset_t *hs)
 	hs->num_data = 0;
 }
 
-#define	ITER_START	(-1)
-#define	ITER_FINISH	(-2)
-
 void	zbx_hashset_iter_reset(zbx_hashset_t *hs, zbx_hashset_iter_t *iter)
 {
 	iter->hashset = hs;
@@ -391,6 +729,9 @@ void	*zbx_hashset_iter_next(zbx_hashset_iter_t *iter)
 	if (ITER_FINISH == iter->slot)
 		return NULL;
 
+	if (ZBX_HASHSET_OPEN == iter->hashset->type)
+		return hashset_open_iter_next(iter);
+
 	if (ITER_START != iter->slot && NULL != iter->entry && NULL != iter->entry->next)
 	{
 		iter->entry = iter->entry->next;
@@ -423,6 +764,12 @@ void	zbx_hashset_iter_remove(zbx_hashset_iter_t *iter)
 		exit(EXIT_FAILURE);
 	}
 
+	if (ZBX_HASHSET_OPEN == iter->hashset->type)
+	{
+		hashset_open_iter_remove(iter);
+		return;
+	}
+
 	if (iter->hashset->slots[iter->slot] == iter->entry)
 	{
 		iter->hashset->slots[iter->slot] = iter->entry->next;
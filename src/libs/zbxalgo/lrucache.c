@@ -0,0 +1,145 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "zbxalgo.h"
+
+static void	lrucache_unlink(zbx_lrucache_t *cache, zbx_lrucache_link_t *link)
+{
+	if (NULL != link->prev)
+		link->prev->next = link->next;
+	else
+		cache->head = link->next;
+
+	if (NULL != link->next)
+		link->next->prev = link->prev;
+	else
+		cache->tail = link->prev;
+}
+
+static void	lrucache_link_head(zbx_lrucache_t *cache, zbx_lrucache_link_t *link)
+{
+	link->prev = NULL;
+
+	if (NULL != (link->next = cache->head))
+		cache->head->prev = link;
+	else
+		cache->tail = link;
+
+	cache->head = link;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_lrucache_search                                              *
+ *                                                                            *
+ * Purpose: search cache for the entry and mark it as the most recently used  *
+ *                                                                            *
+ * Parameters: cache - [IN] the cache                                         *
+ *             data  - [IN] the data with key fields of the entry             *
+ *                                                                            *
+ * Return value: the cached entry or NULL if it was not found                 *
+ *                                                                            *
+ * Comments: The search is counted as cache hit or miss.                      *
+ *                                                                            *
+ ******************************************************************************/
+void	*zbx_lrucache_search(zbx_lrucache_t *cache, const void *data)
+{
+	zbx_lrucache_link_t	*link;
+
+	if (NULL == cache->entries.slots ||
+			NULL == (link = (zbx_lrucache_link_t *)zbx_hashset_search(&cache->entries, data)))
+	{
+		cache->misses++;
+		return NULL;
+	}
+
+	cache->hits++;
+
+	if (link != cache->head)
+	{
+		lrucache_unlink(cache, link);
+		lrucache_link_head(cache, link);
+	}
+
+	return link;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_lrucache_insert                                              *
+ *                                                                            *
+ * Purpose: insert new entry into cache as the most recently used             *
+ *                                                                            *
+ * Parameters: cache - [IN] the cache                                         *
+ *             data  - [IN] the entry data, starting with link                *
+ *             size  - [IN] the entry data size                               *
+ *                                                                            *
+ * Return value: the cached entry                                             *
+ *                                                                            *
+ * Comments: The entry must not be already cached. If the cache is full, the  *
+ *           least recently used entry is cleaned and removed. So an entry    *
+ *           stays valid until at least another max_size - 1 entries are      *
+ *           inserted.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+void	*zbx_lrucache_insert(zbx_lrucache_t *cache, const void *data, size_t size)
+{
+	zbx_lrucache_link_t	*link;
+
+	if (NULL == cache->entries.slots)
+	{
+		zbx_hashset_create_ext(&cache->entries, (size_t)cache->max_size, cache->hash_func,
+				cache->compare_func, cache->clean_func, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+				ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+
+	if (cache->max_size <= cache->entries.num_data)
+	{
+		link = cache->tail;
+		lrucache_unlink(cache, link);
+		zbx_hashset_remove_direct(&cache->entries, link);
+		cache->evictions++;
+	}
+
+	link = (zbx_lrucache_link_t *)zbx_hashset_insert(&cache->entries, data, size);
+	lrucache_link_head(cache, link);
+
+	return link;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_lrucache_destroy                                             *
+ *                                                                            *
+ * Purpose: clean and remove all cached entries                               *
+ *                                                                            *
+ * Parameters: cache - [IN] the cache                                         *
+ *                                                                            *
+ * Comments: The cache can be used again after it was destroyed.              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_lrucache_destroy(zbx_lrucache_t *cache)
+{
+	if (NULL != cache->entries.slots)
+		zbx_hashset_destroy(&cache->entries);
+
+	cache->head = NULL;
+	cache->tail = NULL;
+}
@@ -262,36 +262,29 @@ void xml_escape_xpath(char **data)
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_query_xpath                                                  *
+ * Function: zbx_xml_doc_open                                                 *
  *                                                                            *
- * Purpose: execute xpath query                                               *
+ * Purpose: parse xml document to be used in xpath queries                    *
  *                                                                            *
- * Parameters: value  - [IN/OUT] the value to process                         *
- *             params - [IN] the operation parameters                         *
- *             errmsg - [OUT] error message                                   *
+ * Parameters: data    - [IN] the xml data                                    *
+ *             xml_doc - [OUT] the parsed document                            *
+ *             errmsg  - [OUT] error message                                  *
  *                                                                            *
- * Return value: SUCCEED - the value was processed successfully               *
+ * Return value: SUCCEED - the document was parsed successfully               *
  *               FAIL - otherwise                                             *
  *                                                                            *
  ******************************************************************************/
-int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
+int	zbx_xml_doc_open(const char *data, void **xml_doc, char **errmsg)
 {
 #ifndef HAVE_LIBXML2
-	ZBX_UNUSED(value);
-	ZBX_UNUSED(params);
+	ZBX_UNUSED(data);
+	ZBX_UNUSED(xml_doc);
 	*errmsg = zbx_dsprintf(*errmsg, "Zabbix was compiled without libxml2 support");
 	return FAIL;
 #else
-	int		i, ret = FAIL;
-	char		buffer[32], *ptr;
-	xmlDoc		*doc = NULL;
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
-	xmlNodeSetPtr	nodeset;
 	xmlErrorPtr	pErr;
-	xmlBufferPtr	xmlBufferLocal;
 
-	if (NULL == (doc = xmlReadMemory(value->data.str, strlen(value->data.str), "noname.xml", NULL, 0)))
+	if (NULL == (*xml_doc = xmlReadMemory(data, strlen(data), "noname.xml", NULL, 0)))
 	{
 		if (NULL != (pErr = xmlGetLastError()))
 			*errmsg = zbx_dsprintf(*errmsg, "cannot parse xml value: %s", pErr->message);
@@ -300,6 +293,60 @@ int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
 		return FAIL;
 	}
 
+	return SUCCEED;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_xml_doc_close                                                *
+ *                                                                            *
+ * Purpose: free xml document parsed by zbx_xml_doc_open()                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_xml_doc_close(void *xml_doc)
+{
+#ifndef HAVE_LIBXML2
+	ZBX_UNUSED(xml_doc);
+#else
+	xmlFreeDoc((xmlDoc *)xml_doc);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_query_xpath_doc                                              *
+ *                                                                            *
+ * Purpose: execute xpath query on parsed xml document                        *
+ *                                                                            *
+ * Parameters: xml_doc - [IN] the parsed xml document                         *
+ *             value   - [OUT] the query result, the old value is replaced    *
+ *                             only on success                                *
+ *             params  - [IN] the operation parameters                        *
+ *             errmsg  - [OUT] error message                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the query was executed successfully                *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_query_xpath_doc(void *xml_doc, zbx_variant_t *value, const char *params, char **errmsg)
+{
+#ifndef HAVE_LIBXML2
+	ZBX_UNUSED(xml_doc);
+	ZBX_UNUSED(value);
+	ZBX_UNUSED(params);
+	*errmsg = zbx_dsprintf(*errmsg, "Zabbix was compiled without libxml2 support");
+	return FAIL;
+#else
+	int		i, ret = FAIL;
+	char		buffer[32], *ptr;
+	xmlDoc		*doc = (xmlDoc *)xml_doc;
+	xmlXPathContext	*xpathCtx;
+	xmlXPathObject	*xpathObj;
+	xmlNodeSetPtr	nodeset;
+	xmlErrorPtr	pErr;
+	xmlBufferPtr	xmlBufferLocal;
+
 	xpathCtx = xmlXPathNewContext(doc);
 
 	if (NULL == (xpathObj = xmlXPathEvalExpression((xmlChar *)params, xpathCtx)))
@@ -364,12 +411,39 @@ int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
 out:
 	xmlXPathFreeObject(xpathObj);
 	xmlXPathFreeContext(xpathCtx);
-	xmlFreeDoc(doc);
 
 	return ret;
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_query_xpath                                                  *
+ *                                                                            *
+ * Purpose: execute xpath query                                               *
+ *                                                                            *
+ * Parameters: value  - [IN/OUT] the value to process                         *
+ *             params - [IN] the operation parameters                         *
+ *             errmsg - [OUT] error message                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the value was processed successfully               *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
+{
+	void	*doc;
+	int	ret;
+
+	if (SUCCEED != zbx_xml_doc_open(value->data.str, &doc, errmsg))
+		return FAIL;
+
+	ret = zbx_query_xpath_doc(doc, value, params, errmsg);
+	zbx_xml_doc_close(doc);
+
+	return ret;
+}
+
 #ifdef HAVE_LIBXML2
 /******************************************************************************
  *                                                                            *
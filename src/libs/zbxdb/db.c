@@ -99,6 +99,22 @@ static PGconn			*conn = NULL;
 static unsigned int		ZBX_PG_BYTEAOID = 0;
 static int			ZBX_PG_SVERSION = 0, ZBX_TSDB_VERSION = -1;
 char				ZBX_PG_ESCAPE_BACKSLASH = 1;
+
+/* statements prepared in the current connection, the statement name is based on its index */
+static char			**pg_statements = NULL;
+static int			pg_statements_num = 0;
+
+#ifdef LIBPQ_HAS_PIPELINING
+/* separate connection for pipelined writes, its statements are confirmed by zbx_db_pipeline_wait() */
+static PGconn			*pipeline_conn = NULL;
+static char			*pipeline_dbschema = NULL;
+static int			pipeline_syncs_num = 0, pipeline_error = ZBX_DB_OK;
+/* transaction of the queued statements is started, its id is selected by the first statement */
+static int			pipeline_txn = 0;
+/* the last transaction lost connection after its commit was sent, so it might have been committed */
+static int			pipeline_unconfirmed = 0;
+static zbx_uint64_t		pipeline_xid = 0;
+#endif
 #elif defined(HAVE_SQLITE3)
 static sqlite3			*conn = NULL;
 static zbx_mutex_t		sqlite_access = ZBX_MUTEX_NULL;
@@ -332,6 +348,21 @@ static int	is_recoverable_postgresql_error(const PGconn *pg_conn, const PGresult
 
 	return FAIL;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_pg_statements_clear                                           *
+ *                                                                            *
+ * Purpose: forget statements prepared in the current connection              *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_pg_statements_clear(void)
+{
+	while (0 < pg_statements_num)
+		zbx_free(pg_statements[--pg_statements_num]);
+
+	zbx_free(pg_statements);
+}
 #endif
 
 /******************************************************************************
@@ -764,6 +795,9 @@ int	zbx_db_connect(char *host, char *user, char *password, char *dbname, char *d
 	if (NULL != dbschema && '\0' != *dbschema)
 	{
 		char	*dbschema_esc;
+#ifdef LIBPQ_HAS_PIPELINING
+		pipeline_dbschema = zbx_strdup(pipeline_dbschema, dbschema);
+#endif
 
 		dbschema_esc = zbx_db_dyn_escape_string(dbschema, ZBX_SIZE_T_MAX, ZBX_SIZE_T_MAX, ESCAPE_SEQUENCE_ON);
 		if (ZBX_DB_DOWN == (rc = zbx_db_execute("set schema '%s'", dbschema_esc)) || ZBX_DB_FAIL == rc)
@@ -985,6 +1019,8 @@ void	zbx_db_close(void)
 		PQfinish(conn);
 		conn = NULL;
 	}
+
+	db_pg_statements_clear();
 #elif defined(HAVE_SQLITE3)
 	if (NULL != conn)
 	{
@@ -1568,6 +1604,639 @@ clean:
 	return ret;
 }
 
+#if defined(HAVE_POSTGRESQL)
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy_start                                                *
+ *                                                                            *
+ * Purpose: start COPY FROM STDIN operation                                   *
+ *                                                                            *
+ * Parameters: sql - [IN] the copy statement                                  *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the server is ready to receive data              *
+ *               ZBX_DB_FAIL - the statement failed                           *
+ *               ZBX_DB_DOWN - the statement failed with recoverable error    *
+ *                                                                            *
+ * Comments: The data is sent with zbx_db_copy_put() and the operation must   *
+ *           be completed with zbx_db_copy_end().                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_start(const char *sql)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = ZBX_DB_OK;
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level, sql);
+		return ZBX_DB_FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+
+	result = PQexec(conn, sql);
+
+	if (NULL == result)
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+	else if (PGRES_COPY_IN != PQresultStatus(result))
+	{
+		zbx_postgresql_error(&error, result);
+		zbx_db_errlog(ERR_Z3005, 0, error, sql);
+		zbx_free(error);
+
+		ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+	}
+
+	PQclear(result);
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy_put                                                  *
+ *                                                                            *
+ * Purpose: send data of started COPY FROM STDIN operation                    *
+ *                                                                            *
+ * Parameters: data     - [IN] the data in COPY text format                   *
+ *             data_len - [IN] the data length                                *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the data was sent                                *
+ *               ZBX_DB_DOWN - connection error                               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_put(const char *data, size_t data_len)
+{
+	if (1 != PQputCopyData(conn, data, (int)data_len))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), "copy data");
+		return ZBX_DB_DOWN;
+	}
+
+	return ZBX_DB_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy_end                                                  *
+ *                                                                            *
+ * Purpose: complete COPY FROM STDIN operation                                *
+ *                                                                            *
+ * Parameters: sql - [IN] the copy statement, used for error reporting        *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows copied (on success)                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_end(const char *sql)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = ZBX_DB_OK;
+
+	if (1 != PQputCopyEnd(conn, NULL))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), sql);
+		ret = ZBX_DB_DOWN;
+	}
+
+	while (NULL != (result = PQgetResult(conn)))
+	{
+		if (ZBX_DB_OK == ret)
+		{
+			if (PGRES_COMMAND_OK != PQresultStatus(result))
+			{
+				zbx_postgresql_error(&error, result);
+				zbx_db_errlog(ERR_Z3005, 0, error, sql);
+				zbx_free(error);
+
+				ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN :
+						ZBX_DB_FAIL);
+			}
+			else
+				ret = atoi(PQcmdTuples(result));
+		}
+
+		PQclear(result);
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_execute_prepared                                          *
+ *                                                                            *
+ * Purpose: execute non-select statement using server side prepared plan      *
+ *                                                                            *
+ * Parameters: sql        - [IN] the statement with $1, $2, ... parameters    *
+ *             params     - [IN] the parameter values in text format          *
+ *             params_num - [IN] the number of parameters                     *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows affected (on success)                      *
+ *                                                                            *
+ * Comments: The statement is prepared on first execution and reused until    *
+ *           the connection is closed, so it must have fixed text.            *
+ *           If the server has discarded prepared statements (for example     *
+ *           connection pooler has reset the session) the cache is dropped.   *
+ *           Outside transaction the statement is prepared and executed       *
+ *           again, within transaction it's aborted on server side, so the    *
+ *           transaction is marked as failed with ZBX_DB_DOWN to be repeated  *
+ *           by the caller.                                                   *
+ *           Only PostgreSQL is supported, with other databases the callers   *
+ *           use text statements.                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_execute_prepared(const char *sql, const char * const *params, int params_num)
+{
+	PGresult	*result;
+	char		*error = NULL, name[32];
+	int		ret = ZBX_DB_OK, i, txn_error_new = ZBX_DB_FAIL, prepared = 0;
+	double		sec = 0;
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+		sec = zbx_time();
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level, sql);
+		return ZBX_DB_FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+retry:
+	for (i = 0; i < pg_statements_num; i++)
+	{
+		if (0 == strcmp(pg_statements[i], sql))
+			break;
+	}
+
+	zbx_snprintf(name, sizeof(name), "zbx_stmt_%d", i);
+
+	if (i == pg_statements_num)
+	{
+		result = PQprepare(conn, name, sql, params_num, NULL);
+
+		if (NULL == result)
+		{
+			zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+			ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+		}
+		else if (PGRES_COMMAND_OK != PQresultStatus(result))
+		{
+			zbx_postgresql_error(&error, result);
+			zbx_db_errlog(ERR_Z3005, 0, error, sql);
+			zbx_free(error);
+
+			ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+		}
+		else
+		{
+			pg_statements = (char **)zbx_realloc(pg_statements, (pg_statements_num + 1) * sizeof(char *));
+			pg_statements[pg_statements_num++] = zbx_strdup(NULL, sql);
+			prepared = 1;
+		}
+
+		PQclear(result);
+
+		if (ZBX_DB_OK != ret)
+			goto out;
+	}
+
+	result = PQexecPrepared(conn, name, params_num, params, NULL, NULL, 0);
+
+	if (NULL == result)
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+	else if (0 == prepared && 0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), "26000"))
+	{
+		/* invalid_sql_statement_name - the statements were discarded on server side */
+		zabbix_log(LOG_LEVEL_DEBUG, "prepared statement \"%s\" does not exist, dropping statement cache", name);
+		db_pg_statements_clear();
+		PQclear(result);
+
+		if (0 == txn_level)
+			goto retry;
+
+		ret = ZBX_DB_FAIL;
+		txn_error_new = ZBX_DB_DOWN;
+		goto out;
+	}
+	else if (PGRES_COMMAND_OK != PQresultStatus(result))
+	{
+		zbx_postgresql_error(&error, result);
+		zbx_db_errlog(ERR_Z3005, 0, error, sql);
+		zbx_free(error);
+
+		ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+	}
+
+	if (ZBX_DB_OK == ret)
+		ret = atoi(PQcmdTuples(result));
+
+	PQclear(result);
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)CONFIG_LOG_SLOW_QUERIES / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+out:
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = txn_error_new;
+	}
+
+	return ret;
+}
+
+#ifdef LIBPQ_HAS_PIPELINING
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_pipeline_close                                            *
+ *                                                                            *
+ * Purpose: close pipelined writes connection                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_db_pipeline_close(void)
+{
+	if (NULL != pipeline_conn)
+	{
+		PQfinish(pipeline_conn);
+		pipeline_conn = NULL;
+	}
+
+	pipeline_txn = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_pipeline_send                                             *
+ *                                                                            *
+ * Purpose: send statement to the pipelined writes connection                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_db_pipeline_send(const char *sql)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "pipeline query [%s]", sql);
+
+	if (1 != PQsendQueryParams(pipeline_conn, sql, 0, NULL, NULL, NULL, NULL, 0))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(pipeline_conn), sql);
+		zbx_db_pipeline_close();
+
+		return pipeline_error = ZBX_DB_DOWN;
+	}
+
+	return ZBX_DB_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_pipeline_connect                                          *
+ *                                                                            *
+ * Purpose: open pipelined writes connection with the same parameters as the  *
+ *          main connection                                                   *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - successfully connected                           *
+ *               ZBX_DB_DOWN - database is down                               *
+ *               ZBX_DB_FAIL - failed to connect                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_db_pipeline_connect(void)
+{
+	PQconninfoOption	*options, *option;
+	const char		**keywords, **values;
+	char			*error = NULL;
+	int			ret = ZBX_DB_OK, i = 0;
+
+	if (NULL == conn || NULL == (options = PQconninfo(conn)))
+		return ZBX_DB_DOWN;
+
+	for (option = options; NULL != option->keyword; option++)
+		i++;
+
+	keywords = (const char **)zbx_malloc(NULL, sizeof(char *) * (size_t)(i + 1));
+	values = (const char **)zbx_malloc(NULL, sizeof(char *) * (size_t)(i + 1));
+
+	for (i = 0, option = options; NULL != option->keyword; option++)
+	{
+		if (NULL == option->val || '\0' == *option->val)
+			continue;
+
+		keywords[i] = option->keyword;
+		values[i++] = option->val;
+	}
+
+	keywords[i] = NULL;
+	values[i] = NULL;
+
+	pipeline_conn = PQconnectdbParams(keywords, values, 0);
+
+	zbx_free(values);
+	zbx_free(keywords);
+	PQconninfoFree(options);
+
+	if (CONNECTION_OK != PQstatus(pipeline_conn))
+	{
+		zbx_db_errlog(ERR_Z3001, 0, PQerrorMessage(pipeline_conn), PQdb(conn));
+		ret = ZBX_DB_DOWN;
+		goto out;
+	}
+
+	if (NULL != pipeline_dbschema)
+	{
+		PGresult	*result;
+		char		*dbschema_esc, *sql;
+
+		dbschema_esc = zbx_db_dyn_escape_string(pipeline_dbschema, ZBX_SIZE_T_MAX, ZBX_SIZE_T_MAX,
+				ESCAPE_SEQUENCE_ON);
+		sql = zbx_dsprintf(NULL, "set schema '%s'", dbschema_esc);
+		result = PQexec(pipeline_conn, sql);
+
+		if (PGRES_COMMAND_OK != PQresultStatus(result))
+		{
+			zbx_postgresql_error(&error, result);
+			zbx_db_errlog(ERR_Z3005, 0, error, sql);
+			zbx_free(error);
+
+			ret = (SUCCEED == is_recoverable_postgresql_error(pipeline_conn, result) ? ZBX_DB_DOWN :
+					ZBX_DB_FAIL);
+		}
+
+		PQclear(result);
+		zbx_free(sql);
+		zbx_free(dbschema_esc);
+
+		if (ZBX_DB_OK != ret)
+			goto out;
+	}
+
+	if (1 != PQenterPipelineMode(pipeline_conn))
+	{
+		zbx_db_errlog(ERR_Z3001, 0, PQerrorMessage(pipeline_conn), PQdb(conn));
+		ret = ZBX_DB_FAIL;
+	}
+out:
+	if (ZBX_DB_OK != ret)
+		zbx_db_pipeline_close();
+
+	return ret;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_pipeline_available                                        *
+ *                                                                            *
+ * Purpose: check if pipelined writes are supported by the client library     *
+ *                                                                            *
+ * Return value: SUCCEED - pipelined writes are supported                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_pipeline_available(void)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	return SUCCEED;
+#else
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_pipeline_execute                                          *
+ *                                                                            *
+ * Purpose: queue non-select statement in the pipelined writes connection     *
+ *                                                                            *
+ * Parameters: sql - [IN] the statement                                       *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the statement was queued                         *
+ *               ZBX_DB_FAIL or ZBX_DB_DOWN - otherwise                       *
+ *                                                                            *
+ * Comments: Statements queued until zbx_db_pipeline_sync() call are executed *
+ *           in a single implicit transaction. The database does not wait     *
+ *           for the client to read results, so the caller can continue with  *
+ *           other work and check the outcome with zbx_db_pipeline_wait().    *
+ *           After error the following statements are ignored until           *
+ *           zbx_db_pipeline_wait() reports it.                               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_pipeline_execute(const char *sql)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	if (ZBX_DB_OK != pipeline_error)
+		return pipeline_error;
+
+	if (NULL == pipeline_conn && ZBX_DB_OK != (pipeline_error = zbx_db_pipeline_connect()))
+		return pipeline_error;
+
+	/* transaction id allows to check if it was committed when connection is lost before the results are read */
+	if (0 == pipeline_txn)
+	{
+		if (ZBX_DB_OK != zbx_db_pipeline_send("select txid_current()"))
+			return pipeline_error;
+
+		pipeline_txn = 1;
+	}
+
+	return zbx_db_pipeline_send(sql);
+#else
+	ZBX_UNUSED(sql);
+
+	return ZBX_DB_FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_pipeline_sync                                             *
+ *                                                                            *
+ * Purpose: commit statements queued in the pipelined writes connection and   *
+ *          send them to database without waiting for the results             *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the statements were sent                         *
+ *               ZBX_DB_FAIL or ZBX_DB_DOWN - otherwise                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_pipeline_sync(void)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	if (ZBX_DB_OK != pipeline_error)
+		return pipeline_error;
+
+	if (NULL == pipeline_conn)
+		return ZBX_DB_OK;
+
+	if (1 != PQpipelineSync(pipeline_conn))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(pipeline_conn), "pipeline sync");
+		zbx_db_pipeline_close();
+
+		return pipeline_error = ZBX_DB_DOWN;
+	}
+
+	/* from now on the commit might reach database, the outcome is checked by zbx_db_pipeline_wait() */
+	pipeline_syncs_num++;
+	pipeline_txn = 0;
+
+	if (0 != PQflush(pipeline_conn))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(pipeline_conn), "pipeline sync");
+		zbx_db_pipeline_close();
+
+		return pipeline_error = ZBX_DB_DOWN;
+	}
+
+	return ZBX_DB_OK;
+#else
+	return ZBX_DB_FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_pipeline_wait                                             *
+ *                                                                            *
+ * Purpose: wait for the results of statements sent by zbx_db_pipeline_sync() *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the statements were committed                    *
+ *               ZBX_DB_FAIL - the statements failed and were rolled back     *
+ *               ZBX_DB_DOWN - the connection was lost, check                 *
+ *                             zbx_db_pipeline_unconfirmed() before sending   *
+ *                             the statements again                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_pipeline_wait(void)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = pipeline_error, results_num = 0, aborted = 0;
+
+	pipeline_unconfirmed = 0;
+	pipeline_xid = 0;
+
+	/* each statement results are terminated by NULL, the synchronization point ends the transaction */
+	while (0 < pipeline_syncs_num && NULL != pipeline_conn)
+	{
+		if (NULL == (result = PQgetResult(pipeline_conn)))
+		{
+			if (0 == results_num || CONNECTION_OK != PQstatus(pipeline_conn))
+			{
+				zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(pipeline_conn), "pipeline sync");
+				ret = ZBX_DB_DOWN;
+				break;
+			}
+
+			results_num = 0;
+			continue;
+		}
+
+		results_num++;
+
+		switch (PQresultStatus(result))
+		{
+			case PGRES_PIPELINE_SYNC:
+				pipeline_syncs_num--;
+				results_num = 0;
+				break;
+			case PGRES_TUPLES_OK:
+				if (1 == PQntuples(result) && 1 == PQnfields(result))
+					ZBX_STR2UINT64(pipeline_xid, PQgetvalue(result, 0, 0));
+				break;
+			case PGRES_COMMAND_OK:
+			case PGRES_PIPELINE_ABORTED:
+				break;
+			default:
+				zbx_postgresql_error(&error, result);
+				zbx_db_errlog(ERR_Z3005, 0, error, "pipelined query");
+				zbx_free(error);
+				aborted = 1;
+
+				if (ZBX_DB_DOWN != ret)
+				{
+					ret = (SUCCEED == is_recoverable_postgresql_error(pipeline_conn, result) ?
+							ZBX_DB_DOWN : ZBX_DB_FAIL);
+				}
+		}
+
+		PQclear(result);
+	}
+
+	/* failed statement rolls back the transaction, otherwise the commit result was lost */
+	if (0 < pipeline_syncs_num && 0 == aborted)
+		pipeline_unconfirmed = 1;
+
+	pipeline_syncs_num = 0;
+	pipeline_error = ZBX_DB_OK;
+
+	if (ZBX_DB_DOWN == ret)
+		zbx_db_pipeline_close();
+
+	return ret;
+#else
+	return ZBX_DB_OK;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_pipeline_unconfirmed                                      *
+ *                                                                            *
+ * Purpose: check if the statements reported down by zbx_db_pipeline_wait()   *
+ *          might have been committed                                         *
+ *                                                                            *
+ * Parameters: xid - [OUT] the transaction id or 0 if it was not received     *
+ *                                                                            *
+ * Return value: SUCCEED - the connection was lost after the commit was sent, *
+ *                         check transaction status before sending the        *
+ *                         statements again                                   *
+ *               FAIL    - the statements were not committed                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_pipeline_unconfirmed(zbx_uint64_t *xid)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	*xid = pipeline_xid;
+
+	return 0 == pipeline_unconfirmed ? FAIL : SUCCEED;
+#else
+	*xid = 0;
+
+	return FAIL;
+#endif
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_vselect                                                   *
@@ -42,18 +42,27 @@
 #include "zbxalgo.h"
 #include "../zbxalgo/vectorimpl.h"
 
+/* the number of independently locked history cache shards, every shard needs  */
+/* its own mutex (ZBX_MUTEX_CACHE, ZBX_MUTEX_CACHE_1 ... ZBX_MUTEX_CACHE_3)      */
+#define ZBX_HC_SHARDS_NUM	4
+
+/* history cache allocators of the currently locked shard */
 static zbx_mem_info_t	*hc_index_mem = NULL;
 static zbx_mem_info_t	*hc_mem = NULL;
 static zbx_mem_info_t	*trend_mem = NULL;
 
-#define	LOCK_CACHE	zbx_mutex_lock(cache_lock)
-#define	UNLOCK_CACHE	zbx_mutex_unlock(cache_lock)
+static zbx_mem_info_t	*hc_shard_index_mem[ZBX_HC_SHARDS_NUM];
+static zbx_mem_info_t	*hc_shard_mem[ZBX_HC_SHARDS_NUM];
+static zbx_mutex_t	hc_shard_lock[ZBX_HC_SHARDS_NUM];
+
+/* the first shard lock also protects the global history cache data */
+#define	LOCK_CACHE	hc_lock_shard(0)
+#define	UNLOCK_CACHE	hc_unlock_shard(0)
 #define	LOCK_TRENDS	zbx_mutex_lock(trends_lock)
 #define	UNLOCK_TRENDS	zbx_mutex_unlock(trends_lock)
 #define	LOCK_CACHE_IDS		zbx_mutex_lock(cache_ids_lock)
 #define	UNLOCK_CACHE_IDS	zbx_mutex_unlock(cache_ids_lock)
 
-static zbx_mutex_t	cache_lock = ZBX_MUTEX_NULL;
 static zbx_mutex_t	trends_lock = ZBX_MUTEX_NULL;
 static zbx_mutex_t	cache_ids_lock = ZBX_MUTEX_NULL;
 
@@ -61,7 +70,10 @@ static char		*sql = NULL;
 static size_t		sql_alloc = 4 * ZBX_KIBIBYTE;
 
 extern unsigned char	program_type;
+extern int		process_num;
 extern int		CONFIG_DOUBLE_PRECISION;
+extern int		CONFIG_HISTSYNCER_FORKS;
+extern int		sync_in_progress;
 
 #define ZBX_IDS_SIZE	9
 
@@ -116,13 +128,19 @@ zbx_hc_proxyqueue_t;
 
 typedef struct
 {
-	zbx_hashset_t		trends;
+	zbx_hashset_t		history_items;
+	zbx_binary_heap_t	*history_queues;	/* a queue per history syncer */
 	ZBX_DC_STATS		stats;
+	int			history_num;
+}
+zbx_hc_shard_t;
 
-	zbx_hashset_t		history_items;
-	zbx_binary_heap_t	history_queue;
+typedef struct
+{
+	zbx_hashset_t		trends;
+
+	zbx_hc_shard_t		shards[ZBX_HC_SHARDS_NUM];
 
-	int			history_num;
 	int			trends_num;
 	int			trends_last_cleanup_hour;
 	int			history_num_total;
@@ -136,6 +154,89 @@ ZBX_DC_CACHE;
 
 static ZBX_DC_CACHE	*cache = NULL;
 
+/* all items are queued to the first history syncer queue during full history cache sync */
+static unsigned char	hc_sync_full = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_shard                                                     *
+ *                                                                            *
+ * Purpose: returns index of the history cache shard storing item values      *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item identifier                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_shard(zbx_uint64_t itemid)
+{
+	return (int)(ZBX_DEFAULT_UINT64_HASH_FUNC(&itemid) % ZBX_HC_SHARDS_NUM);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_lock_shard                                                    *
+ *                                                                            *
+ * Purpose: locks history cache shard and selects its memory allocators       *
+ *                                                                            *
+ * Parameters: shard - [IN] the shard index                                   *
+ *                                                                            *
+ * Comments: Shards must be locked one at a time or in ascending order to     *
+ *           avoid deadlocks.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_lock_shard(int shard)
+{
+	zbx_mutex_lock(hc_shard_lock[shard]);
+
+	hc_mem = hc_shard_mem[shard];
+	hc_index_mem = hc_shard_index_mem[shard];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_unlock_shard                                                  *
+ *                                                                            *
+ * Purpose: unlocks history cache shard                                       *
+ *                                                                            *
+ * Parameters: shard - [IN] the shard index                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_unlock_shard(int shard)
+{
+	zbx_mutex_unlock(hc_shard_lock[shard]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_syncer                                                    *
+ *                                                                            *
+ * Purpose: returns index of the history syncer owning synchronization group  *
+ *                                                                            *
+ * Parameters: syncgroupid - [IN] the item synchronization group              *
+ *                                                                            *
+ * Comments: Items sharing triggers belong to the same synchronization group, *
+ *           so their triggers are always recalculated by the same syncer.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_syncer(zbx_uint64_t syncgroupid)
+{
+	return (int)(ZBX_DEFAULT_UINT64_HASH_FUNC(&syncgroupid) % CONFIG_HISTSYNCER_FORKS);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_syncer_queue                                              *
+ *                                                                            *
+ * Purpose: returns index of the history queue processed by current process   *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_syncer_queue(void)
+{
+	if (0 != hc_sync_full || 0 >= process_num)
+		return 0;
+
+	return (process_num - 1) % CONFIG_HISTSYNCER_FORKS;
+}
+
 /* local history cache */
 #define ZBX_MAX_VALUES_LOCAL	256
 #define ZBX_STRUCT_REALLOC_STEP	8
@@ -171,6 +272,7 @@ typedef struct
 	unsigned char	value_type;
 	unsigned char	state;
 	unsigned char	flags;		/* see ZBX_DC_FLAG_* above */
+	int		syncer;		/* the history syncer owning item, set when flushing */
 }
 dc_item_value_t;
 
@@ -179,14 +281,17 @@ static size_t		string_values_alloc = 0, string_values_offset = 0;
 static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
 
-static void	hc_add_item_values(dc_item_value_t *values, int values_num);
+static void	hc_add_item_values(dc_item_value_t *values, int values_num, int shard);
 static void	hc_pop_items(zbx_vector_ptr_t *history_items);
 static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *history_items);
 static void	hc_push_items(zbx_vector_ptr_t *history_items);
 static void	hc_free_item_values(ZBX_DC_HISTORY *history, int history_num);
-static void	hc_queue_item(zbx_hc_item_t *item);
+static void	hc_queue_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 static int	hc_queue_get_size(void);
+static int	hc_get_history_num(void);
+static void	hc_get_stats(ZBX_DC_STATS *stats, zbx_uint64_t *free_size, zbx_uint64_t *total_size,
+		zbx_uint64_t *index_free_size, zbx_uint64_t *index_total_size);
 static int	hc_get_history_compression_age(void);
 
 ZBX_PTR_VECTOR_DECL(item_tag, zbx_tag_t)
@@ -203,13 +308,10 @@ ZBX_PTR_VECTOR_IMPL(item_tag, zbx_tag_t)
  ******************************************************************************/
 void	DCget_stats_all(zbx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
+	hc_get_stats(&wcache_info->stats, &wcache_info->history_free, &wcache_info->history_total,
+			&wcache_info->index_free, &wcache_info->index_total);
 
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+	LOCK_CACHE;
 
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 	{
@@ -234,57 +336,61 @@ void	*DCget_stats(int request)
 	static zbx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	ZBX_DC_STATS		stats;
+	zbx_uint64_t		history_free, history_total, index_free, index_total;
+
+	hc_get_stats(&stats, &history_free, &history_total, &index_free, &index_total);
 
 	LOCK_CACHE;
 
 	switch (request)
 	{
 		case ZBX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = history_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = history_total - history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(history_total - history_free) / history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)history_free / history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_TOTAL:
@@ -309,24 +415,24 @@ void	*DCget_stats(int request)
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = index_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = index_total - index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(index_total - index_free) /
+					index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)index_free / index_total;
 			ret = (void *)&value_double;
 			break;
 		default:
@@ -2900,13 +3006,9 @@ static void	sync_proxy_history(int *total_num, int *more)
 	{
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
-
 		hc_pop_items(&history_items);		/* select and take items out of history cache */
 		history_num = history_items.values_num;
 
-		UNLOCK_CACHE;
-
 		if (0 == history_num)
 			break;
 
@@ -2922,16 +3024,11 @@ static void	sync_proxy_history(int *total_num, int *more)
 		}
 		while (ZBX_DB_DOWN == DBcommit());
 
-		LOCK_CACHE;
-
 		hc_push_items(&history_items);	/* return items to history cache */
-		cache->history_num -= history_num;
 
 		if (0 != hc_queue_get_size())
 			*more = ZBX_SYNC_MORE;
 
-		UNLOCK_CACHE;
-
 		*total_num += history_num;
 
 		zbx_vector_ptr_clear(&history_items);
@@ -3043,17 +3140,13 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
 		hc_pop_items(&history_items);		/* select and take items out of history cache */
-		UNLOCK_CACHE;
 
 		if (0 != history_items.values_num)
 		{
 			if (0 == (history_num = DCconfig_lock_triggers_by_history_items(&history_items, &triggerids)))
 			{
-				LOCK_CACHE;
 				hc_push_items(&history_items);
-				UNLOCK_CACHE;
 				zbx_vector_ptr_clear(&history_items);
 			}
 		}
@@ -3185,9 +3278,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		if (0 != history_num)
 		{
-			LOCK_CACHE;
 			hc_push_items(&history_items);	/* return items to history cache */
-			cache->history_num -= history_num;
 
 			if (0 != hc_queue_get_size())
 			{
@@ -3200,8 +3291,6 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 					*more = ZBX_SYNC_MORE;
 			}
 
-			UNLOCK_CACHE;
-
 			*values_num += history_num;
 		}
 
@@ -3268,6 +3357,9 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	}
 	while (ZBX_SYNC_MORE == *more && ZBX_HC_SYNC_TIME_MAX >= time(NULL) - sync_start);
 
+	/* history of the last batch is written while triggers are recalculated, make sure it is stored */
+	zbx_vc_wait_values();
+
 	zbx_vector_ptr_destroy(&history_items);
 	zbx_vector_ptr_destroy(&inventory_values);
 	zbx_vector_ptr_destroy(&item_diff);
@@ -3293,12 +3385,12 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
  ******************************************************************************/
 static void	sync_history_cache_full(void)
 {
-	int			values_num = 0, triggers_num = 0, more;
+	int			values_num = 0, triggers_num = 0, more, i;
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
-	zbx_binary_heap_t	tmp_history_queue;
+	zbx_binary_heap_t	tmp_history_queue[ZBX_HC_SHARDS_NUM];
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	/* History index cache might be full without any space left for queueing items from history index to  */
 	/* history queue. The solution: replace the shared-memory history queue with heap-allocated one. Add  */
@@ -3317,18 +3409,27 @@ static void	sync_history_cache_full(void)
 		DCconfig_unlock_all_triggers();
 	}
 
-	tmp_history_queue = cache->history_queue;
-
-	zbx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
+	/* queue all items to a single history queue processed by this process */
+	hc_sync_full = 1;
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
 	{
-		if (NULL != item->tail)
+		zbx_hc_shard_t	*shard = &cache->shards[i];
+
+		tmp_history_queue[i] = shard->history_queues[0];
+
+		zbx_binary_heap_create(&shard->history_queues[0], hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY);
+		zbx_hashset_iter_reset(&shard->history_items, &iter);
+
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
 		{
-			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(shard, item);
+			}
 		}
 	}
 
@@ -3344,15 +3445,20 @@ static void	sync_history_cache_full(void)
 				sync_proxy_history(&values_num, &more);
 
 			zabbix_log(LOG_LEVEL_WARNING, "syncing history data... " ZBX_FS_DBL "%%",
-					(double)values_num / (cache->history_num + values_num) * 100);
+					(double)values_num / (hc_get_history_num() + values_num) * 100);
 		}
 		while (0 != hc_queue_get_size());
 
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	zbx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		zbx_binary_heap_destroy(&cache->shards[i].history_queues[0]);
+		cache->shards[i].history_queues[0] = tmp_history_queue[i];
+	}
+
+	hc_sync_full = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -3367,7 +3473,9 @@ static void	sync_history_cache_full(void)
 void	zbx_log_sync_history_cache_progress(void)
 {
 	double		pcnt = -1.0;
-	int		ts_last, ts_next, sec;
+	int		ts_last, ts_next, sec, history_num;
+
+	history_num = hc_get_history_num();
 
 	LOCK_CACHE;
 
@@ -3382,16 +3490,16 @@ void	zbx_log_sync_history_cache_progress(void)
 
 	if (0 == cache->history_progress_ts)
 	{
-		cache->history_num_total = cache->history_num;
+		cache->history_num_total = history_num;
 		cache->history_progress_ts = sec;
 	}
 
-	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == cache->history_num)
+	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == history_num)
 	{
 		if (0 != cache->history_num_total)
-			pcnt = 100 * (double)(cache->history_num_total - cache->history_num) / cache->history_num_total;
+			pcnt = 100 * (double)(cache->history_num_total - history_num) / cache->history_num_total;
 
-		cache->history_progress_ts = (0 == cache->history_num ? INT_MAX : sec);
+		cache->history_progress_ts = (0 == history_num ? INT_MAX : sec);
 	}
 
 	ts_next = cache->history_progress_ts;
@@ -3422,7 +3530,7 @@ void	zbx_log_sync_history_cache_progress(void)
  ******************************************************************************/
 void	zbx_sync_history_cache(int *values_num, int *triggers_num, int *more)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	*values_num = 0;
 	*triggers_num = 0;
@@ -3454,7 +3562,11 @@ static void	dc_string_buffer_realloc(size_t len)
 
 static dc_item_value_t	*dc_local_get_history_slot(void)
 {
-	if (ZBX_MAX_VALUES_LOCAL == item_values_num)
+	/* Values added by configuration cache synchronization (items becoming not supported) are kept in  */
+	/* local cache until the configuration cache lock is released - flushing requires item            */
+	/* synchronization groups from configuration cache and must not lock history cache while holding  */
+	/* configuration cache write lock. DCsync_configuration() flushes them after the items are synced. */
+	if (ZBX_MAX_VALUES_LOCAL <= item_values_num && 0 == sync_in_progress)
 		dc_flush_history();
 
 	if (item_values_alloc == item_values_num)
@@ -3782,16 +3894,45 @@ void	dc_add_history(zbx_uint64_t itemid, unsigned char item_value_type, unsigned
 
 void	dc_flush_history(void)
 {
+	int		i, j, num, values_num[ZBX_HC_SHARDS_NUM] = {0};
+	zbx_uint64_t	itemids[ZBX_MAX_VALUES_LOCAL], syncgroupids[ZBX_MAX_VALUES_LOCAL];
+
 	if (0 == item_values_num)
 		return;
 
-	LOCK_CACHE;
+	/* local cache can exceed ZBX_MAX_VALUES_LOCAL values during configuration sync, resolve in batches */
+	for (i = 0; i < (int)item_values_num; i += num)
+	{
+		num = MIN(ZBX_MAX_VALUES_LOCAL, (int)item_values_num - i);
 
-	hc_add_item_values(item_values, item_values_num);
+		for (j = 0; j < num; j++)
+			itemids[j] = item_values[i + j].itemid;
 
-	cache->history_num += item_values_num;
+		/* proxy does not process triggers, so every item is a group of its own */
+		if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
+			DCconfig_get_items_syncgroups(itemids, syncgroupids, num);
+		else
+			memcpy(syncgroupids, itemids, (size_t)num * sizeof(zbx_uint64_t));
 
-	UNLOCK_CACHE;
+		for (j = 0; j < num; j++)
+		{
+			item_values[i + j].syncer = hc_get_syncer(syncgroupids[j]);
+			values_num[hc_get_shard(item_values[i + j].itemid)]++;
+		}
+	}
+
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		if (0 == values_num[i])
+			continue;
+
+		hc_lock_shard(i);
+
+		hc_add_item_values(item_values, item_values_num, i);
+		cache->shards[i].history_num += values_num[i];
+
+		hc_unlock_shard(i);
+	}
 
 	item_values_num = 0;
 	string_values_offset = 0;
@@ -3870,14 +4011,15 @@ static void	hc_free_data(zbx_hc_data_t *data)
  *                                                                            *
  * Purpose: put back item into history queue                                  *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: shard - [IN] the history cache shard                           *
+ *             item  - [IN] history item                                      *
  *                                                                            *
  ******************************************************************************/
-static void	hc_queue_item(zbx_hc_item_t *item)
+static void	hc_queue_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item)
 {
 	zbx_binary_heap_elem_t	elem = {item->itemid, (const void *)item};
 
-	zbx_binary_heap_insert(&cache->history_queue, &elem);
+	zbx_binary_heap_insert(&shard->history_queues[0 == hc_sync_full ? item->syncer : 0], &elem);
 }
 
 /******************************************************************************
@@ -3886,15 +4028,16 @@ static void	hc_queue_item(zbx_hc_item_t *item)
  *                                                                            *
  * Purpose: returns history item by itemid                                    *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             itemid - [IN] the item id                                      *
  *                                                                            *
  * Return value: the history item or NULL if the requested item is not in     *
  *               history cache                                                *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
+static zbx_hc_item_t	*hc_get_item(zbx_hc_shard_t *shard, zbx_uint64_t itemid)
 {
-	return (zbx_hc_item_t *)zbx_hashset_search(&cache->history_items, &itemid);
+	return (zbx_hc_item_t *)zbx_hashset_search(&shard->history_items, &itemid);
 }
 
 /******************************************************************************
@@ -3903,17 +4046,19 @@ static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
  *                                                                            *
  * Purpose: adds a new item to history cache                                  *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
- *                      [IN] the item data                                    *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             itemid - [IN] the item id                                      *
+ *             syncer - [IN] the history syncer owning the item               *
+ *             data   - [IN] the item data                                    *
  *                                                                            *
  * Return value: the added history item                                       *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
+static zbx_hc_item_t	*hc_add_item(zbx_hc_shard_t *shard, zbx_uint64_t itemid, int syncer, zbx_hc_data_t *data)
 {
-	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, 0, data, data};
+	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, 0, syncer, data, data};
 
-	return (zbx_hc_item_t *)zbx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (zbx_hc_item_t *)zbx_hashset_insert(&shard->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
@@ -4020,6 +4165,7 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *                                                                            *
  * Parameters: data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
+ *             stats      - [IN/OUT] the statistics of the target shard       *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
  *               FAIL    - not enough memory                                  *
@@ -4028,7 +4174,7 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value, ZBX_DC_STATS *stats)
 {
 	if (NULL == *data)
 	{
@@ -4054,7 +4200,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		stats->notsupported_counter++;
 
 		return SUCCEED;
 	}
@@ -4066,8 +4212,8 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		stats->history_text_counter++;
+		stats->history_counter++;
 
 		return SUCCEED;
 	}
@@ -4105,23 +4251,23 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 		switch (item_value->item_value_type)
 		{
 			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
+				stats->history_float_counter++;
 				break;
 			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
+				stats->history_uint_counter++;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
+				stats->history_str_counter++;
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
+				stats->history_text_counter++;
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
+				stats->history_log_counter++;
 				break;
 		}
 
-		cache->stats.history_counter++;
+		stats->history_counter++;
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -4137,17 +4283,20 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
  *                                                                            *
  * Parameters: values     - [IN] the item values to add                       *
  *             values_num - [IN] the number of item values to add             *
+ *             shard      - [IN] the locked shard, values of items stored in  *
+ *                               other shards are skipped                     *
  *                                                                            *
- * Comments: If the history cache is full this function will wait until       *
+ * Comments: If the history cache shard is full this function will wait until *
  *           history syncers processes values freeing enough space to store   *
  *           the new value.                                                   *
  *                                                                            *
  ******************************************************************************/
-static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+static void	hc_add_item_values(dc_item_value_t *values, int values_num, int shard)
 {
 	dc_item_value_t	*item_value;
 	int		i;
 	zbx_hc_item_t	*item;
+	zbx_hc_shard_t	*hc_shard = &cache->shards[shard];
 
 	for (i = 0; i < values_num; i++)
 	{
@@ -4155,20 +4304,23 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 
 		item_value = &values[i];
 
-		while (SUCCEED != hc_clone_history_data(&data, item_value))
+		if (shard != hc_get_shard(item_value->itemid))
+			continue;
+
+		while (SUCCEED != hc_clone_history_data(&data, item_value, &hc_shard->stats))
 		{
-			UNLOCK_CACHE;
+			hc_unlock_shard(shard);
 
 			zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
 			sleep(1);
 
-			LOCK_CACHE;
+			hc_lock_shard(shard);
 		}
 
-		if (NULL == (item = hc_get_item(item_value->itemid)))
+		if (NULL == (item = hc_get_item(hc_shard, item_value->itemid)))
 		{
-			item = hc_add_item(item_value->itemid, data);
-			hc_queue_item(item);
+			item = hc_add_item(hc_shard, item_value->itemid, item_value->syncer, data);
+			hc_queue_item(hc_shard, item);
 		}
 		else
 		{
@@ -4254,20 +4406,42 @@ static void	hc_copy_history_data(ZBX_DC_HISTORY *history, zbx_uint64_t itemid, z
  * Comments: The history_items must be returned back to history cache with    *
  *           hc_push_items() function after they have been processed.         *
  *                                                                            *
+ *           Only items owned by the current history syncer are popped.       *
+ *           Shards are drained starting from a different shard on every      *
+ *           call and by every syncer, so parallel syncers mostly contend for *
+ *           different shard locks.                                           *
+ *                                                                            *
  ******************************************************************************/
 static void	hc_pop_items(zbx_vector_ptr_t *history_items)
 {
+	static int		pop_num = 0;
+	int			i, shard, queue;
 	zbx_binary_heap_elem_t	*elem;
 	zbx_hc_item_t		*item;
+	zbx_binary_heap_t	*history_queue;
+
+	queue = hc_get_syncer_queue();
 
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	for (i = 0; i < ZBX_HC_SHARDS_NUM && ZBX_HC_SYNC_MAX > history_items->values_num; i++)
 	{
-		elem = zbx_binary_heap_find_min(&cache->history_queue);
-		item = (zbx_hc_item_t *)elem->data;
-		zbx_vector_ptr_append(history_items, item);
+		shard = (process_num + pop_num + i) % ZBX_HC_SHARDS_NUM;
+		history_queue = &cache->shards[shard].history_queues[queue];
+
+		hc_lock_shard(shard);
 
-		zbx_binary_heap_remove_min(&cache->history_queue);
+		while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(history_queue))
+		{
+			elem = zbx_binary_heap_find_min(history_queue);
+			item = (zbx_hc_item_t *)elem->data;
+			zbx_vector_ptr_append(history_items, item);
+
+			zbx_binary_heap_remove_min(history_queue);
+		}
+
+		hc_unlock_shard(shard);
 	}
+
+	pop_num++;
 }
 
 /******************************************************************************
@@ -4314,32 +4488,52 @@ static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *histor
  ******************************************************************************/
 void	hc_push_items(zbx_vector_ptr_t *history_items)
 {
-	int		i;
+	int		i, shard, items_num[ZBX_HC_SHARDS_NUM] = {0};
 	zbx_hc_item_t	*item;
 	zbx_hc_data_t	*data_free;
+	zbx_hc_shard_t	*hc_shard;
 
 	for (i = 0; i < history_items->values_num; i++)
+		items_num[hc_get_shard(((zbx_hc_item_t *)history_items->values[i])->itemid)]++;
+
+	for (shard = 0; shard < ZBX_HC_SHARDS_NUM; shard++)
 	{
-		item = (zbx_hc_item_t *)history_items->values[i];
+		if (0 == items_num[shard])
+			continue;
+
+		hc_shard = &cache->shards[shard];
 
-		switch (item->status)
+		hc_lock_shard(shard);
+
+		for (i = 0; i < history_items->values_num; i++)
 		{
-			case ZBX_HC_ITEM_STATUS_BUSY:
-				/* reset item status before returning it to queue */
-				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-				hc_queue_item(item);
-				break;
-			case ZBX_HC_ITEM_STATUS_NORMAL:
-				item->values_num--;
-				data_free = item->tail;
-				item->tail = item->tail->next;
-				hc_free_data(data_free);
-				if (NULL == item->tail)
-					zbx_hashset_remove(&cache->history_items, item);
-				else
-					hc_queue_item(item);
-				break;
+			item = (zbx_hc_item_t *)history_items->values[i];
+
+			if (shard != hc_get_shard(item->itemid))
+				continue;
+
+			switch (item->status)
+			{
+				case ZBX_HC_ITEM_STATUS_BUSY:
+					/* reset item status before returning it to queue */
+					item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+					hc_queue_item(hc_shard, item);
+					break;
+				case ZBX_HC_ITEM_STATUS_NORMAL:
+					item->values_num--;
+					hc_shard->history_num--;
+					data_free = item->tail;
+					item->tail = item->tail->next;
+					hc_free_data(data_free);
+					if (NULL == item->tail)
+						zbx_hashset_remove(&hc_shard->history_items, item);
+					else
+						hc_queue_item(hc_shard, item);
+					break;
+			}
 		}
+
+		hc_unlock_shard(shard);
 	}
 }
 
@@ -4347,12 +4541,94 @@ void	hc_push_items(zbx_vector_ptr_t *history_items)
  *                                                                            *
  * Function: hc_queue_get_size                                                *
  *                                                                            *
- * Purpose: retrieve the size of history queue                                *
+ * Purpose: retrieve the size of history queue of the current history syncer   *
  *                                                                            *
  ******************************************************************************/
 int	hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	int	i, size = 0, queue;
+
+	queue = hc_get_syncer_queue();
+
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		hc_lock_shard(i);
+		size += cache->shards[i].history_queues[queue].elems_num;
+		hc_unlock_shard(i);
+	}
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_history_num                                               *
+ *                                                                            *
+ * Purpose: retrieve the number of values stored in history cache             *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_history_num(void)
+{
+	int	i, history_num = 0;
+
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		hc_lock_shard(i);
+		history_num += cache->shards[i].history_num;
+		hc_unlock_shard(i);
+	}
+
+	return history_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_stats                                                     *
+ *                                                                            *
+ * Purpose: retrieve value statistics and memory usage summed over all        *
+ *          history cache shards                                              *
+ *                                                                            *
+ * Parameters: stats            - [OUT] the value statistics (optional)       *
+ *             free_size        - [OUT] the free history cache size           *
+ *             total_size       - [OUT] the total history cache size          *
+ *             index_free_size  - [OUT] the free history index cache size     *
+ *             index_total_size - [OUT] the total history index cache size    *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_stats(ZBX_DC_STATS *stats, zbx_uint64_t *free_size, zbx_uint64_t *total_size,
+		zbx_uint64_t *index_free_size, zbx_uint64_t *index_total_size)
+{
+	int	i;
+
+	if (NULL != stats)
+		memset(stats, 0, sizeof(ZBX_DC_STATS));
+
+	*free_size = *total_size = *index_free_size = *index_total_size = 0;
+
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		hc_lock_shard(i);
+
+		if (NULL != stats)
+		{
+			const ZBX_DC_STATS	*shard_stats = &cache->shards[i].stats;
+
+			stats->history_counter += shard_stats->history_counter;
+			stats->history_float_counter += shard_stats->history_float_counter;
+			stats->history_uint_counter += shard_stats->history_uint_counter;
+			stats->history_str_counter += shard_stats->history_str_counter;
+			stats->history_log_counter += shard_stats->history_log_counter;
+			stats->history_text_counter += shard_stats->history_text_counter;
+			stats->notsupported_counter += shard_stats->notsupported_counter;
+		}
+
+		*free_size += hc_mem->free_size;
+		*total_size += hc_mem->total_size;
+		*index_free_size += hc_index_mem->free_size;
+		*index_total_size += hc_index_mem->total_size;
+
+		hc_unlock_shard(i);
+	}
 }
 
 int	hc_get_history_compression_age(void)
@@ -4434,40 +4710,64 @@ out:
  ******************************************************************************/
 int	init_database_cache(char **error)
 {
-	int	ret;
+	const zbx_mutex_name_t	shard_mutexes[ZBX_HC_SHARDS_NUM] = {ZBX_MUTEX_CACHE, ZBX_MUTEX_CACHE_1,
+					ZBX_MUTEX_CACHE_2, ZBX_MUTEX_CACHE_3};
+	int			ret, i, j;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (SUCCEED != (ret = zbx_mutex_create(&cache_lock, ZBX_MUTEX_CACHE, error)))
-		goto out;
-
 	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
 		goto out;
 
-	if (SUCCEED != (ret = zbx_mem_create(&hc_mem, CONFIG_HISTORY_CACHE_SIZE, "history cache",
-			"HistoryCacheSize", 1, error)))
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
 	{
-		goto out;
-	}
+		if (SUCCEED != (ret = zbx_mutex_create(&hc_shard_lock[i], shard_mutexes[i], error)))
+			goto out;
 
-	if (SUCCEED != (ret = zbx_mem_create(&hc_index_mem, CONFIG_HISTORY_INDEX_CACHE_SIZE, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
-	{
-		goto out;
+		if (SUCCEED != (ret = zbx_mem_create(&hc_shard_mem[i], CONFIG_HISTORY_CACHE_SIZE / ZBX_HC_SHARDS_NUM,
+				"history cache", "HistoryCacheSize", 1, error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_mem_create(&hc_shard_index_mem[i],
+				CONFIG_HISTORY_INDEX_CACHE_SIZE / ZBX_HC_SHARDS_NUM, "history index cache",
+				"HistoryIndexCacheSize", 0, error)))
+		{
+			goto out;
+		}
 	}
 
+	/* global history cache data is stored in the first shard */
+	hc_mem = hc_shard_mem[0];
+	hc_index_mem = hc_shard_index_mem[0];
+
 	cache = (ZBX_DC_CACHE *)__hc_index_mem_malloc_func(NULL, sizeof(ZBX_DC_CACHE));
 	memset(cache, 0, sizeof(ZBX_DC_CACHE));
 
 	ids = (ZBX_DC_IDS *)__hc_index_mem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
 	memset(ids, 0, sizeof(ZBX_DC_IDS));
 
-	zbx_hashset_create_ext(&cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		hc_index_mem = hc_shard_index_mem[i];
 
-	zbx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
+		zbx_hashset_create_ext(&cache->shards[i].history_items, ZBX_HC_ITEMS_INIT_SIZE / ZBX_HC_SHARDS_NUM,
+				ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+				__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
+
+		cache->shards[i].history_queues = (zbx_binary_heap_t *)__hc_index_mem_malloc_func(NULL,
+				sizeof(zbx_binary_heap_t) * CONFIG_HISTSYNCER_FORKS);
+
+		for (j = 0; j < CONFIG_HISTSYNCER_FORKS; j++)
+		{
+			zbx_binary_heap_create_ext(&cache->shards[i].history_queues[j], hc_queue_elem_compare_func,
+					ZBX_BINARY_HEAP_OPTION_EMPTY, __hc_index_mem_malloc_func,
+					__hc_index_mem_realloc_func, __hc_index_mem_free_func);
+		}
+	}
+
+	hc_index_mem = hc_shard_index_mem[0];
 
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 	{
@@ -4527,13 +4827,17 @@ static void	DCsync_all(void)
  ******************************************************************************/
 void	free_database_cache(void)
 {
+	int	i;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	DCsync_all();
 
 	cache = NULL;
 
-	zbx_mutex_destroy(&cache_lock);
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+		zbx_mutex_destroy(&hc_shard_lock[i]);
+
 	zbx_mutex_destroy(&cache_ids_lock);
 
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
@@ -4658,12 +4962,59 @@ out:
  ******************************************************************************/
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
 {
-	LOCK_CACHE;
+	int	i;
 
-	*values_num = cache->history_num;
-	*items_num = cache->history_items.num_data;
+	*values_num = 0;
+	*items_num = 0;
 
-	UNLOCK_CACHE;
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		hc_lock_shard(i);
+
+		*values_num += cache->shards[i].history_num;
+		*items_num += cache->shards[i].history_items.num_data;
+
+		hc_unlock_shard(i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_add_mem_stats                                                 *
+ *                                                                            *
+ * Purpose: adds shared memory allocator statistics of a history cache shard  *
+ *                                                                            *
+ * Parameters: stats     - [IN/OUT] the summary statistics                    *
+ *             mem_stats - [IN] the shard allocator statistics                *
+ *             shard     - [IN] the shard index                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_add_mem_stats(zbx_mem_stats_t *stats, const zbx_mem_stats_t *mem_stats, int shard)
+{
+	int	i;
+
+	if (0 == shard)
+	{
+		*stats = *mem_stats;
+		return;
+	}
+
+	stats->free_size += mem_stats->free_size;
+	stats->used_size += mem_stats->used_size;
+	stats->overhead += mem_stats->overhead;
+	stats->free_chunks += mem_stats->free_chunks;
+	stats->used_chunks += mem_stats->used_chunks;
+	stats->slabs_num += mem_stats->slabs_num;
+	stats->slab_objects += mem_stats->slab_objects;
+
+	if (stats->min_chunk_size > mem_stats->min_chunk_size)
+		stats->min_chunk_size = mem_stats->min_chunk_size;
+
+	if (stats->max_chunk_size < mem_stats->max_chunk_size)
+		stats->max_chunk_size = mem_stats->max_chunk_size;
+
+	for (i = 0; i < MEM_BUCKET_COUNT; i++)
+		stats->chunks_num[i] += mem_stats->chunks_num[i];
 }
 
 /******************************************************************************
@@ -4675,15 +5026,27 @@ void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
  ******************************************************************************/
 void	zbx_hc_get_mem_stats(zbx_mem_stats_t *data, zbx_mem_stats_t *index)
 {
-	LOCK_CACHE;
+	int		i;
+	zbx_mem_stats_t	mem_stats;
 
-	if (NULL != data)
-		zbx_mem_get_stats(hc_mem, data);
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		hc_lock_shard(i);
 
-	if (NULL != index)
-		zbx_mem_get_stats(hc_index_mem, index);
+		if (NULL != data)
+		{
+			zbx_mem_get_stats(hc_mem, &mem_stats);
+			hc_add_mem_stats(data, &mem_stats, i);
+		}
 
-	UNLOCK_CACHE;
+		if (NULL != index)
+		{
+			zbx_mem_get_stats(hc_index_mem, &mem_stats);
+			hc_add_mem_stats(index, &mem_stats, i);
+		}
+
+		hc_unlock_shard(i);
+	}
 }
 
 /******************************************************************************
@@ -4697,19 +5060,23 @@ void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items)
 {
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
+	int			i;
 
-	LOCK_CACHE;
+	for (i = 0; i < ZBX_HC_SHARDS_NUM; i++)
+	{
+		hc_lock_shard(i);
 
-	zbx_vector_uint64_pair_reserve(items, cache->history_items.num_data);
+		zbx_vector_uint64_pair_reserve(items, items->values_num + cache->shards[i].history_items.num_data);
 
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
-		zbx_vector_uint64_pair_append_ptr(items, &pair);
-	}
+		zbx_hashset_iter_reset(&cache->shards[i].history_items, &iter);
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
+			zbx_vector_uint64_pair_append_ptr(items, &pair);
+		}
 
-	UNLOCK_CACHE;
+		hc_unlock_shard(i);
+	}
 }
 
 /******************************************************************************
@@ -4837,14 +5204,16 @@ static void	zbx_hc_proxyqueue_clear(void)
  ******************************************************************************/
 int	zbx_hc_check_proxy(zbx_uint64_t proxyid)
 {
-	double	hc_pused;
-	int	ret;
+	double		hc_pused;
+	int		ret;
+	zbx_uint64_t	free_size, total_size, index_free_size, index_total_size;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxyid:"ZBX_FS_UI64, __func__, proxyid);
 
-	LOCK_CACHE;
+	hc_get_stats(NULL, &free_size, &total_size, &index_free_size, &index_total_size);
+	hc_pused = 100 * (double)(total_size - free_size) / total_size;
 
-	hc_pused = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+	LOCK_CACHE;
 
 	if (20 >= hc_pused)
 	{
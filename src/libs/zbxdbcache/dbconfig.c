@@ -44,8 +44,17 @@
 
 int	sync_in_progress = 0;
 
-#define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1
-#define FINISH_SYNC	sync_in_progress = 0; UNLOCK_CACHE
+/* configuration cache write lock hold time tracking during synchronization */
+static double	sync_lock_ts, sync_lock_max;
+
+/* the number of rows applied under the current write lock, see dc_sync_slice() */
+static int	sync_slice_rows;
+
+/* the time of the last full configuration tables comparison when changelog based synchronization is enabled */
+static int	sync_full_ts;
+
+#define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1; sync_lock_ts = zbx_time(); sync_slice_rows = 0
+#define FINISH_SYNC	dc_sync_lock_update(); sync_in_progress = 0; UNLOCK_CACHE
 
 #define ZBX_LOC_NOWHERE	0
 #define ZBX_LOC_QUEUE	1
@@ -95,11 +104,69 @@ static zbx_mem_info_t	*config_mem;
 
 extern unsigned char	program_type;
 extern int		CONFIG_TIMER_FORKS;
+extern int		CONFIG_CONF_CACHE_SYNC_SLICE;
+extern int		CONFIG_CONF_CACHE_FULL_SYNC;
 
 ZBX_MEM_FUNC_IMPL(__config, config_mem)
 
 static void	dc_maintenance_precache_nested_groups(void);
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_sync_lock_update                                              *
+ *                                                                            *
+ * Purpose: updates maximum configuration cache write lock hold time of the   *
+ *          current synchronization                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_lock_update(void)
+{
+	double	hold;
+
+	if (sync_lock_max < (hold = zbx_time() - sync_lock_ts))
+		sync_lock_max = hold;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_sync_rows                                                     *
+ *                                                                            *
+ * Purpose: returns the number of rows applied by configuration table sync    *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_sync_rows(const zbx_dbsync_t *sync)
+{
+	return (int)(sync->add_num + sync->update_num + sync->remove_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_sync_slice                                                    *
+ *                                                                            *
+ * Purpose: releases and reacquires configuration cache write lock if the     *
+ *          configured number of rows were applied under the current lock,    *
+ *          allowing readers to access configuration cache between the slices *
+ *                                                                            *
+ * Parameters: rows - [IN] the number of rows applied since the last call     *
+ *                                                                            *
+ * Comments: Must be called only where the already applied rows leave the     *
+ *           cache consistent for readers. Items and triggers are synced in   *
+ *           per row slices - new objects are added hidden (not indexed and   *
+ *           not queued), linked in later slices when the objects they        *
+ *           reference are synchronized and removed objects are freed last.   *
+ *           Tables with sorted per object data (preprocessing, script        *
+ *           parameters, tags, dependencies) are applied in one slice.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_slice(int rows)
+{
+	if (0 == CONFIG_CONF_CACHE_SYNC_SLICE || CONFIG_CONF_CACHE_SYNC_SLICE > (sync_slice_rows += rows))
+		return;
+
+	FINISH_SYNC;
+	START_SYNC;
+}
+
 /* by default the macro environment is non-secure and all secret macros are masked with ****** */
 static unsigned char	macro_env = ZBX_MACRO_ENV_NONSECURE;
 extern char		*CONFIG_VAULTDBPATH;
@@ -2654,6 +2721,32 @@ static void	dc_interface_snmpitems_remove(ZBX_DC_ITEM *item)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_interface_snmpitems_add                                       *
+ *                                                                            *
+ * Purpose: add item to interfaceid -> itemid index                           *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_interface_snmpitems_add(const ZBX_DC_ITEM *item)
+{
+	ZBX_DC_INTERFACE_ITEM	*ifitem;
+	int			found;
+
+	ifitem = (ZBX_DC_INTERFACE_ITEM *)DCfind_id(&config->interface_snmpitems, item->interfaceid,
+			sizeof(ZBX_DC_INTERFACE_ITEM), &found);
+
+	if (0 == found)
+	{
+		zbx_vector_uint64_create_ext(&ifitem->itemids, __config_mem_malloc_func, __config_mem_realloc_func,
+				__config_mem_free_func);
+	}
+
+	zbx_vector_uint64_append(&ifitem->itemids, item->itemid);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_masteritem_remove_depitem                                     *
@@ -2709,7 +2802,89 @@ static void	dc_interface_update_agent_stats(ZBX_DC_INTERFACE *interface, unsigne
 		interface->items_num += num;
 }
 
-static void	DCsync_items(zbx_dbsync_t *sync, int flags)
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_update_schedule                                          *
+ *                                                                            *
+ * Purpose: update item poller type, next check time and poller queue after   *
+ *          item configuration was changed                                    *
+ *                                                                            *
+ * Parameters: item      - [IN/OUT] the item                                  *
+ *             host      - [IN] the item host                                 *
+ *             interface - [IN] the item interface (can be NULL)              *
+ *             flags     - [IN] the item change flags                         *
+ *             now       - [IN] the current time                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_update_schedule(ZBX_DC_ITEM *item, const ZBX_DC_HOST *host, const ZBX_DC_INTERFACE *interface,
+		int flags, time_t now)
+{
+	unsigned char	old_poller_type;
+	int		old_nextcheck;
+
+	old_poller_type = item->poller_type;
+	old_nextcheck = item->nextcheck;
+
+	if (ITEM_STATUS_ACTIVE == item->status && HOST_STATUS_MONITORED == host->status)
+	{
+		DCitem_poller_type_update(item, host, flags);
+
+		if (SUCCEED == zbx_is_counted_in_item_queue(item->type, item->key))
+		{
+			char	*error = NULL;
+
+			if (FAIL == DCitem_nextcheck_update(item, interface, flags, now, &error))
+			{
+				zbx_timespec_t	ts = {now, 0};
+
+				/* Usual way for an item to become not supported is to receive an error     */
+				/* instead of value. Item state and error will be updated by history syncer */
+				/* during history sync following a regular procedure with item update in    */
+				/* database and config cache, logging etc. There is no need to set          */
+				/* ITEM_STATE_NOTSUPPORTED here.                                            */
+
+				if (0 == host->proxy_hostid)
+				{
+					dc_add_history(item->itemid, item->value_type, 0, NULL, &ts,
+							ITEM_STATE_NOTSUPPORTED, error);
+				}
+				zbx_free(error);
+			}
+		}
+	}
+	else
+	{
+		item->nextcheck = 0;
+		item->queue_priority = ZBX_QUEUE_PRIORITY_NORMAL;
+		item->poller_type = ZBX_NO_POLLER;
+	}
+
+	DCupdate_item_queue(item, old_poller_type, old_nextcheck);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCsync_items                                                     *
+ *                                                                            *
+ * Purpose: adds and updates items in configuration cache                     *
+ *                                                                            *
+ * Parameters: sync      - [IN] the db synchronization data                   *
+ *             flags     - [IN] the item change flags                         *
+ *             new_items - [OUT] the added items                              *
+ *             dep_items - [OUT] the dependent items with changed master item *
+ *             itemids   - [OUT] the identifiers of removed items             *
+ *                                                                            *
+ * Comments: The rows are applied in configuration cache lock slices, see     *
+ *           dc_sync_slice(). Added items are not put in host/key index,      *
+ *           SNMP trap index and poller queues, so readers cannot get values  *
+ *           for them before the rest of item configuration (preprocessing,   *
+ *           script parameters) is synchronized. They are linked together     *
+ *           with dependent items by DCsync_items_link(). Removed items are   *
+ *           only collected and are removed last by DCsync_items_remove().    *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCsync_items(zbx_dbsync_t *sync, int flags, zbx_vector_ptr_t *new_items, zbx_vector_ptr_t *dep_items,
+		zbx_vector_uint64_t *itemids)
 {
 	char			**row;
 	zbx_uint64_t		rowid;
@@ -2730,31 +2905,30 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 	ZBX_DC_SIMPLEITEM	*simpleitem;
 	ZBX_DC_JMXITEM		*jmxitem;
 	ZBX_DC_CALCITEM		*calcitem;
-	ZBX_DC_INTERFACE_ITEM	*interface_snmpitem;
-	ZBX_DC_MASTERITEM	*master;
-	ZBX_DC_PREPROCITEM	*preprocitem;
 	ZBX_DC_HTTPITEM		*httpitem;
 	ZBX_DC_SCRIPTITEM	*scriptitem;
 	ZBX_DC_ITEM_HK		*item_hk, item_hk_local;
 	ZBX_DC_INTERFACE	*interface;
 
 	time_t			now;
-	unsigned char		status, type, value_type, old_poller_type;
-	int			found, update_index, ret, i,  old_nextcheck;
+	unsigned char		status, type, value_type;
+	int			found, new_item, update_index;
 	zbx_uint64_t		itemid, hostid, interfaceid;
-	zbx_vector_ptr_t	dep_items;
-
-	zbx_vector_ptr_create(&dep_items);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	now = time(NULL);
 
-	while (SUCCEED == (ret = zbx_dbsync_next(sync, &rowid, &row, &tag)))
+	while (SUCCEED == zbx_dbsync_next(sync, &rowid, &row, &tag))
 	{
 		/* removed rows will be always added at the end */
 		if (ZBX_DBSYNC_ROW_REMOVE == tag)
-			break;
+		{
+			zbx_vector_uint64_append(itemids, rowid);
+			continue;
+		}
+
+		dc_sync_slice(1);
 
 		ZBX_STR2UINT64(itemid, row[0]);
 		ZBX_STR2UINT64(hostid, row[1]);
@@ -2765,6 +2939,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 			continue;
 
 		item = (ZBX_DC_ITEM *)DCfind_id(&config->items, itemid, sizeof(ZBX_DC_ITEM), &found);
+		new_item = (0 == found);
 
 		/* template item */
 		ZBX_DBROW2UINT64(item->templateid, row[48]);
@@ -2775,29 +2950,27 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		if (0 != found && ITEM_TYPE_SNMPTRAP == item->type)
 			dc_interface_snmpitems_remove(item);
 
-		/* see whether we should and can update items_hk index at this point */
+		/* see whether we should and can update items_hk index at this point, */
+		/* new items are added to index by DCsync_items_link()                 */
 
 		update_index = 0;
 
-		if (0 == found || item->hostid != hostid || 0 != strcmp(item->key, row[5]))
+		if (0 == new_item && (item->hostid != hostid || 0 != strcmp(item->key, row[5])))
 		{
-			if (1 == found)
-			{
-				item_hk_local.hostid = item->hostid;
-				item_hk_local.key = item->key;
+			item_hk_local.hostid = item->hostid;
+			item_hk_local.key = item->key;
 
-				if (NULL == (item_hk = (ZBX_DC_ITEM_HK *)zbx_hashset_search(&config->items_hk,
-						&item_hk_local)))
-				{
-					/* item keys should be unique for items within a host, otherwise items with  */
-					/* same key share index and removal of last added item already cleared index */
-					THIS_SHOULD_NEVER_HAPPEN;
-				}
-				else if (item == item_hk->item_ptr)
-				{
-					zbx_strpool_release(item_hk->key);
-					zbx_hashset_remove_direct(&config->items_hk, item_hk);
-				}
+			if (NULL == (item_hk = (ZBX_DC_ITEM_HK *)zbx_hashset_search(&config->items_hk,
+					&item_hk_local)))
+			{
+				/* item keys should be unique for items within a host, otherwise items with  */
+				/* same key share index and removal of last added item already cleared index */
+				THIS_SHOULD_NEVER_HAPPEN;
+			}
+			else if (item == item_hk->item_ptr)
+			{
+				zbx_strpool_release(item_hk->key);
+				zbx_hashset_remove_direct(&config->items_hk, item_hk);
 			}
 
 			item_hk_local.hostid = hostid;
@@ -2839,6 +3012,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		{
 			item->triggers = NULL;
 			item->update_triggers = 0;
+			item->syncgroupid = itemid;
 			item->nextcheck = 0;
 			item->lastclock = 0;
 			item->state = (unsigned char)atoi(row[12]);
@@ -2995,7 +3169,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 			ZBX_STR2UINT64(depitem->master_itemid, row[29]);
 
 			if (depitem->last_master_itemid != depitem->master_itemid)
-				zbx_vector_ptr_append(&dep_items, depitem);
+				zbx_vector_ptr_append(dep_items, depitem);
 		}
 		else if (NULL != (depitem = (ZBX_DC_DEPENDENTITEM *)zbx_hashset_search(&config->dependentitems, &itemid)))
 		{
@@ -3127,21 +3301,8 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 
 		/* SNMP trap items for current server/proxy */
 
-		if (ITEM_TYPE_SNMPTRAP == item->type && 0 == host->proxy_hostid)
-		{
-			interface_snmpitem = (ZBX_DC_INTERFACE_ITEM *)DCfind_id(&config->interface_snmpitems,
-					item->interfaceid, sizeof(ZBX_DC_INTERFACE_ITEM), &found);
-
-			if (0 == found)
-			{
-				zbx_vector_uint64_create_ext(&interface_snmpitem->itemids,
-						__config_mem_malloc_func,
-						__config_mem_realloc_func,
-						__config_mem_free_func);
-			}
-
-			zbx_vector_uint64_append(&interface_snmpitem->itemids, itemid);
-		}
+		if (0 == new_item && ITEM_TYPE_SNMPTRAP == item->type && 0 == host->proxy_hostid)
+			dc_interface_snmpitems_add(item);
 
 		/* calculated items */
 
@@ -3237,53 +3398,53 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		/* it is crucial to update type specific (config->snmpitems, config->ipmiitems, etc.) hashsets before */
 		/* attempting to requeue an item because type specific properties are used to arrange items in queues */
 
-		old_poller_type = item->poller_type;
-		old_nextcheck = item->nextcheck;
-
-		if (ITEM_STATUS_ACTIVE == item->status && HOST_STATUS_MONITORED == host->status)
-		{
-			DCitem_poller_type_update(item, host, flags);
-
-			if (SUCCEED == zbx_is_counted_in_item_queue(item->type, item->key))
-			{
-				char	*error = NULL;
-
-				if (FAIL == DCitem_nextcheck_update(item, interface, flags, now, &error))
-				{
-					zbx_timespec_t	ts = {now, 0};
+		if (0 == new_item)
+			dc_item_update_schedule(item, host, interface, flags, now);
+		else
+			zbx_vector_ptr_append(new_items, item);
+	}
 
-					/* Usual way for an item to become not supported is to receive an error     */
-					/* instead of value. Item state and error will be updated by history syncer */
-					/* during history sync following a regular procedure with item update in    */
-					/* database and config cache, logging etc. There is no need to set          */
-					/* ITEM_STATE_NOTSUPPORTED here.                                            */
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
 
-					if (0 == host->proxy_hostid)
-					{
-						dc_add_history(item->itemid, item->value_type, 0, NULL, &ts,
-								ITEM_STATE_NOTSUPPORTED, error);
-					}
-					zbx_free(error);
-				}
-			}
-		}
-		else
-		{
-			item->nextcheck = 0;
-			item->queue_priority = ZBX_QUEUE_PRIORITY_NORMAL;
-			item->poller_type = ZBX_NO_POLLER;
-		}
+/******************************************************************************
+ *                                                                            *
+ * Function: DCsync_items_link                                                *
+ *                                                                            *
+ * Purpose: links added items and dependent items with changed master items   *
+ *          into configuration cache indexes and poller queues                *
+ *                                                                            *
+ * Parameters: new_items - [IN] the added items                               *
+ *             dep_items - [IN] the dependent items with changed master item  *
+ *             flags     - [IN] the item change flags                         *
+ *                                                                            *
+ * Comments: Called after item preprocessing and script parameters are        *
+ *           synchronized, the links are applied in lock slices.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCsync_items_link(const zbx_vector_ptr_t *new_items, const zbx_vector_ptr_t *dep_items, int flags)
+{
+	ZBX_DC_ITEM		*item;
+	ZBX_DC_ITEM_HK		*item_hk, item_hk_local;
+	ZBX_DC_HOST		*host;
+	ZBX_DC_INTERFACE	*interface;
+	ZBX_DC_DEPENDENTITEM	*depitem;
+	ZBX_DC_MASTERITEM	*master;
+	time_t			now;
+	int			i;
 
-		DCupdate_item_queue(item, old_poller_type, old_nextcheck);
-	}
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() items:%d dependent items:%d", __func__, new_items->values_num,
+			dep_items->values_num);
 
 	/* update dependent item vectors within master items */
 
-	for (i = 0; i < dep_items.values_num; i++)
+	for (i = 0; i < dep_items->values_num; i++)
 	{
 		zbx_uint64_pair_t	pair;
 
-		depitem = (ZBX_DC_DEPENDENTITEM *)dep_items.values[i];
+		dc_sync_slice(1);
+
+		depitem = (ZBX_DC_DEPENDENTITEM *)dep_items->values[i];
 		dc_masteritem_remove_depitem(depitem->last_master_itemid, depitem->itemid);
 		pair.first = depitem->itemid;
 		pair.second = depitem->flags;
@@ -3303,12 +3464,83 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		zbx_vector_uint64_pair_append(&master->dep_itemids, pair);
 	}
 
-	zbx_vector_ptr_destroy(&dep_items);
+	now = time(NULL);
 
-	/* remove deleted items from buffer */
-	for (; SUCCEED == ret; ret = zbx_dbsync_next(sync, &rowid, &row, &tag))
+	for (i = 0; i < new_items->values_num; i++)
+	{
+		dc_sync_slice(1);
+
+		item = (ZBX_DC_ITEM *)new_items->values[i];
+
+		item_hk_local.hostid = item->hostid;
+		item_hk_local.key = item->key;
+
+		if (NULL != (item_hk = (ZBX_DC_ITEM_HK *)zbx_hashset_search(&config->items_hk, &item_hk_local)))
+		{
+			item_hk->item_ptr = item;
+		}
+		else
+		{
+			item_hk_local.key = zbx_strpool_acquire(item->key);
+			item_hk_local.item_ptr = item;
+			zbx_hashset_insert(&config->items_hk, &item_hk_local, sizeof(ZBX_DC_ITEM_HK));
+		}
+
+		if (NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)))
+			continue;
+
+		if (ITEM_TYPE_SNMPTRAP == item->type && 0 == host->proxy_hostid)
+			dc_interface_snmpitems_add(item);
+
+		interface = (ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &item->interfaceid);
+		dc_item_update_schedule(item, host, interface, flags, now);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCsync_items_remove                                              *
+ *                                                                            *
+ * Purpose: removes items from configuration cache                            *
+ *                                                                            *
+ * Parameters: itemids - [IN] the identifiers of removed items                *
+ *                                                                            *
+ * Comments: Called last in items synchronization when nothing references     *
+ *           the removed items anymore, the items are removed in lock slices. *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCsync_items_remove(const zbx_vector_uint64_t *itemids)
+{
+	ZBX_DC_ITEM		*item;
+	ZBX_DC_ITEM_HK		*item_hk, item_hk_local;
+	ZBX_DC_INTERFACE	*interface;
+	ZBX_DC_NUMITEM		*numitem;
+	ZBX_DC_SNMPITEM		*snmpitem;
+	ZBX_DC_IPMIITEM		*ipmiitem;
+	ZBX_DC_TRAPITEM		*trapitem;
+	ZBX_DC_DEPENDENTITEM	*depitem;
+	ZBX_DC_LOGITEM		*logitem;
+	ZBX_DC_DBITEM		*dbitem;
+	ZBX_DC_SSHITEM		*sshitem;
+	ZBX_DC_TELNETITEM	*telnetitem;
+	ZBX_DC_SIMPLEITEM	*simpleitem;
+	ZBX_DC_JMXITEM		*jmxitem;
+	ZBX_DC_CALCITEM		*calcitem;
+	ZBX_DC_HTTPITEM		*httpitem;
+	ZBX_DC_SCRIPTITEM	*scriptitem;
+	ZBX_DC_PREPROCITEM	*preprocitem;
+	zbx_uint64_t		itemid;
+	int			i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() items:%d", __func__, itemids->values_num);
+
+	for (i = 0; i < itemids->values_num; i++)
 	{
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &rowid)))
+		dc_sync_slice(1);
+
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids->values[i])))
 			continue;
 
 		if (ITEM_STATUS_ACTIVE == item->status)
@@ -3600,7 +3832,56 @@ static void	DCsync_prototype_items(zbx_dbsync_t *sync)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static void	DCsync_triggers(zbx_dbsync_t *sync)
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trigger_compile_expression                                    *
+ *                                                                            *
+ * Purpose: compile trigger expression and store the code in configuration   *
+ *          cache                                                             *
+ *                                                                            *
+ * Parameters: code       - [IN/OUT] the compiled expression code             *
+ *             expression - [IN] the trigger expression                       *
+ *                                                                            *
+ * Comments: The code is set to NULL for expressions that cannot be compiled, *
+ *           those are substituted and evaluated as text.                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trigger_compile_expression(unsigned char **code, const char *expression)
+{
+	unsigned char	*local_code;
+	size_t		code_size;
+
+	if (NULL != *code)
+	{
+		__config_mem_free_func(*code);
+		*code = NULL;
+	}
+
+	if (SUCCEED != zbx_eval_compile(expression, &local_code, &code_size))
+		return;
+
+	*code = (unsigned char *)__config_mem_malloc_func(NULL, code_size);
+	memcpy(*code, local_code, code_size);
+	zbx_free(local_code);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCsync_triggers                                                  *
+ *                                                                            *
+ * Purpose: adds and updates triggers in configuration cache                  *
+ *                                                                            *
+ * Parameters: sync       - [IN] the db synchronization data                  *
+ *             triggerids - [OUT] the identifiers of removed triggers         *
+ *                                                                            *
+ * Comments: The rows are applied in configuration cache lock slices. Added   *
+ *           triggers are not functional until trigger links are updated by   *
+ *           dc_trigger_update_cache(). Removed triggers are only collected,  *
+ *           they are referenced by dependency lists and are removed by       *
+ *           DCsync_triggers_remove() after dependencies are synchronized.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCsync_triggers(zbx_dbsync_t *sync, zbx_vector_uint64_t *triggerids)
 {
 	char		**row;
 	zbx_uint64_t	rowid;
@@ -3608,16 +3889,21 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 
 	ZBX_DC_TRIGGER	*trigger;
 
-	int		found, ret;
+	int		found;
 	zbx_uint64_t	triggerid;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	while (SUCCEED == (ret = zbx_dbsync_next(sync, &rowid, &row, &tag)))
+	while (SUCCEED == zbx_dbsync_next(sync, &rowid, &row, &tag))
 	{
 		/* removed rows will be always added at the end */
 		if (ZBX_DBSYNC_ROW_REMOVE == tag)
-			break;
+		{
+			zbx_vector_uint64_append(triggerids, rowid);
+			continue;
+		}
+
+		dc_sync_slice(1);
 
 		ZBX_STR2UINT64(triggerid, row[0]);
 
@@ -3625,9 +3911,22 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 
 		/* store new information in trigger structure */
 
+		if (0 == found)
+		{
+			trigger->expression_code = NULL;
+			trigger->recovery_expression_code = NULL;
+		}
+
 		DCstrpool_replace(found, &trigger->description, row[1]);
-		DCstrpool_replace(found, &trigger->expression, row[2]);
-		DCstrpool_replace(found, &trigger->recovery_expression, row[11]);
+
+		if (SUCCEED == DCstrpool_replace(found, &trigger->expression, row[2]))
+			dc_trigger_compile_expression(&trigger->expression_code, trigger->expression);
+
+		if (SUCCEED == DCstrpool_replace(found, &trigger->recovery_expression, row[11]))
+		{
+			dc_trigger_compile_expression(&trigger->recovery_expression_code,
+					trigger->recovery_expression);
+		}
 		DCstrpool_replace(found, &trigger->correlation_tag, row[13]);
 		DCstrpool_replace(found, &trigger->opdata, row[14]);
 		DCstrpool_replace(found, &trigger->event_name, row[15]);
@@ -3644,6 +3943,7 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 			ZBX_STR2UCHAR(trigger->state, row[7]);
 			trigger->lastchange = atoi(row[8]);
 			trigger->locked = 0;
+			trigger->functional = TRIGGER_FUNCTIONAL_FALSE;
 
 			zbx_vector_ptr_create_ext(&trigger->tags, __config_mem_malloc_func, __config_mem_realloc_func,
 					__config_mem_free_func);
@@ -3651,59 +3951,80 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 		}
 	}
 
-	/* remove deleted triggers from buffer */
-	if (SUCCEED == ret)
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCsync_triggers_remove                                           *
+ *                                                                            *
+ * Purpose: removes triggers from configuration cache                         *
+ *                                                                            *
+ * Parameters: triggerids - [IN] the identifiers of removed triggers          *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCsync_triggers_remove(const zbx_vector_uint64_t *triggerids)
+{
+	ZBX_DC_TRIGGER		*trigger;
+	ZBX_DC_ITEM		*item;
+	ZBX_DC_FUNCTION		*function;
+	zbx_vector_uint64_t	functionids;
+	int			i, j;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() triggers:%d", __func__, triggerids->values_num);
+
+	zbx_vector_uint64_create(&functionids);
+
+	for (j = 0; j < triggerids->values_num; j++)
 	{
-		zbx_vector_uint64_t	functionids;
-		int			i;
-		ZBX_DC_ITEM		*item;
-		ZBX_DC_FUNCTION		*function;
+		dc_sync_slice(1);
 
-		zbx_vector_uint64_create(&functionids);
+		if (NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &triggerids->values[j])))
+			continue;
 
-		for (; SUCCEED == ret; ret = zbx_dbsync_next(sync, &rowid, &row, &tag))
-		{
-			if (NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &rowid)))
-				continue;
+		/* force trigger list update for items used in removed trigger */
 
-			/* force trigger list update for items used in removed trigger */
+		get_functionids(&functionids, trigger->expression);
 
-			get_functionids(&functionids, trigger->expression);
+		if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == trigger->recovery_mode)
+			get_functionids(&functionids, trigger->recovery_expression);
 
-			if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == trigger->recovery_mode)
-				get_functionids(&functionids, trigger->recovery_expression);
+		for (i = 0; i < functionids.values_num; i++)
+		{
+			if (NULL == (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions, &functionids.values[i])))
+				continue;
+
+			if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
+				continue;
 
-			for (i = 0; i < functionids.values_num; i++)
+			item->update_triggers = 1;
+			if (NULL != item->triggers)
 			{
-				if (NULL == (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions, &functionids.values[i])))
-					continue;
+				config->items.mem_free_func(item->triggers);
+				item->triggers = NULL;
+			}
+		}
+		zbx_vector_uint64_clear(&functionids);
 
-				if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
-					continue;
+		zbx_strpool_release(trigger->description);
+		zbx_strpool_release(trigger->expression);
+		zbx_strpool_release(trigger->recovery_expression);
+		zbx_strpool_release(trigger->error);
+		zbx_strpool_release(trigger->correlation_tag);
+		zbx_strpool_release(trigger->opdata);
+		zbx_strpool_release(trigger->event_name);
 
-				item->update_triggers = 1;
-				if (NULL != item->triggers)
-				{
-					config->items.mem_free_func(item->triggers);
-					item->triggers = NULL;
-				}
-			}
-			zbx_vector_uint64_clear(&functionids);
+		if (NULL != trigger->expression_code)
+			__config_mem_free_func(trigger->expression_code);
 
-			zbx_strpool_release(trigger->description);
-			zbx_strpool_release(trigger->expression);
-			zbx_strpool_release(trigger->recovery_expression);
-			zbx_strpool_release(trigger->error);
-			zbx_strpool_release(trigger->correlation_tag);
-			zbx_strpool_release(trigger->opdata);
-			zbx_strpool_release(trigger->event_name);
+		if (NULL != trigger->recovery_expression_code)
+			__config_mem_free_func(trigger->recovery_expression_code);
 
-			zbx_vector_ptr_destroy(&trigger->tags);
+		zbx_vector_ptr_destroy(&trigger->tags);
 
-			zbx_hashset_remove_direct(&config->triggers, trigger);
-		}
-		zbx_vector_uint64_destroy(&functionids);
+		zbx_hashset_remove_direct(&config->triggers, trigger);
 	}
+	zbx_vector_uint64_destroy(&functionids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -4106,6 +4427,8 @@ static void	DCsync_functions(zbx_dbsync_t *sync)
 		if (ZBX_DBSYNC_ROW_REMOVE == tag)
 			break;
 
+		dc_sync_slice(1);
+
 		ZBX_STR2UINT64(itemid, row[0]);
 		ZBX_STR2UINT64(functionid, row[1]);
 		ZBX_STR2UINT64(triggerid, row[4]);
@@ -4160,6 +4483,8 @@ static void	DCsync_functions(zbx_dbsync_t *sync)
 
 	for (; SUCCEED == ret; ret = zbx_dbsync_next(sync, &rowid, &row, &tag))
 	{
+		dc_sync_slice(1);
+
 		if (NULL == (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions, &rowid)))
 			continue;
 
@@ -5719,6 +6044,103 @@ static void	dc_trigger_update_cache(void)
 	zbx_vector_ptr_pair_destroy(&itemtrigs);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_syncgroup_find                                           *
+ *                                                                            *
+ * Purpose: finds root item of the item synchronization group, compressing    *
+ *          the lookup path                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static ZBX_DC_ITEM	*dc_item_syncgroup_find(ZBX_DC_ITEM *item)
+{
+	ZBX_DC_ITEM	*root = item, *next;
+
+	while (root->syncgroupid != root->itemid)
+		root = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &root->syncgroupid);
+
+	while (item != root)
+	{
+		next = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &item->syncgroupid);
+		item->syncgroupid = root->itemid;
+		item = next;
+	}
+
+	return root;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trigger_update_syncgroups                                     *
+ *                                                                            *
+ * Purpose: groups items linked by enabled triggers, so that values of all    *
+ *          items used by a trigger are processed by the same history syncer  *
+ *                                                                            *
+ * Comments: The group is identified by the lowest itemid of its items.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trigger_update_syncgroups(void)
+{
+	zbx_hashset_iter_t	iter;
+	ZBX_DC_ITEM		*item, *root, *root_first;
+	ZBX_DC_TRIGGER		*trigger;
+	ZBX_DC_FUNCTION		*function;
+	zbx_hashset_t		trigger_items;
+	zbx_uint64_pair_t	*trigger_item, trigger_item_local;
+
+	zbx_hashset_iter_reset(&config->items, &iter);
+	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+		item->syncgroupid = item->itemid;
+
+	/* triggerid -> itemid of the first item used by trigger */
+	zbx_hashset_create(&trigger_items, config->triggers.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_hashset_iter_reset(&config->functions, &iter);
+	while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &function->triggerid)) ||
+				TRIGGER_STATUS_ENABLED != trigger->status)
+		{
+			continue;
+		}
+
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
+			continue;
+
+		if (NULL == (trigger_item = (zbx_uint64_pair_t *)zbx_hashset_search(&trigger_items,
+				&function->triggerid)))
+		{
+			trigger_item_local.first = function->triggerid;
+			trigger_item_local.second = function->itemid;
+			zbx_hashset_insert(&trigger_items, &trigger_item_local, sizeof(trigger_item_local));
+			continue;
+		}
+
+		if (trigger_item->second == function->itemid)
+			continue;
+
+		root = dc_item_syncgroup_find(item);
+		root_first = dc_item_syncgroup_find((ZBX_DC_ITEM *)zbx_hashset_search(&config->items,
+				&trigger_item->second));
+
+		if (root == root_first)
+			continue;
+
+		if (root->itemid < root_first->itemid)
+			root_first->syncgroupid = root->itemid;
+		else
+			root->syncgroupid = root_first->itemid;
+	}
+
+	zbx_hashset_destroy(&trigger_items);
+
+	/* flatten groups so they can be read without write lock */
+	zbx_hashset_iter_reset(&config->items, &iter);
+	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+		dc_item_syncgroup_find(item);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_hostgroups_update_cache                                       *
@@ -5797,7 +6219,7 @@ static void	dc_load_trigger_queue(zbx_hashset_t *trend_functions)
  ******************************************************************************/
 void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kvs_paths)
 {
-	int		i, flags;
+	int		i, flags, changelog_status = FAIL;
 	double		sec, csec, hsec, hisec, htsec, gmsec, hmsec, ifsec, isec, tsec, dsec, fsec, expr_sec, csec2,
 			hsec2, hisec2, htsec2, gmsec2, hmsec2, ifsec2, isec2, tsec2, dsec2, fsec2, expr_sec2,
 			action_sec, action_sec2, action_op_sec, action_op_sec2, action_condition_sec,
@@ -5819,10 +6241,13 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 	zbx_uint64_t	update_flags = 0;
 
 	zbx_hashset_t		trend_queue;
+	zbx_vector_ptr_t	new_items, dep_items;
+	zbx_vector_uint64_t	del_itemids, del_triggerids;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	config->sync_start_ts = time(NULL);
+	sync_lock_max = 0;
 
 	if (ZBX_SYNC_SECRETS == mode)
 	{
@@ -5879,6 +6304,11 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 	zbx_dbsync_init(&maintenance_group_sync, mode);
 	zbx_dbsync_init(&maintenance_host_sync, mode);
 
+	/* changelog is loaded before comparing any tables so changes committed */
+	/* during synchronization are processed by the next synchronization     */
+	if (FAIL == zbx_dbsync_env_load_changelog())
+		goto out;
+
 	sec = zbx_time();
 	if (FAIL == zbx_dbsync_compare_config(&config_sync))
 		goto out;
@@ -6023,6 +6453,17 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 		goto out;
 	ifsec = zbx_time() - sec;
 
+	/* host status and proxy changes affect which items, functions, triggers and preprocessing */
+	/* steps are cached, so full comparison is done when hosts are changed                     */
+	if (0 != CONFIG_CONF_CACHE_FULL_SYNC && ZBX_DBSYNC_UPDATE == mode &&
+			0 == hosts_sync.add_num + hosts_sync.update_num + hosts_sync.remove_num &&
+			config->sync_start_ts < sync_full_ts + CONFIG_CONF_CACHE_FULL_SYNC)
+	{
+		zbx_dbsync_env_use_changelog();
+	}
+	else
+		sync_full_ts = config->sync_start_ts;
+
 	sec = zbx_time();
 	if (FAIL == zbx_dbsync_compare_items(&items_sync))
 		goto out;
@@ -6051,23 +6492,45 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 	DCsync_interfaces(&if_sync);
 	ifsec2 = zbx_time() - sec;
 
+	dc_sync_slice(dc_sync_rows(&if_sync));
+
+	zbx_vector_ptr_create(&new_items);
+	zbx_vector_ptr_create(&dep_items);
+	zbx_vector_uint64_create(&del_itemids);
+
 	/* relies on hosts, proxies and interfaces, must be after DCsync_{hosts,interfaces}() */
 	sec = zbx_time();
-	DCsync_items(&items_sync, flags);
+	DCsync_items(&items_sync, flags, &new_items, &dep_items, &del_itemids);
 	DCsync_template_items(&template_items_sync);
 	DCsync_prototype_items(&prototype_items_sync);
 	isec2 = zbx_time() - sec;
 
+	dc_sync_slice(dc_sync_rows(&template_items_sync) + dc_sync_rows(&prototype_items_sync));
+
 	/* relies on items, must be after DCsync_items() */
 	sec = zbx_time();
 	DCsync_item_preproc(&itempp_sync, sec);
 	itempp_sec2 = zbx_time() - sec;
 
+	dc_sync_slice(dc_sync_rows(&itempp_sync));
+
 	/* relies on items, must be after DCsync_items() */
 	sec = zbx_time();
 	DCsync_itemscript_param(&itemscrp_sync);
 	itemscrp_sec2 = zbx_time() - sec;
 
+	dc_sync_slice(dc_sync_rows(&itemscrp_sync));
+
+	/* new items become visible only with their preprocessing and script parameters synchronized */
+	sec = zbx_time();
+	DCsync_items_link(&new_items, &dep_items, flags);
+	DCsync_items_remove(&del_itemids);
+	isec2 += zbx_time() - sec;
+
+	zbx_vector_uint64_destroy(&del_itemids);
+	zbx_vector_ptr_destroy(&dep_items);
+	zbx_vector_ptr_destroy(&new_items);
+
 	/* relies on items, must be after DCsync_items() */
 	sec = zbx_time();
 	if (FAIL == zbx_dbsync_compare_item_tags(&item_tag_sync))
@@ -6146,18 +6609,46 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 
 	START_SYNC;
 
+	zbx_vector_uint64_create(&del_triggerids);
+
 	sec = zbx_time();
-	DCsync_triggers(&triggers_sync);
+	DCsync_triggers(&triggers_sync, &del_triggerids);
 	tsec2 = zbx_time() - sec;
 
 	sec = zbx_time();
 	DCsync_trigdeps(&tdep_sync);
 	dsec2 = zbx_time() - sec;
 
+	dc_sync_slice(dc_sync_rows(&tdep_sync));
+
 	sec = zbx_time();
 	DCsync_expressions(&expr_sync);
 	expr_sec2 = zbx_time() - sec;
 
+	dc_sync_slice(dc_sync_rows(&expr_sync));
+
+	sec = zbx_time();
+	/* relies on triggers, must be after DCsync_triggers() */
+	DCsync_trigger_tags(&trigger_tag_sync);
+	trigger_tag_sec2 = zbx_time() - sec;
+
+	dc_sync_slice(dc_sync_rows(&trigger_tag_sync));
+
+	sec = zbx_time();
+	DCsync_item_tags(&item_tag_sync);
+	item_tag_sec2 = zbx_time() - sec;
+
+	dc_sync_slice(dc_sync_rows(&item_tag_sync));
+
+	/* removed triggers are referenced by dependency lists, must be after DCsync_trigdeps() */
+	sec = zbx_time();
+	DCsync_triggers_remove(&del_triggerids);
+	tsec2 += zbx_time() - sec;
+
+	zbx_vector_uint64_destroy(&del_triggerids);
+
+	/* actions and correlations do not depend on triggers */
+
 	sec = zbx_time();
 	DCsync_actions(&action_sync);
 	action_sec2 = zbx_time() - sec;
@@ -6170,15 +6661,6 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 	DCsync_action_conditions(&action_condition_sync);
 	action_condition_sec2 = zbx_time() - sec;
 
-	sec = zbx_time();
-	/* relies on triggers, must be after DCsync_triggers() */
-	DCsync_trigger_tags(&trigger_tag_sync);
-	trigger_tag_sec2 = zbx_time() - sec;
-
-	sec = zbx_time();
-	DCsync_item_tags(&item_tag_sync);
-	item_tag_sec2 = zbx_time() - sec;
-
 	sec = zbx_time();
 	DCsync_correlations(&correlation_sync);
 	correlation_sec2 = zbx_time() - sec;
@@ -6193,6 +6675,10 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 	DCsync_corr_operations(&corr_operation_sync);
 	corr_operation_sec2 = zbx_time() - sec;
 
+	dc_sync_slice(dc_sync_rows(&action_sync) + dc_sync_rows(&action_op_sync) +
+			dc_sync_rows(&action_condition_sync) + dc_sync_rows(&correlation_sync) +
+			dc_sync_rows(&corr_condition_sync) + dc_sync_rows(&corr_operation_sync));
+
 	sec = zbx_time();
 
 	if (0 != hosts_sync.add_num + hosts_sync.update_num + hosts_sync.remove_num)
@@ -6219,10 +6705,12 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 			ZBX_DBSYNC_UPDATE_TRIGGERS)))
 	{
 		dc_trigger_update_cache();
+		dc_trigger_update_syncgroups();
 		dc_schedule_trigger_timers((ZBX_DBSYNC_INIT == mode ? &trend_queue : NULL), time(NULL));
 	}
 
 	update_sec = zbx_time() - sec;
+	changelog_status = SUCCEED;
 
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
@@ -6496,8 +6984,14 @@ out:
 	config->status->last_update = 0;
 	config->sync_ts = time(NULL);
 
+	dc_sync_lock_update();
+	config->sync_lock_max = sync_lock_max;
+
 	FINISH_SYNC;
 
+	if (SUCCEED == changelog_status)
+		zbx_dbsync_env_flush_changelog();
+
 	zbx_dbsync_clear(&config_sync);
 	zbx_dbsync_clear(&autoreg_config_sync);
 	zbx_dbsync_clear(&hosts_sync);
@@ -6891,7 +7385,17 @@ int	init_configuration_cache(char **error)
 	zbx_hashset_create_ext(&hashset, hashset_size, hash_func, compare_func, NULL,				\
 			__config_mem_malloc_func, __config_mem_realloc_func, __config_mem_free_func)
 
-	CREATE_HASHSET(config->items, 100);
+	/* the most frequently searched indexes use open addressing for better lookup locality */
+#define CREATE_HASHSET_OPEN(hashset, hashset_size)								\
+														\
+	CREATE_HASHSET_OPEN_EXT(hashset, hashset_size, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC)
+
+#define CREATE_HASHSET_OPEN_EXT(hashset, hashset_size, hash_func, compare_func)					\
+														\
+	zbx_hashset_create_open_ext(&hashset, hashset_size, hash_func, compare_func, NULL,			\
+			__config_mem_malloc_func, __config_mem_realloc_func, __config_mem_free_func)
+
+	CREATE_HASHSET_OPEN(config->items, 100);
 	CREATE_HASHSET(config->numitems, 0);
 	CREATE_HASHSET(config->snmpitems, 0);
 	CREATE_HASHSET(config->ipmiitems, 0);
@@ -6911,10 +7415,10 @@ int	init_configuration_cache(char **error)
 	CREATE_HASHSET(config->itemscript_params, 0);
 	CREATE_HASHSET(config->template_items, 0);
 	CREATE_HASHSET(config->prototype_items, 0);
-	CREATE_HASHSET(config->functions, 100);
-	CREATE_HASHSET(config->triggers, 100);
+	CREATE_HASHSET_OPEN(config->functions, 100);
+	CREATE_HASHSET_OPEN(config->triggers, 100);
 	CREATE_HASHSET(config->trigdeps, 0);
-	CREATE_HASHSET(config->hosts, 10);
+	CREATE_HASHSET_OPEN(config->hosts, 10);
 	CREATE_HASHSET(config->proxies, 0);
 	CREATE_HASHSET(config->host_inventories, 0);
 	CREATE_HASHSET(config->host_inventories_auto, 0);
@@ -6947,8 +7451,8 @@ int	init_configuration_cache(char **error)
 	CREATE_HASHSET(config->maintenance_periods, 0);
 	CREATE_HASHSET(config->maintenance_tags, 0);
 
-	CREATE_HASHSET_EXT(config->items_hk, 100, __config_item_hk_hash, __config_item_hk_compare);
-	CREATE_HASHSET_EXT(config->hosts_h, 10, __config_host_h_hash, __config_host_h_compare);
+	CREATE_HASHSET_OPEN_EXT(config->items_hk, 100, __config_item_hk_hash, __config_item_hk_compare);
+	CREATE_HASHSET_OPEN_EXT(config->hosts_h, 10, __config_host_h_hash, __config_host_h_compare);
 	CREATE_HASHSET_EXT(config->hosts_p, 0, __config_host_h_hash, __config_host_h_compare);
 	CREATE_HASHSET_EXT(config->gmacros_m, 0, __config_gmacro_m_hash, __config_gmacro_m_compare);
 	CREATE_HASHSET_EXT(config->hmacros_hm, 0, __config_hmacro_hm_hash, __config_hmacro_hm_compare);
@@ -7017,6 +7521,7 @@ int	init_configuration_cache(char **error)
 	config->availability_diff_ts = 0;
 	config->sync_ts = 0;
 	config->item_sync_ts = 0;
+	config->sync_lock_max = 0;
 	config->sync_start_ts = 0;
 
 	config->internal_actions = 0;
@@ -7046,6 +7551,8 @@ int	init_configuration_cache(char **error)
 
 #undef CREATE_HASHSET
 #undef CREATE_HASHSET_EXT
+#undef CREATE_HASHSET_OPEN
+#undef CREATE_HASHSET_OPEN_EXT
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
@@ -7815,6 +8322,21 @@ static void	DCget_function(DC_FUNCTION *dst_function, const ZBX_DC_FUNCTION *src
 	memcpy(dst_function->parameter, src_function->parameter, sz_parameter);
 }
 
+static unsigned char	*dc_eval_code_dup(const unsigned char *src)
+{
+	unsigned char	*dst;
+	size_t		size;
+
+	if (NULL == src)
+		return NULL;
+
+	size = zbx_eval_code_size(src);
+	dst = (unsigned char *)zbx_malloc(NULL, size);
+	memcpy(dst, src, size);
+
+	return dst;
+}
+
 static void	DCget_trigger(DC_TRIGGER *dst_trigger, const ZBX_DC_TRIGGER *src_trigger)
 {
 	int	i;
@@ -7847,6 +8369,8 @@ static void	DCget_trigger(DC_TRIGGER *dst_trigger, const ZBX_DC_TRIGGER *src_tri
 
 	dst_trigger->expression = zbx_strdup(NULL, src_trigger->expression);
 	dst_trigger->recovery_expression = zbx_strdup(NULL, src_trigger->recovery_expression);
+	dst_trigger->expression_code = dc_eval_code_dup(src_trigger->expression_code);
+	dst_trigger->recovery_expression_code = dc_eval_code_dup(src_trigger->recovery_expression_code);
 
 	zbx_vector_ptr_create(&dst_trigger->tags);
 
@@ -7890,6 +8414,8 @@ static void	DCclean_trigger(DC_TRIGGER *trigger)
 	zbx_free(trigger->recovery_expression_orig);
 	zbx_free(trigger->expression);
 	zbx_free(trigger->recovery_expression);
+	zbx_free(trigger->expression_code);
+	zbx_free(trigger->recovery_expression_code);
 	zbx_free(trigger->description);
 	zbx_free(trigger->correlation_tag);
 	zbx_free(trigger->opdata);
@@ -7912,6 +8438,11 @@ static void	DCclean_trigger(DC_TRIGGER *trigger)
  *                                                                            *
  * Author: Alexander Vladishev, Aleksandrs Saveljevs                          *
  *                                                                            *
+ * Comments: The items are copied under read lock. Besides configuration the  *
+ *           returned structure contains item and host runtime data (state,   *
+ *           error, lastlogsize, mtime, availability), which is changed by    *
+ *           other processes without configuration synchronization.           *
+ *                                                                            *
  ******************************************************************************/
 void	DCconfig_get_items_by_keys(DC_ITEM *items, zbx_host_key_t *keys, int *errcodes, size_t num)
 {
@@ -8264,6 +8795,38 @@ void	DCconfig_clean_triggers(DC_TRIGGER *triggers, int *errcodes, size_t num)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_items_syncgroups                                    *
+ *                                                                            *
+ * Purpose: get synchronization groups of the specified items                 *
+ *                                                                            *
+ * Parameters: itemids      - [IN] the item identifiers                       *
+ *             syncgroupids - [OUT] the synchronization group identifiers     *
+ *             num          - [IN] the number of items                        *
+ *                                                                            *
+ * Comments: Items sharing triggers belong to the same synchronization group. *
+ *           Unknown items are returned as groups of their own.               *
+ *                                                                            *
+ ******************************************************************************/
+void	DCconfig_get_items_syncgroups(const zbx_uint64_t *itemids, zbx_uint64_t *syncgroupids, int num)
+{
+	int			i;
+	const ZBX_DC_ITEM	*dc_item;
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < num; i++)
+	{
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+			syncgroupids[i] = itemids[i];
+		else
+			syncgroupids[i] = dc_item->syncgroupid;
+	}
+
+	UNLOCK_CACHE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCconfig_lock_triggers_by_history_items                          *
@@ -8297,6 +8860,11 @@ void	DCconfig_clean_triggers(DC_TRIGGER *triggers, int *errcodes, size_t num)
  *           case configuration changes. On a stable configuration, it should *
  *           work without any problems.                                       *
  *                                                                            *
+ *           Items sharing triggers are routed to the same history syncer     *
+ *           (see DCconfig_get_items_syncgroups()), so triggers are normally  *
+ *           locked only by their owner and items are marked busy only for    *
+ *           values queued before a configuration change.                     *
+ *                                                                            *
  * Return value: the number of items available for processing (unlocked).     *
  *                                                                            *
  ******************************************************************************/
@@ -9118,6 +9686,9 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
  *           function.                                                        *
  *                                                                            *
+ *           Taking items from queue changes shared item location and         *
+ *           poller queue, so the write lock is required.                     *
+ *                                                                            *
  ******************************************************************************/
 int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 {
@@ -10298,6 +10869,9 @@ void	*DCconfig_get_stats(int request)
 		case ZBX_CONFSTATS_BUFFER_PFREE:
 			value_double = 100 * (double)config_mem->free_size / config_mem->orig_size;
 			return &value_double;
+		case ZBX_CONFSTATS_SYNC_LOCK_MAX:
+			value_double = config->sync_lock_max;
+			return &value_double;
 		default:
 			return NULL;
 	}
@@ -11059,6 +11633,10 @@ int	DCget_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 		if (ITEM_STATUS_ACTIVE != dc_item->status)
 			continue;
 
+		/* items added by configuration sync are not scheduled until linked in a later lock slice */
+		if (0 == dc_item->nextcheck)
+			continue;
+
 		if (SUCCEED != zbx_is_counted_in_item_queue(dc_item->type, dc_item->key))
 			continue;
 
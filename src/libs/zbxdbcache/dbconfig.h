@@ -46,6 +46,10 @@ typedef struct
 	unsigned char		recovery_mode;		/* see TRIGGER_RECOVERY_MODE_* defines   */
 	unsigned char		correlation_mode;	/* see ZBX_TRIGGER_CORRELATION_* defines */
 
+	/* compiled expressions, NULL if expression must be evaluated as text */
+	unsigned char		*expression_code;
+	unsigned char		*recovery_expression_code;
+
 	zbx_vector_ptr_t	tags;
 }
 ZBX_DC_TRIGGER;
@@ -79,6 +83,7 @@ typedef struct
 	zbx_uint64_t		interfaceid;
 	zbx_uint64_t		lastlogsize;
 	zbx_uint64_t		valuemapid;
+	zbx_uint64_t		syncgroupid;	/* the lowest itemid of items linked by triggers */
 	const char		*key;
 	const char		*port;
 	const char		*error;
@@ -777,6 +782,7 @@ typedef struct
 	int			sync_ts;
 	int			item_sync_ts;
 	int			sync_start_ts;
+	double			sync_lock_max;	/* maximum write lock hold time during the last synchronization */
 
 	unsigned int		internal_actions;		/* number of enabled internal actions */
 
@@ -29,11 +29,30 @@
 
 typedef struct
 {
-	zbx_hashset_t	strpool;
-	ZBX_DC_CONFIG	*cache;
+	zbx_hashset_t		strpool;
+	ZBX_DC_CONFIG		*cache;
+
+	/* changelog records loaded at the start of synchronization */
+	zbx_vector_uint64_t	changelogids;
+
+	/* identifiers of changed objects (see ZBX_DBSYNC_OBJ_* defines) */
+	zbx_vector_uint64_t	itemids;
+	zbx_vector_uint64_t	functionids;
+	zbx_vector_uint64_t	triggerids;
+	zbx_vector_uint64_t	item_preprocids;
+
+	/* 1 if only changelog recorded items, functions, triggers and preprocessing steps must be compared */
+	unsigned char		changelog;
 }
 zbx_dbsync_env_t;
 
+typedef struct
+{
+	const char			*fieldname;
+	const zbx_vector_uint64_t	*ids;
+}
+zbx_dbsync_cond_t;
+
 static zbx_dbsync_env_t	dbsync_env;
 
 /* string pool support */
@@ -276,7 +295,14 @@ static char	**dbsync_preproc_row(zbx_dbsync_t *sync, char **row)
 void	zbx_dbsync_init_env(ZBX_DC_CONFIG *cache)
 {
 	dbsync_env.cache = cache;
+	dbsync_env.changelog = 0;
 	zbx_hashset_create(&dbsync_env.strpool, 100, dbsync_strpool_hash_func, dbsync_strpool_compare_func);
+
+	zbx_vector_uint64_create(&dbsync_env.changelogids);
+	zbx_vector_uint64_create(&dbsync_env.itemids);
+	zbx_vector_uint64_create(&dbsync_env.functionids);
+	zbx_vector_uint64_create(&dbsync_env.triggerids);
+	zbx_vector_uint64_create(&dbsync_env.item_preprocids);
 }
 
 /******************************************************************************
@@ -286,9 +312,196 @@ void	zbx_dbsync_init_env(ZBX_DC_CONFIG *cache)
  ******************************************************************************/
 void	zbx_dbsync_free_env(void)
 {
+	zbx_vector_uint64_destroy(&dbsync_env.item_preprocids);
+	zbx_vector_uint64_destroy(&dbsync_env.triggerids);
+	zbx_vector_uint64_destroy(&dbsync_env.functionids);
+	zbx_vector_uint64_destroy(&dbsync_env.itemids);
+	zbx_vector_uint64_destroy(&dbsync_env.changelogids);
+
 	zbx_hashset_destroy(&dbsync_env.strpool);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_load_changelog                                    *
+ *                                                                            *
+ * Purpose: loads identifiers of the objects changed since the last           *
+ *          synchronization from changelog                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the changelog was loaded successfully              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The loaded records are removed from changelog only after         *
+ *           successful synchronization, so records committed while the       *
+ *           synchronization is in progress are processed next time.          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_env_load_changelog(void)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_uint64_t		changelogid, objectid;
+	zbx_vector_uint64_t	*ids;
+
+	if (NULL == (result = DBselect("select changelogid,object,objectid from changelog")))
+		return FAIL;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(changelogid, row[0]);
+		ZBX_STR2UINT64(objectid, row[2]);
+
+		zbx_vector_uint64_append(&dbsync_env.changelogids, changelogid);
+
+		switch (atoi(row[1]))
+		{
+			case ZBX_DBSYNC_OBJ_ITEM:
+				ids = &dbsync_env.itemids;
+				break;
+			case ZBX_DBSYNC_OBJ_FUNCTION:
+				ids = &dbsync_env.functionids;
+				break;
+			case ZBX_DBSYNC_OBJ_TRIGGER:
+				ids = &dbsync_env.triggerids;
+				break;
+			case ZBX_DBSYNC_OBJ_ITEM_PREPROC:
+				ids = &dbsync_env.item_preprocids;
+				break;
+			default:
+				continue;
+		}
+
+		zbx_vector_uint64_append(ids, objectid);
+	}
+	DBfree_result(result);
+
+	zbx_vector_uint64_sort(&dbsync_env.itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&dbsync_env.itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort(&dbsync_env.functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&dbsync_env.functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort(&dbsync_env.triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&dbsync_env.triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort(&dbsync_env.item_preprocids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&dbsync_env.item_preprocids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() changelog:%d items:%d functions:%d triggers:%d preprocessing:%d",
+			__func__, dbsync_env.changelogids.values_num, dbsync_env.itemids.values_num,
+			dbsync_env.functionids.values_num, dbsync_env.triggerids.values_num,
+			dbsync_env.item_preprocids.values_num);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_use_changelog                                     *
+ *                                                                            *
+ * Purpose: switches items, functions, triggers and item preprocessing        *
+ *          comparison to check only the objects recorded in changelog        *
+ *                                                                            *
+ * Comments: Must be called only after zbx_dbsync_env_load_changelog() and    *
+ *           only in ZBX_DBSYNC_UPDATE mode.                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_use_changelog(void)
+{
+	dbsync_env.changelog = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_flush_changelog                                   *
+ *                                                                            *
+ * Purpose: removes the loaded records from changelog                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_flush_changelog(void)
+{
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+
+	if (0 == dbsync_env.changelogids.values_num)
+		return;
+
+	zbx_vector_uint64_sort(&dbsync_env.changelogids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "delete from changelog where");
+	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "changelogid", dbsync_env.changelogids.values,
+			dbsync_env.changelogids.values_num);
+
+	DBexecute("%s", sql);
+
+	zbx_free(sql);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_add_changelog_condition                                   *
+ *                                                                            *
+ * Purpose: appends changelog based object filter to the sql query            *
+ *                                                                            *
+ * Parameters: sql        - [IN/OUT] the sql query                            *
+ *             sql_alloc  - [IN/OUT] the sql query allocated size             *
+ *             sql_offset - [IN/OUT] the sql query length                     *
+ *             conds      - [IN] the field and identifier list pairs,         *
+ *                               combined with 'or'                           *
+ *             conds_num  - [IN] the number of conditions                     *
+ *                                                                            *
+ * Return value: SUCCEED - the condition was added                            *
+ *               FAIL    - all identifier lists are empty, no rows can match  *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_add_changelog_condition(char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const zbx_dbsync_cond_t *conds, int conds_num)
+{
+	int	i, added = 0;
+
+	for (i = 0; i < conds_num; i++)
+	{
+		if (0 == conds[i].ids->values_num)
+			continue;
+
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, 0 == added++ ? " and (" : " or");
+		DBadd_condition_alloc(sql, sql_alloc, sql_offset, conds[i].fieldname, conds[i].ids->values,
+				conds[i].ids->values_num);
+	}
+
+	if (0 == added)
+		return FAIL;
+
+	zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ')');
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_remove_changelog_rows                                     *
+ *                                                                            *
+ * Purpose: adds remove rows for the changed objects which are cached, but    *
+ *          were not returned by the database                                 *
+ *                                                                            *
+ * Parameters: sync  - [OUT] the changeset                                    *
+ *             cache - [IN] the cached objects, indexed by uint64 identifier  *
+ *             ids   - [IN] the candidate object identifiers                  *
+ *             found - [IN] the identifiers returned by the database          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_remove_changelog_rows(zbx_dbsync_t *sync, zbx_hashset_t *cache, const zbx_vector_uint64_t *ids,
+		zbx_hashset_t *found)
+{
+	int	i;
+
+	for (i = 0; i < ids->values_num; i++)
+	{
+		if (NULL == zbx_hashset_search(cache, &ids->values[i]))
+			continue;
+
+		if (NULL == zbx_hashset_search(found, &ids->values[i]))
+			dbsync_add_row(sync, ids->values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dbsync_init                                                  *
@@ -1828,9 +2041,10 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_ITEM		*item;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
 
-	if (NULL == (result = DBselect(
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,i.hostid,i.status,i.type,i.value_type,i.key_,i.snmp_oid,i.ipmi_sensor,i.delay,"
 				"i.trapper_hosts,i.logtimefmt,i.params,ir.state,i.authtype,i.username,i.password,"
 				"i.publickey,i.privatekey,i.flags,i.interfaceid,ir.lastlogsize,ir.mtime,"
@@ -1844,12 +2058,26 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 			" left join item_discovery id on i.itemid=id.itemid"
 			" join item_rtdata ir on i.itemid=ir.itemid"
 			" where h.status in (%d,%d) and i.flags<>%d",
-			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_PROTOTYPE);
 
+	if (0 != dbsync_env.changelog)
 	{
-		return FAIL;
+		zbx_dbsync_cond_t	conds[] = {{"i.itemid", &dbsync_env.itemids}};
+
+		if (FAIL == dbsync_add_changelog_condition(&sql, &sql_alloc, &sql_offset, conds, ARRSIZE(conds)))
+		{
+			zbx_free(sql);
+			dbsync_prepare(sync, 50, dbsync_item_preproc_row);
+			return SUCCEED;
+		}
 	}
 
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
+
 	dbsync_prepare(sync, 50, dbsync_item_preproc_row);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
@@ -1879,11 +2107,18 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
-	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+	if (0 != dbsync_env.changelog)
 	{
-		if (NULL == zbx_hashset_search(&ids, &item->itemid))
-			dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		dbsync_remove_changelog_rows(sync, &dbsync_env.cache->items, &dbsync_env.itemids, &ids);
+	}
+	else
+	{
+		zbx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
+		while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &item->itemid))
+				dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -2186,9 +2421,10 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_TRIGGER		*trigger;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
 
-	if (NULL == (result = DBselect(
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select distinct t.triggerid,t.description,t.expression,t.error,t.priority,t.type,t.value,"
 				"t.state,t.lastchange,t.status,t.recovery_mode,t.recovery_expression,"
 				"t.correlation_mode,t.correlation_tag,opdata,event_name"
@@ -2199,11 +2435,26 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 				" and h.status in (%d,%d)"
 				" and t.flags<>%d",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE);
+
+	if (0 != dbsync_env.changelog)
 	{
-		return FAIL;
+		zbx_dbsync_cond_t	conds[] = {{"t.triggerid", &dbsync_env.triggerids}};
+
+		if (FAIL == dbsync_add_changelog_condition(&sql, &sql_alloc, &sql_offset, conds, ARRSIZE(conds)))
+		{
+			zbx_free(sql);
+			dbsync_prepare(sync, 16, dbsync_trigger_preproc_row);
+			return SUCCEED;
+		}
 	}
 
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
+
 	dbsync_prepare(sync, 16, dbsync_trigger_preproc_row);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
@@ -2233,11 +2484,18 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 		}
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->triggers, &iter);
-	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+	if (0 != dbsync_env.changelog)
+	{
+		dbsync_remove_changelog_rows(sync, &dbsync_env.cache->triggers, &dbsync_env.triggerids, &ids);
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &trigger->triggerid))
-			dbsync_add_row(sync, trigger->triggerid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->triggers, &iter);
+		while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &trigger->triggerid))
+				dbsync_add_row(sync, trigger->triggerid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -2413,11 +2671,13 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 	DB_RESULT		result;
 	zbx_hashset_t		ids;
 	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid;
+	zbx_uint64_t		rowid, triggerid;
 	ZBX_DC_FUNCTION		*function;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	zbx_vector_uint64_t	functionids;
 
-	if (NULL == (result = DBselect(
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,f.functionid,f.name,f.parameter,t.triggerid,i.hostid"
 			" from hosts h,items i,functions f,triggers t"
 			" where h.hostid=i.hostid"
@@ -2426,8 +2686,50 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 				" and h.status in (%d,%d)"
 				" and t.flags<>%d",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE);
+
+	zbx_vector_uint64_create(&functionids);
+
+	if (0 != dbsync_env.changelog)
+	{
+		zbx_dbsync_cond_t	conds[] = {{"f.functionid", &dbsync_env.functionids},
+						{"f.itemid", &dbsync_env.itemids}, {"f.triggerid", &dbsync_env.triggerids}};
+
+		/* cascade deletes do not fire database triggers on MySQL, so functions of changed */
+		/* items and triggers must be checked together with the changed functions          */
+		zbx_vector_uint64_append_array(&functionids, dbsync_env.functionids.values,
+				dbsync_env.functionids.values_num);
+
+		zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
+		while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+		{
+			if (FAIL != zbx_vector_uint64_bsearch(&dbsync_env.itemids, function->itemid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC) ||
+					FAIL != zbx_vector_uint64_bsearch(&dbsync_env.triggerids, function->triggerid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				zbx_vector_uint64_append(&functionids, function->functionid);
+			}
+		}
+
+		zbx_vector_uint64_sort(&functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		if (FAIL == dbsync_add_changelog_condition(&sql, &sql_alloc, &sql_offset, conds, ARRSIZE(conds)))
+		{
+			zbx_vector_uint64_destroy(&functionids);
+			zbx_free(sql);
+			dbsync_prepare(sync, 6, dbsync_function_preproc_row);
+			return SUCCEED;
+		}
+	}
+
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
 	{
+		zbx_vector_uint64_destroy(&functionids);
 		return FAIL;
 	}
 
@@ -2435,6 +2737,7 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
+		zbx_vector_uint64_destroy(&functionids);
 		sync->dbresult = result;
 		return SUCCEED;
 	}
@@ -2458,15 +2761,44 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 
 		if (ZBX_DBSYNC_ROW_NONE != tag)
 			dbsync_add_row(sync, rowid, tag, row);
+
+		/* trigger visibility depends on its functions */
+		if (0 != dbsync_env.changelog)
+		{
+			ZBX_STR2UINT64(triggerid, dbrow[4]);
+			zbx_vector_uint64_append(&dbsync_env.triggerids, triggerid);
+		}
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
-	while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+	if (0 != dbsync_env.changelog)
 	{
-		if (NULL == zbx_hashset_search(&ids, &function->functionid))
-			dbsync_add_row(sync, function->functionid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		int	i;
+
+		dbsync_remove_changelog_rows(sync, &dbsync_env.cache->functions, &functionids, &ids);
+
+		for (i = 0; i < functionids.values_num; i++)
+		{
+			if (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&dbsync_env.cache->functions,
+					&functionids.values[i])))
+			{
+				zbx_vector_uint64_append(&dbsync_env.triggerids, function->triggerid);
+			}
+		}
+
+		zbx_vector_uint64_sort(&dbsync_env.triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&dbsync_env.triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+	else
+	{
+		zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
+		while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &function->functionid))
+				dbsync_add_row(sync, function->functionid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
+	zbx_vector_uint64_destroy(&functionids);
 	zbx_hashset_destroy(&ids);
 	DBfree_result(result);
 
@@ -3717,9 +4049,11 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_preproc_op_t	*preproc;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	zbx_vector_uint64_t	item_preprocids;
 
-	if (NULL == (result = DBselect(
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select pp.item_preprocid,pp.itemid,pp.type,pp.params,pp.step,i.hostid,pp.error_handler,"
 				"pp.error_handler_params,i.type,i.key_,h.proxy_hostid"
 			" from item_preproc pp,items i,hosts h"
@@ -3728,12 +4062,53 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 				" and (h.proxy_hostid is null"
 					" or i.type in (%d,%d,%d,%d))"
 				" and h.status in (%d,%d)"
-				" and i.flags<>%d"
-			" order by pp.itemid",
+				" and i.flags<>%d",
 			ITEM_TYPE_INTERNAL, ITEM_TYPE_AGGREGATE, ITEM_TYPE_CALCULATED, ITEM_TYPE_DEPENDENT,
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE);
+
+	zbx_vector_uint64_create(&item_preprocids);
+
+	if (0 != dbsync_env.changelog)
+	{
+		zbx_dbsync_cond_t	conds[] = {{"pp.item_preprocid", &dbsync_env.item_preprocids},
+						{"pp.itemid", &dbsync_env.itemids}};
+
+		/* item type and host changes affect which preprocessing steps are synced, also */
+		/* cascade deletes do not fire database triggers on MySQL                        */
+		zbx_vector_uint64_append_array(&item_preprocids, dbsync_env.item_preprocids.values,
+				dbsync_env.item_preprocids.values_num);
+
+		zbx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
+		while (NULL != (preproc = (zbx_dc_preproc_op_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (FAIL != zbx_vector_uint64_bsearch(&dbsync_env.itemids, preproc->itemid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				zbx_vector_uint64_append(&item_preprocids, preproc->item_preprocid);
+			}
+		}
+
+		zbx_vector_uint64_sort(&item_preprocids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&item_preprocids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		if (FAIL == dbsync_add_changelog_condition(&sql, &sql_alloc, &sql_offset, conds, ARRSIZE(conds)))
+		{
+			zbx_vector_uint64_destroy(&item_preprocids);
+			zbx_free(sql);
+			dbsync_prepare(sync, 8, dbsync_item_pp_preproc_row);
+			return SUCCEED;
+		}
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by pp.itemid");
+
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
 	{
+		zbx_vector_uint64_destroy(&item_preprocids);
 		return FAIL;
 	}
 
@@ -3741,6 +4116,7 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
+		zbx_vector_uint64_destroy(&item_preprocids);
 		sync->dbresult = result;
 		return SUCCEED;
 	}
@@ -3780,14 +4156,22 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
-
-	while (NULL != (preproc = (zbx_dc_preproc_op_t *)zbx_hashset_iter_next(&iter)))
+	if (0 != dbsync_env.changelog)
 	{
-		if (NULL == zbx_hashset_search(&ids, &preproc->item_preprocid))
-			dbsync_add_row(sync, preproc->item_preprocid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		dbsync_remove_changelog_rows(sync, &dbsync_env.cache->preprocops, &item_preprocids, &ids);
+	}
+	else
+	{
+		zbx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
+
+		while (NULL != (preproc = (zbx_dc_preproc_op_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &preproc->item_preprocid))
+				dbsync_add_row(sync, preproc->item_preprocid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
+	zbx_vector_uint64_destroy(&item_preprocids);
 	zbx_hashset_destroy(&ids);
 	DBfree_result(result);
 
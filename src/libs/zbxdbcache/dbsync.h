@@ -39,6 +39,12 @@
 #define ZBX_DBSYNC_UPDATE_HOST_GROUPS		__UINT64_C(0x0020)
 #define ZBX_DBSYNC_UPDATE_MAINTENANCE_GROUPS	__UINT64_C(0x0040)
 
+/* changelog object types, sync with CHANGELOG entries in schema.tmpl */
+#define ZBX_DBSYNC_OBJ_ITEM		1
+#define ZBX_DBSYNC_OBJ_FUNCTION		2
+#define ZBX_DBSYNC_OBJ_TRIGGER		3
+#define ZBX_DBSYNC_OBJ_ITEM_PREPROC	4
+
 
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 #	define ZBX_HOST_TLS_OFFSET	4
@@ -110,6 +116,9 @@ struct zbx_dbsync
 
 void	zbx_dbsync_init_env(ZBX_DC_CONFIG *cache);
 void	zbx_dbsync_free_env(void);
+int	zbx_dbsync_env_load_changelog(void);
+void	zbx_dbsync_env_use_changelog(void);
+void	zbx_dbsync_env_flush_changelog(void);
 
 void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode);
 void	zbx_dbsync_clear(zbx_dbsync_t *sync);
@@ -41,6 +41,11 @@
  * In addition to active range value cache tracks item range for last 24 hours. Once
  * per day the active range is updated with daily range and the daily range is reset.
  *
+ * Full chunks of numeric (float, unsigned) items, except the head chunk, are packed -
+ * timestamps are stored as delta-of-delta and values XOR-ed with previous values using
+ * variable bit length encoding. Packed chunks are unpacked on the fly into process local
+ * buffers when read and converted back to value slots when values must be inserted.
+ *
  * If an item is already being cached the new values are automatically added to the cache
  * after being written into database.
  *
@@ -108,7 +113,13 @@ typedef struct zbx_vc_chunk
 	/* the number of item value slots in chunk */
 	int			slots_num;
 
-	/* the item value data */
+	/* the size of packed value data in bytes, 0 if values are stored in slots */
+	int			packed_size;
+
+	/* the unique packed chunk identifier, used to find unpacked chunk values */
+	zbx_uint64_t		packed_id;
+
+	/* the item value data, packed value data is stored starting at slots */
 	zbx_history_record_t	slots[1];
 }
 zbx_vc_chunk_t;
@@ -207,6 +218,9 @@ typedef struct
 	/* the minimum number of bytes to be freed when cache runs out of space */
 	size_t		min_free_request;
 
+	/* the last assigned packed chunk identifier */
+	zbx_uint64_t	last_packed_id;
+
 	/* the cached items */
 	zbx_hashset_t	items;
 
@@ -1427,6 +1441,509 @@ static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *i
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * numeric value chunk packing                                                *
+ *                                                                            *
+ ******************************************************************************/
+
+/* the offset of value data in chunk */
+#define ZBX_VC_CHUNK_DATA_OFFSET	((size_t)&((zbx_vc_chunk_t *)0)->slots)
+
+/* the maximum number of bits required to pack one value */
+#define ZBX_VC_PACKED_VALUE_BITS	(4 + 32 + 1 + 30 + 2 + 5 + 6 + 64)
+
+#define ZBX_VC_NS_BITS			30
+
+typedef struct
+{
+	unsigned char	*data;
+	size_t		offset;		/* the current offset in bits */
+}
+zbx_vc_bitstream_t;
+
+/* unpacked chunk values, two chunks are kept so values of neighbouring chunks can be compared */
+typedef struct
+{
+	zbx_uint64_t		packed_id;
+	zbx_history_record_t	*slots;
+}
+zbx_vc_unpacked_chunk_t;
+
+static zbx_vc_unpacked_chunk_t	vc_unpacked[2];
+static int			vc_unpacked_last = 0;
+
+static unsigned char		*vc_pack_buffer = NULL;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_bitstream_write                                               *
+ *                                                                            *
+ * Purpose: writes the lowest bits of value into bit stream                   *
+ *                                                                            *
+ * Comments: The bit stream data must be zero initialized.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_bitstream_write(zbx_vc_bitstream_t *bs, zbx_uint64_t value, int bits)
+{
+	while (0 < bits)
+	{
+		int	free_bits = 8 - (int)(bs->offset & 7), n;
+
+		n = MIN(bits, free_bits);
+		bs->data[bs->offset >> 3] |= (unsigned char)(((value >> (bits - n)) & ((1u << n) - 1)) <<
+				(free_bits - n));
+		bs->offset += n;
+		bits -= n;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_bitstream_read                                                *
+ *                                                                            *
+ * Purpose: reads the specified number of bits from bit stream                *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	vc_bitstream_read(zbx_vc_bitstream_t *bs, int bits)
+{
+	zbx_uint64_t	value = 0;
+
+	while (0 < bits)
+	{
+		int	avail_bits = 8 - (int)(bs->offset & 7), n;
+
+		n = MIN(bits, avail_bits);
+		value = (value << n) | ((bs->data[bs->offset >> 3] >> (avail_bits - n)) & ((1u << n) - 1));
+		bs->offset += n;
+		bits -= n;
+	}
+
+	return value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_value_to_bits                                                 *
+ *                                                                            *
+ * Purpose: returns bit representation of numeric history value               *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	vc_value_to_bits(const history_value_t *value, unsigned char value_type)
+{
+	zbx_uint64_t	bits;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		memcpy(&bits, &value->dbl, sizeof(bits));
+	else
+		bits = value->ui64;
+
+	return bits;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_bits_to_value                                                 *
+ *                                                                            *
+ * Purpose: restores numeric history value from its bit representation        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_bits_to_value(zbx_uint64_t bits, unsigned char value_type, history_value_t *value)
+{
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		memcpy(&value->dbl, &bits, sizeof(bits));
+	else
+		value->ui64 = bits;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_count_leading_zeros                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_count_leading_zeros(zbx_uint64_t value)
+{
+	int	n = 0;
+
+	while (0 == (value & __UINT64_C(0x8000000000000000)))
+	{
+		value <<= 1;
+		n++;
+	}
+
+	return n;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_count_trailing_zeros                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_count_trailing_zeros(zbx_uint64_t value)
+{
+	int	n = 0;
+
+	while (0 == (value & 1))
+	{
+		value >>= 1;
+		n++;
+	}
+
+	return n;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_pack_values                                                   *
+ *                                                                            *
+ * Purpose: packs numeric item values                                         *
+ *                                                                            *
+ * Parameters: values     - [IN] the values to pack                           *
+ *             values_num - [IN] the number of values                         *
+ *             value_type - [IN] the value type (float or unsigned)           *
+ *             data       - [OUT] the packed data, must be zero initialized   *
+ *                                                                            *
+ * Return value: the size of packed data in bytes                             *
+ *                                                                            *
+ * Comments: The first value is stored as is. Following timestamp seconds are *
+ *           stored as delta-of-delta, nanoseconds only when changed and      *
+ *           values as XOR with the previous value (Gorilla encoding).        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_pack_values(const zbx_history_record_t *values, int values_num, unsigned char value_type,
+		unsigned char *data)
+{
+	zbx_vc_bitstream_t	bs = {data, 0};
+	zbx_uint64_t		prev_bits, bits, xor_bits;
+	int			i, prev_leading = -1, prev_trailing = 0, leading, trailing;
+	zbx_int64_t		prev_delta = 0, delta, dod;
+
+	vc_bitstream_write(&bs, (zbx_uint32_t)values[0].timestamp.sec, 32);
+	vc_bitstream_write(&bs, (zbx_uint64_t)values[0].timestamp.ns, ZBX_VC_NS_BITS);
+	prev_bits = vc_value_to_bits(&values[0].value, value_type);
+	vc_bitstream_write(&bs, prev_bits, 64);
+
+	for (i = 1; i < values_num; i++)
+	{
+		delta = (zbx_int64_t)values[i].timestamp.sec - values[i - 1].timestamp.sec;
+		dod = delta - prev_delta;
+
+		if (0 == dod)
+			vc_bitstream_write(&bs, 0, 1);
+		else if (-63 <= dod && 64 >= dod)
+			vc_bitstream_write(&bs, (__UINT64_C(2) << 7) | (zbx_uint64_t)(dod + 63), 2 + 7);
+		else if (-255 <= dod && 256 >= dod)
+			vc_bitstream_write(&bs, (__UINT64_C(6) << 9) | (zbx_uint64_t)(dod + 255), 3 + 9);
+		else if (-2047 <= dod && 2048 >= dod)
+			vc_bitstream_write(&bs, (__UINT64_C(14) << 12) | (zbx_uint64_t)(dod + 2047), 4 + 12);
+		else
+		{
+			/* large changes are stored as absolute timestamp */
+			vc_bitstream_write(&bs, 15, 4);
+			vc_bitstream_write(&bs, (zbx_uint32_t)values[i].timestamp.sec, 32);
+		}
+
+		prev_delta = delta;
+
+		if (values[i].timestamp.ns == values[i - 1].timestamp.ns)
+		{
+			vc_bitstream_write(&bs, 0, 1);
+		}
+		else
+		{
+			vc_bitstream_write(&bs, 1, 1);
+			vc_bitstream_write(&bs, (zbx_uint64_t)values[i].timestamp.ns, ZBX_VC_NS_BITS);
+		}
+
+		bits = vc_value_to_bits(&values[i].value, value_type);
+
+		if (0 == (xor_bits = bits ^ prev_bits))
+		{
+			vc_bitstream_write(&bs, 0, 1);
+		}
+		else
+		{
+			leading = vc_count_leading_zeros(xor_bits);
+			trailing = vc_count_trailing_zeros(xor_bits);
+
+			if (31 < leading)
+				leading = 31;
+
+			if (-1 != prev_leading && leading >= prev_leading && trailing >= prev_trailing)
+			{
+				/* meaningful bits fit into the previous window */
+				vc_bitstream_write(&bs, 2, 2);
+				vc_bitstream_write(&bs, xor_bits >> prev_trailing, 64 - prev_leading - prev_trailing);
+			}
+			else
+			{
+				vc_bitstream_write(&bs, 3, 2);
+				vc_bitstream_write(&bs, (zbx_uint64_t)leading, 5);
+				vc_bitstream_write(&bs, (zbx_uint64_t)(64 - leading - trailing - 1), 6);
+				vc_bitstream_write(&bs, xor_bits >> trailing, 64 - leading - trailing);
+
+				prev_leading = leading;
+				prev_trailing = trailing;
+			}
+		}
+
+		prev_bits = bits;
+	}
+
+	return (int)((bs.offset + 7) >> 3);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_unpack_values                                                 *
+ *                                                                            *
+ * Purpose: unpacks numeric item values packed by vc_pack_values()            *
+ *                                                                            *
+ * Parameters: data       - [IN] the packed data                              *
+ *             values_num - [IN] the number of values                         *
+ *             value_type - [IN] the value type (float or unsigned)           *
+ *             values     - [OUT] the unpacked values                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_unpack_values(const unsigned char *data, int values_num, unsigned char value_type,
+		zbx_history_record_t *values)
+{
+	zbx_vc_bitstream_t	bs = {(unsigned char *)data, 0};
+	zbx_uint64_t		prev_bits, xor_bits;
+	int			i, prev_leading = 0, prev_trailing = 0, meaningful;
+	zbx_int64_t		prev_delta = 0, dod;
+
+	values[0].timestamp.sec = (int)vc_bitstream_read(&bs, 32);
+	values[0].timestamp.ns = (int)vc_bitstream_read(&bs, ZBX_VC_NS_BITS);
+	prev_bits = vc_bitstream_read(&bs, 64);
+	vc_bits_to_value(prev_bits, value_type, &values[0].value);
+
+	for (i = 1; i < values_num; i++)
+	{
+		if (0 == vc_bitstream_read(&bs, 1))
+			dod = 0;
+		else if (0 == vc_bitstream_read(&bs, 1))
+			dod = (zbx_int64_t)vc_bitstream_read(&bs, 7) - 63;
+		else if (0 == vc_bitstream_read(&bs, 1))
+			dod = (zbx_int64_t)vc_bitstream_read(&bs, 9) - 255;
+		else if (0 == vc_bitstream_read(&bs, 1))
+			dod = (zbx_int64_t)vc_bitstream_read(&bs, 12) - 2047;
+		else
+			dod = (zbx_int64_t)(int)vc_bitstream_read(&bs, 32) - values[i - 1].timestamp.sec - prev_delta;
+
+		prev_delta += dod;
+		values[i].timestamp.sec = (int)(values[i - 1].timestamp.sec + prev_delta);
+
+		if (0 == vc_bitstream_read(&bs, 1))
+			values[i].timestamp.ns = values[i - 1].timestamp.ns;
+		else
+			values[i].timestamp.ns = (int)vc_bitstream_read(&bs, ZBX_VC_NS_BITS);
+
+		if (0 != vc_bitstream_read(&bs, 1))
+		{
+			if (1 == vc_bitstream_read(&bs, 1))
+			{
+				prev_leading = (int)vc_bitstream_read(&bs, 5);
+				meaningful = (int)vc_bitstream_read(&bs, 6) + 1;
+				prev_trailing = 64 - prev_leading - meaningful;
+			}
+			else
+				meaningful = 64 - prev_leading - prev_trailing;
+
+			xor_bits = vc_bitstream_read(&bs, meaningful) << prev_trailing;
+			prev_bits ^= xor_bits;
+		}
+
+		vc_bits_to_value(prev_bits, value_type, &values[i].value);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_chunk_slots                                                  *
+ *                                                                            *
+ * Purpose: returns chunk value slots, unpacking packed chunk if necessary    *
+ *                                                                            *
+ * Parameters: chunk      - [IN] the chunk                                    *
+ *             value_type - [IN] the item value type                          *
+ *                                                                            *
+ * Return value: the value slots, indexed as chunk slots                      *
+ *                                                                            *
+ * Comments: Packed chunk values are unpacked into process local buffers.     *
+ *           Values of the two last accessed packed chunks are kept, so the   *
+ *           returned slots are valid until values of two other packed chunks *
+ *           are requested.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_history_record_t	*vch_chunk_slots(const zbx_vc_chunk_t *chunk, unsigned char value_type)
+{
+	zbx_vc_unpacked_chunk_t	*unpacked;
+
+	if (0 == chunk->packed_size)
+		return (zbx_history_record_t *)chunk->slots;
+
+	if (vc_unpacked[vc_unpacked_last].packed_id == chunk->packed_id)
+		return vc_unpacked[vc_unpacked_last].slots;
+
+	vc_unpacked_last ^= 1;
+	unpacked = &vc_unpacked[vc_unpacked_last];
+
+	if (unpacked->packed_id == chunk->packed_id)
+		return unpacked->slots;
+
+	if (NULL == unpacked->slots)
+	{
+		unpacked->slots = (zbx_history_record_t *)zbx_malloc(NULL,
+				ZBX_VC_MAX_CHUNK_RECORDS * sizeof(zbx_history_record_t));
+	}
+
+	vc_unpack_values((const unsigned char *)chunk->slots, chunk->slots_num, value_type, unpacked->slots);
+	unpacked->packed_id = chunk->packed_id;
+
+	return unpacked->slots;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_tail_sec                                                *
+ *                                                                            *
+ * Purpose: returns timestamp seconds of the first (oldest) cached value      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_tail_sec(const zbx_vc_item_t *item)
+{
+	return vch_chunk_slots(item->tail, item->value_type)[item->tail->first_value].timestamp.sec;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_replace_chunk                                           *
+ *                                                                            *
+ * Purpose: replaces item chunk with another chunk in the item chunk list     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_replace_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, zbx_vc_chunk_t *chunk_new)
+{
+	chunk_new->prev = chunk->prev;
+	chunk_new->next = chunk->next;
+	chunk_new->first_value = chunk->first_value;
+	chunk_new->last_value = chunk->last_value;
+	chunk_new->slots_num = chunk->slots_num;
+
+	if (NULL != chunk->prev)
+		chunk->prev->next = chunk_new;
+	else
+		item->tail = chunk_new;
+
+	if (NULL != chunk->next)
+		chunk->next->prev = chunk_new;
+	else
+		item->head = chunk_new;
+
+	__vc_mem_free_func(chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_pack_chunk                                              *
+ *                                                                            *
+ * Purpose: packs numeric item chunk values                                   *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to pack, freed if packed                *
+ *                                                                            *
+ * Return value: the packed chunk replacing the specified chunk or the        *
+ *               specified chunk if it was not packed                         *
+ *                                                                            *
+ * Comments: The chunk is left unchanged if there is not enough memory or     *
+ *           packing does not reduce the chunk size.                          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_chunk_t	*vch_item_pack_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	zbx_vc_chunk_t	*chunk_new;
+	int		values_num, size;
+
+	values_num = chunk->last_value - chunk->first_value + 1;
+
+	if (NULL == vc_pack_buffer)
+	{
+		vc_pack_buffer = (unsigned char *)zbx_malloc(NULL,
+				(ZBX_VC_MAX_CHUNK_RECORDS * ZBX_VC_PACKED_VALUE_BITS + 7) / 8);
+	}
+
+	memset(vc_pack_buffer, 0, (values_num * ZBX_VC_PACKED_VALUE_BITS + 7) / 8);
+	size = vc_pack_values(chunk->slots + chunk->first_value, values_num, item->value_type, vc_pack_buffer);
+
+	if (size >= (int)(sizeof(zbx_history_record_t) * chunk->slots_num))
+		return chunk;
+
+	if (NULL == (chunk_new = (zbx_vc_chunk_t *)__vc_mem_malloc_func(NULL, ZBX_VC_CHUNK_DATA_OFFSET + size)))
+		return chunk;
+
+	memcpy(chunk_new->slots, vc_pack_buffer, size);
+	chunk_new->packed_size = size;
+	chunk_new->packed_id = ++vc_cache->last_packed_id;
+
+	vch_item_replace_chunk(item, chunk, chunk_new);
+
+	/* only the used slots are packed, so the values are renumbered starting with 0 */
+	chunk_new->first_value = 0;
+	chunk_new->last_value = values_num - 1;
+	chunk_new->slots_num = values_num;
+
+	return chunk_new;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_unpack_chunk                                            *
+ *                                                                            *
+ * Purpose: converts packed chunk back to chunk with value slots              *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN/OUT] the chunk to unpack, replaced with the new    *
+ *                              chunk on success                              *
+ *                                                                            *
+ * Return value: SUCCEED - the chunk was unpacked successfully                *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_unpack_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t **chunk)
+{
+	zbx_vc_chunk_t	*chunk_new;
+	size_t		size;
+
+	size = sizeof(zbx_vc_chunk_t) + sizeof(zbx_history_record_t) * ((*chunk)->slots_num - 1);
+
+	if (NULL == (chunk_new = (zbx_vc_chunk_t *)vc_item_malloc(item, size)))
+		return FAIL;
+
+	memset(chunk_new, 0, sizeof(zbx_vc_chunk_t));
+	vc_unpack_values((const unsigned char *)(*chunk)->slots, (*chunk)->slots_num, item->value_type,
+			chunk_new->slots);
+
+	vch_item_replace_chunk(item, *chunk, chunk_new);
+	*chunk = chunk_new;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_is_packable                                             *
+ *                                                                            *
+ * Purpose: checks if item values can be stored in packed chunks              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_is_packable(const zbx_vc_item_t *item)
+{
+	if (ITEM_VALUE_TYPE_FLOAT == item->value_type || ITEM_VALUE_TYPE_UINT64 == item->value_type)
+		return SUCCEED;
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: vch_chunk_find_last_value_before                                 *
@@ -1434,8 +1951,9 @@ static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *i
  * Purpose: find the index of the last value in chunk with timestamp less or  *
  *          equal to the specified timestamp.                                 *
  *                                                                            *
- * Parameters:  chunk - [IN] the chunk                                        *
- *              ts    - [IN] the target timestamp                             *
+ * Parameters:  chunk      - [IN] the chunk                                   *
+ *              value_type - [IN] the item value type                         *
+ *              ts         - [IN] the target timestamp                        *
  *                                                                            *
  * Return value: The index of the last value in chunk with timestamp less or  *
  *               equal to the specified timestamp.                            *
@@ -1443,12 +1961,16 @@ static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *i
  *               values have timestamps greater than the target timestamp).   *
  *                                                                            *
  ******************************************************************************/
-static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, unsigned char value_type,
+		const zbx_timespec_t *ts)
 {
-	int	start = chunk->first_value, end = chunk->last_value, middle;
+	int			start = chunk->first_value, end = chunk->last_value, middle;
+	zbx_history_record_t	*slots;
+
+	slots = vch_chunk_slots(chunk, value_type);
 
 	/* check if the last value timestamp is already greater or equal to the specified timestamp */
-	if (0 >= zbx_timespec_compare(&chunk->slots[end].timestamp, ts))
+	if (0 >= zbx_timespec_compare(&slots[end].timestamp, ts))
 		return end;
 
 	/* chunk contains only one value, which did not pass the above check, return failure */
@@ -1460,13 +1982,13 @@ static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const z
 	{
 		middle = start + (end - start) / 2;
 
-		if (0 < zbx_timespec_compare(&chunk->slots[middle].timestamp, ts))
+		if (0 < zbx_timespec_compare(&slots[middle].timestamp, ts))
 		{
 			end = middle;
 			continue;
 		}
 
-		if (0 >= zbx_timespec_compare(&chunk->slots[middle + 1].timestamp, ts))
+		if (0 >= zbx_timespec_compare(&slots[middle + 1].timestamp, ts))
 		{
 			start = middle;
 			continue;
@@ -1510,16 +2032,17 @@ static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec
 
 	index = chunk->last_value;
 
-	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
+	if (0 < zbx_timespec_compare(&vch_chunk_slots(chunk, item->value_type)[index].timestamp, ts))
 	{
-		while (0 < zbx_timespec_compare(&chunk->slots[chunk->first_value].timestamp, ts))
+		while (0 < zbx_timespec_compare(&vch_chunk_slots(chunk, item->value_type)[chunk->first_value].timestamp,
+				ts))
 		{
 			chunk = chunk->prev;
 			/* there are no values for requested range, return failure */
 			if (NULL == chunk)
 				return FAIL;
 		}
-		index = vch_chunk_find_last_value_before(chunk, ts);
+		index = vch_chunk_find_last_value_before(chunk, item->value_type, ts);
 	}
 
 	*pchunk = chunk;
@@ -1656,7 +2179,11 @@ static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
 	size_t	freed;
 
-	freed = sizeof(zbx_vc_chunk_t) + (chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+	if (0 != chunk->packed_size)
+		freed = ZBX_VC_CHUNK_DATA_OFFSET + chunk->packed_size;
+	else
+		freed = sizeof(zbx_vc_chunk_t) + (chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+
 	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
 
 	__vc_mem_free_func(chunk);
@@ -1709,19 +2236,23 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item)
 	{
 		zbx_vc_chunk_t	*tail = item->tail;
 		zbx_vc_chunk_t	*chunk = tail;
-		int		timestamp;
+		int		timestamp, last_sec;
 
 		timestamp = time(NULL) - item->active_range;
 
 		/* try to remove chunks with all history values older than maximum request range */
-		while (NULL != chunk && chunk->slots[chunk->last_value].timestamp.sec < timestamp &&
-				chunk->slots[chunk->last_value].timestamp.sec !=
-						item->head->slots[item->head->last_value].timestamp.sec)
+		while (NULL != chunk &&
+				(last_sec = vch_chunk_slots(chunk, item->value_type)[chunk->last_value].timestamp.sec) <
+				timestamp && last_sec != item->head->slots[item->head->last_value].timestamp.sec)
 		{
+			zbx_history_record_t	*next_slots;
+
 			/* don't remove the head chunk */
 			if (NULL == (next = chunk->next))
 				break;
 
+			next_slots = vch_chunk_slots(next, item->value_type);
+
 			/* Values with the same timestamps (seconds resolution) always should be either   */
 			/* kept in cache or removed together. There should not be a case when one of them */
 			/* is in cache and the second is dropped.                                         */
@@ -1730,10 +2261,9 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item)
 			/* In this case increase the first value index of the next chunk until the first  */
 			/* value timestamp is greater.                                                    */
 
-			if (next->slots[next->first_value].timestamp.sec != next->slots[next->last_value].timestamp.sec)
+			if (next_slots[next->first_value].timestamp.sec != next_slots[next->last_value].timestamp.sec)
 			{
-				while (next->slots[next->first_value].timestamp.sec ==
-						chunk->slots[chunk->last_value].timestamp.sec)
+				while (next_slots[next->first_value].timestamp.sec == last_sec)
 				{
 					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
 					next->first_value++;
@@ -1741,7 +2271,7 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item)
 			}
 
 			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
-			item->db_cached_from = chunk->slots[chunk->last_value].timestamp.sec + 1;
+			item->db_cached_from = last_sec + 1;
 
 			vch_item_remove_chunk(item, chunk);
 
@@ -1774,16 +2304,17 @@ static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
 		item->status = 0;
 
 	/* try to remove chunks with all history values older than the timestamp */
-	while (NULL != chunk && chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+	while (NULL != chunk && vch_chunk_slots(chunk, item->value_type)[chunk->first_value].timestamp.sec < timestamp)
 	{
-		zbx_vc_chunk_t	*next;
+		zbx_vc_chunk_t		*next;
+		zbx_history_record_t	*slots = vch_chunk_slots(chunk, item->value_type);
 
 		/* If chunk contains values with timestamp greater or equal - remove */
 		/* only the values with less timestamp. Otherwise remove the while   */
 		/* chunk and check next one.                                         */
-		if (chunk->slots[chunk->last_value].timestamp.sec >= timestamp)
+		if (slots[chunk->last_value].timestamp.sec >= timestamp)
 		{
-			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+			while (slots[chunk->first_value].timestamp.sec < timestamp)
 			{
 				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
 				chunk->first_value++;
@@ -1823,7 +2354,8 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 	if (NULL != item->head &&
 			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
 	{
-		if (0 < zbx_history_record_compare_asc_func(&item->tail->slots[item->tail->first_value], value))
+		if (0 < zbx_history_record_compare_asc_func(
+				&vch_chunk_slots(item->tail, item->value_type)[item->tail->first_value], value))
 		{
 			/* If the added value has the same or older timestamp as the first value in cache */
 			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
@@ -1844,6 +2376,16 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 			goto out;
 		}
 
+		/* values are moved between slots, unpack chunks that can be affected by the insertion */
+		for (schunk = item->head; NULL != schunk; schunk = schunk->prev)
+		{
+			if (0 != schunk->packed_size && FAIL == vch_item_unpack_chunk(item, &schunk))
+				goto out;
+
+			if (0 >= zbx_timespec_compare(&schunk->slots[schunk->first_value].timestamp, &value->timestamp))
+				break;
+		}
+
 		sindex = item->head->last_value;
 		schunk = item->head;
 
@@ -1905,8 +2447,15 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
 		goto out;
 
-	ret = SUCCEED;
-out:
+	/* pack the chunks filled before the head chunk */
+	if (SUCCEED == vch_item_is_packable(item))
+	{
+		for (chunk = item->head->prev; NULL != chunk && 0 == chunk->packed_size; chunk = chunk->prev)
+			chunk = vch_item_pack_chunk(item, chunk);
+	}
+
+	ret = SUCCEED;
+out:
 	return ret;
 }
 
@@ -1935,7 +2484,7 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 	/* skip values already added to the item cache by another process */
 	if (NULL != item->tail)
 	{
-		int	sec = item->tail->slots[item->tail->first_value].timestamp.sec;
+		int	sec = vch_item_tail_sec(item);
 
 		while (--count >= 0 && values[count].timestamp.sec >= sec)
 			;
@@ -1946,8 +2495,9 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 	{
 		int	copy_slots, nslots = 0;
 
-		/* find the number of free slots on the left side in first (tail) chunk */
-		if (NULL != item->tail)
+		/* find the number of free slots on the left side in first (tail) chunk, */
+		/* packed chunks are never modified                                      */
+		if (NULL != item->tail && 0 == item->tail->packed_size)
 			nslots = item->tail->first_value;
 
 		if (0 == nslots)
@@ -1969,6 +2519,18 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 			goto out;
 	}
 
+	/* pack the filled chunks, leaving the head chunk for new values */
+	if (SUCCEED == vch_item_is_packable(item))
+	{
+		zbx_vc_chunk_t	*chunk;
+
+		for (chunk = item->tail; NULL != chunk && item->head != chunk && 0 == chunk->packed_size;
+				chunk = chunk->next)
+		{
+			chunk = vch_item_pack_chunk(item, chunk);
+		}
+	}
+
 	ret = SUCCEED;
 out:
 	return ret;
@@ -2008,7 +2570,7 @@ static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
 	if (NULL != (*item)->tail)
 	{
 		/* we need to get item values before the first cached value, but not including it */
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+		range_end = vch_item_tail_sec(*item) - 1;
 	}
 	else
 		range_end = ZBX_JAN_2038;
@@ -2115,7 +2677,7 @@ static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int ran
 
 	/* get the end timestamp to which (including) the values should be cached */
 	if (NULL != (*item)->head)
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+		range_end = vch_item_tail_sec(*item) - 1;
 	else
 		range_end = ZBX_JAN_2038;
 
@@ -2170,8 +2732,7 @@ static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int ran
 
 	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
 	{
-		vc_item_update_db_cached_from(*item,
-				(*item)->tail->slots[(*item)->tail->first_value].timestamp.sec);
+		vc_item_update_db_cached_from(*item, vch_item_tail_sec(*item));
 	}
 	else if (0 != range_start)
 		vc_item_update_db_cached_from(*item, range_start);
@@ -2198,9 +2759,10 @@ out:
 static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
 		const zbx_timespec_t *ts)
 {
-	int		index, now;
-	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
-	zbx_vc_chunk_t	*chunk;
+	int			index, now;
+	zbx_timespec_t		start = {ts->sec - seconds, ts->ns};
+	zbx_vc_chunk_t		*chunk;
+	zbx_history_record_t	*slots;
 
 	/* Check if maximum request range is not set and all data are cached.  */
 	/* Because that indicates there was a count based request with unknown */
@@ -2220,15 +2782,18 @@ static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_hi
 	}
 
 	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	slots = vch_chunk_slots(chunk, item->value_type);
+
+	while (0 < zbx_timespec_compare(&slots[chunk->last_value].timestamp, &start))
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
+			vc_history_record_vector_append(values, item->value_type, &slots[index--]);
 
 		if (NULL == (chunk = chunk->prev))
 			break;
 
 		index = chunk->last_value;
+		slots = vch_chunk_slots(chunk, item->value_type);
 	}
 }
 
@@ -2252,9 +2817,10 @@ static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_hi
 static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
 		int seconds, int count, const zbx_timespec_t *ts)
 {
-	int		index, now, range_timestamp;
-	zbx_vc_chunk_t	*chunk;
-	zbx_timespec_t	start;
+	int			index, now, range_timestamp;
+	zbx_vc_chunk_t		*chunk;
+	zbx_timespec_t		start;
+	zbx_history_record_t	*slots;
 
 	/* set start timestamp of the requested time period */
 	if (0 != seconds)
@@ -2277,11 +2843,13 @@ static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vecto
 	/* fill the values vector with item history values until the <count> values are read    */
 	/* or no more values within specified time period                                       */
 	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	slots = vch_chunk_slots(chunk, item->value_type);
+
+	while (0 < zbx_timespec_compare(&slots[chunk->last_value].timestamp, &start))
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
 		{
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+			vc_history_record_vector_append(values, item->value_type, &slots[index--]);
 
 			if (values->values_num == count)
 				goto out;
@@ -2291,6 +2859,7 @@ static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vecto
 			break;
 
 		index = chunk->last_value;
+		slots = vch_chunk_slots(chunk, item->value_type);
 	}
 out:
 	if (count > values->values_num)
@@ -2387,6 +2956,291 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_records                                             *
+ *                                                                            *
+ * Purpose: aggregates numeric history records                                *
+ *                                                                            *
+ * Parameters: aggr       - [IN/OUT] the aggregate                            *
+ *             value_type - [IN] the item value type                          *
+ *             records    - [IN] the history records                          *
+ *             first      - [IN] the index of the first (oldest) record       *
+ *             last       - [IN] the index of the last (newest) record        *
+ *                                                                            *
+ * Comments: The records are aggregated starting with the newest one, in the  *
+ *           same order as zbx_vc_get_values() returns them, so that floating *
+ *           point results match the ones calculated from values vector.      *
+ *           For the same reason the loops are kept scalar - vectorized       *
+ *           partial sums would reorder the additions. The slots also         *
+ *           interleave timestamps with values, so there is no contiguous     *
+ *           value array to load into wide registers.                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_records(zbx_vc_aggregate_t *aggr, int value_type, const zbx_history_record_t *records,
+		int first, int last)
+{
+	int	i, n, num = last - first + 1;
+
+	if (0 >= num)
+		return;
+
+	switch (aggr->func)
+	{
+		case ZBX_VC_AGGREGATE_SUM:
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			{
+				double	sum = aggr->value.dbl;
+
+				for (i = last; i >= first; i--)
+					sum += records[i].value.dbl;
+
+				aggr->value.dbl = sum;
+			}
+			else
+			{
+				zbx_uint64_t	sum = aggr->value.ui64;
+
+				for (i = last; i >= first; i--)
+					sum += records[i].value.ui64;
+
+				aggr->value.ui64 = sum;
+			}
+			break;
+		case ZBX_VC_AGGREGATE_AVG:
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			{
+				double	avg = aggr->value.dbl;
+
+				/* calculate running average to avoid overflow */
+				for (i = last, n = aggr->values_num + 1; i >= first; i--, n++)
+					avg += records[i].value.dbl / n - avg / n;
+
+				aggr->value.dbl = avg;
+			}
+			else
+			{
+				double	sum = aggr->value.dbl;
+
+				/* the sum is divided by the number of values in zbx_vc_get_aggregate() */
+				for (i = last; i >= first; i--)
+					sum += records[i].value.ui64;
+
+				aggr->value.dbl = sum;
+			}
+			break;
+		case ZBX_VC_AGGREGATE_MIN:
+			if (0 == aggr->values_num)
+				aggr->value = records[last--].value;
+
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			{
+				double	min = aggr->value.dbl;
+
+				for (i = last; i >= first; i--)
+				{
+					if (records[i].value.dbl < min)
+						min = records[i].value.dbl;
+				}
+
+				aggr->value.dbl = min;
+			}
+			else
+			{
+				zbx_uint64_t	min = aggr->value.ui64;
+
+				for (i = last; i >= first; i--)
+				{
+					if (records[i].value.ui64 < min)
+						min = records[i].value.ui64;
+				}
+
+				aggr->value.ui64 = min;
+			}
+			break;
+		case ZBX_VC_AGGREGATE_MAX:
+			if (0 == aggr->values_num)
+				aggr->value = records[last--].value;
+
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			{
+				double	max = aggr->value.dbl;
+
+				for (i = last; i >= first; i--)
+				{
+					if (records[i].value.dbl > max)
+						max = records[i].value.dbl;
+				}
+
+				aggr->value.dbl = max;
+			}
+			else
+			{
+				zbx_uint64_t	max = aggr->value.ui64;
+
+				for (i = last; i >= first; i--)
+				{
+					if (records[i].value.ui64 > max)
+						max = records[i].value.ui64;
+				}
+
+				aggr->value.ui64 = max;
+			}
+			break;
+	}
+
+	aggr->values_num += num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_aggregate_cached_values                                 *
+ *                                                                            *
+ * Purpose: aggregates item history data directly in cache chunks             *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             aggr    - [IN/OUT] the aggregate                               *
+ *             seconds - [IN] the time period                                 *
+ *             count   - [IN] the number of history values to aggregate       *
+ *                            (0 - all values in the time period)             *
+ *             ts      - [IN] the target timestamp                            *
+ *                                                                            *
+ * Comments: This function aggregates the same values as would be returned by *
+ *           vch_item_get_values_by_time() or                                 *
+ *           vch_item_get_values_by_time_and_count() functions, but without   *
+ *           copying them to a vector.                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_aggregate_cached_values(zbx_vc_item_t *item, zbx_vc_aggregate_t *aggr, int seconds,
+		int count, const zbx_timespec_t *ts)
+{
+	int			index, first, now, range_timestamp, oldest_sec = 0;
+	zbx_vc_chunk_t		*chunk;
+	zbx_timespec_t		start = {0, 0};
+	zbx_history_record_t	*slots;
+
+	if (0 == count || 0 != seconds)
+	{
+		start.sec = ts->sec - seconds;
+		start.ns = ts->ns;
+	}
+
+	if (0 == count && (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status))
+	{
+		now = time(NULL);
+		/* add another second to include nanosecond shifts */
+		vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
+	}
+
+	if (SUCCEED == vch_item_get_last_value(item, ts, &chunk, &index))
+	{
+		slots = vch_chunk_slots(chunk, item->value_type);
+
+		while (0 < zbx_timespec_compare(&slots[chunk->last_value].timestamp, &start))
+		{
+			/* find the oldest value in chunk with timestamp greater than start timestamp */
+			if (0 < zbx_timespec_compare(&slots[chunk->first_value].timestamp, &start))
+				first = chunk->first_value;
+			else
+				first = vch_chunk_find_last_value_before(chunk, item->value_type, &start) + 1;
+
+			if (0 != count && index - first + 1 > count - aggr->values_num)
+				first = index - (count - aggr->values_num) + 1;
+
+			if (first <= index)
+			{
+				vc_aggregate_records(aggr, item->value_type, slots, first, index);
+				oldest_sec = slots[first].timestamp.sec;
+			}
+
+			if ((0 != count && aggr->values_num == count) || first > chunk->first_value)
+				break;
+
+			if (NULL == (chunk = chunk->prev))
+				break;
+
+			index = chunk->last_value;
+			slots = vch_chunk_slots(chunk, item->value_type);
+		}
+	}
+
+	if (0 == count)
+		return;
+
+	if (count > aggr->values_num)
+	{
+		if (0 == seconds)
+			return;
+
+		/* not enough data in the requested period, set the range equal to the period plus */
+		/* one second to include nanosecond shifts                                         */
+		range_timestamp = ts->sec - seconds;
+	}
+	else
+	{
+		/* the requested number of values was aggregated, set the range to the oldest value timestamp */
+		range_timestamp = oldest_sec - 1;
+	}
+
+	now = time(NULL);
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_aggregate                                           *
+ *                                                                            *
+ * Purpose: aggregates item history data, updating cache from database if     *
+ *          necessary                                                         *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             aggr    - [IN/OUT] the aggregate                               *
+ *             seconds - [IN] the time period                                 *
+ *             count   - [IN] the number of history values to aggregate       *
+ *             ts      - [IN] the target timestamp                            *
+ *                                                                            *
+ * Return value: SUCCEED - the values were aggregated successfully            *
+ *               FAIL    - failed to cache values from database               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_aggregate(zbx_vc_item_t *item, zbx_vc_aggregate_t *aggr, int seconds, int count,
+		const zbx_timespec_t *ts)
+{
+	int	ret, records_read, hits, misses, range_start;
+
+	if (0 == count)
+	{
+		if (0 > (range_start = ts->sec - seconds))
+			range_start = 0;
+
+		if (FAIL == (ret = vch_item_cache_values_by_time(&item, range_start)))
+			goto out;
+	}
+	else
+	{
+		range_start = (0 == seconds ? 0 : ts->sec - seconds);
+
+		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(&item, range_start, count, ts)))
+			goto out;
+	}
+
+	records_read = ret;
+
+	vch_item_aggregate_cached_values(item, aggr, seconds, count, ts);
+
+	if (records_read > aggr->values_num)
+		records_read = aggr->values_num;
+
+	hits = aggr->values_num - records_read;
+	misses = records_read;
+
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_STATS, hits, misses);
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: vch_item_free_cache                                              *
@@ -2565,6 +3419,34 @@ void	zbx_vc_reset(void)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_remove_failed_items                                           *
+ *                                                                            *
+ * Purpose: removes items with values that failed to be written to history    *
+ *          storage after they were added to value cache                      *
+ *                                                                            *
+ * Parameters: itemids - [IN] the item identifiers                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_remove_failed_items(zbx_vector_uint64_t *itemids)
+{
+	int	i;
+
+	if (0 == itemids->values_num || ZBX_VC_DISABLED == vc_state)
+		return;
+
+	zbx_vector_uint64_sort(itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	WRLOCK_CACHE;
+
+	for (i = 0; i < itemids->values_num; i++)
+		vc_remove_item_by_id(itemids->values[i]);
+
+	UNLOCK_CACHE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_vc_add_values                                                *
@@ -2576,15 +3458,27 @@ void	zbx_vc_reset(void)
  * Return value: SUCCEED - the values were added successfully                 *
  *               FAIL    - otherwise                                          *
  *                                                                            *
+ * Comments: History storage can confirm the write later, in this case the    *
+ *           items of previously added values are removed from cache if the   *
+ *           write failed, so the requests go directly to the database.       *
+ *                                                                            *
  ******************************************************************************/
 int	zbx_vc_add_values(zbx_vector_ptr_t *history)
 {
 	zbx_vc_item_t		*item;
-	int 			i;
+	int 			i, ret;
 	ZBX_DC_HISTORY		*h;
 	time_t			expire_timestamp;
+	zbx_vector_uint64_t	failed_itemids;
 
-	if (FAIL == zbx_history_add_values(history))
+	zbx_vector_uint64_create(&failed_itemids);
+
+	ret = zbx_history_add_values(history, &failed_itemids);
+	vc_remove_failed_items(&failed_itemids);
+
+	zbx_vector_uint64_destroy(&failed_itemids);
+
+	if (FAIL == ret)
 		return FAIL;
 
 	if (ZBX_VC_DISABLED == vc_state)
@@ -2628,6 +3522,26 @@ int	zbx_vc_add_values(zbx_vector_ptr_t *history)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_wait_values                                               *
+ *                                                                            *
+ * Purpose: waits until the item values added by zbx_vc_add_values() are      *
+ *          written to history storage                                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_wait_values(void)
+{
+	zbx_vector_uint64_t	failed_itemids;
+
+	zbx_vector_uint64_create(&failed_itemids);
+
+	zbx_history_wait(&failed_itemids);
+	vc_remove_failed_items(&failed_itemids);
+
+	zbx_vector_uint64_destroy(&failed_itemids);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_vc_get_values                                                *
@@ -2708,6 +3622,178 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_item_requires_storage_aggregate                               *
+ *                                                                            *
+ * Purpose: checks if item history aggregate must be calculated by history    *
+ *          storage instead of caching the values                             *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             func    - [IN] the aggregate function                          *
+ *             seconds - [IN] the time period                                 *
+ *             count   - [IN] the number of history values to aggregate       *
+ *             ts      - [IN] the period end timestamp                        *
+ *                                                                            *
+ * Return value: SUCCEED - the aggregate must be calculated by storage        *
+ *               FAIL    - the values must be aggregated in cache             *
+ *                                                                            *
+ * Comments: Long time based periods, which are not already cached, would     *
+ *           load all values of the period into cache. Such periods are       *
+ *           aggregated by storage if it supports aggregation.                *
+ *           Storage does not report aggregation support if the recently      *
+ *           written values might be not searchable yet.                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_item_requires_storage_aggregate(const zbx_vc_item_t *item, int func, int seconds, int count,
+		const zbx_timespec_t *ts)
+{
+	if (0 != count || SUCCEED != zbx_history_aggregate_available(item->value_type, func, seconds))
+		return FAIL;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		return FAIL;
+
+	if (0 != item->db_cached_from && ts->sec - seconds >= item->db_cached_from)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_get_aggregate                                             *
+ *                                                                            *
+ * Purpose: aggregates item history data                                      *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             func       - [IN] the aggregate function, see                  *
+ *                               ZBX_VC_AGGREGATE_* defines                   *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *             aggr       - [OUT] the aggregate                               *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was aggregated successfully *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: The values are selected in the same way as by                    *
+ *           zbx_vc_get_values() function, but cached values are aggregated   *
+ *           in place instead of being copied to a vector.                    *
+ *           Sum, minimum and maximum are calculated for numeric items        *
+ *           according to their value type, while average is always returned *
+ *           as floating point value. Count is supported for all value types. *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, int value_type, int func, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_aggregate_t *aggr)
+{
+	zbx_vc_item_t	*item, new_item;
+	int 		ret = FAIL, cache_used = 1, storage = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d func:%d seconds:%d count:%d"
+			" sec:%d ns:%d", __func__, itemid, value_type, func, seconds, count, ts->sec, ts->ns);
+
+	memset(aggr, 0, sizeof(zbx_vc_aggregate_t));
+	aggr->func = func;
+
+	RDLOCK_CACHE;
+
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
+
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		vc_warn_low_memory();
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+			goto out;
+
+		memset(&new_item, 0, sizeof(new_item));
+		new_item.itemid = itemid;
+		new_item.value_type = value_type;
+		item = &new_item;
+	}
+	else if (item->value_type != value_type)
+		goto out;
+
+	if (SUCCEED == vc_item_requires_storage_aggregate(item, func, seconds, count, ts))
+	{
+		storage = 1;
+		goto out;
+	}
+
+	ret = vch_item_get_aggregate(item, aggr, seconds, count, ts);
+out:
+	if (0 != storage)
+	{
+		UNLOCK_CACHE;
+
+		ret = zbx_history_get_aggregate(itemid, value_type, func, ts->sec - seconds, ts, &aggr->value,
+				&aggr->values_num);
+
+		WRLOCK_CACHE;
+
+		if (SUCCEED == ret)
+		{
+			cache_used = 0;
+			vc_update_statistics(NULL, 0, aggr->values_num, time(NULL));
+		}
+		else
+			storage = 0;
+	}
+
+	if (FAIL == ret)
+	{
+		zbx_vector_history_record_t	values;
+		int				i;
+
+		cache_used = 0;
+		aggr->values_num = 0;
+		memset(&aggr->value, 0, sizeof(aggr->value));
+		zbx_history_record_vector_create(&values);
+
+		UNLOCK_CACHE;
+
+		if (SUCCEED == (ret = vc_db_get_values(itemid, value_type, &values, seconds, count, ts)))
+		{
+			if (ZBX_VC_AGGREGATE_COUNT != func)
+			{
+				for (i = 0; i < values.values_num; i++)
+					vc_aggregate_records(aggr, value_type, values.values, i, i);
+			}
+			else
+				aggr->values_num = values.values_num;
+		}
+
+		zbx_history_record_vector_destroy(&values, value_type);
+
+		WRLOCK_CACHE;
+
+		if (ZBX_VC_DISABLED != vc_state)
+			vc_remove_item_by_id(itemid);
+
+		if (SUCCEED == ret)
+			vc_update_statistics(NULL, 0, aggr->values_num, time(NULL));
+	}
+
+	UNLOCK_CACHE;
+
+	/* storage returns average of integer values already divided */
+	if (ZBX_VC_AGGREGATE_AVG == func && ITEM_VALUE_TYPE_UINT64 == value_type && 0 != aggr->values_num &&
+			0 == storage)
+	{
+		aggr->value.dbl /= aggr->values_num;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
+			__func__, zbx_result_string(ret), aggr->values_num, cache_used);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_vc_get_value                                                 *
@@ -49,6 +49,8 @@
  *   functions. Afterwards the retrieved history data must be freed by the caller by using
  *   either zbx_history_record_vector_destroy() function (free the zbx_vc_get_values()
  *   call output) or zbx_history_record_clear() function (free the zbx_vc_get_value() call output).
+ *   Aggregate functions over numeric item values should be calculated with zbx_vc_get_aggregate()
+ *   function, which works directly on the cached data without copying it.
  *
  * Locking
  *
@@ -92,6 +94,27 @@ typedef struct
 }
 zbx_vc_item_stats_t;
 
+/* value cache aggregate functions */
+#define ZBX_VC_AGGREGATE_SUM	ZBX_HISTORY_AGGREGATE_SUM
+#define ZBX_VC_AGGREGATE_AVG	ZBX_HISTORY_AGGREGATE_AVG
+#define ZBX_VC_AGGREGATE_MIN	ZBX_HISTORY_AGGREGATE_MIN
+#define ZBX_VC_AGGREGATE_MAX	ZBX_HISTORY_AGGREGATE_MAX
+#define ZBX_VC_AGGREGATE_COUNT	ZBX_HISTORY_AGGREGATE_COUNT
+
+/* the result of aggregate function calculated over item history values */
+typedef struct
+{
+	/* the aggregated value, average is always stored as floating point value */
+	history_value_t	value;
+
+	/* the number of aggregated values */
+	int		values_num;
+
+	/* the aggregate function - see ZBX_VC_AGGREGATE_* defines */
+	int		func;
+}
+zbx_vc_aggregate_t;
+
 int	zbx_vc_init(char **error);
 
 void	zbx_vc_destroy(void);
@@ -105,10 +128,15 @@ void	zbx_vc_disable(void);
 int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_record_t *values, int seconds,
 		int count, const zbx_timespec_t *ts);
 
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, int value_type, int func, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_aggregate_t *aggr);
+
 int	zbx_vc_get_value(zbx_uint64_t itemid, int value_type, const zbx_timespec_t *ts, zbx_history_record_t *value);
 
 int	zbx_vc_add_values(zbx_vector_ptr_t *history);
 
+void	zbx_vc_wait_values(void);
+
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats);
 
 void	zbx_vc_housekeeping_value_cache(void);
@@ -429,6 +429,39 @@ int	DBexecute_once(const char *fmt, ...)
 	return rc;
 }
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: DBexecute_prepared                                               *
+ *                                                                            *
+ * Purpose: execute a non-select statement using cached prepared plan         *
+ *                                                                            *
+ * Comments: retry until DB is up                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	DBexecute_prepared(const char *sql, const char * const *params, int params_num)
+{
+	int	rc;
+
+	rc = zbx_db_execute_prepared(sql, params, params_num);
+
+	while (ZBX_DB_DOWN == rc)
+	{
+		DBclose();
+		DBconnect(ZBX_DB_CONNECT_NORMAL);
+
+		if (ZBX_DB_DOWN == (rc = zbx_db_execute_prepared(sql, params, params_num)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+
+	return rc;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: DBis_null                                                        *
@@ -2538,7 +2571,7 @@ out:
 #endif
 }
 
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_POSTGRESQL)
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_format_values                                             *
@@ -2597,6 +2630,172 @@ static char	*zbx_db_format_values(ZBX_FIELD **fields, const zbx_db_value_t *valu
 }
 #endif
 
+#ifdef HAVE_POSTGRESQL
+
+#define ZBX_DB_COPY_BUFFER_SIZE	(64 * ZBX_KIBIBYTE)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_str                                                      *
+ *                                                                            *
+ * Purpose: append string value in COPY text format                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_str(char **data, size_t *data_alloc, size_t *data_offset, const char *str)
+{
+	const char	*ptr, *esc;
+
+	for (ptr = str; '\0' != *ptr; ptr++)
+	{
+		switch (*ptr)
+		{
+			case '\\':
+				esc = "\\\\";
+				break;
+			case '\n':
+				esc = "\\n";
+				break;
+			case '\r':
+				esc = "\\r";
+				break;
+			case '\t':
+				esc = "\\t";
+				break;
+			default:
+				continue;
+		}
+
+		zbx_strncpy_alloc(data, data_alloc, data_offset, str, ptr - str);
+		zbx_strcpy_alloc(data, data_alloc, data_offset, esc);
+		str = ptr + 1;
+	}
+
+	zbx_strncpy_alloc(data, data_alloc, data_offset, str, ptr - str);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_uint64                                                   *
+ *                                                                            *
+ * Purpose: append unsigned integer value in COPY text format                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_uint64(char **data, size_t *data_alloc, size_t *data_offset, zbx_uint64_t value)
+{
+	char	buf[MAX_ID_LEN + 1], *ptr = buf + sizeof(buf);
+
+	do
+	{
+		*--ptr = '0' + value % 10;
+		value /= 10;
+	}
+	while (0 != value);
+
+	zbx_strncpy_alloc(data, data_alloc, data_offset, ptr, buf + sizeof(buf) - ptr);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_insert_copy                                                   *
+ *                                                                            *
+ * Purpose: insert bulk insert rows with COPY FROM STDIN operation            *
+ *                                                                            *
+ * Parameters: self        - [IN] the bulk insert data                        *
+ *             sql_command - [IN] the copy statement                          *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows copied (on success)                        *
+ *                                                                            *
+ * Comments: Rows are sent in text format, which unlike binary format does    *
+ *           not depend on the actual column types - the numeric columns can  *
+ *           have different types depending on database schema version.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_copy(const zbx_db_insert_t *self, const char *sql_command)
+{
+	int	rc, i, j;
+	char	*data;
+	size_t	data_alloc = ZBX_DB_COPY_BUFFER_SIZE + ZBX_KIBIBYTE, data_offset = 0;
+
+	if (ZBX_DB_OK != (rc = zbx_db_copy_start(sql_command)))
+		return rc;
+
+	data = (char *)zbx_malloc(NULL, data_alloc);
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		const zbx_db_value_t	*values = (const zbx_db_value_t *)self->rows.values[i];
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			const zbx_db_value_t	*value = &values[j];
+			const ZBX_FIELD		*field = (const ZBX_FIELD *)self->fields.values[j];
+
+			if (0 != j)
+				zbx_chrcpy_alloc(&data, &data_alloc, &data_offset, '\t');
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+					db_copy_str(&data, &data_alloc, &data_offset, value->str);
+					break;
+				case ZBX_TYPE_INT:
+					if (0 > value->i32)
+					{
+						zbx_chrcpy_alloc(&data, &data_alloc, &data_offset, '-');
+						db_copy_uint64(&data, &data_alloc, &data_offset,
+								-(zbx_uint64_t)value->i32);
+					}
+					else
+						db_copy_uint64(&data, &data_alloc, &data_offset, value->i32);
+					break;
+				case ZBX_TYPE_FLOAT:
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_DBL64_SQL,
+							value->dbl);
+					break;
+				case ZBX_TYPE_UINT:
+					db_copy_uint64(&data, &data_alloc, &data_offset, value->ui64);
+					break;
+				case ZBX_TYPE_ID:
+					if (0 != value->ui64)
+						db_copy_uint64(&data, &data_alloc, &data_offset, value->ui64);
+					else
+						zbx_strcpy_alloc(&data, &data_alloc, &data_offset, "\\N");
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+		}
+
+		zbx_chrcpy_alloc(&data, &data_alloc, &data_offset, '\n');
+
+		if (ZBX_DB_COPY_BUFFER_SIZE <= data_offset)
+		{
+			if (ZBX_DB_OK != (rc = zbx_db_copy_put(data, data_offset)))
+				goto out;
+
+			data_offset = 0;
+		}
+	}
+
+	if (0 != data_offset && ZBX_DB_OK != (rc = zbx_db_copy_put(data, data_offset)))
+		goto out;
+
+	rc = zbx_db_copy_end(sql_command);
+out:
+	zbx_free(data);
+
+	return rc;
+}
+
+#undef ZBX_DB_COPY_BUFFER_SIZE
+
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_insert_clean                                              *
@@ -2773,7 +2972,7 @@ void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *self, const zbx_db_value_t **
 			case ZBX_TYPE_CHAR:
 			case ZBX_TYPE_TEXT:
 			case ZBX_TYPE_SHORTTEXT:
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_POSTGRESQL)
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_OFF);
 #else
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
@@ -2869,12 +3068,15 @@ void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...)
  ******************************************************************************/
 int	zbx_db_insert_execute(zbx_db_insert_t *self)
 {
-	int		ret = FAIL, i, j;
+	int		ret = FAIL, i;
 	const ZBX_FIELD	*field;
 	char		*sql_command, delim[2] = {',', '('};
 	size_t		sql_command_alloc = 512, sql_command_offset = 0;
 
-#ifndef HAVE_ORACLE
+#if defined(HAVE_POSTGRESQL)
+	int		rc, tries = 0;
+#elif !defined(HAVE_ORACLE)
+	int		j;
 	char		*sql;
 	size_t		sql_alloc = 16 * ZBX_KIBIBYTE, sql_offset = 0;
 
@@ -2884,7 +3086,7 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 #	endif
 #else
 	zbx_db_bind_context_t	*contexts;
-	int			rc, tries = 0;
+	int			rc, tries = 0, j;
 #endif
 
 	if (0 == self->rows.values_num)
@@ -2905,14 +3107,18 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 		}
 	}
 
-#ifndef HAVE_ORACLE
+#if !defined(HAVE_ORACLE) && !defined(HAVE_POSTGRESQL)
 	sql = (char *)zbx_malloc(NULL, sql_alloc);
 #endif
 	sql_command = (char *)zbx_malloc(NULL, sql_command_alloc);
 
 	/* create sql insert statement command */
 
+#ifdef HAVE_POSTGRESQL
+	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, "copy ");
+#else
 	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, "insert into ");
+#endif
 	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, self->table->table);
 	zbx_chrcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, ' ');
 
@@ -2948,7 +3154,11 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 		}
 	}
 #endif
+#ifdef HAVE_POSTGRESQL
+	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, ") from stdin");
+#else
 	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, ") values ");
+#endif
 
 #ifdef HAVE_ORACLE
 	for (i = 0; i < self->fields.values_num; i++)
@@ -3012,6 +3222,35 @@ retry_oracle:
 
 	ret = (ZBX_DB_OK <= rc ? SUCCEED : FAIL);
 
+#elif defined(HAVE_POSTGRESQL)
+	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+	{
+		for (i = 0; i < self->rows.values_num; i++)
+		{
+			zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+			char	*str;
+
+			str = zbx_db_format_values((ZBX_FIELD **)self->fields.values, values, self->fields.values_num);
+			zabbix_log(LOG_LEVEL_DEBUG, "insert [txnlev:%d] [%s]", zbx_db_txn_level(),
+					ZBX_NULL2EMPTY_STR(str));
+			zbx_free(str);
+		}
+	}
+
+	while (ZBX_DB_DOWN == (rc = db_insert_copy(self, sql_command)))
+	{
+		if (0 < tries++)
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+
+		DBclose();
+		DBconnect(ZBX_DB_CONNECT_NORMAL);
+	}
+
+	ret = (ZBX_DB_OK <= rc ? SUCCEED : FAIL);
 #else
 	DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
 
@@ -3089,21 +3328,155 @@ retry_oracle:
 	}
 #endif
 
+#ifndef HAVE_POSTGRESQL
 out:
+#endif
 	zbx_free(sql_command);
 
-#ifndef HAVE_ORACLE
+#if defined(HAVE_ORACLE)
+	zbx_free(contexts);
+#elif !defined(HAVE_POSTGRESQL)
 	zbx_free(sql);
 
 #	ifdef HAVE_MYSQL
 	zbx_free(sql_values);
 #	endif
-#else
-	zbx_free(contexts);
 #endif
 	return ret;
 }
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: db_pipeline_str                                                  *
+ *                                                                            *
+ * Purpose: append quoted string value to sql statement                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_pipeline_str(char **sql, size_t *sql_alloc, size_t *sql_offset, const char *str)
+{
+	const char	*ptr;
+
+	zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, '\'');
+
+	for (ptr = str; '\0' != *ptr; ptr++)
+	{
+		if ('\'' != *ptr && ('\\' != *ptr || 0 == ZBX_PG_ESCAPE_BACKSLASH))
+			continue;
+
+		/* copy the character twice - first time with the preceding run */
+		zbx_strncpy_alloc(sql, sql_alloc, sql_offset, str, ptr - str + 1);
+		str = ptr;
+	}
+
+	zbx_strncpy_alloc(sql, sql_alloc, sql_offset, str, ptr - str);
+	zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, '\'');
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_pipeline                                           *
+ *                                                                            *
+ * Purpose: queues the prepared database bulk insert operation in pipelined   *
+ *          writes connection                                                 *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the rows were queued                             *
+ *               ZBX_DB_FAIL or ZBX_DB_DOWN - otherwise                       *
+ *                                                                            *
+ * Comments: The rows are written after zbx_db_pipeline_sync() call and the   *
+ *           outcome is known only after zbx_db_pipeline_wait() call, so the  *
+ *           bulk insert data must be kept until then to be able to retry.    *
+ *           Autoincrement fields are not supported.                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_insert_pipeline(const zbx_db_insert_t *self)
+{
+	int		i, j, rc = ZBX_DB_OK;
+	char		*sql;
+	size_t		sql_alloc = ZBX_MAX_OVERFLOW_SQL_SIZE + ZBX_KIBIBYTE, sql_offset = 0, sql_command_offset;
+
+	if (0 == self->rows.values_num)
+		return ZBX_DB_OK;
+
+	sql = (char *)zbx_malloc(NULL, sql_alloc);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "insert into %s (", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		const ZBX_FIELD	*field = (const ZBX_FIELD *)self->fields.values[i];
+
+		if (0 != i)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") values ");
+	sql_command_offset = sql_offset;
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		const zbx_db_value_t	*values = (const zbx_db_value_t *)self->rows.values[i];
+
+		if (sql_command_offset != sql_offset)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			const zbx_db_value_t	*value = &values[j];
+			const ZBX_FIELD		*field = (const ZBX_FIELD *)self->fields.values[j];
+
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, 0 == j ? '(' : ',');
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+					db_pipeline_str(&sql, &sql_alloc, &sql_offset, value->str);
+					break;
+				case ZBX_TYPE_INT:
+					zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%d", value->i32);
+					break;
+				case ZBX_TYPE_FLOAT:
+					zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ZBX_FS_DBL64_SQL, value->dbl);
+					break;
+				case ZBX_TYPE_UINT:
+					zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				case ZBX_TYPE_ID:
+					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, DBsql_id_ins(value->ui64));
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+		}
+
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+
+		if (ZBX_MAX_OVERFLOW_SQL_SIZE <= sql_offset)
+		{
+			if (ZBX_DB_OK != (rc = zbx_db_pipeline_execute(sql)))
+				goto out;
+
+			sql_offset = sql_command_offset;
+		}
+	}
+
+	if (sql_command_offset != sql_offset)
+		rc = zbx_db_pipeline_execute(sql);
+out:
+	zbx_free(sql);
+
+	return rc;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_insert_autoincrement                                      *
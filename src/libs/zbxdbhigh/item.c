@@ -21,6 +21,165 @@
 
 #include "db.h"
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: db_item_changes_add_str                                          *
+ *                                                                            *
+ * Purpose: add string to PostgreSQL array literal                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_item_changes_add_str(char **data, size_t *data_alloc, size_t *data_offset, const char *str)
+{
+	const char	*ptr;
+
+	zbx_chrcpy_alloc(data, data_alloc, data_offset, '"');
+
+	for (ptr = str; '\0' != *ptr; ptr++)
+	{
+		if ('"' == *ptr || '\\' == *ptr)
+			zbx_chrcpy_alloc(data, data_alloc, data_offset, '\\');
+
+		zbx_chrcpy_alloc(data, data_alloc, data_offset, *ptr);
+	}
+
+	zbx_chrcpy_alloc(data, data_alloc, data_offset, '"');
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_save_item_changes_prepared                                    *
+ *                                                                            *
+ * Purpose: save item changes with the same set of updated columns using      *
+ *          prepared statement                                                *
+ *                                                                            *
+ * Parameters: item_diff - [IN] the item changes                              *
+ *             flags     - [IN] the updated column flags                      *
+ *                                                                            *
+ * Comments: The changes are passed as arrays, so each set of updated columns *
+ *           has one fixed statement regardless of the number of items.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_save_item_changes_prepared(const zbx_vector_ptr_t *item_diff, zbx_uint64_t flags)
+{
+	static const struct
+	{
+		zbx_uint64_t	flag;
+		const char	*name;
+		const char	*type;
+	}
+	columns[] = {
+		{ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTLOGSIZE, "lastlogsize", "numeric"},
+		{ZBX_FLAGS_ITEM_DIFF_UPDATE_MTIME, "mtime", "integer"},
+		{ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE, "state", "integer"},
+		{ZBX_FLAGS_ITEM_DIFF_UPDATE_ERROR, "error", "text"}
+	};
+
+	char			*sql = NULL, *arrays[ARRSIZE(columns) + 1] = {NULL}, *error;
+	size_t			sql_alloc = 0, sql_offset = 0, arrays_alloc[ARRSIZE(columns) + 1] = {0},
+				arrays_offset[ARRSIZE(columns) + 1] = {0};
+	const char		*params[ARRSIZE(columns) + 1];
+	int			i, j, params_num = 1;
+	const zbx_item_diff_t	*diff;
+	const ZBX_FIELD		*field;
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "update item_rtdata set ");
+
+	for (j = 0; j < (int)ARRSIZE(columns); j++)
+	{
+		if (0 == (columns[j].flag & flags))
+			continue;
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s%s=v.%s", (1 == params_num ? "" : ","),
+				columns[j].name, columns[j].name);
+		params_num++;
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " from unnest($1::bigint[]");
+
+	for (j = 0, params_num = 1; j < (int)ARRSIZE(columns); j++)
+	{
+		if (0 != (columns[j].flag & flags))
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ",$%d::%s[]", ++params_num, columns[j].type);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") as v(itemid");
+
+	for (j = 0; j < (int)ARRSIZE(columns); j++)
+	{
+		if (0 != (columns[j].flag & flags))
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ",%s", columns[j].name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") where item_rtdata.itemid=v.itemid");
+
+	field = DBget_field(DBget_table("item_rtdata"), "error");
+
+	for (i = 0; i < params_num; i++)
+		zbx_chrcpy_alloc(&arrays[i], &arrays_alloc[i], &arrays_offset[i], '{');
+
+	for (i = 0; i < item_diff->values_num; i++)
+	{
+		diff = (const zbx_item_diff_t *)item_diff->values[i];
+
+		if (flags != (ZBX_FLAGS_ITEM_DIFF_UPDATE_DB & diff->flags))
+			continue;
+
+		if (1 != arrays_offset[0])
+		{
+			for (j = 0; j < params_num; j++)
+				zbx_chrcpy_alloc(&arrays[j], &arrays_alloc[j], &arrays_offset[j], ',');
+		}
+
+		zbx_snprintf_alloc(&arrays[0], &arrays_alloc[0], &arrays_offset[0], ZBX_FS_UI64, diff->itemid);
+
+		for (j = 0, params_num = 1; j < (int)ARRSIZE(columns); j++)
+		{
+			if (0 == (columns[j].flag & flags))
+				continue;
+
+			switch (columns[j].flag)
+			{
+				case ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTLOGSIZE:
+					zbx_snprintf_alloc(&arrays[params_num], &arrays_alloc[params_num],
+							&arrays_offset[params_num], ZBX_FS_UI64, diff->lastlogsize);
+					break;
+				case ZBX_FLAGS_ITEM_DIFF_UPDATE_MTIME:
+					zbx_snprintf_alloc(&arrays[params_num], &arrays_alloc[params_num],
+							&arrays_offset[params_num], "%d", diff->mtime);
+					break;
+				case ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE:
+					zbx_snprintf_alloc(&arrays[params_num], &arrays_alloc[params_num],
+							&arrays_offset[params_num], "%d", (int)diff->state);
+					break;
+				case ZBX_FLAGS_ITEM_DIFF_UPDATE_ERROR:
+					error = zbx_db_dyn_escape_string(ZBX_NULL2EMPTY_STR(diff->error), ZBX_SIZE_T_MAX,
+							field->length, ESCAPE_SEQUENCE_OFF);
+					db_item_changes_add_str(&arrays[params_num], &arrays_alloc[params_num],
+							&arrays_offset[params_num], error);
+					zbx_free(error);
+					break;
+			}
+
+			params_num++;
+		}
+	}
+
+	for (i = 0; i < params_num; i++)
+	{
+		zbx_chrcpy_alloc(&arrays[i], &arrays_alloc[i], &arrays_offset[i], '}');
+		params[i] = arrays[i];
+	}
+
+	DBexecute_prepared(sql, params, params_num);
+
+	for (i = 0; i < params_num; i++)
+		zbx_free(arrays[i]);
+
+	zbx_free(sql);
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_save_item_changes                                         *
@@ -28,11 +187,39 @@
  * Purpose: save item state, error, mtime, lastlogsize changes to             *
  *          database                                                          *
  *                                                                            *
+ * Comments: With PostgreSQL the changes are executed directly with prepared  *
+ *           statements instead of being added to the sql buffer. Other       *
+ *           databases keep generated update statements. The item changes     *
+ *           must not contain duplicate items.                                *
+ *                                                                            *
  ******************************************************************************/
 void	zbx_db_save_item_changes(char **sql, size_t *sql_alloc, size_t *sql_offset, const zbx_vector_ptr_t *item_diff)
 {
 	int			i;
 	const zbx_item_diff_t	*diff;
+#ifdef HAVE_POSTGRESQL
+	zbx_uint64_t		flags;
+	unsigned int		shapes = 0;
+
+	ZBX_UNUSED(sql);
+	ZBX_UNUSED(sql_alloc);
+	ZBX_UNUSED(sql_offset);
+
+	/* mark which sets of updated columns are present, each set is saved with its own statement */
+	for (i = 0; i < item_diff->values_num; i++)
+	{
+		diff = (const zbx_item_diff_t *)item_diff->values[i];
+
+		if (0 != (flags = (ZBX_FLAGS_ITEM_DIFF_UPDATE_DB & diff->flags)))
+			shapes |= 1 << flags;
+	}
+
+	for (flags = 1; flags <= ZBX_FLAGS_ITEM_DIFF_UPDATE_DB; flags++)
+	{
+		if (0 != (shapes & (1 << flags)))
+			db_save_item_changes_prepared(item_diff, flags);
+	}
+#else
 	char			*value_esc;
 
 	for (i = 0; i < item_diff->values_num; i++)
@@ -76,4 +263,5 @@ void	zbx_db_save_item_changes(char **sql, size_t *sql_alloc, size_t *sql_offset,
 
 		DBexecute_overflowed_sql(sql, sql_alloc, sql_offset);
 	}
+#endif
 }
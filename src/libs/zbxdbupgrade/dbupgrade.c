@@ -81,6 +81,17 @@ zbx_db_version_t;
 #	define ZBX_TYPE_UINT_STR	"numeric(20)"
 #endif
 
+#if defined(HAVE_MYSQL)
+#	define ZBX_TYPE_SERIAL_STR	"bigint unsigned"
+#	define ZBX_TYPE_SERIAL_SUFFIX	" auto_increment"
+#elif defined(HAVE_ORACLE)
+#	define ZBX_TYPE_SERIAL_STR	"number(20)"
+#	define ZBX_TYPE_SERIAL_SUFFIX	""
+#elif defined(HAVE_POSTGRESQL)
+#	define ZBX_TYPE_SERIAL_STR	"bigserial"
+#	define ZBX_TYPE_SERIAL_SUFFIX	""
+#endif
+
 #if defined(HAVE_ORACLE)
 #	define ZBX_TYPE_SHORTTEXT_STR	"nvarchar2(2048)"
 #else
@@ -124,6 +135,9 @@ static void	DBfield_type_string(char **sql, size_t *sql_alloc, size_t *sql_offse
 		case ZBX_TYPE_TEXT:
 			zbx_strcpy_alloc(sql, sql_alloc, sql_offset, ZBX_TYPE_TEXT_STR);
 			break;
+		case ZBX_TYPE_SERIAL:
+			zbx_strcpy_alloc(sql, sql_alloc, sql_offset, ZBX_TYPE_SERIAL_STR);
+			break;
 		default:
 			assert(0);
 	}
@@ -162,6 +176,7 @@ static zbx_oracle_column_type_t	zbx_oracle_column_type(unsigned char field_type)
 		case ZBX_TYPE_ID:
 		case ZBX_TYPE_INT:
 		case ZBX_TYPE_UINT:
+		case ZBX_TYPE_SERIAL:
 			return ZBX_ORACLE_COLUMN_TYPE_NUMERIC;
 		case ZBX_TYPE_CHAR:
 		case ZBX_TYPE_SHORTTEXT:
@@ -213,6 +228,7 @@ static void	DBfield_definition_string(char **sql, size_t *sql_alloc, size_t *sql
 			case ZBX_TYPE_BLOB:
 			case ZBX_TYPE_UINT:
 			case ZBX_TYPE_ID:
+			case ZBX_TYPE_SERIAL:
 				zbx_strcpy_alloc(sql, sql_alloc, sql_offset, " not null");
 				break;
 			default:	/* ZBX_TYPE_CHAR, ZBX_TYPE_TEXT, ZBX_TYPE_SHORTTEXT or ZBX_TYPE_LONGTEXT */
@@ -222,6 +238,9 @@ static void	DBfield_definition_string(char **sql, size_t *sql_alloc, size_t *sql
 		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, " not null");
 #endif
 	}
+
+	if (ZBX_TYPE_SERIAL == field->type)
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, ZBX_TYPE_SERIAL_SUFFIX);
 }
 
 static void	DBcreate_table_sql(char **sql, size_t *sql_alloc, size_t *sql_offset, const ZBX_TABLE *table)
@@ -412,6 +431,42 @@ static void	DBdrop_foreign_key_sql(char **sql, size_t *sql_alloc, size_t *sql_of
 			table_name, table_name, id);
 }
 
+#ifdef HAVE_ORACLE
+/******************************************************************************
+ *                                                                            *
+ * Function: DBcreate_serial_sequence                                         *
+ *                                                                            *
+ * Purpose: emulate auto incremented field on Oracle with sequence and        *
+ *          before insert trigger, named the same as by schema generator      *
+ *                                                                            *
+ * Parameters: table_name - [IN] the table name                               *
+ *             field_name - [IN] the serial field name                        *
+ *                                                                            *
+ * Return value: SUCCEED - the sequence and trigger were created              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	DBcreate_serial_sequence(const char *table_name, const char *field_name)
+{
+	if (ZBX_DB_OK > DBexecute("create sequence %s_seq start with 1 increment by 1 nomaxvalue", table_name))
+		return FAIL;
+
+	if (ZBX_DB_OK > DBexecute(
+			"create trigger %s_tr"
+			" before insert on %s"
+			" for each row"
+			" begin"
+				" select %s_seq.nextval into :new.%s from dual;"
+			" end;",
+			table_name, table_name, table_name, field_name))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+#endif
+
 int	DBcreate_table(const ZBX_TABLE *table)
 {
 	char	*sql = NULL;
@@ -424,7 +479,18 @@ int	DBcreate_table(const ZBX_TABLE *table)
 		ret = SUCCEED;
 
 	zbx_free(sql);
+#ifdef HAVE_ORACLE
+	if (SUCCEED == ret)
+	{
+		int	i;
 
+		for (i = 0; NULL != table->fields[i].name && SUCCEED == ret; i++)
+		{
+			if (ZBX_TYPE_SERIAL == table->fields[i].type)
+				ret = DBcreate_serial_sequence(table->table, table->fields[i].name);
+		}
+	}
+#endif
 	return ret;
 }
 
@@ -4653,6 +4653,216 @@ static int	DBpatch_5030163(void)
 	return DBadd_field("config", &field);
 }
 
+static int	DBpatch_5030164(void)
+{
+	const ZBX_TABLE table =
+		{"changelog", "changelogid", 0,
+			{
+				{"changelogid", NULL, NULL, NULL, 0, ZBX_TYPE_SERIAL, ZBX_NOTNULL, 0},
+				{"object", "0", NULL, NULL, 0, ZBX_TYPE_INT, ZBX_NOTNULL, 0},
+				{"objectid", NULL, NULL, NULL, 0, ZBX_TYPE_ID, ZBX_NOTNULL, 0},
+				{"operation", "0", NULL, NULL, 0, ZBX_TYPE_INT, ZBX_NOTNULL, 0},
+				{"clock", "0", NULL, NULL, 0, ZBX_TYPE_INT, ZBX_NOTNULL, 0},
+				{0}
+			},
+			NULL
+		};
+
+	return DBcreate_table(&table);
+}
+
+static int	DBpatch_5030165(void)
+{
+	return DBcreate_index("changelog", "changelog_1", "clock", 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBpatch_changelog_create_trigger                                 *
+ *                                                                            *
+ * Purpose: creates database trigger recording changes of the specified table *
+ *          in changelog                                                      *
+ *                                                                            *
+ * Parameters: table_name - [IN] the table name                               *
+ *             field_name - [IN] the table primary key field name             *
+ *             object     - [IN] the changelog object type                    *
+ *             operation  - [IN] the operation (insert, update, delete)       *
+ *             opcode     - [IN] the changelog operation code                 *
+ *             columns    - [IN] comma separated configuration columns to     *
+ *                               track by update trigger, NULL - all columns  *
+ *                                                                            *
+ * Return value: SUCCEED - the trigger was created successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Tables having runtime columns updated by server must list only   *
+ *           configuration columns, otherwise every runtime update would be   *
+ *           recorded in changelog.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	DBpatch_changelog_create_trigger(const char *table_name, const char *field_name, int object,
+		const char *operation, int opcode, const char *columns)
+{
+	const char	*row = (3 == opcode ? "old" : "new");
+	char		*sql = NULL;
+	size_t		sql_alloc = 0, sql_offset = 0;
+	int		ret = SUCCEED;
+
+#if defined(HAVE_MYSQL)
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"create trigger %s_%s after %s on %s"
+			" for each row"
+				" insert into changelog (object,objectid,operation,clock)",
+			table_name, operation, operation, table_name);
+
+	if (NULL != columns && 2 == opcode)
+	{
+		const char	*ptr, *next;
+
+		/* MySQL does not support update of <columns>, compare configuration columns instead */
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				" select %d,%s.%s,%d,unix_timestamp() from dual where not (",
+				object, row, field_name, opcode);
+
+		for (ptr = columns; NULL != ptr; ptr = (NULL != next ? next + 1 : NULL))
+		{
+			int	len;
+
+			next = strchr(ptr, ',');
+			len = (int)(NULL != next ? (size_t)(next - ptr) : strlen(ptr));
+
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%sold.%.*s<=>new.%.*s",
+					ptr != columns ? " and " : "", len, ptr, len, ptr);
+		}
+
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+	}
+	else
+	{
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " values (%d,%s.%s,%d,unix_timestamp())",
+				object, row, field_name, opcode);
+	}
+
+	if (ZBX_DB_OK > DBexecute("%s", sql))
+		ret = FAIL;
+#else
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "create trigger %s_%s after %s", table_name, operation,
+			operation);
+
+	if (NULL != columns && 2 == opcode)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " of %s", columns);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " on %s for each row", table_name);
+#	if defined(HAVE_POSTGRESQL)
+	if (ZBX_DB_OK > DBexecute(
+			"create function changelog_%s_%s() returns trigger as $$"
+			" begin"
+				" insert into changelog (object,objectid,operation,clock)"
+					" values (%d,%s.%s,%d,cast(extract(epoch from now()) as int));"
+				" return %s;"
+			" end;"
+			" $$ language plpgsql",
+			table_name, operation, object, row, field_name, opcode, row))
+	{
+		ret = FAIL;
+	}
+	else if (ZBX_DB_OK > DBexecute("%s execute procedure changelog_%s_%s()", sql, table_name, operation))
+		ret = FAIL;
+#	elif defined(HAVE_ORACLE)
+	if (ZBX_DB_OK > DBexecute(
+			"%s"
+			" begin"
+				" insert into changelog (object,objectid,operation,clock)"
+					" values (%d,:%s.%s,%d,"
+					"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);"
+			" end;",
+			sql, object, row, field_name, opcode))
+	{
+		ret = FAIL;
+	}
+#	endif
+#endif
+	zbx_free(sql);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBpatch_changelog_get_columns                                    *
+ *                                                                            *
+ * Purpose: gets configuration columns to track by changelog update trigger   *
+ *                                                                            *
+ * Parameters: table_name - [IN] the table name                               *
+ *                                                                            *
+ * Return value: comma separated configuration columns or NULL if table has   *
+ *               no runtime columns and all columns must be tracked           *
+ *                                                                            *
+ * Comments: The columns are selected in the same way as by schema generator  *
+ *           for new installations - all columns except primary key and       *
+ *           columns with ZBX_NODATA flag. Columns added to schema by later   *
+ *           patches are skipped, such patches must create the update trigger *
+ *           again.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static char	*DBpatch_changelog_get_columns(const char *table_name)
+{
+	const ZBX_TABLE	*table;
+	const ZBX_FIELD	*field;
+	char		*columns = NULL;
+	size_t		columns_alloc = 0, columns_offset = 0;
+	int		nodata = 0;
+
+	if (NULL == (table = DBget_table(table_name)))
+		return NULL;
+
+	for (field = table->fields; NULL != field->name; field++)
+	{
+		if (0 != (field->flags & ZBX_NODATA))
+		{
+			nodata = 1;
+			continue;
+		}
+
+		if (0 == strcmp(field->name, table->recid) || SUCCEED != DBfield_exists(table_name, field->name))
+			continue;
+
+		if (0 != columns_offset)
+			zbx_chrcpy_alloc(&columns, &columns_alloc, &columns_offset, ',');
+
+		zbx_strcpy_alloc(&columns, &columns_alloc, &columns_offset, field->name);
+	}
+
+	if (0 == nodata)
+		zbx_free(columns);
+
+	return columns;
+}
+
+static int	DBpatch_5030166(void)
+{
+	const char	*tables[][2] = {{"items", "itemid"}, {"functions", "functionid"}, {"triggers", "triggerid"},
+				{"item_preproc", "item_preprocid"}};
+	const char	*operations[] = {"insert", "update", "delete"};
+	char		*columns;
+	size_t		i, j;
+	int		ret = SUCCEED;
+
+	for (i = 0; i < ARRSIZE(tables) && SUCCEED == ret; i++)
+	{
+		columns = DBpatch_changelog_get_columns(tables[i][0]);
+
+		for (j = 0; j < ARRSIZE(operations) && SUCCEED == ret; j++)
+		{
+			ret = DBpatch_changelog_create_trigger(tables[i][0], tables[i][1], (int)i + 1, operations[j],
+					(int)j + 1, columns);
+		}
+
+		zbx_free(columns);
+	}
+
+	return ret;
+}
+
 #endif
 
 DBPATCH_START(5030)
@@ -4823,5 +5033,8 @@ DBPATCH_ADD(5030160, 0, 1)
 DBPATCH_ADD(5030161, 0, 1)
 DBPATCH_ADD(5030162, 0, 1)
 DBPATCH_ADD(5030163, 0, 1)
+DBPATCH_ADD(5030164, 0, 1)
+DBPATCH_ADD(5030165, 0, 1)
+DBPATCH_ADD(5030166, 0, 1)
 
 DBPATCH_END()
@@ -180,6 +180,15 @@ void	diag_add_mem_stats(struct zbx_json *json, const char *name, const zbx_mem_s
 
 	zbx_json_close(json);
 	zbx_json_close(json);
+
+	if (0 != stats->slabs_num)
+	{
+		zbx_json_addobject(json, "slabs");
+		zbx_json_adduint64(json, "count", stats->slabs_num);
+		zbx_json_adduint64(json, "objects", stats->slab_objects);
+		zbx_json_close(json);
+	}
+
 	zbx_json_close(json);
 }
 
@@ -399,9 +408,16 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 	double			time1, time2, time_total = 0;
 	zbx_uint64_t		fields;
 	zbx_diag_map_t		field_map[] = {
-					{"", ZBX_DIAG_PREPROC_VALUES | ZBX_DIAG_PREPROC_VALUES_PREPROC},
+					{"", ZBX_DIAG_PREPROC_SIMPLE},
 					{"values", ZBX_DIAG_PREPROC_VALUES},
 					{"preproc.values", ZBX_DIAG_PREPROC_VALUES_PREPROC},
+					{"regexp.cache.hits", ZBX_DIAG_PREPROC_REGEXP_HITS},
+					{"regexp.cache.misses", ZBX_DIAG_PREPROC_REGEXP_MISSES},
+					{"script.cache.hits", ZBX_DIAG_PREPROC_SCRIPT_HITS},
+					{"script.cache.misses", ZBX_DIAG_PREPROC_SCRIPT_MISSES},
+					{"jsonpath.cache.hits", ZBX_DIAG_PREPROC_JSONPATH_HITS},
+					{"jsonpath.cache.misses", ZBX_DIAG_PREPROC_JSONPATH_MISSES},
+					{"managers", ZBX_DIAG_PREPROC_MANAGERS},
 					{NULL, 0}
 					};
 
@@ -413,11 +429,19 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 
 		if (0 != (fields & ZBX_DIAG_PREPROC_SIMPLE))
 		{
-			int	values_num, values_preproc_num;
+			int				values_num, values_preproc_num;
+			zbx_preproc_cache_stats_t	cache_stats;
+			zbx_vector_uint64_pair_t	managers;
+
+			zbx_vector_uint64_pair_create(&managers);
 
 			time1 = zbx_time();
-			if (FAIL == (ret = zbx_preprocessor_get_diag_stats(&values_num, &values_preproc_num, error)))
+			if (FAIL == (ret = zbx_preprocessor_get_diag_stats(&values_num, &values_preproc_num, &cache_stats,
+					&managers, error)))
+			{
+				zbx_vector_uint64_pair_destroy(&managers);
 				goto out;
+			}
 
 			time2 = zbx_time();
 			time_total += time2 - time1;
@@ -426,6 +450,37 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 				zbx_json_addint64(json, "values", values_num);
 			if (0 != (fields & ZBX_DIAG_PREPROC_VALUES_PREPROC))
 				zbx_json_addint64(json, "preproc.values", values_preproc_num);
+			if (0 != (fields & ZBX_DIAG_PREPROC_REGEXP_HITS))
+				zbx_json_adduint64(json, "regexp.cache.hits", cache_stats.regexp_hits);
+			if (0 != (fields & ZBX_DIAG_PREPROC_REGEXP_MISSES))
+				zbx_json_adduint64(json, "regexp.cache.misses", cache_stats.regexp_misses);
+			if (0 != (fields & ZBX_DIAG_PREPROC_SCRIPT_HITS))
+				zbx_json_adduint64(json, "script.cache.hits", cache_stats.script_hits);
+			if (0 != (fields & ZBX_DIAG_PREPROC_SCRIPT_MISSES))
+				zbx_json_adduint64(json, "script.cache.misses", cache_stats.script_misses);
+			if (0 != (fields & ZBX_DIAG_PREPROC_JSONPATH_HITS))
+				zbx_json_adduint64(json, "jsonpath.cache.hits", cache_stats.jsonpath_hits);
+			if (0 != (fields & ZBX_DIAG_PREPROC_JSONPATH_MISSES))
+				zbx_json_adduint64(json, "jsonpath.cache.misses", cache_stats.jsonpath_misses);
+
+			if (0 != (fields & ZBX_DIAG_PREPROC_MANAGERS))
+			{
+				int	i;
+
+				zbx_json_addarray(json, "managers");
+
+				for (i = 0; i < managers.values_num; i++)
+				{
+					zbx_json_addobject(json, NULL);
+					zbx_json_adduint64(json, "values", managers.values[i].first);
+					zbx_json_adduint64(json, "preproc.values", managers.values[i].second);
+					zbx_json_close(json);
+				}
+
+				zbx_json_close(json);
+			}
+
+			zbx_vector_uint64_pair_destroy(&managers);
 		}
 
 		if (0 != tops.values_num)
@@ -498,14 +553,16 @@ void	diag_add_locks_info(struct zbx_json *json)
 {
 	int		i;
 #ifdef HAVE_VMINFO_T_UPDATES
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
-				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
+	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_CACHE_1",
+				"ZBX_MUTEX_CACHE_2", "ZBX_MUTEX_CACHE_3", "ZBX_MUTEX_TRENDS", "ZBX_MUTEX_CACHE_IDS",
+				"ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_ITSERVICES", "ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_KSTAT", "ZBX_MUTEX_MODBUS",
 				"ZBX_MUTEX_TREND_FUNC"};
 #else
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
-				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
+	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_CACHE_1",
+				"ZBX_MUTEX_CACHE_2", "ZBX_MUTEX_CACHE_3", "ZBX_MUTEX_TRENDS", "ZBX_MUTEX_CACHE_IDS",
+				"ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_ITSERVICES", "ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_MODBUS",
 				"ZBX_MUTEX_TREND_FUNC"};
@@ -828,6 +885,7 @@ static void	diag_log_preprocessing(struct zbx_json_parse *jp)
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s", msg);
 	zbx_free(msg);
 
+	diag_log_top_view(jp, "managers", "$.managers");
 	diag_log_top_view(jp, "top.values", "$.top.values");
 
 	zabbix_log(LOG_LEVEL_INFORMATION, "==");
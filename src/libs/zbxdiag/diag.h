@@ -51,9 +51,23 @@
 
 #define ZBX_DIAG_PREPROC_VALUES			0x00000001
 #define ZBX_DIAG_PREPROC_VALUES_PREPROC		0x00000002
+#define ZBX_DIAG_PREPROC_REGEXP_HITS		0x00000004
+#define ZBX_DIAG_PREPROC_REGEXP_MISSES		0x00000008
+#define ZBX_DIAG_PREPROC_MANAGERS		0x00000010
+#define ZBX_DIAG_PREPROC_SCRIPT_HITS		0x00000020
+#define ZBX_DIAG_PREPROC_SCRIPT_MISSES		0x00000040
+#define ZBX_DIAG_PREPROC_JSONPATH_HITS		0x00000080
+#define ZBX_DIAG_PREPROC_JSONPATH_MISSES	0x00000100
 
 #define ZBX_DIAG_PREPROC_SIMPLE		(ZBX_DIAG_PREPROC_VALUES | \
-					ZBX_DIAG_PREPROC_VALUES_PREPROC)
+					ZBX_DIAG_PREPROC_VALUES_PREPROC | \
+					ZBX_DIAG_PREPROC_REGEXP_HITS | \
+					ZBX_DIAG_PREPROC_REGEXP_MISSES | \
+					ZBX_DIAG_PREPROC_SCRIPT_HITS | \
+					ZBX_DIAG_PREPROC_SCRIPT_MISSES | \
+					ZBX_DIAG_PREPROC_JSONPATH_HITS | \
+					ZBX_DIAG_PREPROC_JSONPATH_MISSES | \
+					ZBX_DIAG_PREPROC_MANAGERS)
 
 #define ZBX_DIAG_LLD_RULES		0x00000001
 #define ZBX_DIAG_LLD_VALUES		0x00000002
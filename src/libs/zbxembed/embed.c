@@ -18,6 +18,7 @@
 **/
 
 #include "log.h"
+#include "zbxalgo.h"
 #include "zbxembed.h"
 
 #include "httprequest.h"
@@ -38,6 +39,25 @@
 #define ZBX_ES_SCRIPT_HEADER	"function(value){"
 #define ZBX_ES_SCRIPT_FOOTER	"\n}"
 
+#define ZBX_ES_CACHE_SIZE	128	/* default maximum number of cached compiled scripts per process */
+
+/* compiled script cache entry */
+typedef struct
+{
+	zbx_lrucache_link_t	link;
+	char			*script;
+	char			*code;
+	int			size;
+}
+zbx_es_cache_entry_t;
+
+static zbx_hash_t	es_cache_entry_hash(const void *data);
+static int	es_cache_entry_compare(const void *d1, const void *d2);
+static void	es_cache_entry_clean(void *data);
+
+static zbx_lrucache_t	es_cache = ZBX_LRUCACHE_INITIALIZER(ZBX_ES_CACHE_SIZE, es_cache_entry_hash,
+		es_cache_entry_compare, es_cache_entry_clean);
+
 /******************************************************************************
  *                                                                            *
  * Function: es_handle_error                                                  *
@@ -412,6 +432,115 @@ out:
 	return ret;
 }
 
+static zbx_hash_t	es_cache_entry_hash(const void *data)
+{
+	const zbx_es_cache_entry_t	*entry = (const zbx_es_cache_entry_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(entry->script);
+}
+
+static int	es_cache_entry_compare(const void *d1, const void *d2)
+{
+	const zbx_es_cache_entry_t	*e1 = (const zbx_es_cache_entry_t *)d1;
+	const zbx_es_cache_entry_t	*e2 = (const zbx_es_cache_entry_t *)d2;
+
+	return strcmp(e1->script, e2->script);
+}
+
+static void	es_cache_entry_clean(void *data)
+{
+	zbx_es_cache_entry_t	*entry = (zbx_es_cache_entry_t *)data;
+
+	zbx_free(entry->code);
+	zbx_free(entry->script);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_es_compile_cached                                            *
+ *                                                                            *
+ * Purpose: get script bytecode from the per process bytecode cache,          *
+ *          compiling and caching it if necessary                             *
+ *                                                                            *
+ * Parameters: es     - [IN] the embedded scripting engine                    *
+ *             script - [IN] the script to compile                            *
+ *             code   - [OUT] the bytecode                                    *
+ *             size   - [OUT] the size of bytecode                            *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value: SUCCEED                                                      *
+ *               FAIL                                                         *
+ *                                                                            *
+ * Comments: The returned bytecode is owned by the cache and must not be      *
+ *           freed. It stays valid until the next bytecode cache access.      *
+ *           The bytecode does not depend on the engine environment, so the   *
+ *           cache is kept when environment is destroyed after fatal error.   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_es_compile_cached(zbx_es_t *es, const char *script, const char **code, int *size, char **error)
+{
+	zbx_es_cache_entry_t	entry_local, *entry;
+
+	entry_local.script = (char *)script;
+
+	if (NULL != (entry = (zbx_es_cache_entry_t *)zbx_lrucache_search(&es_cache, &entry_local)))
+	{
+		*code = entry->code;
+		*size = entry->size;
+		return SUCCEED;
+	}
+
+	if (SUCCEED != zbx_es_compile(es, script, &entry_local.code, &entry_local.size, error))
+		return FAIL;
+
+	if (0 == es_cache.evictions && es_cache.max_size <= es_cache.entries.num_data)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "compiled script cache is full, least recently used scripts"
+				" will be recompiled: consider increasing \"MaxCachedScripts\" configuration parameter");
+	}
+
+	entry_local.script = zbx_strdup(NULL, script);
+	entry = (zbx_es_cache_entry_t *)zbx_lrucache_insert(&es_cache, &entry_local, sizeof(entry_local));
+
+	*code = entry->code;
+	*size = entry->size;
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_es_cache_set_size                                            *
+ *                                                                            *
+ * Purpose: set the maximum number of compiled scripts kept in the per        *
+ *          process bytecode cache                                            *
+ *                                                                            *
+ * Parameters: size - [IN] the maximum number of cached scripts               *
+ *                                                                            *
+ * Comments: Must be called before the cache is used, normally by the main    *
+ *           process before starting child processes.                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_es_cache_set_size(int size)
+{
+	es_cache.max_size = size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_es_cache_get_stats                                           *
+ *                                                                            *
+ * Purpose: get the per process script bytecode cache statistics              *
+ *                                                                            *
+ * Parameters: hits   - [OUT] the number of cache hits                        *
+ *             misses - [OUT] the number of cache misses                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_es_cache_get_stats(zbx_uint64_t *hits, zbx_uint64_t *misses)
+{
+	*hits = es_cache.hits;
+	*misses = es_cache.misses;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_es_execute                                                   *
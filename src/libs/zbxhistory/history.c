@@ -93,12 +93,14 @@ void	zbx_history_destroy(void)
  *                                                                                  *
  * Purpose: Sends values to the history storage                                     *
  *                                                                                  *
- * Parameters: history - [IN] the values to store                                   *
+ * Parameters: history        - [IN] the values to store                            *
+ *             failed_itemids - [OUT] the items of previously sent values that      *
+ *                                    failed to be stored                           *
  *                                                                                  *
  * Comments: add history values to the configured storage backends                  *
  *                                                                                  *
  ************************************************************************************/
-int	zbx_history_add_values(const zbx_vector_ptr_t *history)
+int	zbx_history_add_values(const zbx_vector_ptr_t *history, zbx_vector_uint64_t *failed_itemids)
 {
 	int	i, flags = 0, ret = SUCCEED;
 
@@ -112,6 +114,9 @@ int	zbx_history_add_values(const zbx_vector_ptr_t *history)
 			flags |= (1 << i);
 	}
 
+	/* the previously sent values must be confirmed before sending new ones */
+	zbx_history_sql_wait(failed_itemids);
+
 	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
 	{
 		zbx_history_iface_t	*writer = &history_ifaces[i];
@@ -125,6 +130,24 @@ int	zbx_history_add_values(const zbx_vector_ptr_t *history)
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_wait                                                       *
+ *                                                                                  *
+ * Purpose: waits until the values sent to the history storage are stored           *
+ *                                                                                  *
+ * Parameters: failed_itemids - [OUT] the items of values that failed to be stored  *
+ *                                                                                  *
+ ************************************************************************************/
+void	zbx_history_wait(zbx_vector_uint64_t *failed_itemids)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_history_sql_wait(failed_itemids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: zbx_history_get_values                                                 *
@@ -177,6 +200,48 @@ int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int c
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_get_aggregate                                              *
+ *                                                                                  *
+ * Purpose: aggregates item values in history storage                               *
+ *                                                                                  *
+ * Parameters:  itemid     - [IN] the itemid                                        *
+ *              value_type - [IN] the item value type                               *
+ *              func       - [IN] the aggregate function, see                       *
+ *                                ZBX_HISTORY_AGGREGATE_* defines                   *
+ *              start      - [IN] the period start timestamp                        *
+ *              end        - [IN] the period end timestamp                          *
+ *              value      - [OUT] the aggregated value                             *
+ *              values_num - [OUT] the number of aggregated values                  *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were aggregated successfully            *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function aggregates values from ]<start>.<end ns>,<end>] interval *
+ *           without reading them. Sum, minimum and maximum are returned according  *
+ *           to the value type, while average is always returned as floating point  *
+ *           value.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_history_get_aggregate(zbx_uint64_t itemid, int value_type, int func, int start, const zbx_timespec_t *end,
+		history_value_t *value, int *values_num)
+{
+	int			ret = FAIL;
+	zbx_history_iface_t	*writer = &history_ifaces[value_type];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d func:%d start:%d end:%d.%09d",
+			__func__, itemid, value_type, func, start, end->sec, end->ns);
+
+	if (NULL != writer->get_aggregate)
+		ret = writer->get_aggregate(writer, itemid, func, start, end, value, values_num);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s values:%d", __func__, zbx_result_string(ret),
+			SUCCEED == ret ? *values_num : 0);
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: zbx_history_requires_trends                                            *
@@ -199,6 +264,39 @@ int	zbx_history_requires_trends(int value_type)
 	return 0 != writer->requires_trends ? SUCCEED : FAIL;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_aggregate_available                                        *
+ *                                                                                  *
+ * Purpose: checks if the values can be aggregated by history storage               *
+ *                                                                                  *
+ * Parameters: value_type - [IN] the value type                                     *
+ *             func       - [IN] the aggregate function                             *
+ *             seconds    - [IN] the aggregated period                              *
+ *                                                                                  *
+ * Return value: SUCCEED - the storage aggregation should be used                   *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: Only periods not shorter than configured by storage are aggregated     *
+ *           there, shorter periods are served by value cache.                      *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_history_aggregate_available(int value_type, int func, int seconds)
+{
+	zbx_history_iface_t	*writer = &history_ifaces[value_type];
+
+	if (NULL == writer->get_aggregate || 0 == writer->aggregate_period || seconds < writer->aggregate_period)
+		return FAIL;
+
+	if (ZBX_HISTORY_AGGREGATE_COUNT != func && ITEM_VALUE_TYPE_FLOAT != value_type &&
+			ITEM_VALUE_TYPE_UINT64 != value_type)
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: history_logfree                                                  *
@@ -425,4 +523,3 @@ int	zbx_history_record_compare_desc_func(const zbx_history_record_t *d1, const z
 
 	return d2->timestamp.sec - d1->timestamp.sec;
 }
-
@@ -30,21 +30,27 @@ typedef int (*zbx_history_add_values_func_t)(struct zbx_history_iface *hist, con
 typedef int (*zbx_history_get_values_func_t)(struct zbx_history_iface *hist, zbx_uint64_t itemid, int start,
 		int count, int end, zbx_vector_history_record_t *values);
 typedef int (*zbx_history_flush_func_t)(struct zbx_history_iface *hist);
+typedef int (*zbx_history_get_aggregate_func_t)(struct zbx_history_iface *hist, zbx_uint64_t itemid, int func,
+		int start, const zbx_timespec_t *end, history_value_t *value, int *values_num);
 
 struct zbx_history_iface
 {
 	unsigned char			value_type;
 	unsigned char			requires_trends;
+	/* the minimum period in seconds aggregated by history storage, 0 - not supported */
+	int				aggregate_period;
 	void				*data;
 
 	zbx_history_destroy_func_t	destroy;
 	zbx_history_add_values_func_t	add_values;
 	zbx_history_get_values_func_t	get_values;
 	zbx_history_flush_func_t	flush;
+	zbx_history_get_aggregate_func_t	get_aggregate;
 };
 
 /* SQL hist */
 int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
+void	zbx_history_sql_wait(zbx_vector_uint64_t *itemids);
 
 /* elastic hist */
 int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
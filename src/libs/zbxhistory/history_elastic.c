@@ -31,34 +31,39 @@
 
 #define		ZBX_HISTORY_STORAGE_DOWN	10000 /* Timeout in milliseconds */
 
-#define		ZBX_IDX_JSON_ALLOCATE		256
 #define		ZBX_JSON_ALLOCATE		2048
+#define		ZBX_ELASTIC_STREAM_CHUNK	(64 * ZBX_KIBIBYTE)
+#ifndef ZBX_ELASTIC_PAGE_SIZE
+#define		ZBX_ELASTIC_PAGE_SIZE		10000	/* default index.max_result_window */
+#endif
+#define		ZBX_ELASTIC_PIT_KEEP_ALIVE	"1m"
 
 
 const char	*value_type_str[] = {"dbl", "str", "log", "uint", "text"};
 
 extern char	*CONFIG_HISTORY_STORAGE_URL;
 extern int	CONFIG_HISTORY_STORAGE_PIPELINES;
+extern int	CONFIG_HISTORY_STORAGE_REFRESH;
+extern int	CONFIG_HISTORY_STORAGE_STREAMS;
+extern int	CONFIG_HISTORY_STORAGE_AGGREGATE;
 
-typedef struct
-{
-	char	*base_url;
-	char	*post_url;
-	char	*buf;
-	CURL	*handle;
-}
-zbx_elastic_data_t;
+/* values of refresh parameter of bulk requests, see HistoryStorageRefresh option */
+static const char	*refresh_str[] = {"false", "true", "wait_for"};
+
+/* elasticsearch metrics aggregations, see ZBX_HISTORY_AGGREGATE_* defines */
+static const char	*aggregate_str[] = {"sum", "avg", "min", "max"};
 
 typedef struct
 {
-	unsigned char		initialized;
-	zbx_vector_ptr_t	ifaces;
-
-	CURLM			*handle;
+	char			*base_url;
+	char			*post_url;
+	char			*pit_url;
+	char			*action;
+	CURL			*handle;
+	struct curl_slist	*headers;
+	char			errbuf[CURL_ERROR_SIZE];
 }
-zbx_elastic_writer_t;
-
-static zbx_elastic_writer_t	writer;
+zbx_elastic_data_t;
 
 typedef struct
 {
@@ -77,7 +82,31 @@ typedef struct
 }
 zbx_curlpage_t;
 
-static zbx_curlpage_t	page_w[ITEM_VALUE_TYPE_MAX];
+/* bulk request stream, the handle and buffers are reused by subsequent flushes */
+typedef struct
+{
+	CURL		*handle;
+	zbx_curlpage_t	page;
+	char		*buf;
+	size_t		buf_alloc;
+	size_t		buf_offset;
+}
+zbx_elastic_stream_t;
+
+typedef struct
+{
+	unsigned char		initialized;
+	zbx_elastic_stream_t	*streams;
+	int			streams_num;
+	int			stream_index;
+	char			*post_url;
+	struct curl_slist	*headers;
+
+	CURLM			*handle;
+}
+zbx_elastic_writer_t;
+
+static zbx_elastic_writer_t	writer;
 
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
@@ -191,6 +220,61 @@ out:
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: history_parse_field                                                    *
+ *                                                                                  *
+ * Purpose: gets the first value of doc values field                                *
+ *                                                                                  *
+ ************************************************************************************/
+static int	history_parse_field(struct zbx_json_parse *jp, const char *name, char **value, size_t *value_alloc)
+{
+	struct zbx_json_parse	jp_field;
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp, name, &jp_field))
+		return FAIL;
+
+	if (NULL == zbx_json_next_value_dyn(&jp_field, NULL, value, value_alloc, NULL))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: history_parse_fields                                                   *
+ *                                                                                  *
+ * Purpose: parses numeric history value from doc values fields of search hit       *
+ *                                                                                  *
+ ************************************************************************************/
+static int	history_parse_fields(struct zbx_json_parse *jp, unsigned char value_type, zbx_history_record_t *hr)
+{
+	char	*value = NULL;
+	size_t	value_alloc = 0;
+	int	ret = FAIL;
+
+	if (SUCCEED != history_parse_field(jp, "clock", &value, &value_alloc))
+		goto out;
+
+	hr->timestamp.sec = atoi(value);
+
+	if (SUCCEED != history_parse_field(jp, "ns", &value, &value_alloc))
+		goto out;
+
+	hr->timestamp.ns = atoi(value);
+
+	if (SUCCEED != history_parse_field(jp, "value", &value, &value_alloc))
+		goto out;
+
+	hr->value = history_str2value(value, value_type);
+
+	ret = SUCCEED;
+out:
+	zbx_free(value);
+
+	return ret;
+}
+
 static void	elastic_log_error(CURL *handle, CURLcode error, const char *errbuf)
 {
 	char		http_status[MAX_STRING_LEN];
@@ -232,17 +316,14 @@ static void	elastic_close(zbx_history_iface_t *hist)
 {
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 
-	zbx_free(data->buf);
-	zbx_free(data->post_url);
-
 	if (NULL != data->handle)
 	{
-		if (NULL != writer.handle)
-			curl_multi_remove_handle(writer.handle, data->handle);
-
 		curl_easy_cleanup(data->handle);
 		data->handle = NULL;
 	}
+
+	curl_slist_free_all(data->headers);
+	data->headers = NULL;
 }
 
 /******************************************************************************
@@ -323,29 +404,6 @@ static int	elastic_is_error_present(zbx_httppage_t *page, char **err)
 
 
 
-/************************************************************************************
- *                                                                                  *
- * Function: elastic_writer_init                                                    *
- *                                                                                  *
- * Purpose: initializes elastic writer for a new batch of history values            *
- *                                                                                  *
- ************************************************************************************/
-static void	elastic_writer_init(void)
-{
-	if (0 != writer.initialized)
-		return;
-
-	zbx_vector_ptr_create(&writer.ifaces);
-
-	if (NULL == (writer.handle = curl_multi_init()))
-	{
-		zbx_error("Cannot initialize cURL multi session");
-		exit(EXIT_FAILURE);
-	}
-
-	writer.initialized = 1;
-}
-
 /************************************************************************************
  *                                                                                  *
  * Function: elastic_writer_release                                                 *
@@ -358,75 +416,147 @@ static void	elastic_writer_release(void)
 {
 	int	i;
 
-	for (i = 0; i < writer.ifaces.values_num; i++)
-		elastic_close((zbx_history_iface_t *)writer.ifaces.values[i]);
+	for (i = 0; i < writer.streams_num; i++)
+	{
+		zbx_elastic_stream_t	*stream = &writer.streams[i];
+
+		if (NULL != stream->handle)
+		{
+			curl_multi_remove_handle(writer.handle, stream->handle);
+			curl_easy_cleanup(stream->handle);
+		}
+
+		zbx_free(stream->buf);
+		zbx_free(stream->page.page.data);
+	}
+
+	zbx_free(writer.streams);
+	writer.streams_num = 0;
 
 	curl_multi_cleanup(writer.handle);
 	writer.handle = NULL;
 
-	zbx_vector_ptr_destroy(&writer.ifaces);
+	curl_slist_free_all(writer.headers);
+	writer.headers = NULL;
+
+	zbx_free(writer.post_url);
 
 	writer.initialized = 0;
 }
 
 /************************************************************************************
  *                                                                                  *
- * Function: elastic_writer_add_iface                                               *
+ * Function: elastic_writer_init                                                    *
+ *                                                                                  *
+ * Purpose: initializes elastic writer bulk request streams                         *
  *                                                                                  *
- * Purpose: adds history storage interface to be flushed later                      *
+ * Parameters: base_url - [IN] the history storage url                              *
+ *                                                                                  *
+ * Return value: SUCCEED - the writer was initialized                               *
+ *               FAIL    - otherwise                                                *
  *                                                                                  *
- * Parameters: db_insert - [IN] bulk insert data                                    *
+ * Comments: The writer is kept between flushes, so the bulk requests reuse the     *
+ *           established connections and the allocated buffers.                     *
  *                                                                                  *
  ************************************************************************************/
-static void	elastic_writer_add_iface(zbx_history_iface_t *hist)
+static int	elastic_writer_init(const char *base_url)
 {
-	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
-	CURLoption		opt;
-	CURLcode		err;
+	CURLoption	opt;
+	CURLcode	err;
+	int		i;
 
-	elastic_writer_init();
+	if (0 != writer.initialized)
+		return SUCCEED;
 
-	if (NULL == (data->handle = curl_easy_init()))
+	if (NULL == (writer.handle = curl_multi_init()))
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
-		return;
+		zbx_error("Cannot initialize cURL multi session");
+		exit(EXIT_FAILURE);
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POST, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, data->buf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
-					curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA,
-					&page_w[hist->value_type].page)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER,
-					page_w[hist->value_type].errbuf)))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
-	}
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	/* CURLPIPE_MULTIPLEX is supported starting with version 7.43.0 (0x072b00), */
+	/* it allows to send the streams over single connection with HTTP/2         */
+	curl_multi_setopt(writer.handle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+	writer.post_url = zbx_dsprintf(NULL, "%s/_bulk?refresh=%s", base_url,
+			refresh_str[CONFIG_HISTORY_STORAGE_REFRESH]);
+	writer.headers = curl_slist_append(NULL, "Content-Type: application/x-ndjson");
 
-	*page_w[hist->value_type].errbuf = '\0';
+	writer.streams_num = CONFIG_HISTORY_STORAGE_STREAMS;
+	writer.streams = (zbx_elastic_stream_t *)zbx_malloc(NULL, sizeof(zbx_elastic_stream_t) *
+			(size_t)writer.streams_num);
+	memset(writer.streams, 0, sizeof(zbx_elastic_stream_t) * (size_t)writer.streams_num);
+	writer.stream_index = 0;
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_PRIVATE, &page_w[hist->value_type])))
+	writer.initialized = 1;
+
+	for (i = 0; i < writer.streams_num; i++)
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
+		zbx_elastic_stream_t	*stream = &writer.streams[i];
+
+		if (NULL == (stream->handle = curl_easy_init()))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
+			goto out;
+		}
+
+		if (CURLE_OK != (err = curl_easy_setopt(stream->handle, opt = CURLOPT_URL, writer.post_url)) ||
+				CURLE_OK != (err = curl_easy_setopt(stream->handle, opt = CURLOPT_POST, 1L)) ||
+				CURLE_OK != (err = curl_easy_setopt(stream->handle, opt = CURLOPT_HTTPHEADER,
+						writer.headers)) ||
+				CURLE_OK != (err = curl_easy_setopt(stream->handle, opt = CURLOPT_WRITEFUNCTION,
+						curl_write_cb)) ||
+				CURLE_OK != (err = curl_easy_setopt(stream->handle, opt = CURLOPT_WRITEDATA,
+						&stream->page.page)) ||
+				CURLE_OK != (err = curl_easy_setopt(stream->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
+				CURLE_OK != (err = curl_easy_setopt(stream->handle, opt = CURLOPT_ERRORBUFFER,
+						stream->page.errbuf)) ||
+				CURLE_OK != (err = curl_easy_setopt(stream->handle, opt = CURLOPT_PRIVATE,
+						&stream->page)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt,
+					curl_easy_strerror(err));
+			goto out;
+		}
 	}
 
-	page_w[hist->value_type].page.offset = 0;
+	return SUCCEED;
+out:
+	elastic_writer_release();
 
-	if (0 < page_w[hist->value_type].page.alloc)
-		*page_w[hist->value_type].page.data = '\0';
+	return FAIL;
+}
 
-	curl_multi_add_handle(writer.handle, data->handle);
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_writer_get_stream                                              *
+ *                                                                                  *
+ * Purpose: gets bulk request stream for the next history value                     *
+ *                                                                                  *
+ * Comments: The current stream is filled up to ZBX_ELASTIC_STREAM_CHUNK bytes, so  *
+ *           small batches are not split into many small requests. After that the   *
+ *           values are distributed to the least loaded streams.                    *
+ *                                                                                  *
+ ************************************************************************************/
+static zbx_elastic_stream_t	*elastic_writer_get_stream(void)
+{
+	zbx_elastic_stream_t	*stream = &writer.streams[writer.stream_index];
+	int			i;
 
-	zbx_vector_ptr_append(&writer.ifaces, hist);
+	if (ZBX_ELASTIC_STREAM_CHUNK > stream->buf_offset)
+		return stream;
 
-	return;
-out:
-	elastic_close(hist);
+	for (i = 0; i < writer.streams_num; i++)
+	{
+		if (writer.streams[i].buf_offset < stream->buf_offset)
+		{
+			stream = &writer.streams[i];
+			writer.stream_index = i;
+		}
+	}
+
+	return stream;
 }
 
 /************************************************************************************
@@ -438,8 +568,7 @@ out:
  ************************************************************************************/
 static int	elastic_writer_flush(void)
 {
-	struct curl_slist	*curl_headers = NULL;
-	int			i, running, previous, msgnum;
+	int			i, running, previous, msgnum, streams_num = 0;
 	CURLMsg			*msg;
 	zbx_vector_ptr_t	retries;
 	CURLcode		err;
@@ -447,31 +576,44 @@ static int	elastic_writer_flush(void)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	/* The writer might be uninitialized only if the history */
-	/* was already flushed. In that case, return SUCCEED */
+	/* The writer might be uninitialized only if no history */
+	/* was added. In that case, return SUCCEED */
 	if (0 == writer.initialized)
 		goto end;
 
 	zbx_vector_ptr_create(&retries);
 
-	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/x-ndjson");
-
-	for (i = 0; i < writer.ifaces.values_num; i++)
+	for (i = 0; i < writer.streams_num; i++)
 	{
-		zbx_history_iface_t	*hist = (zbx_history_iface_t *)writer.ifaces.values[i];
-		zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
+		zbx_elastic_stream_t	*stream = &writer.streams[i];
+
+		if (0 == stream->buf_offset)
+			continue;
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_HTTPHEADER, curl_headers)))
+		if (CURLE_OK != (err = curl_easy_setopt(stream->handle, CURLOPT_POSTFIELDS, stream->buf)) ||
+				CURLE_OK != (err = curl_easy_setopt(stream->handle, CURLOPT_POSTFIELDSIZE,
+						(long)stream->buf_offset)))
 		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_HTTPHEADER,
+			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_POSTFIELDS,
 					curl_easy_strerror(err));
 			ret = FAIL;
 			goto clean;
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "sending %s", data->buf);
+		*stream->page.errbuf = '\0';
+		stream->page.page.offset = 0;
+
+		if (0 < stream->page.page.alloc)
+			*stream->page.page.data = '\0';
+
+		curl_multi_add_handle(writer.handle, stream->handle);
+		streams_num++;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "sending %s", stream->buf);
 	}
 
+	if (0 == streams_num)
+		goto clean;
 try_again:
 	previous = 0;
 
@@ -582,11 +724,18 @@ try_again:
 		goto try_again;
 	}
 clean:
-	curl_slist_free_all(curl_headers);
+	for (i = 0; i < writer.streams_num; i++)
+	{
+		zbx_elastic_stream_t	*stream = &writer.streams[i];
 
-	zbx_vector_ptr_destroy(&retries);
+		if (0 == stream->buf_offset)
+			continue;
 
-	elastic_writer_release();
+		curl_multi_remove_handle(writer.handle, stream->handle);
+		stream->buf_offset = 0;
+	}
+
+	zbx_vector_ptr_destroy(&retries);
 
 end:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -615,254 +764,668 @@ static void	elastic_destroy(zbx_history_iface_t *hist)
 
 	elastic_close(hist);
 
+	if (0 != writer.initialized)
+		elastic_writer_release();
+
+	zbx_free(data->post_url);
+	zbx_free(data->pit_url);
+	zbx_free(data->action);
 	zbx_free(data->base_url);
 	zbx_free(data);
 }
 
 /************************************************************************************
  *                                                                                  *
- * Function: elastic_get_values                                                     *
+ * Function: elastic_request                                                        *
  *                                                                                  *
- * Purpose: gets item history data from history storage                             *
+ * Purpose: sends request to history storage                                        *
  *                                                                                  *
- * Parameters:  hist    - [IN] the history storage interface                        *
- *              itemid  - [IN] the itemid                                           *
- *              start   - [IN] the period start timestamp                           *
- *              count   - [IN] the number of values to read                         *
- *              end     - [IN] the period end timestamp                             *
- *              values  - [OUT] the item history data values                        *
+ * Parameters:  hist   - [IN] the history storage interface                         *
+ *              url    - [IN] the request url                                       *
+ *              method - [IN] the request method, NULL for POST                     *
+ *              query  - [IN] the request body                                      *
+ *              jp     - [OUT] the response                                         *
  *                                                                                  *
- * Return value: SUCCEED - the history data were read successfully                  *
+ * Return value: SUCCEED - the request was performed successfully                   *
  *               FAIL - otherwise                                                   *
  *                                                                                  *
- * Comments: This function reads <count> values from ]<start>,<end>] interval or    *
- *           all values from the specified interval if count is zero.               *
+ * Comments: The session is kept open between requests, so the subsequent requests  *
+ *           reuse the established connection. The response is stored in page_r     *
+ *           buffer and is valid until the next request.                            *
  *                                                                                  *
  ************************************************************************************/
-static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int start, int count, int end,
-		zbx_vector_history_record_t *values)
+static int	elastic_request(zbx_history_iface_t *hist, const char *url, const char *method, const char *query,
+		struct zbx_json_parse *jp)
 {
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
-	size_t			url_alloc = 0, url_offset = 0, id_alloc = 0, scroll_alloc = 0, scroll_offset = 0;
-	int			total, empty, ret;
 	CURLcode		err;
-	struct zbx_json		query;
-	struct curl_slist	*curl_headers = NULL;
-	char			*scroll_id = NULL, *scroll_query = NULL, errbuf[CURL_ERROR_SIZE];
 	CURLoption		opt;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	ret = FAIL;
-
-	if (NULL == (data->handle = curl_easy_init()))
+	if (NULL == data->handle)
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
-
-		return FAIL;
-	}
-
-	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/%s*/_search?scroll=10s", data->base_url,
-			value_type_str[hist->value_type]);
+		if (NULL == (data->handle = curl_easy_init()))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
+			return FAIL;
+		}
 
-	/* prepare the json query for elasticsearch, apply ranges if needed */
-	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
+		data->headers = curl_slist_append(NULL, "Content-Type: application/json");
 
-	if (0 < count)
-	{
-		zbx_json_adduint64(&query, "size", count);
-		zbx_json_addarray(&query, "sort");
-		zbx_json_addobject(&query, NULL);
-		zbx_json_addobject(&query, "clock");
-		zbx_json_addstring(&query, "order", "desc", ZBX_JSON_TYPE_STRING);
-		zbx_json_close(&query);
-		zbx_json_close(&query);
-		zbx_json_close(&query);
+		if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
+						curl_write_cb)) ||
+				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
+				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_HTTPHEADER,
+						data->headers)) ||
+				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
+				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER,
+						data->errbuf)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
+			elastic_close(hist);
+			return FAIL;
+		}
 	}
 
-	zbx_json_addobject(&query, "query");
-	zbx_json_addobject(&query, "bool");
-	zbx_json_addarray(&query, "must");
-	zbx_json_addobject(&query, NULL);
-	zbx_json_addobject(&query, "match");
-	zbx_json_adduint64(&query, "itemid", itemid);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_addarray(&query, "filter");
-	zbx_json_addobject(&query, NULL);
-	zbx_json_addobject(&query, "range");
-	zbx_json_addobject(&query, "clock");
-
-	if (0 < start)
-		zbx_json_adduint64(&query, "gt", start);
-
-	if (0 < end)
-		zbx_json_adduint64(&query, "lte", end);
-
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-
-	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/json");
-
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, query.buffer)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
-					curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_HTTPHEADER, curl_headers)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER, errbuf)))
+	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, url)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_CUSTOMREQUEST, method)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, query)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
+		return FAIL;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", data->post_url, query.buffer);
+	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", url, query);
 
 	page_r.offset = 0;
-	*errbuf = '\0';
+	*data->errbuf = '\0';
 	if (CURLE_OK != (err = curl_easy_perform(data->handle)))
 	{
-		elastic_log_error(data->handle, err, errbuf);
-		goto out;
+		elastic_log_error(data->handle, err, data->errbuf);
+		return FAIL;
 	}
 
-	url_offset = 0;
-	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/_search/scroll", data->base_url);
-
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_URL, data->post_url)))
+	if (0 == page_r.offset)
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_URL,
-				curl_easy_strerror(err));
-		goto out;
+		zabbix_log(LOG_LEVEL_ERR, "cannot get values from elasticsearch: empty response");
+		return FAIL;
 	}
 
-	total = (0 == count ? -1 : count);
+	zabbix_log(LOG_LEVEL_DEBUG, "received from elasticsearch: %s", page_r.data);
 
-	/* For processing the records, we need to keep track of the total requested and if the response from the */
-	/* elasticsearch server is empty. For this we use two variables, empty and total. If the result is empty or */
-	/* the total reach zero, we terminate the scrolling query and return what we currently have. */
-	do
+	if (SUCCEED != zbx_json_open(page_r.data, jp))
 	{
-		struct zbx_json_parse	jp, jp_values, jp_item, jp_sub, jp_hits, jp_source;
-		zbx_history_record_t	hr;
-		const char		*p = NULL;
+		zabbix_log(LOG_LEVEL_ERR, "cannot parse elasticsearch response: %s", zbx_json_strerror());
+		return FAIL;
+	}
 
-		empty = 1;
+	return SUCCEED;
+}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "received from elasticsearch: %s", page_r.data);
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_search                                                         *
+ *                                                                                  *
+ * Purpose: sends search request to the indices of value type                       *
+ *                                                                                  *
+ * Parameters:  hist  - [IN] the history storage interface                          *
+ *              query - [IN] the search request body                                *
+ *              jp    - [OUT] the response                                          *
+ *                                                                                  *
+ * Return value: SUCCEED - the search was performed successfully                    *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_search(zbx_history_iface_t *hist, const char *query, struct zbx_json_parse *jp)
+{
+	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 
-		zbx_json_open(page_r.data, &jp);
-		zbx_json_brackets_open(jp.start, &jp_values);
+	return elastic_request(hist, data->post_url, NULL, query, jp);
+}
 
-		/* get the scroll id immediately, for being used in subsequent queries */
-		if (SUCCEED != zbx_json_value_by_name_dyn(&jp_values, "_scroll_id", &scroll_id, &id_alloc, NULL))
-		{
-			zabbix_log(LOG_LEVEL_WARNING, "elasticsearch version is not compatible with zabbix server. "
-					"_scroll_id tag is absent");
-		}
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_open_pit                                                       *
+ *                                                                                  *
+ * Purpose: opens point in time of the indices of value type                        *
+ *                                                                                  *
+ * Parameters:  hist   - [IN] the history storage interface                         *
+ *              pit_id - [OUT] the point in time id                                 *
+ *                                                                                  *
+ * Return value: SUCCEED - the point in time was opened                             *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_open_pit(zbx_history_iface_t *hist, char **pit_id)
+{
+	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
+	struct zbx_json_parse	jp, jp_values;
+	size_t			pit_id_alloc = 0;
 
-		zbx_json_brackets_by_name(&jp_values, "hits", &jp_sub);
-		zbx_json_brackets_by_name(&jp_sub, "hits", &jp_hits);
+	if (SUCCEED != elastic_request(hist, data->pit_url, NULL, "", &jp))
+		return FAIL;
+
+	if (SUCCEED != zbx_json_brackets_open(jp.start, &jp_values) ||
+			SUCCEED != zbx_json_value_by_name_dyn(&jp_values, "id", pit_id, &pit_id_alloc, NULL))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "elasticsearch version is not compatible with zabbix server. "
+				"point in time id is absent");
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_close_pit                                                      *
+ *                                                                                  *
+ * Purpose: closes point in time opened by elastic_open_pit()                       *
+ *                                                                                  *
+ * Parameters:  hist   - [IN] the history storage interface                         *
+ *              pit_id - [IN] the point in time id                                  *
+ *                                                                                  *
+ * Comments: Point in time, which was not closed, expires after keep alive period.  *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_close_pit(zbx_history_iface_t *hist, const char *pit_id)
+{
+	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
+	struct zbx_json_parse	jp;
+	struct zbx_json		query;
+	char			*url;
+
+	url = zbx_dsprintf(NULL, "%s/_pit", data->base_url);
+
+	zbx_json_init(&query, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&query, "id", pit_id, ZBX_JSON_TYPE_STRING);
+
+	if (SUCCEED != elastic_request(hist, url, "DELETE", query.buffer, &jp))
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot close elasticsearch point in time");
+
+	zbx_json_free(&query);
+	zbx_free(url);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_add_item_filter                                                *
+ *                                                                                  *
+ * Purpose: adds item and time range filter to the search request                   *
+ *                                                                                  *
+ * Parameters:  query  - [IN/OUT] the search request                                *
+ *              itemid - [IN] the itemid                                            *
+ *              start  - [IN] the period start timestamp (0 - unlimited)            *
+ *              end    - [IN] the period end timestamp (0 - unlimited)              *
+ *                                                                                  *
+ * Comments: The filter array is left open, so more clauses can be added.           *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_add_item_filter(struct zbx_json *query, zbx_uint64_t itemid, int start, int end)
+{
+	zbx_json_addobject(query, "query");
+	zbx_json_addobject(query, "bool");
+	zbx_json_addarray(query, "filter");
+
+	zbx_json_addobject(query, NULL);
+	zbx_json_addobject(query, "term");
+	zbx_json_adduint64(query, "itemid", itemid);
+	zbx_json_close(query);
+	zbx_json_close(query);
+
+	if (0 < start || 0 < end)
+	{
+		zbx_json_addobject(query, NULL);
+		zbx_json_addobject(query, "range");
+		zbx_json_addobject(query, "clock");
+
+		if (0 < start)
+			zbx_json_adduint64(query, "gt", start);
+
+		if (0 < end)
+			zbx_json_adduint64(query, "lte", end);
+
+		zbx_json_close(query);
+		zbx_json_close(query);
+		zbx_json_close(query);
+	}
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_add_sort_field                                                 *
+ *                                                                                  *
+ * Purpose: adds descending sort by the specified field to the search request       *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_add_sort_field(struct zbx_json *query, const char *field)
+{
+	zbx_json_addobject(query, NULL);
+	zbx_json_addobject(query, field);
+	zbx_json_addstring(query, "order", "desc", ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(query, "unmapped_type", "long", ZBX_JSON_TYPE_STRING);
+	zbx_json_close(query);
+	zbx_json_close(query);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_add_docvalue_field                                             *
+ *                                                                                  *
+ * Purpose: adds field to be read from doc values to the search request             *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_add_docvalue_field(struct zbx_json *query, const char *field, const char *format)
+{
+	zbx_json_addobject(query, NULL);
+	zbx_json_addstring(query, "field", field, ZBX_JSON_TYPE_STRING);
+
+	if (NULL != format)
+		zbx_json_addstring(query, "format", format, ZBX_JSON_TYPE_STRING);
+
+	zbx_json_close(query);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_prepare_values_query                                           *
+ *                                                                                  *
+ * Purpose: prepares search request for the next page of item history values        *
+ *                                                                                  *
+ * Parameters:  query      - [OUT] the search request                               *
+ *              value_type - [IN] the item value type                               *
+ *              itemid     - [IN] the itemid                                        *
+ *              start      - [IN] the period start timestamp                        *
+ *              end        - [IN] the period end timestamp                          *
+ *              size       - [IN] the page size                                     *
+ *              pit_id     - [IN] the point in time id, NULL to search the indices  *
+ *                                without point in time                             *
+ *              after      - [IN] the sort values of the last hit of the previous   *
+ *                                page, NULL for the first page                     *
+ *                                                                                  *
+ * Comments: Numeric values are read from doc values instead of the document        *
+ *           source, so the documents are not loaded and parsed by storage.         *
+ *           In point in time the hits are also sorted by _shard_doc, so the sort   *
+ *           values are unique and the next page continues exactly after the last   *
+ *           hit.                                                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_prepare_values_query(struct zbx_json *query, unsigned char value_type, zbx_uint64_t itemid,
+		int start, int end, int size, const char *pit_id, const char *after)
+{
+	zbx_json_clean(query);
+
+	zbx_json_adduint64(query, "size", size);
+	zbx_json_addstring(query, "track_total_hits", "false", ZBX_JSON_TYPE_INT);
+
+	zbx_json_addarray(query, "sort");
+	elastic_add_sort_field(query, "clock");
+	elastic_add_sort_field(query, "ns");
+
+	if (NULL != pit_id)
+	{
+		zbx_json_addobject(query, NULL);
+		zbx_json_addstring(query, "_shard_doc", "asc", ZBX_JSON_TYPE_STRING);
+		zbx_json_close(query);
+	}
+
+	zbx_json_close(query);
+
+	if (NULL != pit_id)
+	{
+		zbx_json_addobject(query, "pit");
+		zbx_json_addstring(query, "id", pit_id, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(query, "keep_alive", ZBX_ELASTIC_PIT_KEEP_ALIVE, ZBX_JSON_TYPE_STRING);
+		zbx_json_close(query);
+	}
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type || ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		zbx_json_addstring(query, "_source", "false", ZBX_JSON_TYPE_INT);
+		zbx_json_addarray(query, "docvalue_fields");
+		elastic_add_docvalue_field(query, "clock", "epoch_second");
+		elastic_add_docvalue_field(query, "ns", NULL);
+		elastic_add_docvalue_field(query, "value", NULL);
+		zbx_json_close(query);
+	}
+
+	elastic_add_item_filter(query, itemid, start, end);
+	zbx_json_close(query);
+	zbx_json_close(query);
+	zbx_json_close(query);
+
+	if (NULL != after)
+		zbx_json_addraw(query, "search_after", after);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_get_values                                                     *
+ *                                                                                  *
+ * Purpose: gets item history data from history storage                             *
+ *                                                                                  *
+ * Parameters:  hist    - [IN] the history storage interface                        *
+ *              itemid  - [IN] the itemid                                           *
+ *              start   - [IN] the period start timestamp                           *
+ *              count   - [IN] the number of values to read                         *
+ *              end     - [IN] the period end timestamp                             *
+ *              values  - [OUT] the item history data values                        *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads <count> values from ]<start>,<end>] interval or    *
+ *           all values from the specified interval if count is zero.               *
+ *           The values are read in pages sorted by timestamp in descending order,  *
+ *           each page continuing after the last value of previous page. So only    *
+ *           the requested number of values is transferred.                         *
+ *           Timestamps are not unique, so if more than one page is needed, the     *
+ *           values with timestamp equal to the last value of the first page are    *
+ *           dropped and the following pages are read in point in time, where the   *
+ *           values are additionally sorted by unique _shard_doc tiebreaker.        *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int start, int count, int end,
+		zbx_vector_history_record_t *values)
+{
+	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
+	int			ret = FAIL, i, size, hits_num, group_hits, group_index, values_num = 0;
+	struct zbx_json		query;
+	char			*after = NULL, *last = NULL, *pit_id = NULL, *pit_search_url = NULL, *tmp;
+	size_t			after_alloc = 0, last_alloc = 0, pit_id_alloc = 0, tmp_alloc, offset, len;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
+
+	while (1)
+	{
+		struct zbx_json_parse	jp, jp_values, jp_item, jp_sub, jp_hits, jp_source, jp_sort;
+		zbx_history_record_t	hr;
+		const char		*p = NULL;
+
+		size = ZBX_ELASTIC_PAGE_SIZE;
+
+		if (0 != count && count - values_num < size)
+			size = count - values_num;
+
+		elastic_prepare_values_query(&query, hist->value_type, itemid, start, end, size, pit_id, after);
+
+		if (SUCCEED != elastic_request(hist, NULL == pit_id ? data->post_url : pit_search_url, NULL,
+				query.buffer, &jp))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != zbx_json_brackets_open(jp.start, &jp_values) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp_values, "hits", &jp_sub) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp_sub, "hits", &jp_hits))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "elasticsearch version is not compatible with zabbix server. "
+					"hits tag is absent");
+			goto out;
+		}
+
+		/* point in time id might change with each search response */
+		if (NULL != pit_id)
+			zbx_json_value_by_name_dyn(&jp_values, "pit_id", &pit_id, &pit_id_alloc, NULL);
+
+		hits_num = 0;
+		group_hits = 0;
+		group_index = values->values_num;
+
+		if (NULL != last)
+			*last = '\0';
 
 		while (NULL != (p = zbx_json_next(&jp_hits, p)))
 		{
-			empty = 0;
+			hits_num++;
 
 			if (SUCCEED != zbx_json_brackets_open(p, &jp_item))
 				continue;
 
-			if (SUCCEED != zbx_json_brackets_by_name(&jp_item, "_source", &jp_source))
-				continue;
-
-			if (SUCCEED != history_parse_value(&jp_source, hist->value_type, &hr))
-				continue;
+			/* remember the sort values of the last hit and where the last group of hits with */
+			/* equal sort values starts                                                        */
+			if (SUCCEED == zbx_json_brackets_by_name(&jp_item, "sort", &jp_sort))
+			{
+				len = (size_t)(jp_sort.end - jp_sort.start + 1);
 
-			zbx_vector_history_record_append_ptr(values, &hr);
+				if (NULL == last || len != strlen(last) || 0 != strncmp(last, jp_sort.start, len))
+				{
+					group_hits = hits_num - 1;
+					group_index = values->values_num;
+				}
 
-			if (-1 != total)
-				--total;
+				offset = 0;
+				zbx_strncpy_alloc(&last, &last_alloc, &offset, jp_sort.start, len);
+			}
 
-			if (0 == total)
+			if (SUCCEED == zbx_json_brackets_by_name(&jp_item, "fields", &jp_source))
 			{
-				empty = 1;
-				break;
+				if (SUCCEED != history_parse_fields(&jp_source, hist->value_type, &hr))
+					continue;
 			}
-		}
+			else
+			{
+				if (SUCCEED != zbx_json_brackets_by_name(&jp_item, "_source", &jp_source))
+					continue;
 
-		if (1 == empty)
-		{
-			ret = SUCCEED;
-			break;
-		}
+				if (SUCCEED != history_parse_value(&jp_source, hist->value_type, &hr))
+					continue;
+			}
 
-		/* scroll to the next page */
-		scroll_offset = 0;
-		zbx_snprintf_alloc(&scroll_query, &scroll_alloc, &scroll_offset,
-				"{\"scroll\":\"10s\",\"scroll_id\":\"%s\"}\n", ZBX_NULL2EMPTY_STR(scroll_id));
+			zbx_vector_history_record_append_ptr(values, &hr);
+		}
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_POSTFIELDS, scroll_query)))
-		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_POSTFIELDS,
-					curl_easy_strerror(err));
+		if (hits_num != size || NULL == last || '\0' == *last || (0 != count && values_num + hits_num >= count))
 			break;
-		}
 
-		page_r.offset = 0;
-		*errbuf = '\0';
-		if (CURLE_OK != (err = curl_easy_perform(data->handle)))
+		if (NULL == pit_id)
 		{
-			elastic_log_error(data->handle, err, errbuf);
-			break;
+			if (SUCCEED != elastic_open_pit(hist, &pit_id))
+			{
+				zabbix_log(LOG_LEVEL_ERR, "cannot read values of item " ZBX_FS_UI64 " in pages from"
+						" elasticsearch: point in time is not available", itemid);
+				goto out;
+			}
+
+			pit_search_url = zbx_dsprintf(NULL, "%s/_search", data->base_url);
+
+			/* the values with equal timestamp might continue in the next page, so the last group */
+			/* of hits is read again in point in time, starting before its lowest tiebreaker      */
+			for (i = group_index; i < values->values_num; i++)
+				zbx_history_record_clear(&values->values[i], hist->value_type);
+
+			values->values_num = group_index;
+			hits_num = group_hits;
+
+			offset = strlen(last) - 1;
+			zbx_strcpy_alloc(&last, &last_alloc, &offset, ",-1]");
 		}
+
+		values_num += hits_num;
+
+		tmp = after;
+		tmp_alloc = after_alloc;
+		after = last;
+		after_alloc = last_alloc;
+		last = tmp;
+		last_alloc = tmp_alloc;
 	}
-	while (0 == empty);
 
-	/* as recommended by the elasticsearch documentation, we close the scroll search through a DELETE request */
-	if (NULL != scroll_id)
+	ret = SUCCEED;
+out:
+	if (NULL != pit_id)
+		elastic_close_pit(hist, pit_id);
+
+	zbx_json_free(&query);
+	zbx_free(after);
+	zbx_free(last);
+	zbx_free(pit_id);
+	zbx_free(pit_search_url);
+
+	zbx_vector_history_record_sort(values, (zbx_compare_func_t)zbx_history_record_compare_desc_func);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_get_aggregate                                                  *
+ *                                                                                  *
+ * Purpose: aggregates item history data in history storage                         *
+ *                                                                                  *
+ * Parameters:  hist       - [IN] the history storage interface                     *
+ *              itemid     - [IN] the itemid                                        *
+ *              func       - [IN] the aggregate function, see                       *
+ *                                ZBX_HISTORY_AGGREGATE_* defines                   *
+ *              start      - [IN] the period start timestamp                        *
+ *              end        - [IN] the period end timestamp                          *
+ *              value      - [OUT] the aggregated value                             *
+ *              values_num - [OUT] the number of aggregated values                  *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were aggregated successfully            *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: The values from ]<start>.<end ns>,<end>] interval are aggregated with  *
+ *           nanosecond precision, the same as they would be selected by value      *
+ *           cache. Storage calculates metrics of integer values as floating point  *
+ *           values, so sums over 2^53 can lose precision.                          *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_get_aggregate(zbx_history_iface_t *hist, zbx_uint64_t itemid, int func, int start,
+		const zbx_timespec_t *end, history_value_t *value, int *values_num)
+{
+	int			ret = FAIL;
+	struct zbx_json		query;
+	struct zbx_json_parse	jp, jp_values, jp_aggs, jp_aggr;
+	char			buffer[MAX_STRING_LEN];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
+
+	zbx_json_adduint64(&query, "size", 0);
+	zbx_json_addstring(&query, "track_total_hits", "false", ZBX_JSON_TYPE_INT);
+
+	elastic_add_item_filter(&query, itemid, 0, end->sec);
+
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "range");
+	zbx_json_addobject(&query, "clock");
+	zbx_json_adduint64(&query, "gte", start);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	/* exclude values outside the period boundaries with nanosecond precision */
+	zbx_json_addarray(&query, "must_not");
+
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "bool");
+	zbx_json_addarray(&query, "filter");
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "term");
+	zbx_json_adduint64(&query, "clock", start);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "range");
+	zbx_json_addobject(&query, "ns");
+	zbx_json_adduint64(&query, "lte", end->ns);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "bool");
+	zbx_json_addarray(&query, "filter");
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "term");
+	zbx_json_adduint64(&query, "clock", end->sec);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "range");
+	zbx_json_addobject(&query, "ns");
+	zbx_json_adduint64(&query, "gt", end->ns);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	zbx_json_addobject(&query, "aggs");
+	zbx_json_addobject(&query, "count");
+	zbx_json_addobject(&query, "value_count");
+	zbx_json_addstring(&query, "field", "clock", ZBX_JSON_TYPE_STRING);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	if (ZBX_HISTORY_AGGREGATE_COUNT != func)
+	{
+		zbx_json_addobject(&query, "value");
+		zbx_json_addobject(&query, aggregate_str[func]);
+		zbx_json_addstring(&query, "field", "value", ZBX_JSON_TYPE_STRING);
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+	}
+
+	zbx_json_close(&query);
+
+	if (SUCCEED != elastic_search(hist, query.buffer, &jp))
+		goto out;
+
+	if (SUCCEED != zbx_json_brackets_open(jp.start, &jp_values) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp_values, "aggregations", &jp_aggs) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp_aggs, "count", &jp_aggr) ||
+			SUCCEED != zbx_json_value_by_name(&jp_aggr, "value", buffer, sizeof(buffer), NULL))
 	{
-		url_offset = 0;
-		zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/_search/scroll/%s", data->base_url,
-				scroll_id);
+		zabbix_log(LOG_LEVEL_WARNING, "elasticsearch version is not compatible with zabbix server. "
+				"aggregations tag is absent");
+		goto out;
+	}
+
+	memset(value, 0, sizeof(history_value_t));
+	*values_num = atoi(buffer);
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, "")) ||
-				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_CUSTOMREQUEST, "DELETE")))
+	if (ZBX_HISTORY_AGGREGATE_COUNT != func && 0 != *values_num)
+	{
+		zbx_json_type_t	type;
+		double		dbl;
+
+		if (SUCCEED != zbx_json_brackets_by_name(&jp_aggs, "value", &jp_aggr) ||
+				SUCCEED != zbx_json_value_by_name(&jp_aggr, "value", buffer, sizeof(buffer), &type) ||
+				ZBX_JSON_TYPE_NULL == type)
 		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt,
-					curl_easy_strerror(err));
-			ret = FAIL;
+			zabbix_log(LOG_LEVEL_WARNING, "cannot get %s aggregation value from elasticsearch",
+					aggregate_str[func]);
 			goto out;
 		}
 
+		dbl = atof(buffer);
 
-		zabbix_log(LOG_LEVEL_DEBUG, "elasticsearch closing scroll %s", data->post_url);
-
-		page_r.offset = 0;
-		*errbuf = '\0';
-		if (CURLE_OK != (err = curl_easy_perform(data->handle)))
-			elastic_log_error(data->handle, err, errbuf);
+		if (ITEM_VALUE_TYPE_FLOAT == hist->value_type || ZBX_HISTORY_AGGREGATE_AVG == func)
+			value->dbl = dbl;
+		else
+			value->ui64 = (zbx_uint64_t)dbl;
 	}
 
+	ret = SUCCEED;
 out:
-	elastic_close(hist);
-
-	curl_slist_free_all(curl_headers);
-
 	zbx_json_free(&query);
 
-	zbx_free(scroll_id);
-	zbx_free(scroll_query);
-
-	zbx_vector_history_record_sort(values, (zbx_compare_func_t)zbx_history_record_compare_desc_func);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
@@ -882,38 +1445,27 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 	int			i, num = 0;
 	ZBX_DC_HISTORY		*h;
-	struct zbx_json		json_idx, json;
-	size_t			buf_alloc = 0, buf_offset = 0;
-	char			pipeline[14]; /* index name length + suffix "-pipeline" */
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_json_init(&json_idx, ZBX_IDX_JSON_ALLOCATE);
-
-	zbx_json_addobject(&json_idx, "index");
-	zbx_json_addstring(&json_idx, "_index", value_type_str[hist->value_type], ZBX_JSON_TYPE_STRING);
-
-	if (1 == CONFIG_HISTORY_STORAGE_PIPELINES)
-	{
-		zbx_snprintf(pipeline, sizeof(pipeline), "%s-pipeline", value_type_str[hist->value_type]);
-		zbx_json_addstring(&json_idx, "pipeline", pipeline, ZBX_JSON_TYPE_STRING);
-	}
-
-	zbx_json_close(&json_idx);
-	zbx_json_close(&json_idx);
+	if (SUCCEED != elastic_writer_init(data->base_url))
+		goto out;
 
 	for (i = 0; i < history->values_num; i++)
 	{
+		zbx_elastic_stream_t	*stream;
+
 		h = (ZBX_DC_HISTORY *)history->values[i];
 
 		if (hist->value_type != h->value_type)
 			continue;
 
-		zbx_json_init(&json, ZBX_JSON_ALLOCATE);
-
-		zbx_json_adduint64(&json, "itemid", h->itemid);
+		stream = elastic_writer_get_stream();
 
-		zbx_json_addstring(&json, "value", history_value2str(h), ZBX_JSON_TYPE_STRING);
+		zbx_strcpy_alloc(&stream->buf, &stream->buf_alloc, &stream->buf_offset, data->action);
+		zbx_snprintf_alloc(&stream->buf, &stream->buf_alloc, &stream->buf_offset,
+				"{\"itemid\":" ZBX_FS_UI64 ",\"value\":", h->itemid);
+		zbx_json_strcpy_alloc(&stream->buf, &stream->buf_alloc, &stream->buf_offset, history_value2str(h));
 
 		if (ITEM_VALUE_TYPE_LOG == h->value_type)
 		{
@@ -921,33 +1473,20 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 
 			log = h->value.log;
 
-			zbx_json_adduint64(&json, "timestamp", log->timestamp);
-			zbx_json_addstring(&json, "source", ZBX_NULL2EMPTY_STR(log->source), ZBX_JSON_TYPE_STRING);
-			zbx_json_adduint64(&json, "severity", log->severity);
-			zbx_json_adduint64(&json, "logeventid", log->logeventid);
+			zbx_snprintf_alloc(&stream->buf, &stream->buf_alloc, &stream->buf_offset,
+					",\"timestamp\":%d,\"source\":", log->timestamp);
+			zbx_json_strcpy_alloc(&stream->buf, &stream->buf_alloc, &stream->buf_offset,
+					ZBX_NULL2EMPTY_STR(log->source));
+			zbx_snprintf_alloc(&stream->buf, &stream->buf_alloc, &stream->buf_offset,
+					",\"severity\":%d,\"logeventid\":%d", log->severity, log->logeventid);
 		}
 
-		zbx_json_adduint64(&json, "clock", h->ts.sec);
-		zbx_json_adduint64(&json, "ns", h->ts.ns);
-		zbx_json_adduint64(&json, "ttl", h->ttl);
-
-		zbx_json_close(&json);
-
-		zbx_snprintf_alloc(&data->buf, &buf_alloc, &buf_offset, "%s\n%s\n", json_idx.buffer, json.buffer);
-
-		zbx_json_free(&json);
+		zbx_snprintf_alloc(&stream->buf, &stream->buf_alloc, &stream->buf_offset,
+				",\"clock\":%d,\"ns\":%d,\"ttl\":%d}\n", h->ts.sec, h->ts.ns, h->ttl);
 
 		num++;
 	}
-
-	if (num > 0)
-	{
-		data->post_url = zbx_dsprintf(NULL, "%s/_bulk?refresh=true", data->base_url);
-		elastic_writer_add_iface(hist);
-	}
-
-	zbx_json_free(&json_idx);
-
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return num;
@@ -1000,18 +1539,36 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 	memset(data, 0, sizeof(zbx_elastic_data_t));
 	data->base_url = zbx_strdup(NULL, CONFIG_HISTORY_STORAGE_URL);
 	zbx_rtrim(data->base_url, "/");
-	data->buf = NULL;
-	data->post_url = NULL;
+	data->post_url = zbx_dsprintf(NULL, "%s/%s*/_search", data->base_url, value_type_str[value_type]);
+	data->pit_url = zbx_dsprintf(NULL, "%s/%s*/_pit?keep_alive=" ZBX_ELASTIC_PIT_KEEP_ALIVE, data->base_url,
+			value_type_str[value_type]);
 	data->handle = NULL;
 
+	/* bulk index action line of the value type */
+	if (1 == CONFIG_HISTORY_STORAGE_PIPELINES)
+	{
+		data->action = zbx_dsprintf(NULL, "{\"index\":{\"_index\":\"%s\",\"pipeline\":\"%s-pipeline\"}}\n",
+				value_type_str[value_type], value_type_str[value_type]);
+	}
+	else
+		data->action = zbx_dsprintf(NULL, "{\"index\":{\"_index\":\"%s\"}}\n", value_type_str[value_type]);
+
 	hist->value_type = value_type;
 	hist->data = data;
 	hist->destroy = elastic_destroy;
 	hist->add_values = elastic_add_values;
 	hist->flush = elastic_flush;
 	hist->get_values = elastic_get_values;
+	hist->get_aggregate = elastic_get_aggregate;
 	hist->requires_trends = 0;
 
+	/* without index refresh the last written values might be not searchable yet, */
+	/* aggregating them in storage would give different results than value cache */
+	if (0 != CONFIG_HISTORY_STORAGE_REFRESH)
+		hist->aggregate_period = CONFIG_HISTORY_STORAGE_AGGREGATE;
+	else
+		hist->aggregate_period = 0;
+
 	return SUCCEED;
 }
 
@@ -19,6 +19,7 @@
 
 #include "common.h"
 #include "log.h"
+#include "threads.h"
 #include "zbxalgo.h"
 #include "db.h"
 #include "dbcache.h"
@@ -34,6 +35,17 @@ zbx_sql_writer_t;
 
 static zbx_sql_writer_t	writer;
 
+#ifdef HAVE_POSTGRESQL
+extern int	CONFIG_HISTORY_PIPELINING;
+
+/* the time pipelined writes are not used after pipelined writes connection failure */
+#define ZBX_HISTORY_PIPELINE_RETRY_DELAY	SEC_PER_MIN
+
+/* bulk inserts sent in pipelined writes connection, kept until database confirms them */
+static zbx_sql_writer_t	pipeline;
+static time_t		pipeline_retry_time;
+#endif
+
 typedef void (*vc_str2value_func_t)(history_value_t *value, DB_ROW row);
 
 /* history table data */
@@ -118,22 +130,24 @@ static void	sql_writer_init(void)
  * Purpose: releases initialized sql writer by freeing allocated resources and      *
  *          setting its state to uninitialized.                                     *
  *                                                                                  *
+ * Parameters: sql_writer - [IN] the sql writer                                     *
+ *                                                                                  *
  ************************************************************************************/
-static void	sql_writer_release(void)
+static void	sql_writer_release(zbx_sql_writer_t *sql_writer)
 {
 	int	i;
 
-	for (i = 0; i < writer.dbinserts.values_num; i++)
+	for (i = 0; i < sql_writer->dbinserts.values_num; i++)
 	{
-		zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)writer.dbinserts.values[i];
+		zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)sql_writer->dbinserts.values[i];
 
 		zbx_db_insert_clean(db_insert);
 		zbx_free(db_insert);
 	}
-	zbx_vector_ptr_clear(&writer.dbinserts);
-	zbx_vector_ptr_destroy(&writer.dbinserts);
+	zbx_vector_ptr_clear(&sql_writer->dbinserts);
+	zbx_vector_ptr_destroy(&sql_writer->dbinserts);
 
-	writer.initialized = 0;
+	sql_writer->initialized = 0;
 }
 
 /************************************************************************************
@@ -151,37 +165,235 @@ static void	sql_writer_add_dbinsert(zbx_db_insert_t *db_insert)
 	zbx_vector_ptr_append(&writer.dbinserts, db_insert);
 }
 
+#ifdef HAVE_POSTGRESQL
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_send                                                        *
+ *                                                                                  *
+ * Purpose: sends bulk insert data of sql writer in pipelined writes connection     *
+ *                                                                                  *
+ * Parameters: sql_writer - [IN] the sql writer                                     *
+ *                                                                                  *
+ * Comments: Errors are reported by zbx_db_pipeline_wait() function.                *
+ *                                                                                  *
+ ************************************************************************************/
+static void	sql_writer_send(const zbx_sql_writer_t *sql_writer)
+{
+	int	i;
+
+	for (i = 0; i < sql_writer->dbinserts.values_num; i++)
+	{
+		if (ZBX_DB_OK != zbx_db_insert_pipeline((zbx_db_insert_t *)sql_writer->dbinserts.values[i]))
+			return;
+	}
+
+	zbx_db_pipeline_sync();
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_committed                                                   *
+ *                                                                                  *
+ * Purpose: checks in the main connection if pipelined writes transaction, which    *
+ *          lost connection after its commit was sent, was committed                *
+ *                                                                                  *
+ * Parameters: xid - [IN] the transaction id, 0 if it is not known                  *
+ *                                                                                  *
+ * Return value: SUCCEED - the transaction was committed                            *
+ *               FAIL - the transaction was not committed or its status is unknown  *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_writer_committed(zbx_uint64_t xid)
+{
+	DB_RESULT	result;
+	DB_ROW		row;
+	int		ret = FAIL, in_progress;
+
+	if (0 == xid)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "pipelined database connection was lost before history transaction"
+				" id was received, the values might be written twice");
+		return FAIL;
+	}
+
+	do
+	{
+		in_progress = 0;
+
+		/* the transaction might still be committing if the connection was broken only on the client side */
+		if (NULL == (result = DBselect("select txid_status(" ZBX_FS_UI64 ")", xid)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot check status of pipelined history transaction "
+					ZBX_FS_UI64 ", the values might be written twice", xid);
+			break;
+		}
+
+		if (NULL != (row = DBfetch(result)) && SUCCEED != DBis_null(row[0]))
+		{
+			if (0 == strcmp(row[0], "committed"))
+				ret = SUCCEED;
+			else if (0 == strcmp(row[0], "in progress"))
+				in_progress = 1;
+		}
+
+		DBfree_result(result);
+
+		if (0 != in_progress)
+			zbx_sleep(1);
+	}
+	while (0 != in_progress);
+
+	return ret;
+}
+#endif
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_execute                                                     *
+ *                                                                                  *
+ * Purpose: writes bulk insert data of sql writer into database in the main         *
+ *          connection                                                              *
+ *                                                                                  *
+ * Parameters: sql_writer - [IN] the sql writer                                     *
+ *                                                                                  *
+ * Return value: ZBX_DB_OK - the data was written                                   *
+ *               ZBX_DB_FAIL - otherwise                                            *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_writer_execute(const zbx_sql_writer_t *sql_writer)
+{
+	int	i, txn_error;
+
+	do
+	{
+		DBbegin();
+
+		for (i = 0; i < sql_writer->dbinserts.values_num; i++)
+		{
+			zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)sql_writer->dbinserts.values[i];
+			zbx_db_insert_execute(db_insert);
+		}
+	}
+	while (ZBX_DB_DOWN == (txn_error = DBcommit()));
+
+	return txn_error;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: sql_writer_flush                                                       *
  *                                                                                  *
  * Purpose: flushes bulk insert data into database                                  *
  *                                                                                  *
+ * Comments: With PostgreSQL and enabled HistoryPipelining the data is sent in      *
+ *           pipelined writes connection and the syncer continues without waiting   *
+ *           for the commit. The outcome is checked by zbx_history_sql_wait()       *
+ *           before the next flush.                                                 *
+ *                                                                                  *
  ************************************************************************************/
 static int	sql_writer_flush(void)
 {
-	int	i, txn_error;
+	int	txn_error;
 
 	/* The writer might be uninitialized only if the history */
 	/* was already flushed. In that case, return SUCCEED */
 	if (0 == writer.initialized)
 		return SUCCEED;
 
-	do
+#ifdef HAVE_POSTGRESQL
+	if (0 != CONFIG_HISTORY_PIPELINING && SUCCEED == zbx_db_pipeline_available() && 0 == pipeline.initialized &&
+			pipeline_retry_time <= time(NULL))
 	{
-		DBbegin();
+		sql_writer_send(&writer);
+
+		pipeline = writer;
+		writer.initialized = 0;
+
+		return SUCCEED;
+	}
+#endif
+	txn_error = sql_writer_execute(&writer);
+
+	sql_writer_release(&writer);
+
+	return ZBX_DB_OK == txn_error ? SUCCEED : FAIL;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_sql_wait                                                   *
+ *                                                                                  *
+ * Purpose: waits until database confirms the bulk insert data sent by              *
+ *          sql_writer_flush()                                                      *
+ *                                                                                  *
+ * Parameters: itemids - [OUT] the items of values that failed to be written        *
+ *                                                                                  *
+ * Comments: If pipelined writes connection was lost before the commit was sent     *
+ *           or could not be opened (for example because of database connection     *
+ *           limit) the data is written in the main connection and pipelined writes *
+ *           are not used for ZBX_HISTORY_PIPELINE_RETRY_DELAY seconds.             *
+ *           If the connection was lost after the commit was sent, the transaction  *
+ *           status is checked and the data is sent again in reconnected pipelined  *
+ *           writes connection only if it was not committed.                        *
+ *                                                                                  *
+ ************************************************************************************/
+void	zbx_history_sql_wait(zbx_vector_uint64_t *itemids)
+{
+#ifdef HAVE_POSTGRESQL
+	int	i, j, k, rc, values_num = 0;
+
+	if (0 == pipeline.initialized)
+		return;
+
+	while (ZBX_DB_DOWN == (rc = zbx_db_pipeline_wait()))
+	{
+		zbx_uint64_t	xid;
 
-		for (i = 0; i < writer.dbinserts.values_num; i++)
+		if (SUCCEED != zbx_db_pipeline_unconfirmed(&xid))
 		{
-			zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)writer.dbinserts.values[i];
-			zbx_db_insert_execute(db_insert);
+			zabbix_log(LOG_LEVEL_WARNING, "cannot write history in pipelined database connection,"
+					" disabling pipelined writes for %d seconds", ZBX_HISTORY_PIPELINE_RETRY_DELAY);
+
+			pipeline_retry_time = time(NULL) + ZBX_HISTORY_PIPELINE_RETRY_DELAY;
+			rc = sql_writer_execute(&pipeline);
+			break;
+		}
+
+		/* the connection was lost after commit, write the data again only if it was not committed */
+		if (SUCCEED == sql_writer_committed(xid))
+		{
+			rc = ZBX_DB_OK;
+			break;
 		}
+
+		sql_writer_send(&pipeline);
 	}
-	while (ZBX_DB_DOWN == (txn_error = DBcommit()));
 
-	sql_writer_release();
+	if (ZBX_DB_OK != rc)
+	{
+		for (i = 0; i < pipeline.dbinserts.values_num; i++)
+		{
+			zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)pipeline.dbinserts.values[i];
+
+			for (j = 0; j < db_insert->fields.values_num; j++)
+			{
+				if (0 == strcmp(((ZBX_FIELD *)db_insert->fields.values[j])->name, "itemid"))
+					break;
+			}
 
-	return ZBX_DB_OK == txn_error ? SUCCEED : FAIL;
+			for (k = 0; k < db_insert->rows.values_num && j < db_insert->fields.values_num; k++)
+				zbx_vector_uint64_append(itemids, ((zbx_db_value_t *)db_insert->rows.values[k])[j].ui64);
+
+			values_num += db_insert->rows.values_num;
+		}
+
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write %d history values to database", values_num);
+	}
+
+	sql_writer_release(&pipeline);
+#else
+	ZBX_UNUSED(itemids);
+#endif
 }
 
 /******************************************************************************************************************
@@ -728,6 +940,7 @@ int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, ch
 	hist->add_values = sql_add_values;
 	hist->flush = sql_flush;
 	hist->get_values = sql_get_values;
+	hist->get_aggregate = NULL;
 
 	switch (value_type)
 	{
@@ -749,6 +962,7 @@ int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, ch
 	}
 
 	hist->requires_trends = 1;
+	hist->aggregate_period = 0;
 
 	return SUCCEED;
 }
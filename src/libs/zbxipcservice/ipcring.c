@@ -0,0 +1,236 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+
+#ifdef HAVE_IPCSERVICE
+
+#include "zbxipcservice.h"
+
+#ifdef ZBX_IPC_RING_ENABLED
+
+/* Single producer, single consumer ring buffer of variable length records.            */
+/*                                                                                     */
+/* Each record consists of zbx_uint32_t data size followed by the data, padded to 8    */
+/* bytes. If the record does not fit at the end of buffer, a wrap marker is written    */
+/* instead and the record is placed at the buffer start. The head offset is updated    */
+/* only by producer and the tail offset only by consumer, so no locking is required -  */
+/* memory barriers ensure that record data is visible before offsets are updated.      */
+
+#define ZBX_IPC_RING_WRAP	0xffffffff
+#define ZBX_IPC_RING_ALIGN(x)	(((x) + 7) & ~(zbx_uint32_t)7)
+#define ZBX_IPC_RING_DATA(r)	((unsigned char *)((r) + 1))
+
+#define ipc_ring_barrier()	__sync_synchronize()
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_required_size                                       *
+ *                                                                            *
+ * Purpose: calculate memory required for ring buffer                         *
+ *                                                                            *
+ * Parameters: size - [IN] the ring data buffer size                          *
+ *                                                                            *
+ * Return value: The ring buffer size including header.                       *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_ipc_ring_required_size(zbx_uint32_t size)
+{
+	return sizeof(zbx_ipc_ring_t) + (size & ~(zbx_uint32_t)7);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_init                                                *
+ *                                                                            *
+ * Purpose: initialize ring buffer                                            *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer, must have at least                *
+ *                         zbx_ipc_ring_required_size(size) bytes             *
+ *             size - [IN] the ring data buffer size                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_ring_init(zbx_ipc_ring_t *ring, zbx_uint32_t size)
+{
+	ring->head = 0;
+	ring->tail = 0;
+	ring->size = size & ~(zbx_uint32_t)7;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_max_record                                          *
+ *                                                                            *
+ * Purpose: get the largest record size that is guaranteed to fit into ring   *
+ *          buffer once it has been emptied                                   *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_ipc_ring_max_record(const zbx_ipc_ring_t *ring)
+{
+	/* with the record header and alignment the required space stays below half of the buffer, */
+	/* so it fits either before or after the current head of an empty buffer                  */
+	return ring->size / 2 - 4 * sizeof(zbx_uint32_t);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_write                                               *
+ *                                                                            *
+ * Purpose: write record into ring buffer (producer side)                     *
+ *                                                                            *
+ * Parameters: ring   - [IN] the ring buffer                                  *
+ *             data   - [IN] the record data                                  *
+ *             size   - [IN] the record data size                             *
+ *             wakeup - [OUT] 1 if the ring was drained before this record    *
+ *                            and consumer must be woken up, 0 otherwise      *
+ *                                                                            *
+ * Return value: SUCCEED - the record was written                             *
+ *               FAIL    - not enough free space                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_ring_write(zbx_ipc_ring_t *ring, const unsigned char *data, zbx_uint32_t size, int *wakeup)
+{
+	zbx_uint32_t	head, tail, need, offset;
+	unsigned char	*buffer = ZBX_IPC_RING_DATA(ring);
+
+	if (zbx_ipc_ring_max_record(ring) < size)
+		return FAIL;
+
+	need = ZBX_IPC_RING_ALIGN(size + sizeof(zbx_uint32_t));
+	head = ring->head;
+	tail = ring->tail;
+
+	/* head must never catch up with tail, otherwise full buffer would look empty */
+	if (head >= tail)
+	{
+		if (need < ring->size - head || (need == ring->size - head && 0 != tail))
+			offset = head;
+		else if (need < tail)
+			offset = 0;
+		else
+			return FAIL;
+	}
+	else
+	{
+		if (need >= tail - head)
+			return FAIL;
+
+		offset = head;
+	}
+
+	if (offset != head)
+		*(zbx_uint32_t *)(buffer + head) = ZBX_IPC_RING_WRAP;
+
+	*(zbx_uint32_t *)(buffer + offset) = size;
+	memcpy(buffer + offset + sizeof(zbx_uint32_t), data, size);
+
+	/* make the record visible before publishing the new head */
+	ipc_ring_barrier();
+
+	if ((offset += need) == ring->size)
+		offset = 0;
+
+	ring->head = offset;
+
+	/* Full barrier pairs with the one in zbx_ipc_ring_pop(). If consumer has already */
+	/* released everything written before, it might be waiting for the next wakeup.    */
+	ipc_ring_barrier();
+	*wakeup = (ring->tail == head ? 1 : 0);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_peek                                                *
+ *                                                                            *
+ * Purpose: get the oldest record from ring buffer (consumer side)            *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *             size - [OUT] the record data size                              *
+ *                                                                            *
+ * Return value: The record data or NULL if the ring buffer is empty.         *
+ *                                                                            *
+ * Comments: The record data stays valid until zbx_ipc_ring_pop() is called.  *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	*zbx_ipc_ring_peek(zbx_ipc_ring_t *ring, zbx_uint32_t *size)
+{
+	zbx_uint32_t	tail = ring->tail;
+	unsigned char	*buffer = ZBX_IPC_RING_DATA(ring);
+
+	if (tail == ring->head)
+		return NULL;
+
+	/* read record data only after the head has been read */
+	ipc_ring_barrier();
+
+	if (ZBX_IPC_RING_WRAP == *(zbx_uint32_t *)(buffer + tail))
+	{
+		/* wrap marker is always followed by a record at buffer start */
+		ring->tail = tail = 0;
+	}
+
+	*size = *(zbx_uint32_t *)(buffer + tail);
+
+	return buffer + tail + sizeof(zbx_uint32_t);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_pop                                                 *
+ *                                                                            *
+ * Purpose: release the oldest record returned by zbx_ipc_ring_peek()         *
+ *          (consumer side)                                                   *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_ring_pop(zbx_ipc_ring_t *ring)
+{
+	zbx_uint32_t	tail = ring->tail;
+
+	tail += ZBX_IPC_RING_ALIGN(*(zbx_uint32_t *)(ZBX_IPC_RING_DATA(ring) + tail) + sizeof(zbx_uint32_t));
+
+	if (tail == ring->size)
+		tail = 0;
+
+	/* finish reading record data before producer can overwrite it */
+	ipc_ring_barrier();
+	ring->tail = tail;
+
+	/* pairs with the barrier in zbx_ipc_ring_write(), see comments there */
+	ipc_ring_barrier();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_is_empty                                            *
+ *                                                                            *
+ * Purpose: check if all written records have been released by consumer      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_ring_is_empty(const zbx_ipc_ring_t *ring)
+{
+	return ring->head == ring->tail ? SUCCEED : FAIL;
+}
+
+#endif	/* ZBX_IPC_RING_ENABLED */
+
+#endif	/* HAVE_IPCSERVICE */
@@ -36,6 +36,8 @@ struct zbx_ipc_client
 	zbx_uint32_t		rx_header[2];
 	unsigned char		*rx_data;
 	zbx_uint32_t		rx_bytes;
+	/* the space allocated before received message data */
+	zbx_uint32_t		rx_reserve;
 	zbx_queue_ptr_t		rx_queue;
 	struct event		*rx_event;
 
@@ -62,6 +64,12 @@ struct zbx_ipc_client
 #define ZBX_IPC_MESSAGE_CODE	0
 #define ZBX_IPC_MESSAGE_SIZE	1
 
+/* messages received by IPC service are allocated together with their data */
+#define ZBX_IPC_MESSAGE_RESERVE	ZBX_SIZE_T_ALIGN8(sizeof(zbx_ipc_message_t))
+
+/* the number of queued messages returned before checking sockets for new data */
+#define ZBX_IPC_SERVICE_RECV_BATCH	64
+
 #if !defined(LIBEVENT_VERSION_NUMBER) || LIBEVENT_VERSION_NUMBER < 0x2000000
 typedef int evutil_socket_t;
 
@@ -360,6 +368,8 @@ static int	ipc_socket_write_message(zbx_ipc_socket_t *csocket, zbx_uint32_t code
  *             data        - [OUT] the message data                           *
  *             rx_bytes    - [IN] the number of bytes stored in message       *
  *                                (including header)                          *
+ *             reserve     - [IN] the number of bytes to allocate before      *
+ *                                message data                                *
  *             buffer      - [IN] the buffer to parse                         *
  *             size        - [IN] the number of bytes to parse                *
  *             read_size   - [OUT] the number of bytes read                   *
@@ -369,7 +379,7 @@ static int	ipc_socket_write_message(zbx_ipc_socket_t *csocket, zbx_uint32_t code
  *                                                                            *
  ******************************************************************************/
 static int	ipc_read_buffer(zbx_uint32_t *header, unsigned char **data, zbx_uint32_t rx_bytes,
-		const unsigned char *buffer, zbx_uint32_t size, zbx_uint32_t *read_size)
+		zbx_uint32_t reserve, const unsigned char *buffer, zbx_uint32_t size, zbx_uint32_t *read_size)
 {
 	zbx_uint32_t	copy_size, data_size, data_offset;
 
@@ -392,7 +402,7 @@ static int	ipc_read_buffer(zbx_uint32_t *header, unsigned char **data, zbx_uint3
 			return SUCCEED;
 		}
 
-		*data = (unsigned char *)zbx_malloc(NULL, data_size);
+		*data = (unsigned char *)zbx_malloc(NULL, reserve + data_size) + reserve;
 		data_offset = 0;
 	}
 	else
@@ -444,6 +454,8 @@ static int	ipc_message_is_completed(const zbx_uint32_t *header, zbx_uint32_t rx_
  *             data     - [OUT] the data of the message                       *
  *             rx_bytes - [IN/OUT] the total message size read (including     *
  *                                 header                                     *
+ *             reserve  - [IN] the number of bytes to allocate before message *
+ *                             data                                           *
  *                                                                            *
  * Return value:  SUCCEED - data was read successfully, check rx_bytes to     *
  *                          determine if the message was completed.           *
@@ -452,7 +464,7 @@ static int	ipc_message_is_completed(const zbx_uint32_t *header, zbx_uint32_t rx_
  *                                                                            *
  ******************************************************************************/
 static int	ipc_socket_read_message(zbx_ipc_socket_t *csocket, zbx_uint32_t *header, unsigned char **data,
-		zbx_uint32_t *rx_bytes)
+		zbx_uint32_t *rx_bytes, zbx_uint32_t reserve)
 {
 	zbx_uint32_t	data_size, offset, read_size = 0;
 	int		ret = FAIL;
@@ -460,8 +472,9 @@ static int	ipc_socket_read_message(zbx_ipc_socket_t *csocket, zbx_uint32_t *head
 	/* try to read message from socket buffer */
 	if (csocket->rx_buffer_bytes > csocket->rx_buffer_offset)
 	{
-		ret = ipc_read_buffer(header, data, *rx_bytes, csocket->rx_buffer + csocket->rx_buffer_offset,
-				csocket->rx_buffer_bytes - csocket->rx_buffer_offset, &read_size);
+		ret = ipc_read_buffer(header, data, *rx_bytes, reserve, csocket->rx_buffer +
+				csocket->rx_buffer_offset, csocket->rx_buffer_bytes - csocket->rx_buffer_offset,
+				&read_size);
 
 		csocket->rx_buffer_offset += read_size;
 		*rx_bytes += read_size;
@@ -502,8 +515,8 @@ static int	ipc_socket_read_message(zbx_ipc_socket_t *csocket, zbx_uint32_t *head
 
 		csocket->rx_buffer_bytes = read_size;
 
-		ret = ipc_read_buffer(header, data, *rx_bytes, csocket->rx_buffer, csocket->rx_buffer_bytes,
-				&read_size);
+		ret = ipc_read_buffer(header, data, *rx_bytes, reserve, csocket->rx_buffer,
+				csocket->rx_buffer_bytes, &read_size);
 
 		csocket->rx_buffer_offset += read_size;
 		*rx_bytes += read_size;
@@ -536,6 +549,28 @@ static void	ipc_client_free_events(zbx_ipc_client_t *client)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_client_free_rx_data                                          *
+ *                                                                            *
+ * Purpose: frees partially received message data                             *
+ *                                                                            *
+ * Parameters: client - [IN] the client                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_free_rx_data(zbx_ipc_client_t *client)
+{
+	if (NULL != client->rx_data)
+	{
+		unsigned char	*ptr = client->rx_data - client->rx_reserve;
+
+		zbx_free(ptr);
+		client->rx_data = NULL;
+	}
+
+	client->rx_bytes = 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: ipc_client_free                                                  *
@@ -556,7 +591,7 @@ static void	ipc_client_free(zbx_ipc_client_t *client)
 		zbx_ipc_message_free(message);
 
 	zbx_queue_ptr_destroy(&client->rx_queue);
-	zbx_free(client->rx_data);
+	ipc_client_free_rx_data(client);
 
 	while (NULL != (message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&client->tx_queue)))
 		zbx_ipc_message_free(message);
@@ -577,12 +612,19 @@ static void	ipc_client_free(zbx_ipc_client_t *client)
  *                                                                            *
  * Parameters: client - [IN] the client to read                               *
  *                                                                            *
+ * Comments: If space was reserved before the message data, the message is    *
+ *           stored there to avoid separate allocation.                       *
+ *                                                                            *
  ******************************************************************************/
 static void	ipc_client_push_rx_message(zbx_ipc_client_t *client)
 {
 	zbx_ipc_message_t	*message;
 
-	message = (zbx_ipc_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_message_t));
+	if (NULL != client->rx_data && ZBX_IPC_MESSAGE_RESERVE == client->rx_reserve)
+		message = (zbx_ipc_message_t *)(client->rx_data - ZBX_IPC_MESSAGE_RESERVE);
+	else
+		message = (zbx_ipc_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_message_t));
+
 	message->code = client->rx_header[ZBX_IPC_MESSAGE_CODE];
 	message->size = client->rx_header[ZBX_IPC_MESSAGE_SIZE];
 	message->data = client->rx_data;
@@ -639,10 +681,9 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
 	do
 	{
 		if (FAIL == ipc_socket_read_message(&client->csocket, client->rx_header, &client->rx_data,
-				&client->rx_bytes))
+				&client->rx_bytes, client->rx_reserve))
 		{
-			zbx_free(client->rx_data);
-			client->rx_bytes = 0;
+			ipc_client_free_rx_data(client);
 			return FAIL;
 		}
 
@@ -798,6 +839,7 @@ static void	ipc_service_add_client(zbx_ipc_service_t *service, int fd)
 	client->id = next_clientid++;
 	client->state = ZBX_IPC_CLIENT_STATE_NONE;
 	client->refcount = 1;
+	client->rx_reserve = ZBX_IPC_MESSAGE_RESERVE;
 
 	zbx_queue_ptr_create(&client->rx_queue);
 	zbx_queue_ptr_create(&client->tx_queue);
@@ -1295,7 +1337,7 @@ int	zbx_ipc_socket_read(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (SUCCEED != ipc_socket_read_message(csocket, header, &data, &rx_bytes))
+	if (SUCCEED != ipc_socket_read_message(csocket, header, &data, &rx_bytes, 0))
 		goto out;
 
 	if (SUCCEED != ipc_message_is_completed(header, rx_bytes))
@@ -1339,7 +1381,10 @@ void	zbx_ipc_message_free(zbx_ipc_message_t *message)
 {
 	if (NULL != message)
 	{
-		zbx_free(message->data);
+		/* the data of messages received by IPC service is stored in the same allocation */
+		if (message->data != (unsigned char *)message + ZBX_IPC_MESSAGE_RESERVE)
+			zbx_free(message->data);
+
 		zbx_free(message);
 	}
 }
@@ -1581,6 +1626,7 @@ int	zbx_ipc_service_start(zbx_ipc_service_t *service, const char *service_name,
 	service->path = zbx_strdup(NULL, service_name);
 	zbx_vector_ptr_create(&service->clients);
 	zbx_queue_ptr_create(&service->clients_recv);
+	service->recv_num = 0;
 
 	service->ev = event_base_new();
 	service->ev_listener = event_new(service->ev, service->fd, EV_READ | EV_PERSIST,
@@ -1657,27 +1703,45 @@ void	zbx_ipc_service_close(zbx_ipc_service_t *service)
  *                                        event                               *
  *               ZBX_IPC_RECV_TIMEOUT   - returned after timeout expired      *
  *                                                                            *
+ * Comments: Messages already read from client sockets are returned without   *
+ *           dispatching socket events, which are checked again after         *
+ *           ZBX_IPC_SERVICE_RECV_BATCH queued messages or when the queue is  *
+ *           empty.                                                           *
+ *                                                                            *
  ******************************************************************************/
 int	zbx_ipc_service_recv(zbx_ipc_service_t *service, int timeout, zbx_ipc_client_t **client,
 		zbx_ipc_message_t **message)
 {
-	int	ret, flags;
+	int	ret, flags, timer = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() timeout:%d", __func__, timeout);
 
-	if (timeout != 0 && SUCCEED == zbx_queue_ptr_empty(&service->clients_recv))
+	if (SUCCEED != zbx_queue_ptr_empty(&service->clients_recv) &&
+			ZBX_IPC_SERVICE_RECV_BATCH > service->recv_num)
 	{
-		if (ZBX_IPC_WAIT_FOREVER != timeout)
-		{
-			struct timeval	tv = {timeout, 0};
-			evtimer_add(service->ev_timer, &tv);
-		}
-		flags = EVLOOP_ONCE;
+		/* return already queued messages without dispatching socket events */
+		service->recv_num++;
+		flags = EVLOOP_NONBLOCK;
 	}
 	else
-		flags = EVLOOP_NONBLOCK;
+	{
+		service->recv_num = 0;
+
+		if (timeout != 0 && SUCCEED == zbx_queue_ptr_empty(&service->clients_recv))
+		{
+			if (ZBX_IPC_WAIT_FOREVER != timeout)
+			{
+				struct timeval	tv = {timeout, 0};
+				evtimer_add(service->ev_timer, &tv);
+				timer = 1;
+			}
+			flags = EVLOOP_ONCE;
+		}
+		else
+			flags = EVLOOP_NONBLOCK;
 
-	event_base_loop(service->ev, flags);
+		event_base_loop(service->ev, flags);
+	}
 
 	if (NULL != (*client = ipc_service_pop_client(service)))
 	{
@@ -1705,7 +1769,8 @@ int	zbx_ipc_service_recv(zbx_ipc_service_t *service, int timeout, zbx_ipc_client
 		*message = NULL;
 	}
 
-	evtimer_del(service->ev_timer);
+	if (0 != timer)
+		evtimer_del(service->ev_timer);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, ret);
 
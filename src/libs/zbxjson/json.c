@@ -293,6 +293,45 @@ void	zbx_json_escape(char **string)
 	*string = buffer;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_strcpy_alloc                                            *
+ *                                                                            *
+ * Purpose: append string as quoted and escaped JSON string value             *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the output buffer                       *
+ *             data_alloc  - [IN/OUT] the output buffer size                  *
+ *             data_offset - [IN/OUT] the output buffer offset                *
+ *             string      - [IN] the string to append                        *
+ *                                                                            *
+ * Comments: This allows building large JSON documents, for example newline   *
+ *           delimited JSON, without creating zbx_json structure per object.  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_json_strcpy_alloc(char **data, size_t *data_alloc, size_t *data_offset, const char *string)
+{
+	size_t	size;
+
+	size = __zbx_json_stringsize(string, ZBX_JSON_TYPE_STRING);
+
+	if (NULL == *data)
+	{
+		*data_alloc = size + 1;
+		*data_offset = 0;
+		*data = (char *)zbx_malloc(NULL, *data_alloc);
+	}
+	else if (*data_offset + size >= *data_alloc)
+	{
+		while (*data_offset + size >= *data_alloc)
+			*data_alloc *= 2;
+		*data = (char *)zbx_realloc(*data, *data_alloc);
+	}
+
+	__zbx_json_insstring(*data + *data_offset, string, ZBX_JSON_TYPE_STRING);
+	*data_offset += size;
+	(*data)[*data_offset] = '\0';
+}
+
 static void	__zbx_json_addobject(struct zbx_json *j, const char *name, int object)
 {
 	size_t	len = 2; /* brackets */
@@ -1232,23 +1271,23 @@ int	zbx_json_open_path(const struct zbx_json_parse *jp, const char *path, struct
 {
 	int			i, ret = FAIL;
 	struct zbx_json_parse	object;
-	zbx_jsonpath_t		jsonpath;
+	const zbx_jsonpath_t	*jsonpath;
 
 	object = *jp;
 
-	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
+	if (FAIL == zbx_jsonpath_compile_cached(path, &jsonpath))
 		return FAIL;
 
-	if (0 == jsonpath.definite)
+	if (0 == jsonpath->definite)
 	{
 		zbx_set_json_strerror("cannot use indefinite path when opening sub element");
 		goto out;
 	}
 
-	for (i = 0; i < jsonpath.segments_num; i++)
+	for (i = 0; i < jsonpath->segments_num; i++)
 	{
-		const char		*p;
-		zbx_jsonpath_segment_t	*segment = &jsonpath.segments[i];
+		const char			*p;
+		const zbx_jsonpath_segment_t	*segment = &jsonpath->segments[i];
 
 		if (ZBX_JSONPATH_SEGMENT_MATCH_LIST != segment->type)
 		{
@@ -1292,7 +1331,6 @@ int	zbx_json_open_path(const struct zbx_json_parse *jp, const char *path, struct
 	*out = object;
 	ret = SUCCEED;
 out:
-	zbx_jsonpath_clear(&jsonpath);
 	return ret;
 }
 
@@ -41,6 +41,24 @@ zbx_json_element_t;
 ZBX_VECTOR_DECL(json, zbx_json_element_t)
 ZBX_VECTOR_IMPL(json, zbx_json_element_t)
 
+#define ZBX_JSONPATH_CACHE_SIZE	256	/* maximum number of cached compiled jsonpaths per process */
+
+/* compiled jsonpath cache entry */
+typedef struct
+{
+	zbx_lrucache_link_t	link;
+	char			*path;
+	zbx_jsonpath_t		jsonpath;
+}
+zbx_jsonpath_cache_entry_t;
+
+static zbx_hash_t	jsonpath_cache_entry_hash(const void *data);
+static int	jsonpath_cache_entry_compare(const void *d1, const void *d2);
+static void	jsonpath_cache_entry_clean(void *data);
+
+static ZBX_THREAD_LOCAL zbx_lrucache_t	jsonpath_cache = ZBX_LRUCACHE_INITIALIZER(ZBX_JSONPATH_CACHE_SIZE,
+		jsonpath_cache_entry_hash, jsonpath_cache_entry_compare, jsonpath_cache_entry_clean);
+
 static int	jsonpath_query_object(const struct zbx_json_parse *jp_root, const struct zbx_json_parse *jp,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects);
 static int	jsonpath_query_array(const struct zbx_json_parse *jp_root, const struct zbx_json_parse *jp,
@@ -2386,7 +2404,8 @@ static int	jsonpath_apply_functions(const struct zbx_json_parse *jp_root, const
  *               FAIL    - invalid result data (internal json error)          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_format_query_result(const zbx_vector_json_t *objects, zbx_jsonpath_t *jsonpath, char **output)
+static int	jsonpath_format_query_result(const zbx_vector_json_t *objects, const zbx_jsonpath_t *jsonpath,
+		char **output)
 {
 	size_t	output_offset = 0, output_alloc;
 	int	i;
@@ -2546,52 +2565,374 @@ int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath)
 	return ret;
 }
 
+static zbx_hash_t	jsonpath_cache_entry_hash(const void *data)
+{
+	const zbx_jsonpath_cache_entry_t	*entry = (const zbx_jsonpath_cache_entry_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(entry->path);
+}
+
+static int	jsonpath_cache_entry_compare(const void *d1, const void *d2)
+{
+	const zbx_jsonpath_cache_entry_t	*e1 = (const zbx_jsonpath_cache_entry_t *)d1;
+	const zbx_jsonpath_cache_entry_t	*e2 = (const zbx_jsonpath_cache_entry_t *)d2;
+
+	return strcmp(e1->path, e2->path);
+}
+
+static void	jsonpath_cache_entry_clean(void *data)
+{
+	zbx_jsonpath_cache_entry_t	*entry = (zbx_jsonpath_cache_entry_t *)data;
+
+	zbx_jsonpath_clear(&entry->jsonpath);
+	zbx_free(entry->path);
+}
+
 /******************************************************************************
  *                                                                            *
- * Function: zbx_jsonpath_query                                               *
+ * Function: zbx_jsonpath_compile_cached                                      *
  *                                                                            *
- * Purpose: perform jsonpath query on the specified json data                 *
+ * Purpose: get compiled jsonpath from the per process jsonpath cache,        *
+ *          compiling and caching it if necessary                             *
  *                                                                            *
- * Parameters: jp     - [IN] the json data                                    *
- *             path   - [IN] the jsonpath                                     *
- *             output - [OUT] the output value                                *
+ * Parameters: path     - [IN] the path to parse                              *
+ *             jsonpath - [OUT] the compiled jsonpath                         *
+ *                                                                            *
+ * Return value: SUCCEED - the jsonpath was compiled successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The returned jsonpath is owned by the cache and must not be      *
+ *           freed. As the least recently used jsonpath is dropped when the   *
+ *           cache is full, it stays valid until at least another             *
+ *           ZBX_JSONPATH_CACHE_SIZE - 1 different jsonpaths are accessed.    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_compile_cached(const char *path, const zbx_jsonpath_t **jsonpath)
+{
+	zbx_jsonpath_cache_entry_t	entry_local, *entry;
+
+	entry_local.path = (char *)path;
+
+	if (NULL != (entry = (zbx_jsonpath_cache_entry_t *)zbx_lrucache_search(&jsonpath_cache, &entry_local)))
+	{
+		*jsonpath = &entry->jsonpath;
+		return SUCCEED;
+	}
+
+	if (SUCCEED != zbx_jsonpath_compile(path, &entry_local.jsonpath))
+		return FAIL;
+
+	entry_local.path = zbx_strdup(NULL, path);
+	entry = (zbx_jsonpath_cache_entry_t *)zbx_lrucache_insert(&jsonpath_cache, &entry_local,
+			sizeof(entry_local));
+
+	*jsonpath = &entry->jsonpath;
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_cache_get_stats                                     *
+ *                                                                            *
+ * Purpose: get the per process compiled jsonpath cache statistics            *
+ *                                                                            *
+ * Parameters: hits   - [OUT] the number of cache hits                        *
+ *             misses - [OUT] the number of cache misses                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_jsonpath_cache_get_stats(zbx_uint64_t *hits, zbx_uint64_t *misses)
+{
+	*hits = jsonpath_cache.hits;
+	*misses = jsonpath_cache.misses;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_query_compiled                                      *
+ *                                                                            *
+ * Purpose: perform compiled jsonpath query on the specified json data        *
+ *                                                                            *
+ * Parameters: jp       - [IN] the json data                                  *
+ *             jsonpath - [IN] the compiled jsonpath                          *
+ *             output   - [OUT] the output value                              *
  *                                                                            *
  * Return value: SUCCEED - the query was performed successfully (empty result *
  *                         being counted as successful query)                 *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output)
+int	zbx_jsonpath_query_compiled(const struct zbx_json_parse *jp, const zbx_jsonpath_t *jsonpath, char **output)
 {
-	zbx_jsonpath_t		jsonpath;
 	int			path_depth = 0, ret = SUCCEED;
 	zbx_vector_json_t	objects;
 
-	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
-		return FAIL;
-
 	zbx_vector_json_create(&objects);
 
 	if ('{' == *jp->start)
-		ret = jsonpath_query_object(jp, jp, &jsonpath, path_depth, &objects);
+		ret = jsonpath_query_object(jp, jp, jsonpath, path_depth, &objects);
 	else if ('[' == *jp->start)
-		ret = jsonpath_query_array(jp, jp, &jsonpath, path_depth, &objects);
+		ret = jsonpath_query_array(jp, jp, jsonpath, path_depth, &objects);
 
 	if (SUCCEED == ret)
 	{
-		path_depth = jsonpath.segments_num;
-		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath.segments[path_depth - 1].type)
+		path_depth = jsonpath->segments_num;
+		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath->segments[path_depth - 1].type)
 			path_depth--;
 
-		if (path_depth < jsonpath.segments_num)
-			ret = jsonpath_apply_functions(jp, &objects, &jsonpath, path_depth, output);
+		if (path_depth < jsonpath->segments_num)
+			ret = jsonpath_apply_functions(jp, &objects, jsonpath, path_depth, output);
 		else
-			ret = jsonpath_format_query_result(&objects, &jsonpath, output);
+			ret = jsonpath_format_query_result(&objects, jsonpath, output);
 	}
 
 	zbx_vector_json_clear_ext(&objects);
 	zbx_vector_json_destroy(&objects);
-	zbx_jsonpath_clear(&jsonpath);
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_query                                               *
+ *                                                                            *
+ * Purpose: perform jsonpath query on the specified json data                 *
+ *                                                                            *
+ * Parameters: jp     - [IN] the json data                                    *
+ *             path   - [IN] the jsonpath                                     *
+ *             output - [OUT] the output value                                *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output)
+{
+	const zbx_jsonpath_t	*jsonpath;
+
+	if (FAIL == zbx_jsonpath_compile_cached(path, &jsonpath))
+		return FAIL;
+
+	return zbx_jsonpath_query_compiled(jp, jsonpath, output);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_is_simple                                               *
+ *                                                                            *
+ * Purpose: check if jsonpath consists only of single name or index segments  *
+ *          and can be evaluated by multi-path evaluator                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	jsonpath_is_simple(const zbx_jsonpath_t *jsonpath)
+{
+	int	i;
+
+	for (i = 0; i < jsonpath->segments_num; i++)
+	{
+		const zbx_jsonpath_segment_t	*segment = &jsonpath->segments[i];
+
+		if (ZBX_JSONPATH_SEGMENT_MATCH_LIST != segment->type || 1 == segment->detached ||
+				NULL != segment->data.list.values->next)
+		{
+			return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_query_multi_contents                                    *
+ *                                                                            *
+ * Purpose: match json element against the rest of simple jsonpaths           *
+ *                                                                            *
+ * Parameters: pnext       - [IN] pointer to object/array/value in json data *
+ *             jsonpaths   - [IN] the compiled jsonpaths                      *
+ *             indexes     - [IN/OUT] the indexes of jsonpaths to match, the  *
+ *                                    array is reordered during matching      *
+ *             indexes_num - [IN] the number of jsonpath indexes              *
+ *             path_depth  - [IN] the jsonpath segment to match               *
+ *             outputs     - [OUT] the query results                          *
+ *             errors      - [OUT] the query errors                           *
+ *                                                                            *
+ * Comments: Every object/array is iterated once for all jsonpaths, jsonpaths *
+ *           matching the same member are passed down together. Iteration is  *
+ *           stopped as soon as all jsonpaths have found their member.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	jsonpath_query_multi_contents(const char *pnext, const zbx_jsonpath_t **jsonpaths, int *indexes,
+		int indexes_num, int path_depth, char **outputs, char **errors)
+{
+	struct zbx_json_parse	jp;
+	int			i, pending_num = 0, elements_num = -1, *matched;
+	const char		*p = NULL;
+	char			name[MAX_STRING_LEN];
+
+	/* extract values of finished jsonpaths, move the rest to the front of indexes array */
+	for (i = 0; i < indexes_num; i++)
+	{
+		int	index = indexes[i];
+
+		if (path_depth < jsonpaths[index]->segments_num)
+		{
+			indexes[pending_num++] = index;
+			continue;
+		}
+
+		if (SUCCEED != jsonpath_extract_element(pnext, &outputs[index]))
+			errors[index] = zbx_strdup(NULL, zbx_json_strerror());
+	}
+
+	if (0 == pending_num || ('{' != *pnext && '[' != *pnext))
+		return;
+
+	if (FAIL == zbx_json_brackets_open(pnext, &jp))
+	{
+		for (i = 0; i < pending_num; i++)
+			errors[indexes[i]] = zbx_strdup(NULL, zbx_json_strerror());
+		return;
+	}
+
+	matched = (int *)zbx_malloc(NULL, sizeof(int) * pending_num);
+
+	if ('[' == *pnext)
+	{
+		/* negative indexes require the number of array elements */
+		for (i = 0; i < pending_num; i++)
+		{
+			const zbx_jsonpath_list_t	*list = &jsonpaths[indexes[i]]->segments[path_depth].data.list;
+			int				query_index;
+
+			if (ZBX_JSONPATH_LIST_INDEX != list->type)
+				continue;
+
+			memcpy(&query_index, list->values->data, sizeof(query_index));
+
+			if (0 > query_index)
+			{
+				for (elements_num = 0; NULL != (p = zbx_json_next(&jp, p)); elements_num++)
+					;
+				break;
+			}
+		}
+	}
+
+	for (i = 0; 0 < pending_num; i++)
+	{
+		int	j, matched_num = 0;
+
+		if ('[' == *pnext)
+		{
+			if (NULL == (p = zbx_json_next(&jp, p)))
+				break;
+		}
+		else if (NULL == (p = zbx_json_pair_next(&jp, p, name, sizeof(name))))
+			break;
+
+		for (j = 0; j < pending_num;)
+		{
+			const zbx_jsonpath_list_t	*list = &jsonpaths[indexes[j]]->segments[path_depth].data.list;
+			int				match = 0, query_index;
+
+			if ('[' == *pnext)
+			{
+				if (ZBX_JSONPATH_LIST_INDEX == list->type)
+				{
+					memcpy(&query_index, list->values->data, sizeof(query_index));
+
+					if (i == (0 <= query_index ? query_index : elements_num + query_index))
+						match = 1;
+				}
+			}
+			else if (ZBX_JSONPATH_LIST_NAME == list->type && 0 == strcmp(name, list->values->data))
+				match = 1;
+
+			if (0 == match)
+			{
+				j++;
+				continue;
+			}
+
+			/* only the first matching member is used for definite path */
+			matched[matched_num++] = indexes[j];
+			indexes[j] = indexes[--pending_num];
+		}
+
+		if (0 != matched_num)
+		{
+			jsonpath_query_multi_contents(p, jsonpaths, matched, matched_num, path_depth + 1, outputs,
+					errors);
+		}
+	}
+
+	zbx_free(matched);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_query_multi                                         *
+ *                                                                            *
+ * Purpose: perform multiple jsonpath queries on the same json data           *
+ *                                                                            *
+ * Parameters: jp        - [IN] the json data                                 *
+ *             paths     - [IN] the jsonpaths                                 *
+ *             paths_num - [IN] the number of jsonpaths                       *
+ *             outputs   - [OUT] the output values, NULL if there was no data *
+ *                               matching the jsonpath                        *
+ *             errors    - [OUT] the error messages, NULL if jsonpath query   *
+ *                               was successful                               *
+ *                                                                            *
+ * Comments: The outputs and errors arrays must be initialized with NULLs.    *
+ *           Jsonpaths consisting only of name/index segments are evaluated   *
+ *           in a single pass over json data, other jsonpaths are queried one *
+ *           by one.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_jsonpath_query_multi(const struct zbx_json_parse *jp, const char **paths, int paths_num, char **outputs,
+		char **errors)
+{
+	const zbx_jsonpath_t	**jsonpaths;
+	int			i, chunk, chunk_num, *indexes, indexes_num, *others, others_num;
+
+	jsonpaths = (const zbx_jsonpath_t **)zbx_malloc(NULL, sizeof(zbx_jsonpath_t *) * paths_num);
+	indexes = (int *)zbx_malloc(NULL, sizeof(int) * paths_num);
+	others = (int *)zbx_malloc(NULL, sizeof(int) * paths_num);
+
+	/* compiled jsonpaths are borrowed from cache, so process them in chunks fitting into cache */
+	for (chunk = 0; chunk < paths_num; chunk += ZBX_JSONPATH_CACHE_SIZE)
+	{
+		chunk_num = MIN(paths_num - chunk, ZBX_JSONPATH_CACHE_SIZE);
+		indexes_num = 0;
+		others_num = 0;
+
+		for (i = chunk; i < chunk + chunk_num; i++)
+		{
+			if (SUCCEED != zbx_jsonpath_compile_cached(paths[i], &jsonpaths[i]))
+			{
+				errors[i] = zbx_strdup(NULL, zbx_json_strerror());
+				continue;
+			}
+
+			if (SUCCEED == jsonpath_is_simple(jsonpaths[i]))
+				indexes[indexes_num++] = i;
+			else
+				others[others_num++] = i;
+		}
+
+		if (0 != indexes_num && ('{' == *jp->start || '[' == *jp->start))
+			jsonpath_query_multi_contents(jp->start, jsonpaths, indexes, indexes_num, 0, outputs, errors);
+
+		/* the remaining queries can access cache recursively, so jsonpaths are acquired again */
+		for (i = 0; i < others_num; i++)
+		{
+			if (SUCCEED != zbx_jsonpath_query(jp, paths[others[i]], &outputs[others[i]]))
+				errors[others[i]] = zbx_strdup(NULL, zbx_json_strerror());
+		}
+	}
+
+	zbx_free(others);
+	zbx_free(indexes);
+	zbx_free(jsonpaths);
+}
@@ -90,6 +90,27 @@
  *                                                                            *
  ******************************************************************************/
 
+/******************************************************************************
+ *                                                                            *
+ * (*) slabs: objects up to MEM_SLAB_MAX_OBJECT bytes are allocated in slabs  *
+ *     of MEM_SLAB_SIZE bytes without chunk size fields                       *
+ *                                                                            *
+ *     slabs are cut from the free chunk at hi_bound, so slab area grows      *
+ *     downwards from slabs_hi_bound and the slab of an object can be found   *
+ *     by its offset from slabs_hi_bound                                      *
+ *                                                                            *
+ *        lo_bound                  hi_bound                 slabs_hi_bound   *
+ *           v                         v                             v        *
+ *           #--chunk--|--chunk--...---#---slab---|--...--|---slab---#        *
+ *                                                                            *
+ *     each slab starts with a header containing object size and bitmap of    *
+ *     free objects, slabs with free objects are linked into lists by object  *
+ *     size, emptied slabs are returned to chunk memory if possible, other    *
+ *     empty slabs are reused for any object size or, when chunk memory is    *
+ *     exhausted, for single larger objects                                   *
+ *                                                                            *
+ ******************************************************************************/
+
 static void	*ALIGN4(void *ptr);
 static void	*ALIGN8(void *ptr);
 static void	*ALIGNPTR(void *ptr);
@@ -124,6 +145,25 @@ static void	__mem_free(zbx_mem_info_t *info, void *ptr);
 #define MEM_MIN_SIZE		__UINT64_C(128)
 #define MEM_MAX_SIZE		__UINT64_C(0x1000000000)	/* 64 GB */
 
+/* slabs are used only in large enough memory to keep partially used slabs overhead low */
+#define MEM_SLAB_MIN_TOTAL_SIZE	(__UINT64_C(512) * MEM_SLAB_SIZE)
+#define MEM_SLAB_BITMAP_SIZE	(MEM_SLAB_SIZE / MEM_SLAB_MIN_OBJECT / 64)
+
+typedef struct
+{
+	void		*prev;
+	void		*next;
+	zbx_uint32_t	object_size;	/* 0 for empty slabs */
+	zbx_uint32_t	objects_num;
+	zbx_uint32_t	free_num;
+	zbx_uint32_t	reserved;
+	zbx_uint64_t	bitmap[MEM_SLAB_BITMAP_SIZE];	/* set bits mark free objects */
+}
+zbx_mem_slab_t;
+
+/* larger objects are placed in empty slabs only when chunk memory is exhausted, one object per slab */
+#define MEM_SLAB_MAX_LARGE_OBJECT	(MEM_SLAB_SIZE - sizeof(zbx_mem_slab_t))
+
 /* helper functions */
 
 static void	*ALIGN4(void *ptr)
@@ -530,6 +570,334 @@ static void	__mem_free(zbx_mem_info_t *info, void *ptr)
 	}
 }
 
+/* slab functions */
+
+static int	mem_slab_index(const zbx_mem_info_t *info, zbx_uint64_t size)
+{
+	if (MEM_SLAB_MAX_OBJECT < size || MEM_SLAB_MIN_TOTAL_SIZE > info->total_size)
+		return -1;
+
+	if (MEM_SLAB_MIN_OBJECT > size)
+		size = MEM_SLAB_MIN_OBJECT;
+
+	return (int)((size - MEM_SLAB_MIN_OBJECT + 7) >> 3);
+}
+
+static int	mem_slab_is_object(const zbx_mem_info_t *info, const void *ptr)
+{
+	if ((const char *)ptr < (const char *)info->hi_bound || (const char *)ptr >= (const char *)info->slabs_hi_bound)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+static zbx_mem_slab_t	*mem_slab_by_object(const zbx_mem_info_t *info, const void *ptr)
+{
+	zbx_uint64_t	offset;
+
+	offset = (zbx_uint64_t)((const char *)info->slabs_hi_bound - (const char *)ptr);
+
+	return (zbx_mem_slab_t *)((char *)info->slabs_hi_bound - ((offset - 1) / MEM_SLAB_SIZE + 1) * MEM_SLAB_SIZE);
+}
+
+static void	mem_slab_link(void **head, zbx_mem_slab_t *slab)
+{
+	slab->prev = NULL;
+	slab->next = *head;
+
+	if (NULL != *head)
+		((zbx_mem_slab_t *)*head)->prev = slab;
+
+	*head = slab;
+}
+
+static void	mem_slab_unlink(void **head, zbx_mem_slab_t *slab)
+{
+	if (NULL != slab->prev)
+		((zbx_mem_slab_t *)slab->prev)->next = slab->next;
+	else
+		*head = slab->next;
+
+	if (NULL != slab->next)
+		((zbx_mem_slab_t *)slab->next)->prev = slab->prev;
+}
+
+static void	mem_slab_init(zbx_mem_info_t *info, zbx_mem_slab_t *slab, zbx_uint32_t object_size)
+{
+	zbx_uint32_t	i;
+
+	slab->object_size = object_size;
+
+	if (MEM_SLAB_MAX_OBJECT >= object_size)
+		slab->objects_num = (MEM_SLAB_SIZE - sizeof(zbx_mem_slab_t)) / object_size;
+	else
+		slab->objects_num = 1;
+	slab->free_num = slab->objects_num;
+
+	memset(slab->bitmap, 0, sizeof(slab->bitmap));
+
+	for (i = 0; i < slab->objects_num / 64; i++)
+		slab->bitmap[i] = __UINT64_C(0xffffffffffffffff);
+
+	if (0 != slab->objects_num % 64)
+		slab->bitmap[i] = (__UINT64_C(1) << (slab->objects_num % 64)) - 1;
+
+	info->free_size += (zbx_uint64_t)slab->objects_num * object_size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_slab_cut                                                     *
+ *                                                                            *
+ * Purpose: cuts new slab from the free chunk at the upper bound of chunk     *
+ *          memory                                                            *
+ *                                                                            *
+ * Return value: the new slab or NULL if the last chunk is used or too small  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_mem_slab_t	*mem_slab_cut(zbx_mem_info_t *info)
+{
+	void		*chunk;
+	zbx_uint64_t	chunk_size;
+
+	if (!FREE_CHUNK((char *)info->hi_bound - MEM_SIZE_FIELD))
+		return NULL;
+
+	chunk_size = CHUNK_SIZE((char *)info->hi_bound - MEM_SIZE_FIELD);
+
+	if (chunk_size < MEM_SLAB_SIZE + MEM_MIN_ALLOC)
+		return NULL;
+
+	chunk = (void *)((char *)info->hi_bound - MEM_SIZE_FIELD - chunk_size - MEM_SIZE_FIELD);
+
+	mem_unlink_chunk(info, chunk);
+	mem_set_chunk_size(chunk, chunk_size - MEM_SLAB_SIZE);
+	mem_link_chunk(info, chunk);
+
+	info->hi_bound = (void *)((char *)info->hi_bound - MEM_SLAB_SIZE);
+	info->free_size -= MEM_SLAB_SIZE;
+
+	return (zbx_mem_slab_t *)info->hi_bound;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_slab_join                                                    *
+ *                                                                            *
+ * Purpose: returns the lowest slab to chunk memory                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	mem_slab_join(zbx_mem_info_t *info)
+{
+	void		*chunk;
+	zbx_uint64_t	chunk_size;
+
+	if (FREE_CHUNK((char *)info->hi_bound - MEM_SIZE_FIELD))
+	{
+		chunk_size = CHUNK_SIZE((char *)info->hi_bound - MEM_SIZE_FIELD);
+		chunk = (void *)((char *)info->hi_bound - MEM_SIZE_FIELD - chunk_size - MEM_SIZE_FIELD);
+		mem_unlink_chunk(info, chunk);
+
+		chunk_size += MEM_SLAB_SIZE;
+		info->free_size += MEM_SLAB_SIZE;
+	}
+	else
+	{
+		chunk = info->hi_bound;
+		chunk_size = MEM_SLAB_SIZE - 2 * MEM_SIZE_FIELD;
+		info->free_size += chunk_size;
+	}
+
+	info->hi_bound = (void *)((char *)info->hi_bound + MEM_SLAB_SIZE);
+
+	mem_set_chunk_size(chunk, chunk_size);
+	mem_link_chunk(info, chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_slab_release                                                 *
+ *                                                                            *
+ * Purpose: releases empty slab                                               *
+ *                                                                            *
+ * Comments: Empty slabs at the bottom of slab area are returned to chunk     *
+ *           memory, others are kept for reuse by any object size.            *
+ *                                                                            *
+ ******************************************************************************/
+static void	mem_slab_release(zbx_mem_info_t *info, zbx_mem_slab_t *slab)
+{
+	info->free_size -= (zbx_uint64_t)slab->objects_num * slab->object_size;
+	slab->object_size = 0;
+
+	if ((void *)slab != info->hi_bound)
+	{
+		mem_slab_link(&info->slabs_empty, slab);
+		return;
+	}
+
+	mem_slab_join(info);
+
+	while (info->hi_bound < info->slabs_hi_bound && 0 == ((zbx_mem_slab_t *)info->hi_bound)->object_size)
+	{
+		mem_slab_unlink(&info->slabs_empty, (zbx_mem_slab_t *)info->hi_bound);
+		mem_slab_join(info);
+	}
+}
+
+static void	*mem_slab_malloc(zbx_mem_info_t *info, int index)
+{
+	zbx_mem_slab_t	*slab;
+	zbx_uint32_t	i, bit;
+	zbx_uint64_t	mask;
+
+	if (NULL == (slab = (zbx_mem_slab_t *)info->slabs[index]))
+	{
+		if (NULL != (slab = (zbx_mem_slab_t *)info->slabs_empty))
+			mem_slab_unlink(&info->slabs_empty, slab);
+		else if (NULL == (slab = mem_slab_cut(info)))
+			return NULL;
+
+		mem_slab_init(info, slab, MEM_SLAB_MIN_OBJECT + index * 8);
+		mem_slab_link(&info->slabs[index], slab);
+	}
+
+	for (i = 0; 0 == slab->bitmap[i]; i++)
+		;
+
+	for (bit = 0, mask = 1; 0 == (slab->bitmap[i] & mask); bit++, mask <<= 1)
+		;
+
+	slab->bitmap[i] &= ~mask;
+
+	if (0 == --slab->free_num)
+		mem_slab_unlink(&info->slabs[index], slab);
+
+	info->used_size += slab->object_size;
+	info->free_size -= slab->object_size;
+
+	return (char *)(slab + 1) + (zbx_uint64_t)(i * 64 + bit) * slab->object_size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_slab_malloc_large                                            *
+ *                                                                            *
+ * Purpose: allocates object larger than MEM_SLAB_MAX_OBJECT bytes in empty   *
+ *          slab                                                              *
+ *                                                                            *
+ * Return value: the allocated object or NULL if there are no empty slabs or  *
+ *               the object does not fit in slab                              *
+ *                                                                            *
+ * Comments: Empty slabs above the bottom of slab area cannot be returned to  *
+ *           chunk memory. This is used when chunk allocation fails, so that  *
+ *           the memory of such slabs is still available for larger objects. *
+ *                                                                            *
+ ******************************************************************************/
+static void	*mem_slab_malloc_large(zbx_mem_info_t *info, zbx_uint64_t size)
+{
+	zbx_mem_slab_t	*slab;
+
+	if (NULL == (slab = (zbx_mem_slab_t *)info->slabs_empty) || MEM_SLAB_MAX_LARGE_OBJECT < size)
+		return NULL;
+
+	mem_slab_unlink(&info->slabs_empty, slab);
+	mem_slab_init(info, slab, (zbx_uint32_t)mem_proper_alloc_size(size));
+
+	slab->bitmap[0] = 0;
+	slab->free_num = 0;
+
+	info->used_size += slab->object_size;
+	info->free_size -= slab->object_size;
+
+	return slab + 1;
+}
+
+static void	mem_slab_free(zbx_mem_info_t *info, void *ptr)
+{
+	zbx_mem_slab_t	*slab;
+	zbx_uint32_t	n;
+	int		index;
+
+	slab = mem_slab_by_object(info, ptr);
+	index = (slab->object_size - MEM_SLAB_MIN_OBJECT) >> 3;
+	n = (zbx_uint32_t)(((char *)ptr - (char *)(slab + 1)) / slab->object_size);
+
+	slab->bitmap[n / 64] |= __UINT64_C(1) << (n % 64);
+
+	info->used_size -= slab->object_size;
+	info->free_size += slab->object_size;
+
+	if (++slab->free_num == slab->objects_num)
+	{
+		if (1 < slab->objects_num)
+			mem_slab_unlink(&info->slabs[index], slab);
+
+		mem_slab_release(info, slab);
+	}
+	else if (1 == slab->free_num)
+		mem_slab_link(&info->slabs[index], slab);
+}
+
+/* allocation functions working with user data pointers */
+
+static void	*mem_malloc(zbx_mem_info_t *info, zbx_uint64_t size)
+{
+	void	*ptr;
+	int	index;
+
+	if (-1 != (index = mem_slab_index(info, size)) && NULL != (ptr = mem_slab_malloc(info, index)))
+		return ptr;
+
+	if (NULL == (ptr = __mem_malloc(info, size)))
+		return mem_slab_malloc_large(info, size);
+
+	return (void *)((char *)ptr + MEM_SIZE_FIELD);
+}
+
+static void	*mem_realloc(zbx_mem_info_t *info, void *old, zbx_uint64_t size)
+{
+	void	*ptr;
+
+	if (SUCCEED == mem_slab_is_object(info, old))
+	{
+		zbx_mem_slab_t	*slab;
+
+		slab = mem_slab_by_object(info, old);
+
+		if (mem_slab_index(info, size) == (int)((slab->object_size - MEM_SLAB_MIN_OBJECT) >> 3))
+			return old;
+
+		if (NULL == (ptr = mem_malloc(info, size)))
+			return NULL;
+
+		memcpy(ptr, old, MIN(size, slab->object_size));
+		mem_slab_free(info, old);
+
+		return ptr;
+	}
+
+	if (NULL == (ptr = __mem_realloc(info, old, size)))
+	{
+		if (NULL == (ptr = mem_slab_malloc_large(info, size)))
+			return NULL;
+
+		memcpy(ptr, old, MIN(size, CHUNK_SIZE((char *)old - MEM_SIZE_FIELD)));
+		__mem_free(info, old);
+
+		return ptr;
+	}
+
+	return (void *)((char *)ptr + MEM_SIZE_FIELD);
+}
+
+static void	mem_free(zbx_mem_info_t *info, void *ptr)
+{
+	if (SUCCEED == mem_slab_is_object(info, ptr))
+		mem_slab_free(info, ptr);
+	else
+		__mem_free(info, ptr);
+}
+
 /* public memory interface */
 
 int	zbx_mem_create(zbx_mem_info_t **info, zbx_uint64_t size, const char *descr, const char *param, int allow_oom,
@@ -610,6 +978,10 @@ int	zbx_mem_create(zbx_mem_info_t **info, zbx_uint64_t size, const char *descr,
 	(*info)->total_size = (zbx_uint64_t)((char *)((*info)->hi_bound) - (char *)((*info)->lo_bound) -
 			2 * MEM_SIZE_FIELD);
 
+	memset((*info)->slabs, 0, sizeof((*info)->slabs));
+	(*info)->slabs_empty = NULL;
+	(*info)->slabs_hi_bound = (*info)->hi_bound;
+
 	index = mem_bucket_by_size((*info)->total_size);
 	(*info)->buckets[index] = (*info)->lo_bound;
 	mem_set_chunk_size((*info)->buckets[index], (*info)->total_size);
@@ -631,7 +1003,7 @@ out:
 
 void	*__zbx_mem_malloc(const char *file, int line, zbx_mem_info_t *info, const void *old, size_t size)
 {
-	void	*chunk;
+	void	*ptr;
 
 	if (NULL != old)
 	{
@@ -647,9 +1019,9 @@ void	*__zbx_mem_malloc(const char *file, int line, zbx_mem_info_t *info, const v
 		exit(EXIT_FAILURE);
 	}
 
-	chunk = __mem_malloc(info, size);
+	ptr = mem_malloc(info, size);
 
-	if (NULL == chunk)
+	if (NULL == ptr)
 	{
 		if (1 == info->allow_oom)
 			return NULL;
@@ -663,12 +1035,12 @@ void	*__zbx_mem_malloc(const char *file, int line, zbx_mem_info_t *info, const v
 		exit(EXIT_FAILURE);
 	}
 
-	return (void *)((char *)chunk + MEM_SIZE_FIELD);
+	return ptr;
 }
 
 void	*__zbx_mem_realloc(const char *file, int line, zbx_mem_info_t *info, void *old, size_t size)
 {
-	void	*chunk;
+	void	*ptr;
 
 	if (0 == size || size > MEM_MAX_SIZE)
 	{
@@ -678,11 +1050,11 @@ void	*__zbx_mem_realloc(const char *file, int line, zbx_mem_info_t *info, void *
 	}
 
 	if (NULL == old)
-		chunk = __mem_malloc(info, size);
+		ptr = mem_malloc(info, size);
 	else
-		chunk = __mem_realloc(info, old, size);
+		ptr = mem_realloc(info, old, size);
 
-	if (NULL == chunk)
+	if (NULL == ptr)
 	{
 		if (1 == info->allow_oom)
 			return NULL;
@@ -696,7 +1068,7 @@ void	*__zbx_mem_realloc(const char *file, int line, zbx_mem_info_t *info, void *
 		exit(EXIT_FAILURE);
 	}
 
-	return (void *)((char *)chunk + MEM_SIZE_FIELD);
+	return ptr;
 }
 
 void	__zbx_mem_free(const char *file, int line, zbx_mem_info_t *info, void *ptr)
@@ -707,7 +1079,7 @@ void	__zbx_mem_free(const char *file, int line, zbx_mem_info_t *info, void *ptr)
 		exit(EXIT_FAILURE);
 	}
 
-	__mem_free(info, ptr);
+	mem_free(info, ptr);
 }
 
 void	zbx_mem_clear(zbx_mem_info_t *info)
@@ -717,6 +1089,9 @@ void	zbx_mem_clear(zbx_mem_info_t *info)
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	memset(info->buckets, 0, MEM_BUCKET_COUNT * ZBX_PTR_SIZE);
+	memset(info->slabs, 0, sizeof(info->slabs));
+	info->slabs_empty = NULL;
+	info->hi_bound = info->slabs_hi_bound;
 	index = mem_bucket_by_size(info->total_size);
 	info->buckets[index] = info->lo_bound;
 	mem_set_chunk_size(info->buckets[index], info->total_size);
@@ -730,9 +1105,26 @@ void	zbx_mem_clear(zbx_mem_info_t *info)
 
 void	zbx_mem_get_stats(const zbx_mem_info_t *info, zbx_mem_stats_t *stats)
 {
-	void		*chunk;
-	int		i;
-	zbx_uint64_t	counter;
+	void			*chunk;
+	const zbx_mem_slab_t	*slab;
+	int			i;
+	zbx_uint64_t		counter, slabs_used = 0, slabs_free = 0, chunks_overhead;
+
+	stats->slabs_num = 0;
+	stats->slab_objects = 0;
+
+	for (slab = (const zbx_mem_slab_t *)info->hi_bound; (const void *)slab < info->slabs_hi_bound;
+			slab = (const zbx_mem_slab_t *)((const char *)slab + MEM_SLAB_SIZE))
+	{
+		stats->slabs_num++;
+
+		if (0 == slab->object_size)
+			continue;
+
+		stats->slab_objects += slab->objects_num - slab->free_num;
+		slabs_used += (zbx_uint64_t)(slab->objects_num - slab->free_num) * slab->object_size;
+		slabs_free += (zbx_uint64_t)slab->free_num * slab->object_size;
+	}
 
 	stats->free_chunks = 0;
 	stats->max_chunk_size = __UINT64_C(0);
@@ -756,7 +1148,9 @@ void	zbx_mem_get_stats(const zbx_mem_info_t *info, zbx_mem_stats_t *stats)
 	}
 
 	stats->overhead = info->total_size - info->used_size - info->free_size;
-	stats->used_chunks = stats->overhead / (2 * MEM_SIZE_FIELD) + 1 - stats->free_chunks;
+
+	chunks_overhead = stats->overhead - ((zbx_uint64_t)stats->slabs_num * MEM_SLAB_SIZE - slabs_used - slabs_free);
+	stats->used_chunks = chunks_overhead / (2 * MEM_SIZE_FIELD) + 1 - stats->free_chunks + stats->slab_objects;
 	stats->free_size = info->free_size;
 	stats->used_size = info->used_size;
 }
@@ -792,6 +1186,13 @@ void	zbx_mem_dump_stats(int level, zbx_mem_info_t *info)
 	zabbix_log(level, "of those, %10llu bytes are used by allocation overhead",
 			(unsigned long long)stats.overhead);
 
+	if (0 != stats.slabs_num)
+	{
+		zabbix_log(level, "%llu bytes are in %u slabs holding %u used chunks",
+				(unsigned long long)stats.slabs_num * MEM_SLAB_SIZE, stats.slabs_num,
+				stats.slab_objects);
+	}
+
 	zabbix_log(level, "================================");
 }
 
@@ -81,6 +81,8 @@ typedef struct
 	char			*value;
 	zbx_vector_ptr_t	labels;
 	char			*raw;
+	/* 1 if the row has label block, label conditions are not checked for rows without it */
+	unsigned char		has_labels;
 }
 zbx_prometheus_row_t;
 
@@ -110,6 +112,49 @@ static int	prometheus_hint_compare(const void *d1, const void *d2)
 	return strcmp(hint1->metric, hint2->metric);
 }
 
+/* the indexes of data rows having the same metric name */
+typedef struct
+{
+	const char		*metric;
+	zbx_vector_uint64_t	rows;
+}
+zbx_prometheus_metric_t;
+
+/* the indexed prometheus data */
+struct zbx_prometheus
+{
+	/* the parsed data rows in their original order */
+	zbx_vector_ptr_t	rows;
+	/* the row indexes by metric names */
+	zbx_hashset_t		metrics;
+	/* the TYPE, HELP hints of all metrics */
+	zbx_hashset_t		hints;
+};
+
+/* metric index hashset support */
+
+static zbx_hash_t	prometheus_metric_hash(const void *d)
+{
+	const zbx_prometheus_metric_t	*metric = (zbx_prometheus_metric_t *)d;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(metric->metric);
+}
+
+static int	prometheus_metric_compare(const void *d1, const void *d2)
+{
+	const zbx_prometheus_metric_t	*metric1 = (zbx_prometheus_metric_t *)d1;
+	const zbx_prometheus_metric_t	*metric2 = (zbx_prometheus_metric_t *)d2;
+
+	return strcmp(metric1->metric, metric2->metric);
+}
+
+static void	prometheus_metric_clear(void *d)
+{
+	zbx_prometheus_metric_t	*metric = (zbx_prometheus_metric_t *)d;
+
+	zbx_vector_uint64_destroy(&metric->rows);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: str_loc_dup                                                      *
@@ -1054,6 +1099,8 @@ static int	prometheus_parse_row(zbx_prometheus_filter_t *filter, const char *dat
 
 	if ('{' == data[pos])
 	{
+		row->has_labels = 1;
+
 		if (SUCCEED != prometheus_metric_parse_labels(data, pos, &row->labels, &loc, error))
 			goto out;
 
@@ -1581,6 +1628,88 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: prometheus_hints_clear                                           *
+ *                                                                            *
+ * Purpose: frees resources allocated by TYPE/HELP hint registry              *
+ *                                                                            *
+ * Parameters: hints - [IN] the hint registry                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	prometheus_hints_clear(zbx_hashset_t *hints)
+{
+	zbx_prometheus_hint_t	*hint;
+	zbx_hashset_iter_t	iter;
+
+	zbx_hashset_iter_reset(hints, &iter);
+	while (NULL != (hint = (zbx_prometheus_hint_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_free(hint->metric);
+		zbx_free(hint->help);
+		zbx_free(hint->type);
+	}
+	zbx_hashset_destroy(hints);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: prometheus_rows_to_json                                          *
+ *                                                                            *
+ * Purpose: converts filtered rows to json to be used with LLD                *
+ *                                                                            *
+ * Parameters: rows  - [IN] the filtered rows                                 *
+ *             hints - [IN] the TYPE/HELP hint registry                       *
+ *             value - [OUT] the converted data                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	prometheus_rows_to_json(const zbx_vector_ptr_t *rows, zbx_hashset_t *hints, char **value)
+{
+	int			i, j;
+	zbx_prometheus_hint_t	*hint, hint_local;
+	struct zbx_json		json;
+
+	zbx_json_initarray(&json, rows->values_num * 100);
+
+	for (i = 0; i < rows->values_num; i++)
+	{
+		zbx_prometheus_row_t	*row = (zbx_prometheus_row_t *)rows->values[i];
+		char			*hint_type;
+
+		zbx_json_addobject(&json, NULL);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, row->metric, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_VALUE, row->value, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_LINE_RAW, row->raw, ZBX_JSON_TYPE_STRING);
+
+		if (0 != row->labels.values_num)
+		{
+			zbx_json_addobject(&json, ZBX_PROTO_TAG_LABELS);
+
+			for (j = 0; j < row->labels.values_num; j++)
+			{
+				zbx_prometheus_label_t	*label = (zbx_prometheus_label_t *)row->labels.values[j];
+				zbx_json_addstring(&json, label->name, label->value, ZBX_JSON_TYPE_STRING);
+			}
+
+			zbx_json_close(&json);
+		}
+
+		hint_local.metric = row->metric;
+		hint = (zbx_prometheus_hint_t *)zbx_hashset_search(hints, &hint_local);
+
+		hint_type = (NULL != hint && NULL != hint->type ? hint->type : ZBX_PROMETHEUS_TYPE_UNTYPED);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_TYPE, hint_type, ZBX_JSON_TYPE_STRING);
+
+		if (NULL != hint && NULL != hint->help)
+			zbx_json_addstring(&json, ZBX_PROTO_TAG_HELP, hint->help, ZBX_JSON_TYPE_STRING);
+
+		zbx_json_close(&json);
+	}
+
+	*value = zbx_strdup(NULL, json.buffer);
+	zbx_json_free(&json);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_prometheus_to_json                                           *
@@ -1600,12 +1729,9 @@ int	zbx_prometheus_to_json(const char *data, const char *filter_data, char **val
 {
 	zbx_prometheus_filter_t	filter;
 	char			*errmsg = NULL;
-	int			ret = FAIL, i, j;
+	int			ret = FAIL;
 	zbx_vector_ptr_t	rows;
 	zbx_hashset_t		hints;
-	zbx_prometheus_hint_t	*hint, hint_local;
-	zbx_hashset_iter_t	iter;
-	struct zbx_json		json;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1622,58 +1748,321 @@ int	zbx_prometheus_to_json(const char *data, const char *filter_data, char **val
 	if (FAIL == prometheus_parse_rows(&filter, data, &rows, &hints, error))
 		goto cleanup;
 
-	zbx_json_initarray(&json, rows.values_num * 100);
+	prometheus_rows_to_json(&rows, &hints, value);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s(): output:%s", __func__, *value);
+	ret = SUCCEED;
+cleanup:
+	prometheus_hints_clear(&hints);
+
+	zbx_vector_ptr_clear_ext(&rows, (zbx_clean_func_t)prometheus_row_free);
+	zbx_vector_ptr_destroy(&rows);
+	prometheus_filter_clear(&filter);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prometheus_index_create                                      *
+ *                                                                            *
+ * Purpose: parses all prometheus data rows and indexes them by metric names  *
+ *                                                                            *
+ * Parameters: prom  - [OUT] the indexed prometheus data                      *
+ *             data  - [IN] the prometheus data                               *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the data was indexed successfully                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The index is built with a single pass over data and can be used  *
+ *           to apply multiple filters to the same data. Unlike filtered      *
+ *           parsing all rows must be valid, so if indexing fails the data    *
+ *           must be processed by zbx_prometheus_pattern() and                *
+ *           zbx_prometheus_to_json() functions instead.                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prometheus_index_create(zbx_prometheus_t **prom, const char *data, char **error)
+{
+	zbx_prometheus_filter_t	filter;
+	zbx_prometheus_t	*index;
+	zbx_prometheus_metric_t	*metric, metric_local;
+	int			i, ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (FAIL == prometheus_filter_init(&filter, "", error))
+		goto out;
+
+	index = (zbx_prometheus_t *)zbx_malloc(NULL, sizeof(zbx_prometheus_t));
+	zbx_vector_ptr_create(&index->rows);
+	zbx_hashset_create(&index->hints, 100, prometheus_hint_hash, prometheus_hint_compare);
+	zbx_hashset_create_ext(&index->metrics, 100, prometheus_metric_hash, prometheus_metric_compare,
+			prometheus_metric_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
 
-	for (i = 0; i < rows.values_num; i++)
+	if (FAIL == prometheus_parse_rows(&filter, data, &index->rows, &index->hints, error))
 	{
-		zbx_prometheus_row_t	*row = (zbx_prometheus_row_t *)rows.values[i];
-		char			*hint_type;
+		zbx_prometheus_index_free(index);
+		goto clean;
+	}
 
-		zbx_json_addobject(&json, NULL);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, row->metric, ZBX_JSON_TYPE_STRING);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_VALUE, row->value, ZBX_JSON_TYPE_STRING);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_LINE_RAW, row->raw, ZBX_JSON_TYPE_STRING);
+	for (i = 0; i < index->rows.values_num; i++)
+	{
+		metric_local.metric = ((zbx_prometheus_row_t *)index->rows.values[i])->metric;
 
-		if (0 != row->labels.values_num)
+		if (NULL == (metric = (zbx_prometheus_metric_t *)zbx_hashset_search(&index->metrics, &metric_local)))
 		{
-			zbx_json_addobject(&json, ZBX_PROTO_TAG_LABELS);
+			metric = (zbx_prometheus_metric_t *)zbx_hashset_insert(&index->metrics, &metric_local,
+					sizeof(metric_local));
+			zbx_vector_uint64_create(&metric->rows);
+		}
+
+		zbx_vector_uint64_append(&metric->rows, (zbx_uint64_t)i);
+	}
+
+	*prom = index;
+	ret = SUCCEED;
+clean:
+	prometheus_filter_clear(&filter);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prometheus_index_free                                        *
+ *                                                                            *
+ * Purpose: frees indexed prometheus data                                     *
+ *                                                                            *
+ * Parameters: prom - [IN] the indexed prometheus data                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_prometheus_index_free(zbx_prometheus_t *prom)
+{
+	zbx_hashset_destroy(&prom->metrics);
+	prometheus_hints_clear(&prom->hints);
+	zbx_vector_ptr_clear_ext(&prom->rows, (zbx_clean_func_t)prometheus_row_free);
+	zbx_vector_ptr_destroy(&prom->rows);
+	zbx_free(prom);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: prometheus_row_match                                             *
+ *                                                                            *
+ * Purpose: matches parsed row against filter label and value conditions      *
+ *                                                                            *
+ * Parameters: filter - [IN] the prometheus filter                            *
+ *             row    - [IN] the parsed row                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the row matches filter conditions                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The metric condition must be checked by caller.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	prometheus_row_match(const zbx_prometheus_filter_t *filter, const zbx_prometheus_row_t *row)
+{
+	int	i, j;
+
+	if (0 != row->has_labels)
+	{
+		for (i = 0; i < filter->labels.values_num; i++)
+		{
+			zbx_prometheus_condition_t	*condition = filter->labels.values[i];
 
 			for (j = 0; j < row->labels.values_num; j++)
 			{
-				zbx_prometheus_label_t	*label = (zbx_prometheus_label_t *)row->labels.values[j];
-				zbx_json_addstring(&json, label->name, label->value, ZBX_JSON_TYPE_STRING);
+				zbx_prometheus_label_t	*label = row->labels.values[j];
+
+				if (SUCCEED == condition_match_key_value(condition, label->name, label->value))
+					break;
 			}
 
-			zbx_json_close(&json);
+			if (j == row->labels.values_num)
+				return FAIL;
 		}
+	}
 
-		hint_local.metric = row->metric;
-		hint = (zbx_prometheus_hint_t *)zbx_hashset_search(&hints, &hint_local);
+	if (NULL != filter->value && SUCCEED != condition_match_metric_value(filter->value->pattern, row->value))
+		return FAIL;
 
-		hint_type = (NULL != hint && NULL != hint->type ? hint->type : ZBX_PROMETHEUS_TYPE_UNTYPED);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_TYPE, hint_type, ZBX_JSON_TYPE_STRING);
+	return SUCCEED;
+}
 
-		if (NULL != hint && NULL != hint->help)
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_HELP, hint->help, ZBX_JSON_TYPE_STRING);
+/******************************************************************************
+ *                                                                            *
+ * Function: prometheus_index_filter_rows                                     *
+ *                                                                            *
+ * Purpose: gets indexed rows matching filter                                 *
+ *                                                                            *
+ * Parameters: prom   - [IN] the indexed prometheus data                      *
+ *             filter - [IN] the prometheus filter                            *
+ *             rows   - [OUT] the matching rows in their original order       *
+ *                                                                            *
+ * Comments: Metric name equality condition is resolved with a hash lookup,   *
+ *           metric name regular expression is matched once per distinct      *
+ *           metric name.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	prometheus_index_filter_rows(zbx_prometheus_t *prom, const zbx_prometheus_filter_t *filter,
+		zbx_vector_ptr_t *rows)
+{
+	zbx_prometheus_metric_t	*metric, metric_local;
+	zbx_prometheus_row_t	*row;
+	zbx_vector_uint64_t	indexes;
+	zbx_hashset_iter_t	iter;
+	int			i;
 
-		zbx_json_close(&json);
+	if (NULL == filter->metric)
+	{
+		for (i = 0; i < prom->rows.values_num; i++)
+		{
+			row = (zbx_prometheus_row_t *)prom->rows.values[i];
+
+			if (SUCCEED == prometheus_row_match(filter, row))
+				zbx_vector_ptr_append(rows, row);
+		}
+
+		return;
+	}
+
+	if (ZBX_PROMETHEUS_CONDITION_OP_REGEX != filter->metric->op)
+	{
+		metric_local.metric = filter->metric->pattern;
+
+		if (NULL == (metric = (zbx_prometheus_metric_t *)zbx_hashset_search(&prom->metrics, &metric_local)))
+			return;
+
+		for (i = 0; i < metric->rows.values_num; i++)
+		{
+			row = (zbx_prometheus_row_t *)prom->rows.values[metric->rows.values[i]];
+
+			if (SUCCEED == prometheus_row_match(filter, row))
+				zbx_vector_ptr_append(rows, row);
+		}
+
+		return;
+	}
+
+	zbx_vector_uint64_create(&indexes);
+
+	zbx_hashset_iter_reset(&prom->metrics, &iter);
+	while (NULL != (metric = (zbx_prometheus_metric_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (SUCCEED == condition_match_key_value(filter->metric, NULL, metric->metric))
+			zbx_vector_uint64_append_array(&indexes, metric->rows.values, metric->rows.values_num);
+	}
+
+	zbx_vector_uint64_sort(&indexes, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < indexes.values_num; i++)
+	{
+		row = (zbx_prometheus_row_t *)prom->rows.values[indexes.values[i]];
+
+		if (SUCCEED == prometheus_row_match(filter, row))
+			zbx_vector_ptr_append(rows, row);
+	}
+
+	zbx_vector_uint64_destroy(&indexes);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prometheus_index_pattern                                     *
+ *                                                                            *
+ * Purpose: extracts value from indexed prometheus data by the specified      *
+ *          filter                                                            *
+ *                                                                            *
+ * Parameters: prom        - [IN] the indexed prometheus data                 *
+ *             fitler_data - [IN] the filter in text format                   *
+ *             output      - [IN] the output template                         *
+ *             value       - [OUT] the extracted value                        *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - the value was extracted successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prometheus_index_pattern(zbx_prometheus_t *prom, const char *filter_data, const char *output,
+		char **value, char **error)
+{
+	zbx_prometheus_filter_t	filter;
+	char			*errmsg = NULL;
+	int			ret = FAIL;
+	zbx_vector_ptr_t	rows;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (FAIL == prometheus_filter_init(&filter, filter_data, &errmsg))
+	{
+		*error = zbx_dsprintf(*error, "pattern error: %s", errmsg);
+		zbx_free(errmsg);
+		goto out;
+	}
+
+	zbx_vector_ptr_create(&rows);
+	prometheus_index_filter_rows(prom, &filter, &rows);
+
+	if (FAIL == prometheus_extract_value(&rows, output, value, &errmsg))
+	{
+		*error = zbx_dsprintf(*error, "data extraction error: %s", errmsg);
+		zbx_free(errmsg);
+		goto cleanup;
 	}
 
-	*value = zbx_strdup(NULL, json.buffer);
-	zbx_json_free(&json);
 	zabbix_log(LOG_LEVEL_DEBUG, "%s(): output:%s", __func__, *value);
 	ret = SUCCEED;
 cleanup:
-	zbx_hashset_iter_reset(&hints, &iter);
-	while (NULL != (hint = (zbx_prometheus_hint_t *)zbx_hashset_iter_next(&iter)))
+	zbx_vector_ptr_destroy(&rows);
+	prometheus_filter_clear(&filter);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prometheus_index_to_json                                     *
+ *                                                                            *
+ * Purpose: converts filtered indexed prometheus data to json to be used with *
+ *          LLD                                                               *
+ *                                                                            *
+ * Parameters: prom        - [IN] the indexed prometheus data                 *
+ *             fitler_data - [IN] the filter in text format                   *
+ *             value       - [OUT] the converted data                         *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - the data was converted successfully                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prometheus_index_to_json(zbx_prometheus_t *prom, const char *filter_data, char **value,
+		char **error)
+{
+	zbx_prometheus_filter_t	filter;
+	char			*errmsg = NULL;
+	int			ret = FAIL;
+	zbx_vector_ptr_t	rows;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (FAIL == prometheus_filter_init(&filter, filter_data, &errmsg))
 	{
-		zbx_free(hint->metric);
-		zbx_free(hint->help);
-		zbx_free(hint->type);
+		*error = zbx_dsprintf(*error, "pattern error: %s", errmsg);
+		zbx_free(errmsg);
+		goto out;
 	}
-	zbx_hashset_destroy(&hints);
 
-	zbx_vector_ptr_clear_ext(&rows, (zbx_clean_func_t)prometheus_row_free);
+	zbx_vector_ptr_create(&rows);
+	prometheus_index_filter_rows(prom, &filter, &rows);
+
+	prometheus_rows_to_json(&rows, &prom->hints, value);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s(): output:%s", __func__, *value);
+	ret = SUCCEED;
+
 	zbx_vector_ptr_destroy(&rows);
 	prometheus_filter_clear(&filter);
 out:
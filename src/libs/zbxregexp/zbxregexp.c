@@ -39,6 +39,30 @@ zbx_regmatch_t;
 					/* Group \0 contains the matching part of string, groups \1 ...\9 */
 					/* contain captured groups (substrings).                          */
 
+#define ZBX_REGEXP_CACHE_SIZE		256		/* maximum number of cached compiled regexps per process */
+#define ZBX_REGEXP_JIT_STACK_MIN	(32 * ZBX_KIBIBYTE)
+#define ZBX_REGEXP_JIT_STACK_MAX	(ZBX_MEBIBYTE)
+
+/* compiled regexp cache entry */
+typedef struct
+{
+	zbx_lrucache_link_t	link;
+	char			*pattern;
+	int			flags;
+	zbx_regexp_t		*regexp;
+}
+zbx_regexp_cache_entry_t;
+
+static zbx_hash_t	regexp_cache_entry_hash(const void *data);
+static int	regexp_cache_entry_compare(const void *d1, const void *d2);
+static void	regexp_cache_entry_clean(void *data);
+
+static ZBX_THREAD_LOCAL zbx_lrucache_t	regexp_cache = ZBX_LRUCACHE_INITIALIZER(ZBX_REGEXP_CACHE_SIZE,
+		regexp_cache_entry_hash, regexp_cache_entry_compare, regexp_cache_entry_clean);
+#ifdef PCRE_STUDY_JIT_COMPILE
+static ZBX_THREAD_LOCAL pcre_jit_stack	*regexp_jit_stack;
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: regexp_compile                                                   *
@@ -51,6 +75,7 @@ zbx_regmatch_t;
  *                      NULL is not allowed.                                  *
  *     flags     - [IN] regexp compilation parameters passed to pcre_compile. *
  *                      PCRE_CASELESS, PCRE_NO_AUTO_CAPTURE, PCRE_MULTILINE.  *
+ *     study_flags - [IN] regexp study options passed to pcre_study.          *
  *     regexp    - [OUT] output regexp.                                       *
  *     err_msg_static - [OUT] error message if any. Do not deallocate with    *
  *                            zbx_free().                                     *
@@ -58,7 +83,8 @@ zbx_regmatch_t;
  * Return value: SUCCEED or FAIL                                              *
  *                                                                            *
  ******************************************************************************/
-static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp, const char **err_msg_static)
+static int	regexp_compile(const char *pattern, int flags, int study_flags, zbx_regexp_t **regexp,
+		const char **err_msg_static)
 {
 	int			error_offset = -1;
 	pcre			*pcre_regexp;
@@ -94,7 +120,7 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 
 	if (NULL != regexp)
 	{
-		if (NULL == (extra = pcre_study(pcre_regexp, 0, err_msg_static)) && NULL != *err_msg_static)
+		if (NULL == (extra = pcre_study(pcre_regexp, study_flags, err_msg_static)) && NULL != *err_msg_static)
 		{
 			pcre_free(pcre_regexp);
 			return FAIL;
@@ -120,9 +146,9 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 int	zbx_regexp_compile(const char *pattern, zbx_regexp_t **regexp, const char **err_msg_static)
 {
 #ifdef PCRE_NO_AUTO_CAPTURE
-	return regexp_compile(pattern, PCRE_MULTILINE | PCRE_NO_AUTO_CAPTURE, regexp, err_msg_static);
+	return regexp_compile(pattern, PCRE_MULTILINE | PCRE_NO_AUTO_CAPTURE, 0, regexp, err_msg_static);
 #else
-	return regexp_compile(pattern, PCRE_MULTILINE, regexp, err_msg_static);
+	return regexp_compile(pattern, PCRE_MULTILINE, 0, regexp, err_msg_static);
 #endif
 }
 
@@ -135,46 +161,151 @@ int	zbx_regexp_compile(const char *pattern, zbx_regexp_t **regexp, const char **
  *******************************************************/
 int	zbx_regexp_compile_ext(const char *pattern, zbx_regexp_t **regexp, int flags, const char **err_msg_static)
 {
-	return regexp_compile(pattern, flags, regexp, err_msg_static);
+	return regexp_compile(pattern, flags, 0, regexp, err_msg_static);
 }
 
-/****************************************************************************************************
- *                                                                                                  *
- * Function: regexp_prepare                                                                         *
- *                                                                                                  *
- * Purpose: wrapper for zbx_regexp_compile. Caches and reuses the last used regexp.                 *
- *                                                                                                  *
- ****************************************************************************************************/
-static int	regexp_prepare(const char *pattern, int flags, zbx_regexp_t **regexp, const char **err_msg_static)
+static zbx_hash_t	regexp_cache_entry_hash(const void *data)
 {
-	static ZBX_THREAD_LOCAL zbx_regexp_t	*curr_regexp = NULL;
-	static ZBX_THREAD_LOCAL char		*curr_pattern = NULL;
-	static ZBX_THREAD_LOCAL int		curr_flags = 0;
-	int					ret = SUCCEED;
+	const zbx_regexp_cache_entry_t	*entry = (const zbx_regexp_cache_entry_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(entry->pattern);
 
-	if (NULL == curr_regexp || 0 != strcmp(curr_pattern, pattern) || curr_flags != flags)
+	return ZBX_DEFAULT_HASH_ALGO(&entry->flags, sizeof(entry->flags), hash);
+}
+
+static int	regexp_cache_entry_compare(const void *d1, const void *d2)
+{
+	const zbx_regexp_cache_entry_t	*e1 = (const zbx_regexp_cache_entry_t *)d1;
+	const zbx_regexp_cache_entry_t	*e2 = (const zbx_regexp_cache_entry_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->flags, e2->flags);
+
+	return strcmp(e1->pattern, e2->pattern);
+}
+
+static void	regexp_cache_entry_clean(void *data)
+{
+	zbx_regexp_cache_entry_t	*entry = (zbx_regexp_cache_entry_t *)data;
+
+	zbx_regexp_free(entry->regexp);
+	zbx_free(entry->pattern);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_get                                                 *
+ *                                                                            *
+ * Purpose: get compiled regexp from the per process regexp cache, compiling  *
+ *          and caching it if necessary                                       *
+ *                                                                            *
+ * Parameters: pattern        - [IN] regular expression as a text string      *
+ *             flags          - [IN] regexp compilation parameters            *
+ *             regexp         - [OUT] the compiled regexp                     *
+ *             err_msg_static - [OUT] error message if any. Do not deallocate *
+ *                                    with zbx_free().                        *
+ *                                                                            *
+ * Return value: SUCCEED or FAIL                                              *
+ *                                                                            *
+ * Comments: The least recently used regexp is dropped when the cache is      *
+ *           full, so the returned regexp is valid only until the next cache  *
+ *           access. Cached regexps are JIT compiled when PCRE supports it.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	regexp_cache_get(const char *pattern, int flags, zbx_regexp_t **regexp, const char **err_msg_static)
+{
+	zbx_regexp_cache_entry_t	entry_local, *entry;
+	int				study_flags = 0;
+
+	entry_local.pattern = (char *)pattern;
+	entry_local.flags = flags;
+
+	if (NULL != (entry = (zbx_regexp_cache_entry_t *)zbx_lrucache_search(&regexp_cache, &entry_local)))
 	{
-		if (NULL != curr_regexp)
-		{
-			zbx_regexp_free(curr_regexp);
-			zbx_free(curr_pattern);
-		}
+		*regexp = entry->regexp;
+		return SUCCEED;
+	}
+
+#ifdef PCRE_STUDY_JIT_COMPILE
+	study_flags = PCRE_STUDY_JIT_COMPILE;
+#endif
+	if (SUCCEED != regexp_compile(pattern, flags, study_flags, &entry_local.regexp, err_msg_static))
+		return FAIL;
 
-		curr_regexp = NULL;
-		curr_pattern = NULL;
-		curr_flags = 0;
+#ifdef PCRE_STUDY_JIT_COMPILE
+	if (NULL != entry_local.regexp->extra)
+	{
+		/* the default JIT machine stack (32KB) is too small for complex patterns matched against */
+		/* large values, share a larger stack between all cached regexps instead                */
+		if (NULL == regexp_jit_stack)
+			regexp_jit_stack = pcre_jit_stack_alloc(ZBX_REGEXP_JIT_STACK_MIN, ZBX_REGEXP_JIT_STACK_MAX);
 
-		if (SUCCEED == regexp_compile(pattern, flags, &curr_regexp, err_msg_static))
-		{
-			curr_pattern = zbx_strdup(curr_pattern, pattern);
-			curr_flags = flags;
-		}
-		else
-			ret = FAIL;
+		if (NULL != regexp_jit_stack)
+			pcre_assign_jit_stack(entry_local.regexp->extra, NULL, regexp_jit_stack);
 	}
+#endif
+	entry_local.pattern = zbx_strdup(NULL, pattern);
+	entry = (zbx_regexp_cache_entry_t *)zbx_lrucache_insert(&regexp_cache, &entry_local, sizeof(entry_local));
 
-	*regexp = curr_regexp;
-	return ret;
+	*regexp = entry->regexp;
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_compile_cached                                        *
+ *                                                                            *
+ * Purpose: cached counterpart of zbx_regexp_compile                          *
+ *                                                                            *
+ * Comments: The returned regexp is owned by the cache and must not be freed. *
+ *           It stays valid until the next regexp cache access.               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_regexp_compile_cached(const char *pattern, const zbx_regexp_t **regexp, const char **err_msg_static)
+{
+#ifdef PCRE_NO_AUTO_CAPTURE
+	return zbx_regexp_compile_cached_ext(pattern, regexp, PCRE_MULTILINE | PCRE_NO_AUTO_CAPTURE, err_msg_static);
+#else
+	return zbx_regexp_compile_cached_ext(pattern, regexp, PCRE_MULTILINE, err_msg_static);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_compile_cached_ext                                    *
+ *                                                                            *
+ * Purpose: cached counterpart of zbx_regexp_compile_ext                      *
+ *                                                                            *
+ * Comments: The returned regexp is owned by the cache and must not be freed. *
+ *           It stays valid until the next regexp cache access.               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_regexp_compile_cached_ext(const char *pattern, const zbx_regexp_t **regexp, int flags,
+		const char **err_msg_static)
+{
+	zbx_regexp_t	*cached;
+
+	if (SUCCEED != regexp_cache_get(pattern, flags, &cached, err_msg_static))
+		return FAIL;
+
+	*regexp = cached;
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_cache_get_stats                                       *
+ *                                                                            *
+ * Purpose: get the per process compiled regexp cache statistics              *
+ *                                                                            *
+ * Parameters: hits   - [OUT] the number of cache hits                        *
+ *             misses - [OUT] the number of cache misses                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_regexp_cache_get_stats(zbx_uint64_t *hits, zbx_uint64_t *misses)
+{
+	*hits = regexp_cache.hits;
+	*misses = regexp_cache.misses;
 }
 
 /***********************************************************************************
@@ -339,7 +470,7 @@ static char	*zbx_regexp(const char *string, const char *pattern, int flags, int
 	if (NULL != len)
 		*len = FAIL;
 
-	if (SUCCEED != regexp_prepare(pattern, flags, &regexp, &error))
+	if (SUCCEED != regexp_cache_get(pattern, flags, &regexp, &error))
 		return NULL;
 
 	if (NULL != string)
@@ -553,7 +684,7 @@ static int	regexp_sub(const char *string, const char *pattern, const char *outpu
 		flags |= PCRE_NO_AUTO_CAPTURE;
 #endif
 
-	if (FAIL == regexp_prepare(pattern, flags, &regexp, &error))
+	if (FAIL == regexp_cache_get(pattern, flags, &regexp, &error))
 		return FAIL;
 
 	zbx_free(*out);
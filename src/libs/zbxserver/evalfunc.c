@@ -742,16 +742,16 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
-	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
 	/* skip counting values one by one if both pattern and operator are empty or "" is searched in text values */
 	if ((NULL != arg2 && '\0' != *arg2) || (NULL != arg3 && '\0' != *arg3 &&
 			OP_LIKE != op && OP_REGEXP != op && OP_IREGEXP != op))
 	{
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
+
 		switch (item->value_type)
 		{
 			case ITEM_VALUE_TYPE_UINT64:
@@ -805,7 +805,18 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 		}
 	}
 	else
-		count = values.values_num;
+	{
+		zbx_vc_aggregate_t	aggr;
+
+		if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_COUNT, seconds,
+				nvalues, &ts_end, &aggr))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
+
+		count = aggr.values_num;
+	}
 
 	zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%d", count);
 
@@ -852,16 +863,13 @@ out:
  ******************************************************************************/
 static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	history_value_t			result;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0;
+	zbx_value_type_t	arg1_type;
+	zbx_vc_aggregate_t	aggr;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -907,32 +915,16 @@ static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_SUM, seconds, nvalues,
+			&ts_end, &aggr))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
-	}
-	else
-	{
-		result.ui64 = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
-	}
-
-	*value = zbx_history_value2str_dyn(&result, item->value_type);
+	*value = zbx_history_value2str_dyn(&aggr.value, item->value_type);
 	ret = SUCCEED;
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -953,15 +945,13 @@ out:
  ******************************************************************************/
 static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0;
+	zbx_value_type_t	arg1_type;
+	zbx_vc_aggregate_t	aggr;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1007,30 +997,18 @@ static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_AVG, seconds, nvalues,
+			&ts_end, &aggr))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggr.values_num)
 	{
-		double	avg = 0;
 		size_t	value_alloc = 0, value_offset = 0;
 
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
-		}
-		else
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.ui64;
-
-			avg = avg / values.values_num;
-		}
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, avg);
+		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, aggr.value.dbl);
 
 		ret = SUCCEED;
 	}
@@ -1040,8 +1018,6 @@ static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1159,15 +1135,13 @@ out:
  ******************************************************************************/
 static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0;
+	zbx_value_type_t	arg1_type;
+	zbx_vc_aggregate_t	aggr;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1213,34 +1187,16 @@ static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_MIN, seconds, nvalues,
+			&ts_end, &aggr))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggr.values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.ui64 < values.values[index].value.ui64)
-					index = i;
-			}
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.dbl < values.values[index].value.dbl)
-					index = i;
-			}
-		}
-
-		*value = zbx_history_value2str_dyn(&values.values[index].value, item->value_type);
+		*value = zbx_history_value2str_dyn(&aggr.value, item->value_type);
 		ret = SUCCEED;
 	}
 	else
@@ -1249,8 +1205,6 @@ static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1271,15 +1225,13 @@ out:
  ******************************************************************************/
 static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0;
+	zbx_value_type_t	arg1_type;
+	zbx_vc_aggregate_t	aggr;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1325,35 +1277,16 @@ static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_MAX, seconds, nvalues,
+			&ts_end, &aggr))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggr.values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.ui64 > values.values[index].value.ui64)
-					index = i;
-			}
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.dbl > values.values[index].value.dbl)
-					index = i;
-			}
-		}
-
-		*value = zbx_history_value2str_dyn(&values.values[index].value, item->value_type);
-
+		*value = zbx_history_value2str_dyn(&aggr.value, item->value_type);
 		ret = SUCCEED;
 	}
 	else
@@ -1362,8 +1295,6 @@ static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -5054,6 +5054,16 @@ static void	zbx_extract_functionids(zbx_vector_uint64_t *functionids, zbx_vector
 		if (NULL != tr->new_error)
 			continue;
 
+		if (NULL != tr->expression_code)
+		{
+			zbx_eval_get_functionids(tr->expression_code, functionids);
+
+			if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == tr->recovery_mode)
+				zbx_eval_get_functionids(tr->recovery_expression_code, functionids);
+
+			continue;
+		}
+
 		values_num_save = functionids->values_num;
 
 		if (SUCCEED != extract_expression_functionids(functionids, tr->expression))
@@ -5157,11 +5167,21 @@ static void	zbx_link_triggers_with_functions(zbx_vector_ptr_t *triggers_func_pos
 		if (NULL != tr->new_error)
 			continue;
 
-		ev.value = tr->value;
+		if (NULL != tr->expression_code)
+		{
+			zbx_eval_get_functionids(tr->expression_code, &funcids);
+		}
+		else
+		{
+			ev.value = tr->value;
+
+			expand_trigger_macros(&ev, tr, NULL, 0);
 
-		expand_trigger_macros(&ev, tr, NULL, 0);
+			if (SUCCEED != extract_expression_functionids(&funcids, tr->expression))
+				zbx_vector_uint64_clear(&funcids);
+		}
 
-		if (SUCCEED == extract_expression_functionids(&funcids, tr->expression))
+		if (0 != funcids.values_num)
 		{
 			tr_func_pos = (zbx_trigger_func_position_t *)zbx_malloc(NULL, sizeof(zbx_trigger_func_position_t));
 			tr_func_pos->trigger = tr;
@@ -5512,14 +5532,59 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: get_function_result                                              *
+ *                                                                            *
+ * Purpose: get evaluated function value by function identifier               *
+ *                                                                            *
+ * Parameters: ifuncs     - [IN] function index by functionid                 *
+ *             functionid - [IN] the function identifier                      *
+ *             value      - [OUT] the function value                          *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value: SUCCEED - the function value was returned                    *
+ *               FAIL    - the function was not evaluated                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_function_result(zbx_hashset_t *ifuncs, zbx_uint64_t functionid, const char **value, char **error)
+{
+	zbx_func_t	*func;
+	zbx_ifunc_t	*ifunc;
+
+	if (NULL == (ifunc = (zbx_ifunc_t *)zbx_hashset_search(ifuncs, &functionid)))
+	{
+		*error = zbx_dsprintf(*error, "Cannot obtain function"
+				" and item for functionid: " ZBX_FS_UI64, functionid);
+		return FAIL;
+	}
+
+	func = ifunc->func;
+
+	if (NULL != func->error)
+	{
+		*error = zbx_strdup(*error, func->error);
+		return FAIL;
+	}
+
+	if (NULL == func->value)
+	{
+		*error = zbx_strdup(*error, "Unexpected error while processing a trigger expression");
+		return FAIL;
+	}
+
+	*value = func->value;
+
+	return SUCCEED;
+}
+
 static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *expression, char **out,
 		size_t *out_alloc, char **error)
 {
 	char			*br, *bl;
+	const char		*value;
 	size_t			out_offset = 0;
 	zbx_uint64_t		functionid;
-	zbx_func_t		*func;
-	zbx_ifunc_t		*ifunc;
 
 	for (br = expression, bl = strchr(expression, '{'); NULL != bl; bl = strchr(bl, '{'))
 	{
@@ -5540,35 +5605,17 @@ static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *
 		*br++ = '}';
 		bl = br;
 
-		if (NULL == (ifunc = (zbx_ifunc_t *)zbx_hashset_search(ifuncs, &functionid)))
-		{
-			*error = zbx_dsprintf(*error, "Cannot obtain function"
-					" and item for functionid: " ZBX_FS_UI64, functionid);
+		if (SUCCEED != get_function_result(ifuncs, functionid, &value, error))
 			return FAIL;
-		}
-
-		func = ifunc->func;
 
-		if (NULL != func->error)
-		{
-			*error = zbx_strdup(*error, func->error);
-			return FAIL;
-		}
-
-		if (NULL == func->value)
-		{
-			*error = zbx_strdup(*error, "Unexpected error while processing a trigger expression");
-			return FAIL;
-		}
-
-		if (SUCCEED != is_double_suffix(func->value, ZBX_FLAG_DOUBLE_SUFFIX) || '-' == *func->value)
+		if (SUCCEED != is_double_suffix(value, ZBX_FLAG_DOUBLE_SUFFIX) || '-' == *value)
 		{
 			zbx_chrcpy_alloc(out, out_alloc, &out_offset, '(');
-			zbx_strcpy_alloc(out, out_alloc, &out_offset, func->value);
+			zbx_strcpy_alloc(out, out_alloc, &out_offset, value);
 			zbx_chrcpy_alloc(out, out_alloc, &out_offset, ')');
 		}
 		else
-			zbx_strcpy_alloc(out, out_alloc, &out_offset, func->value);
+			zbx_strcpy_alloc(out, out_alloc, &out_offset, value);
 	}
 
 	zbx_strcpy_alloc(out, out_alloc, &out_offset, br);
@@ -5576,17 +5623,85 @@ static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *
 	return SUCCEED;
 }
 
-static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_ptr_t *triggers)
+/******************************************************************************
+ *                                                                            *
+ * Function: check_expression_functions_results                               *
+ *                                                                            *
+ * Purpose: check that all functions referenced by compiled expression were   *
+ *          evaluated                                                         *
+ *                                                                            *
+ * Parameters: ifuncs      - [IN] function index by functionid                *
+ *             code        - [IN] the compiled expression                     *
+ *             functionids - [IN] vector for temporary data                   *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - all function values are available                  *
+ *               FAIL    - otherwise, the error is the same as returned by    *
+ *                         substitute_expression_functions_results()          *
+ *                                                                            *
+ ******************************************************************************/
+static int	check_expression_functions_results(zbx_hashset_t *ifuncs, const unsigned char *code,
+		zbx_vector_uint64_t *functionids, char **error)
 {
-	DC_TRIGGER	*tr;
-	char		*out = NULL;
-	size_t		out_alloc = TRIGGER_EXPRESSION_LEN_MAX;
+	const char	*value;
 	int		i;
 
+	zbx_vector_uint64_clear(functionids);
+	zbx_eval_get_functionids(code, functionids);
+
+	for (i = 0; i < functionids->values_num; i++)
+	{
+		if (SUCCEED != get_function_result(ifuncs, functionids->values[i], &value, error))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static void	zbx_substitute_trigger_functions_results(zbx_hashset_t *ifuncs, DC_TRIGGER *tr, char **out,
+		size_t *out_alloc)
+{
+	if (SUCCEED != substitute_expression_functions_results(ifuncs, tr->expression, out, out_alloc,
+			&tr->new_error))
+	{
+		tr->new_value = TRIGGER_VALUE_UNKNOWN;
+		return;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() expression[" ZBX_FS_UI64 "]:'%s' => '%s'", __func__, tr->triggerid,
+			tr->expression, *out);
+
+	tr->expression = zbx_strdup(tr->expression, *out);
+
+	if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == tr->recovery_mode)
+	{
+		if (SUCCEED != substitute_expression_functions_results(ifuncs, tr->recovery_expression, out,
+				out_alloc, &tr->new_error))
+		{
+			tr->new_value = TRIGGER_VALUE_UNKNOWN;
+			return;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() recovery_expression[" ZBX_FS_UI64 "]:'%s' => '%s'", __func__,
+				tr->triggerid, tr->recovery_expression, *out);
+
+		tr->recovery_expression = zbx_strdup(tr->recovery_expression, *out);
+	}
+}
+
+static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_ptr_t *triggers)
+{
+	DC_TRIGGER		*tr;
+	char			*out = NULL;
+	size_t			out_alloc = TRIGGER_EXPRESSION_LEN_MAX;
+	int			i;
+	zbx_vector_uint64_t	functionids;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() ifuncs_num:%d tr_num:%d",
 			__func__, ifuncs->num_data, triggers->values_num);
 
 	out = (char *)zbx_malloc(out, out_alloc);
+	zbx_vector_uint64_create(&functionids);
 
 	for (i = 0; i < triggers->values_num; i++)
 	{
@@ -5595,33 +5710,28 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
 		if (NULL != tr->new_error)
 			continue;
 
-		if( SUCCEED != substitute_expression_functions_results(ifuncs, tr->expression, &out, &out_alloc,
-				&tr->new_error))
-		{
-			tr->new_value = TRIGGER_VALUE_UNKNOWN;
-			continue;
-		}
-
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() expression[%d]:'%s' => '%s'", __func__, i, tr->expression, out);
-
-		tr->expression = zbx_strdup(tr->expression, out);
-
-		if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == tr->recovery_mode)
+		/* compiled expressions are evaluated with function values directly */
+		if (NULL != tr->expression_code)
 		{
-			if (SUCCEED != substitute_expression_functions_results(ifuncs,
-					tr->recovery_expression, &out, &out_alloc, &tr->new_error))
+			if (SUCCEED != check_expression_functions_results(ifuncs, tr->expression_code, &functionids,
+					&tr->new_error))
+			{
+				tr->new_value = TRIGGER_VALUE_UNKNOWN;
+			}
+			else if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == tr->recovery_mode &&
+					SUCCEED != check_expression_functions_results(ifuncs,
+					tr->recovery_expression_code, &functionids, &tr->new_error))
 			{
 				tr->new_value = TRIGGER_VALUE_UNKNOWN;
-				continue;
 			}
 
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() recovery_expression[%d]:'%s' => '%s'", __func__, i,
-					tr->recovery_expression, out);
-
-			tr->recovery_expression = zbx_strdup(tr->recovery_expression, out);
+			continue;
 		}
+
+		zbx_substitute_trigger_functions_results(ifuncs, tr, &out, &out_alloc);
 	}
 
+	zbx_vector_uint64_destroy(&functionids);
 	zbx_free(out);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -5633,8 +5743,11 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
  *                                                                            *
  * Purpose: substitute expression functions with their values                 *
  *                                                                            *
- * Parameters: triggers - [IN] vector of DC_TRIGGER pointers, sorted by      *
- *                             triggerids                                     *
+ * Parameters: triggers     - [IN] vector of DC_TRIGGER pointers, sorted by  *
+ *                                 triggerids                                 *
+ *             funcs        - [OUT] functions indexed by itemid, name,        *
+ *                                  parameter, timestamp                      *
+ *             ifuncs       - [OUT] function index by functionid              *
  *             unknown_msgs - vector for storing messages for NOTSUPPORTED    *
  *                            items and failed functions                      *
  *                                                                            *
@@ -5643,10 +5756,10 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
  * Comments: example: "({15}>10) or ({123}=1)" => "(26.416>10) or (0=1)"      *
  *                                                                            *
  ******************************************************************************/
-static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *unknown_msgs)
+static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_hashset_t *funcs, zbx_hashset_t *ifuncs,
+		zbx_vector_ptr_t *unknown_msgs)
 {
 	zbx_vector_uint64_t	functionids;
-	zbx_hashset_t		ifuncs, funcs;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -5656,28 +5769,106 @@ static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *u
 	if (0 == functionids.values_num)
 		goto empty;
 
-	zbx_hashset_create(&ifuncs, triggers->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_populate_function_items(&functionids, funcs, ifuncs, triggers);
 
-	zbx_hashset_create_ext(&funcs, triggers->values_num, func_hash_func, func_compare_func, func_clean,
-				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
-
-	zbx_populate_function_items(&functionids, &funcs, &ifuncs, triggers);
-
-	if (0 != ifuncs.num_data)
+	if (0 != ifuncs->num_data)
 	{
-		zbx_evaluate_item_functions(&funcs, unknown_msgs);
-		zbx_substitute_functions_results(&ifuncs, triggers);
+		zbx_evaluate_item_functions(funcs, unknown_msgs);
+		zbx_substitute_functions_results(ifuncs, triggers);
 	}
-
-	zbx_hashset_destroy(&ifuncs);
-	zbx_hashset_destroy(&funcs);
 empty:
 	zbx_vector_uint64_destroy(&functionids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+typedef struct
+{
+	zbx_hashset_t	*ifuncs;
+	char		trigger_value[MAX_ID_LEN + 1];
+}
+zbx_trigger_eval_t;
+
+static const char	*trigger_function_value(zbx_uint64_t functionid, void *data)
+{
+	zbx_trigger_eval_t	*eval = (zbx_trigger_eval_t *)data;
+	zbx_ifunc_t		*ifunc;
+
+	if (ZBX_EVAL_TRIGGER_VALUE_ID == functionid)
+		return eval->trigger_value;
+
+	if (NULL == (ifunc = (zbx_ifunc_t *)zbx_hashset_search(eval->ifuncs, &functionid)))
+		return NULL;
+
+	return ifunc->func->value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: evaluate_trigger_expression                                      *
+ *                                                                            *
+ * Purpose: evaluate trigger problem or recovery expression                   *
+ *                                                                            *
+ * Parameters: ifuncs       - [IN] function index by functionid               *
+ *             tr           - [IN/OUT] the trigger                            *
+ *             recovery     - [IN] 1 - evaluate recovery expression,          *
+ *                                 0 - evaluate problem expression            *
+ *             value        - [OUT] expression evaluation result              *
+ *             error        - [OUT] error message buffer                      *
+ *             max_error_len - [IN] error buffer size                         *
+ *             unknown_msgs - [IN] messages about origins of 'unknown' values *
+ *                                                                            *
+ * Return value: SUCCEED - expression evaluated successfully                  *
+ *               FAIL    - expression evaluation failed                       *
+ *                                                                            *
+ * Comments: Compiled expressions are executed with function values plugged   *
+ *           in. If the compiled code cannot reproduce text evaluation result *
+ *           for the current function values, the trigger expressions are     *
+ *           substituted and evaluated as text instead.                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	evaluate_trigger_expression(zbx_hashset_t *ifuncs, DC_TRIGGER *tr, int recovery, double *value,
+		char *error, size_t max_error_len, zbx_vector_ptr_t *unknown_msgs)
+{
+	if (NULL != tr->expression_code)
+	{
+		zbx_trigger_eval_t	eval;
+		DB_EVENT		event;
+		int			ret;
+		char			*out = NULL;
+		size_t			out_alloc = 0;
+
+		eval.ifuncs = ifuncs;
+		zbx_snprintf(eval.trigger_value, sizeof(eval.trigger_value), "%d", tr->value);
+
+		if (NOTSUPPORTED != (ret = zbx_eval_execute(0 == recovery ? tr->expression_code :
+				tr->recovery_expression_code, trigger_function_value, &eval, value, error,
+				max_error_len, unknown_msgs)))
+		{
+			return ret;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() triggerid:" ZBX_FS_UI64 " falling back to text evaluation",
+				__func__, tr->triggerid);
+
+		zbx_free(tr->expression_code);
+		zbx_free(tr->recovery_expression_code);
+
+		event.object = EVENT_OBJECT_TRIGGER;
+		event.value = tr->value;
+		expand_trigger_macros(&event, tr, NULL, 0);
+
+		if (0 != ifuncs->num_data)
+		{
+			zbx_substitute_trigger_functions_results(ifuncs, tr, &out, &out_alloc);
+			zbx_free(out);
+		}
+	}
+
+	return evaluate(value, 0 == recovery ? tr->expression : tr->recovery_expression, error, max_error_len,
+			unknown_msgs);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_expressions                                             *
@@ -5698,6 +5889,7 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 	double			expr_result;
 	zbx_vector_ptr_t	unknown_msgs;	    /* pointers to messages about origins of 'unknown' values */
 	char			err[MAX_STRING_LEN];
+	zbx_hashset_t		ifuncs, funcs;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() tr_num:%d", __func__, triggers->values_num);
 
@@ -5707,6 +5899,19 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 	{
 		tr = (DC_TRIGGER *)triggers->values[i];
 
+		/* compiled expressions reference only functions and {TRIGGER.VALUE} macro, */
+		/* which is resolved during execution                                       */
+		if (NULL != tr->expression_code)
+		{
+			if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION != tr->recovery_mode ||
+					NULL != tr->recovery_expression_code)
+			{
+				continue;
+			}
+
+			zbx_free(tr->expression_code);
+		}
+
 		event.value = tr->value;
 
 		if (SUCCEED != expand_trigger_macros(&event, tr, err, sizeof(err)))
@@ -5720,7 +5925,13 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 	/* Therefore initialize error messages vector but do not reserve any space. */
 	zbx_vector_ptr_create(&unknown_msgs);
 
-	substitute_functions(triggers, &unknown_msgs);
+	zbx_hashset_create(&ifuncs, triggers->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_hashset_create_ext(&funcs, triggers->values_num, func_hash_func, func_compare_func, func_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	substitute_functions(triggers, &funcs, &ifuncs, &unknown_msgs);
 
 	/* calculate new trigger values based on their recovery modes and expression evaluations */
 	for (i = 0; i < triggers->values_num; i++)
@@ -5730,7 +5941,8 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 		if (NULL != tr->new_error)
 			continue;
 
-		if (SUCCEED != evaluate(&expr_result, tr->expression, err, sizeof(err), &unknown_msgs))
+		if (SUCCEED != evaluate_trigger_expression(&ifuncs, tr, 0, &expr_result, err, sizeof(err),
+				&unknown_msgs))
 		{
 			tr->new_error = zbx_strdup(tr->new_error, err);
 			tr->new_value = TRIGGER_VALUE_UNKNOWN;
@@ -5763,7 +5975,8 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 			}
 
 			/* processing recovery expression mode */
-			if (SUCCEED != evaluate(&expr_result, tr->recovery_expression, err, sizeof(err), &unknown_msgs))
+			if (SUCCEED != evaluate_trigger_expression(&ifuncs, tr, 1, &expr_result, err, sizeof(err),
+					&unknown_msgs))
 			{
 				tr->new_error = zbx_strdup(tr->new_error, err);
 				tr->new_value = TRIGGER_VALUE_UNKNOWN;
@@ -5781,6 +5994,9 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 		tr->new_value = TRIGGER_VALUE_NONE;
 	}
 
+	zbx_hashset_destroy(&ifuncs);
+	zbx_hashset_destroy(&funcs);
+
 	zbx_vector_ptr_clear_ext(&unknown_msgs, zbx_ptr_free);
 	zbx_vector_ptr_destroy(&unknown_msgs);
 
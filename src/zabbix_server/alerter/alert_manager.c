@@ -404,6 +404,8 @@ static void	zbx_am_update_webhook(zbx_am_t *manager, zbx_am_mediatype_t *mediaty
 
 	if (NULL == mediatype->script || 0 != strcmp(mediatype->script, script))
 	{
+		const char	*script_bin;
+
 		if (SUCCEED != zbx_es_is_env_initialized(&manager->es))
 		{
 			if (SUCCEED != zbx_es_init_env(&manager->es, &mediatype->error))
@@ -411,11 +413,13 @@ static void	zbx_am_update_webhook(zbx_am_t *manager, zbx_am_mediatype_t *mediaty
 		}
 
 		zbx_free(mediatype->script_bin);
-		if (SUCCEED != zbx_es_compile(&manager->es, script, &mediatype->script_bin, &mediatype->script_bin_sz,
+		if (SUCCEED != zbx_es_compile_cached(&manager->es, script, &script_bin, &mediatype->script_bin_sz,
 				&mediatype->error))
 		{
 			return;
 		}
+		mediatype->script_bin = (char *)zbx_malloc(NULL, mediatype->script_bin_sz);
+		memcpy(mediatype->script_bin, script_bin, mediatype->script_bin_sz);
 		mediatype->script = zbx_strdup(mediatype->script, script);
 	}
 }
@@ -36,7 +36,8 @@ void	scriptitem_es_engine_destroy(void)
 
 int	get_value_script(DC_ITEM *item, AGENT_RESULT *result)
 {
-	char		*error = NULL, *script_bin = NULL, *output = NULL;
+	char		*error = NULL, *output = NULL;
+	const char	*script_bin;
 	int		script_bin_sz, timeout_seconds, ret = NOTSUPPORTED;
 
 	if (FAIL == is_time_suffix(item->timeout, &timeout_seconds, strlen(item->timeout)))
@@ -51,7 +52,7 @@ int	get_value_script(DC_ITEM *item, AGENT_RESULT *result)
 		return ret;
 	}
 
-	if (SUCCEED != zbx_es_compile(&es_engine, item->params, &script_bin, &script_bin_sz, &error))
+	if (SUCCEED != zbx_es_compile_cached(&es_engine, item->params, &script_bin, &script_bin_sz, &error))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot compile script: %s", error));
 		goto err;
@@ -81,7 +82,6 @@ err:
 		}
 	}
 
-	zbx_free(script_bin);
 	zbx_free(error);
 
 	return ret;
@@ -35,6 +35,30 @@
 
 extern zbx_es_t	es_engine;
 
+/* pre-calculated jsonpath query result */
+typedef struct
+{
+	char	*path;
+	char	*output;
+	char	*error;
+}
+zbx_preproc_jsonpath_result_t;
+
+/* master item value shared by dependent items, parsed once for their first preprocessing steps */
+typedef struct
+{
+	const char		*data;		/* the document text */
+	const char		*value;		/* the bound value text, NULL if no value is bound */
+	zbx_hashset_t		jsonpaths;	/* jsonpath query results */
+	void			*xml_doc;	/* the parsed xml document, NULL if not parsed yet */
+	char			*xml_error;	/* the xml document parsing error */
+	zbx_prometheus_t	*prometheus;	/* the indexed prometheus data, NULL if not indexed yet */
+	int			prometheus_num;	/* the number of prometheus steps, 0 if indexing failed */
+}
+zbx_preproc_document_t;
+
+static zbx_preproc_document_t	*preproc_document = NULL;
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_numeric_type_hint                                   *
@@ -785,10 +809,10 @@ static int	item_preproc_hex2dec(zbx_variant_t *value, char **errmsg)
  ******************************************************************************/
 static int	item_preproc_regsub_op(zbx_variant_t *value, const char *params, char **errmsg)
 {
-	char		pattern[ITEM_PREPROC_PARAMS_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1];
-	char		*output, *new_value = NULL;
-	const char	*regex_error;
-	zbx_regexp_t	*regex = NULL;
+	char			pattern[ITEM_PREPROC_PARAMS_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1];
+	char			*output, *new_value = NULL;
+	const char		*regex_error;
+	const zbx_regexp_t	*regex;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
@@ -803,7 +827,8 @@ static int	item_preproc_regsub_op(zbx_variant_t *value, const char *params, char
 
 	*output++ = '\0';
 
-	if (FAIL == zbx_regexp_compile_ext(pattern, &regex, 0, &regex_error))	/* PCRE_MULTILINE is not used here */
+	/* PCRE_MULTILINE is not used here */
+	if (FAIL == zbx_regexp_compile_cached_ext(pattern, &regex, 0, &regex_error))
 	{
 		*errmsg = zbx_dsprintf(*errmsg, "invalid regular expression: %s", regex_error);
 		return FAIL;
@@ -812,15 +837,12 @@ static int	item_preproc_regsub_op(zbx_variant_t *value, const char *params, char
 	if (FAIL == zbx_mregexp_sub_precompiled(value->data.str, regex, output, ZBX_MAX_RECV_DATA_SIZE, &new_value))
 	{
 		*errmsg = zbx_strdup(*errmsg, "pattern does not match");
-		zbx_regexp_free(regex);
 		return FAIL;
 	}
 
 	zbx_variant_clear(value);
 	zbx_variant_set_str(value, new_value);
 
-	zbx_regexp_free(regex);
-
 	return SUCCEED;
 }
 
@@ -859,6 +881,211 @@ static int	item_preproc_regsub(zbx_variant_t *value, const char *params, char **
 	return FAIL;
 }
 
+static zbx_hash_t	preproc_jsonpath_result_hash(const void *data)
+{
+	const zbx_preproc_jsonpath_result_t	*result = (const zbx_preproc_jsonpath_result_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(result->path);
+}
+
+static int	preproc_jsonpath_result_compare(const void *d1, const void *d2)
+{
+	const zbx_preproc_jsonpath_result_t	*r1 = (const zbx_preproc_jsonpath_result_t *)d1;
+	const zbx_preproc_jsonpath_result_t	*r2 = (const zbx_preproc_jsonpath_result_t *)d2;
+
+	return strcmp(r1->path, r2->path);
+}
+
+static void	preproc_jsonpath_result_clear(void *data)
+{
+	zbx_preproc_jsonpath_result_t	*result = (zbx_preproc_jsonpath_result_t *)data;
+
+	zbx_free(result->path);
+	zbx_free(result->output);
+	zbx_free(result->error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_document_match                                      *
+ *                                                                            *
+ * Purpose: check if the value is the currently opened shared document        *
+ *                                                                            *
+ ******************************************************************************/
+static int	item_preproc_document_match(const zbx_variant_t *value)
+{
+	if (NULL == preproc_document || ZBX_VARIANT_STR != value->type)
+		return FAIL;
+
+	if (value->data.str != preproc_document->value)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_item_preproc_document_bind                                   *
+ *                                                                            *
+ * Purpose: bind dependent item value to the opened shared document           *
+ *                                                                            *
+ * Parameters: value - [IN] the dependent item value, a copy of the document  *
+ *                                                                            *
+ * Comments: The next preprocessing step executed on the bound value uses the *
+ *           shared document results. The value is unbound after that step,   *
+ *           as the step can change the value.                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_item_preproc_document_bind(const zbx_variant_t *value)
+{
+	if (NULL == preproc_document)
+		return;
+
+	preproc_document->value = (ZBX_VARIANT_STR == value->type ? value->data.str : NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_document_unbind                                     *
+ *                                                                            *
+ * Purpose: unbind value bound by zbx_item_preproc_document_bind()            *
+ *                                                                            *
+ ******************************************************************************/
+static void	item_preproc_document_unbind(void)
+{
+	if (NULL != preproc_document)
+		preproc_document->value = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_item_preproc_document_open                                   *
+ *                                                                            *
+ * Purpose: open master item value shared by dependent items                  *
+ *                                                                            *
+ * Parameters: value     - [IN] the master item value                         *
+ *             steps     - [IN] the first preprocessing steps of dependent    *
+ *                              items                                         *
+ *             steps_num - [IN] the number of steps                           *
+ *                                                                            *
+ * Comments: JSONPath steps are evaluated in a single pass over the document  *
+ *           and XML document is parsed once on first use. Prometheus data    *
+ *           used by multiple steps is indexed once on first use. The results *
+ *           are used by the first preprocessing steps of values bound with   *
+ *           zbx_item_preproc_document_bind() until the document is closed.   *
+ *           The value must not be changed until then.                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_item_preproc_document_open(const zbx_variant_t *value, const zbx_preproc_op_t **steps, int steps_num)
+{
+	int				i, paths_num;
+	zbx_preproc_jsonpath_result_t	result_local, *result;
+	zbx_hashset_iter_t		iter;
+	zbx_vector_ptr_t		results;
+	const char			**paths;
+	char				**outputs, **errors;
+	struct zbx_json_parse		jp;
+
+	zbx_item_preproc_document_close();
+
+	if (ZBX_VARIANT_STR != value->type)
+		return;
+
+	preproc_document = (zbx_preproc_document_t *)zbx_malloc(NULL, sizeof(zbx_preproc_document_t));
+	preproc_document->data = value->data.str;
+	preproc_document->value = NULL;
+	preproc_document->xml_doc = NULL;
+	preproc_document->xml_error = NULL;
+	preproc_document->prometheus = NULL;
+	preproc_document->prometheus_num = 0;
+	zbx_hashset_create_ext(&preproc_document->jsonpaths, steps_num, preproc_jsonpath_result_hash,
+			preproc_jsonpath_result_compare, preproc_jsonpath_result_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+			ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	for (i = 0; i < steps_num; i++)
+	{
+		if (ZBX_PREPROC_PROMETHEUS_PATTERN == steps[i]->type || ZBX_PREPROC_PROMETHEUS_TO_JSON == steps[i]->type)
+			preproc_document->prometheus_num++;
+
+		if (ZBX_PREPROC_JSONPATH != steps[i]->type)
+			continue;
+
+		result_local.path = steps[i]->params;
+
+		if (NULL != zbx_hashset_search(&preproc_document->jsonpaths, &result_local))
+			continue;
+
+		result_local.path = zbx_strdup(NULL, steps[i]->params);
+		result_local.output = NULL;
+		result_local.error = NULL;
+		zbx_hashset_insert(&preproc_document->jsonpaths, &result_local, sizeof(result_local));
+	}
+
+	if (0 == (paths_num = preproc_document->jsonpaths.num_data))
+		return;
+
+	zbx_vector_ptr_create(&results);
+	zbx_hashset_iter_reset(&preproc_document->jsonpaths, &iter);
+	while (NULL != (result = (zbx_preproc_jsonpath_result_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_ptr_append(&results, result);
+
+	paths = (const char **)zbx_malloc(NULL, sizeof(char *) * paths_num);
+	outputs = (char **)zbx_malloc(NULL, sizeof(char *) * paths_num);
+	errors = (char **)zbx_malloc(NULL, sizeof(char *) * paths_num);
+	memset(outputs, 0, sizeof(char *) * paths_num);
+	memset(errors, 0, sizeof(char *) * paths_num);
+
+	for (i = 0; i < paths_num; i++)
+		paths[i] = ((zbx_preproc_jsonpath_result_t *)results.values[i])->path;
+
+	if (SUCCEED == zbx_json_open(value->data.str, &jp))
+	{
+		zbx_jsonpath_query_multi(&jp, paths, paths_num, outputs, errors);
+	}
+	else
+	{
+		for (i = 0; i < paths_num; i++)
+			errors[i] = zbx_strdup(NULL, zbx_json_strerror());
+	}
+
+	for (i = 0; i < paths_num; i++)
+	{
+		result = (zbx_preproc_jsonpath_result_t *)results.values[i];
+		result->output = outputs[i];
+		result->error = errors[i];
+	}
+
+	zbx_free(errors);
+	zbx_free(outputs);
+	zbx_free(paths);
+	zbx_vector_ptr_destroy(&results);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_item_preproc_document_close                                  *
+ *                                                                            *
+ * Purpose: close shared master item value opened by                          *
+ *          zbx_item_preproc_document_open()                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_item_preproc_document_close(void)
+{
+	if (NULL == preproc_document)
+		return;
+
+	zbx_hashset_destroy(&preproc_document->jsonpaths);
+
+	if (NULL != preproc_document->xml_doc)
+		zbx_xml_doc_close(preproc_document->xml_doc);
+
+	if (NULL != preproc_document->prometheus)
+		zbx_prometheus_index_free(preproc_document->prometheus);
+
+	zbx_free(preproc_document->xml_error);
+	zbx_free(preproc_document);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_jsonpath_op                                         *
@@ -875,13 +1102,28 @@ static int	item_preproc_regsub(zbx_variant_t *value, const char *params, char **
  ******************************************************************************/
 static int	item_preproc_jsonpath_op(zbx_variant_t *value, const char *params, char **errmsg)
 {
-	struct zbx_json_parse	jp;
-	char			*data = NULL;
+	struct zbx_json_parse		jp;
+	char				*data = NULL;
+	zbx_preproc_jsonpath_result_t	*result, result_local;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
 
-	if (FAIL == zbx_json_open(value->data.str, &jp) || FAIL == zbx_jsonpath_query(&jp, params, &data))
+	result_local.path = (char *)params;
+
+	if (SUCCEED == item_preproc_document_match(value) && NULL != (result = (zbx_preproc_jsonpath_result_t *)
+			zbx_hashset_search(&preproc_document->jsonpaths, &result_local)))
+	{
+		if (NULL != result->error)
+		{
+			*errmsg = zbx_strdup(*errmsg, result->error);
+			return FAIL;
+		}
+
+		if (NULL != result->output)
+			data = zbx_strdup(NULL, result->output);
+	}
+	else if (FAIL == zbx_json_open(value->data.str, &jp) || FAIL == zbx_jsonpath_query(&jp, params, &data))
 	{
 		*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
 		return FAIL;
@@ -944,11 +1186,33 @@ static int	item_preproc_jsonpath(zbx_variant_t *value, const char *params, char
 static int	item_preproc_xpath(zbx_variant_t *value, const char *params, char **errmsg)
 {
 	char	*err = NULL;
+	int	ret;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
 
-	if (SUCCEED == zbx_query_xpath(value, params, &err))
+	if (SUCCEED == item_preproc_document_match(value))
+	{
+		/* the shared document is parsed on first use */
+		if (NULL == preproc_document->xml_doc && NULL == preproc_document->xml_error &&
+				SUCCEED != zbx_xml_doc_open(preproc_document->data, &preproc_document->xml_doc,
+				&preproc_document->xml_error))
+		{
+			preproc_document->xml_doc = NULL;
+		}
+
+		if (NULL != preproc_document->xml_error)
+		{
+			err = zbx_strdup(NULL, preproc_document->xml_error);
+			ret = FAIL;
+		}
+		else
+			ret = zbx_query_xpath_doc(preproc_document->xml_doc, value, params, &err);
+	}
+	else
+		ret = zbx_query_xpath(value, params, &err);
+
+	if (SUCCEED == ret)
 		return SUCCEED;
 
 	*errmsg = zbx_dsprintf(*errmsg, "cannot extract XML value with xpath \"%s\": %s", params, err);
@@ -1051,11 +1315,11 @@ out:
  ******************************************************************************/
 static int	item_preproc_validate_regex(const zbx_variant_t *value, const char *params, char **error)
 {
-	zbx_variant_t	value_str;
-	int		ret = FAIL;
-	zbx_regexp_t	*regex;
-	const char	*errptr = NULL;
-	char		*errmsg;
+	zbx_variant_t		value_str;
+	int			ret = FAIL;
+	const zbx_regexp_t	*regex;
+	const char		*errptr = NULL;
+	char			*errmsg;
 
 	zbx_variant_copy(&value_str, value);
 
@@ -1065,7 +1329,7 @@ static int	item_preproc_validate_regex(const zbx_variant_t *value, const char *p
 		goto out;
 	}
 
-	if (FAIL == zbx_regexp_compile(params, &regex, &errptr))
+	if (FAIL == zbx_regexp_compile_cached(params, &regex, &errptr))
 	{
 		errmsg = zbx_dsprintf(NULL, "invalid regular expression pattern: %s", errptr);
 		goto out;
@@ -1075,8 +1339,6 @@ static int	item_preproc_validate_regex(const zbx_variant_t *value, const char *p
 		errmsg = zbx_strdup(NULL, "value does not match regular expression");
 	else
 		ret = SUCCEED;
-
-	zbx_regexp_free(regex);
 out:
 	zbx_variant_clear(&value_str);
 
@@ -1107,11 +1369,11 @@ out:
  ******************************************************************************/
 static int	item_preproc_validate_not_regex(const zbx_variant_t *value, const char *params, char **error)
 {
-	zbx_variant_t	value_str;
-	int		ret = FAIL;
-	zbx_regexp_t	*regex;
-	const char	*errptr = NULL;
-	char		*errmsg;
+	zbx_variant_t		value_str;
+	int			ret = FAIL;
+	const zbx_regexp_t	*regex;
+	const char		*errptr = NULL;
+	char			*errmsg;
 
 	zbx_variant_copy(&value_str, value);
 
@@ -1121,7 +1383,7 @@ static int	item_preproc_validate_not_regex(const zbx_variant_t *value, const cha
 		goto out;
 	}
 
-	if (FAIL == zbx_regexp_compile(params, &regex, &errptr))
+	if (FAIL == zbx_regexp_compile_cached(params, &regex, &errptr))
 	{
 		errmsg = zbx_dsprintf(NULL, "invalid regular expression pattern: %s", errptr);
 		goto out;
@@ -1133,8 +1395,6 @@ static int	item_preproc_validate_not_regex(const zbx_variant_t *value, const cha
 	}
 	else
 		ret = SUCCEED;
-
-	zbx_regexp_free(regex);
 out:
 	zbx_variant_clear(&value_str);
 
@@ -1460,19 +1720,22 @@ static int	item_preproc_throttle_timed_value(zbx_variant_t *value, const zbx_tim
  *                                                                            *
  * Purpose: executes script passed with params                                *
  *                                                                            *
- * Parameters: value    - [IN/OUT] the value to process                       *
- *             params   - [IN] the script to execute                          *
- *             bytecode - [IN] precompiled bytecode, can be NULL              *
- *             errmsg   - [OUT] error message                                 *
+ * Parameters: value  - [IN/OUT] the value to process                         *
+ *             params - [IN] the script to execute                            *
+ *             errmsg - [OUT] error message                                   *
  *                                                                            *
  * Return value: SUCCEED - the value was calculated successfully              *
  *               FAIL - otherwise                                             *
  *                                                                            *
+ * Comments: The script bytecode is taken from the worker bytecode cache, so  *
+ *           the script is compiled only once per worker.                     *
+ *                                                                            *
  ******************************************************************************/
-static int	item_preproc_script(zbx_variant_t *value, const char *params, zbx_variant_t *bytecode, char **errmsg)
+static int	item_preproc_script(zbx_variant_t *value, const char *params, char **errmsg)
 {
-	char	*code, *output = NULL, *error = NULL;
-	int	size;
+	const char	*code;
+	char		*output = NULL, *error = NULL;
+	int		size;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
@@ -1483,17 +1746,8 @@ static int	item_preproc_script(zbx_variant_t *value, const char *params, zbx_var
 			return FAIL;
 	}
 
-	if (ZBX_VARIANT_BIN != bytecode->type)
-	{
-		if (SUCCEED != zbx_es_compile(&es_engine, params, &code, &size, errmsg))
-			goto fail;
-
-		zbx_variant_clear(bytecode);
-		zbx_variant_set_bin(bytecode, zbx_variant_data_bin_create(code, size));
-		zbx_free(code);
-	}
-
-	size = zbx_variant_data_bin_get(bytecode->data.bin, (void **)&code);
+	if (SUCCEED != zbx_es_compile_cached(&es_engine, params, &code, &size, errmsg))
+		goto fail;
 
 	if (SUCCEED == zbx_es_execute(&es_engine, params, code, size, value->data.str, &output, errmsg))
 	{
@@ -1518,6 +1772,38 @@ fail:
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_document_prometheus                                 *
+ *                                                                            *
+ * Purpose: get indexed prometheus data of the opened shared document         *
+ *                                                                            *
+ * Parameters: value - [IN] the value to process                              *
+ *                                                                            *
+ * Return value: the indexed prometheus data or NULL if the value is not the  *
+ *               shared document or it cannot be indexed                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_prometheus_t	*item_preproc_document_prometheus(const zbx_variant_t *value)
+{
+	char	*error = NULL;
+
+	if (SUCCEED != item_preproc_document_match(value))
+		return NULL;
+
+	if (NULL == preproc_document->prometheus && 1 < preproc_document->prometheus_num &&
+			SUCCEED != zbx_prometheus_index_create(&preproc_document->prometheus, preproc_document->data,
+			&error))
+	{
+		/* parsing errors will be reported by filtered data processing */
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot index Prometheus data: %s", error);
+		zbx_free(error);
+		preproc_document->prometheus_num = 0;
+	}
+
+	return preproc_document->prometheus;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_prometheus_pattern                                  *
@@ -1534,8 +1820,10 @@ fail:
  ******************************************************************************/
 static int	item_preproc_prometheus_pattern(zbx_variant_t *value, const char *params, char **errmsg)
 {
-	char	pattern[ITEM_PREPROC_PARAMS_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1], *output, *value_out = NULL,
-		*err = NULL;
+	char			pattern[ITEM_PREPROC_PARAMS_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1], *output,
+				*value_out = NULL, *err = NULL;
+	zbx_prometheus_t	*prom;
+	int			ret;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
@@ -1550,7 +1838,12 @@ static int	item_preproc_prometheus_pattern(zbx_variant_t *value, const char *par
 
 	*output++ = '\0';
 
-	if (FAIL == zbx_prometheus_pattern(value->data.str, pattern, output, &value_out, &err))
+	if (NULL != (prom = item_preproc_document_prometheus(value)))
+		ret = zbx_prometheus_index_pattern(prom, pattern, output, &value_out, &err);
+	else
+		ret = zbx_prometheus_pattern(value->data.str, pattern, output, &value_out, &err);
+
+	if (FAIL == ret)
 	{
 		*errmsg = zbx_dsprintf(*errmsg, "cannot apply Prometheus pattern: %s", err);
 		zbx_free(err);
@@ -1579,12 +1872,19 @@ static int	item_preproc_prometheus_pattern(zbx_variant_t *value, const char *par
  ******************************************************************************/
 static int	item_preproc_prometheus_to_json(zbx_variant_t *value, const char *params, char **errmsg)
 {
-	char	*value_out = NULL, *err = NULL;
+	char			*value_out = NULL, *err = NULL;
+	zbx_prometheus_t	*prom;
+	int			ret;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
 
-	if (FAIL == zbx_prometheus_to_json(value->data.str, params, &value_out, &err))
+	if (NULL != (prom = item_preproc_document_prometheus(value)))
+		ret = zbx_prometheus_index_to_json(prom, params, &value_out, &err);
+	else
+		ret = zbx_prometheus_to_json(value->data.str, params, &value_out, &err);
+
+	if (FAIL == ret)
 	{
 		*errmsg = zbx_dsprintf(*errmsg, "cannot convert Prometheus data to JSON: %s", err);
 		zbx_free(err);
@@ -2103,7 +2403,7 @@ int	zbx_item_preproc(unsigned char value_type, zbx_variant_t *value, const zbx_t
 					error);
 			break;
 		case ZBX_PREPROC_SCRIPT:
-			ret = item_preproc_script(value, op->params, history_value, error);
+			ret = item_preproc_script(value, op->params, error);
 			break;
 		case ZBX_PREPROC_PROMETHEUS_PATTERN:
 			ret = item_preproc_prometheus_pattern(value, op->params, error);
@@ -2128,6 +2428,9 @@ int	zbx_item_preproc(unsigned char value_type, zbx_variant_t *value, const zbx_t
 			ret = FAIL;
 	}
 
+	/* only the first step can use shared document - the value can be changed by the step */
+	item_preproc_document_unbind();
+
 	return ret;
 }
 
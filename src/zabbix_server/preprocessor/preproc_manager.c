@@ -32,12 +32,18 @@
 #include "preprocessing.h"
 #include "preproc_manager.h"
 #include "zbxalgo.h"
+#include "zbxregexp.h"
 #include "preproc_history.h"
+#include "item_preproc.h"
 
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num, CONFIG_PREPROCESSOR_FORKS;
 
 #define ZBX_PREPROCESSING_MANAGER_DELAY	1
+#define ZBX_PREPROCESSING_RING_BATCH	16	/* ring records processed before handling other messages */
+#define ZBX_PREPROCESSING_BATCH_MAX	32	/* maximum number of values sent to worker in one message */
+#define ZBX_PREPROCESSING_DEPENDENT_MAX	256	/* maximum number of dependent item values sharing master */
+						/* value sent to worker in one message                   */
 
 #define ZBX_PREPROC_PRIORITY_NONE	0
 #define ZBX_PREPROC_PRIORITY_FIRST	1
@@ -68,8 +74,10 @@ zbx_preprocessing_request_t;
 /* preprocessing worker data */
 typedef struct
 {
-	zbx_ipc_client_t	*client;	/* the connected preprocessing worker client */
-	void			*task;		/* the current task data */
+	zbx_ipc_client_t		*client;	/* the connected preprocessing worker client */
+	void				*task;		/* the current direct request */
+	zbx_vector_ptr_t		tasks;		/* the queued items of the current value batch */
+	zbx_preproc_cache_stats_t	cache_stats;	/* the last reported worker cache statistics */
 }
 zbx_preprocessing_worker_t;
 
@@ -106,11 +114,14 @@ typedef struct
 
 	zbx_list_t			direct_queue;	/* Queue of external requests that have to be */
 							/* forwarded to workers for preprocessing.    */
+	zbx_vector_ptr_t		pending_rings;	/* shared memory rings with unprocessed data */
 }
 zbx_preprocessing_manager_t;
 
 static void	preprocessor_enqueue_dependent(zbx_preprocessing_manager_t *manager,
 		zbx_preproc_item_value_t *source_value, zbx_list_item_t *master);
+static int	preprocessor_set_variant_result(zbx_preprocessing_request_t *request,
+		zbx_variant_t *value, char *error);
 
 /* cleanup functions */
 
@@ -199,6 +210,36 @@ static void	preprocessor_sync_configuration(zbx_preprocessing_manager_t *manager
 			manager->item_config.num_data, manager->history_cache.num_data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_request_value                                   *
+ *                                                                            *
+ * Purpose: get request value to be preprocessed                              *
+ *                                                                            *
+ * Parameters: request - [IN] preprocessing request                           *
+ *             value   - [OUT] the value                                      *
+ *                                                                            *
+ * Comments: String values are not copied and must not be freed or modified.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_get_request_value(const zbx_preprocessing_request_t *request, zbx_variant_t *value)
+{
+	if (ITEM_STATE_NOTSUPPORTED == request->value.state)
+		zbx_variant_set_str(value, "");
+	else if (ISSET_LOG(request->value.result_ptr->result))
+		zbx_variant_set_str(value, request->value.result_ptr->result->log->value);
+	else if (ISSET_UI64(request->value.result_ptr->result))
+		zbx_variant_set_ui64(value, request->value.result_ptr->result->ui64);
+	else if (ISSET_DBL(request->value.result_ptr->result))
+		zbx_variant_set_dbl(value, request->value.result_ptr->result->dbl);
+	else if (ISSET_STR(request->value.result_ptr->result))
+		zbx_variant_set_str(value, request->value.result_ptr->result->str);
+	else if (ISSET_TEXT(request->value.result_ptr->result))
+		zbx_variant_set_str(value, request->value.result_ptr->result->text);
+	else
+		THIS_SHOULD_NEVER_HAPPEN;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_create_task                                         *
@@ -207,30 +248,23 @@ static void	preprocessor_sync_configuration(zbx_preprocessing_manager_t *manager
  *                                                                            *
  * Parameters: manager - [IN] preprocessing manager                           *
  *             request - [IN] preprocessing request                           *
+ *             shared  - [IN] 1 - the value is the same as the value of the   *
+ *                                previous task in the batch and is not sent  *
+ *                            0 - otherwise                                   *
  *             task    - [OUT] preprocessing task data                        *
  *                                                                            *
  ******************************************************************************/
 static zbx_uint32_t	preprocessor_create_task(zbx_preprocessing_manager_t *manager,
-		zbx_preprocessing_request_t *request, unsigned char **task)
+		zbx_preprocessing_request_t *request, int shared, unsigned char **task)
 {
 	zbx_variant_t		value;
 	zbx_preproc_history_t	*vault;
 	zbx_vector_ptr_t	*phistory;
 
-	if (ITEM_STATE_NOTSUPPORTED == request->value.state)
-		zbx_variant_set_str(&value, "");
-	else if (ISSET_LOG(request->value.result_ptr->result))
-		zbx_variant_set_str(&value, request->value.result_ptr->result->log->value);
-	else if (ISSET_UI64(request->value.result_ptr->result))
-		zbx_variant_set_ui64(&value, request->value.result_ptr->result->ui64);
-	else if (ISSET_DBL(request->value.result_ptr->result))
-		zbx_variant_set_dbl(&value, request->value.result_ptr->result->dbl);
-	else if (ISSET_STR(request->value.result_ptr->result))
-		zbx_variant_set_str(&value, request->value.result_ptr->result->str);
-	else if (ISSET_TEXT(request->value.result_ptr->result))
-		zbx_variant_set_str(&value, request->value.result_ptr->result->text);
+	if (0 == shared)
+		preprocessor_get_request_value(request, &value);
 	else
-		THIS_SHOULD_NEVER_HAPPEN;
+		zbx_variant_set_none(&value);
 
 	if (NULL != (vault = (zbx_preproc_history_t *)zbx_hashset_search(&manager->history_cache,
 				&request->value.itemid)))
@@ -274,6 +308,57 @@ static	void	preprocessor_set_request_state_done(zbx_preprocessing_manager_t *man
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_batch_size                                      *
+ *                                                                            *
+ * Purpose: get number of values to be sent to worker in one message          *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *                                                                            *
+ * Comments: With short queue values are sent one by one to keep latency low, *
+ *           batches grow with the number of values waiting for workers.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_get_batch_size(const zbx_preprocessing_manager_t *manager)
+{
+	zbx_uint64_t	size;
+
+	size = manager->preproc_num / (zbx_uint64_t)manager->worker_count;
+
+	if (1 > size)
+		return 1;
+
+	if (ZBX_PREPROCESSING_BATCH_MAX < size)
+		return ZBX_PREPROCESSING_BATCH_MAX;
+
+	return (int)size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_batch_has_item                                      *
+ *                                                                            *
+ * Purpose: check if worker batch already has value of the specified item     *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_batch_has_item(const zbx_vector_ptr_t *tasks, zbx_uint64_t itemid)
+{
+	int	i;
+
+	for (i = 0; i < tasks->values_num; i++)
+	{
+		const zbx_preprocessing_request_t	*request;
+
+		request = (const zbx_preprocessing_request_t *)((const zbx_list_item_t *)tasks->values[i])->data;
+
+		if (request->value.itemid == itemid)
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_get_next_task                                       *
@@ -281,17 +366,28 @@ static	void	preprocessor_set_request_state_done(zbx_preprocessing_manager_t *man
  * Purpose: gets next task to be sent to worker                               *
  *                                                                            *
  * Parameters: manager - [IN] preprocessing manager                           *
+ *             worker  - [IN] the worker to assign task to                    *
  *             message - [OUT] the serialized task to be sent                 *
  *                                                                            *
- * Return value: pointer to the task object                                   *
+ * Return value: SUCCEED - the task was assigned to worker                    *
+ *               FAIL    - there are no tasks to process                      *
+ *                                                                            *
+ * Comments: Item values are sent in batches of different items, the batch is *
+ *           stored in worker tasks vector. Dependent items of the same       *
+ *           master value are kept in one batch so that worker can parse the  *
+ *           master value once, the value itself is sent only once.           *
  *                                                                            *
  ******************************************************************************/
-static void	*preprocessor_get_next_task(zbx_preprocessing_manager_t *manager, zbx_ipc_message_t *message)
+static int	preprocessor_get_next_task(zbx_preprocessing_manager_t *manager, zbx_preprocessing_worker_t *worker,
+		zbx_ipc_message_t *message)
 {
 	zbx_list_iterator_t			iterator;
 	zbx_preprocessing_request_t		*request = NULL;
-	void					*task = NULL;
 	zbx_preprocessing_direct_request_t	*direct_request;
+	int					batch_size, ret = SUCCEED;
+	unsigned char				*task;
+	zbx_uint32_t				task_size, data_alloc = 0, data_offset = 0;
+	const zbx_result_ptr_t			*last_result = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -299,10 +395,13 @@ static void	*preprocessor_get_next_task(zbx_preprocessing_manager_t *manager, zb
 	{
 		*message = direct_request->message;
 		zbx_ipc_message_init(&direct_request->message);
-		task = direct_request;
+		worker->task = direct_request;
 		goto out;
 	}
 
+	batch_size = preprocessor_get_batch_size(manager);
+	message->data = NULL;
+
 	zbx_list_iterator_init(&manager->queue, &iterator);
 	while (SUCCEED == zbx_list_iterator_next(&iterator))
 	{
@@ -313,6 +412,12 @@ static void	*preprocessor_get_next_task(zbx_preprocessing_manager_t *manager, zb
 		if (REQUEST_STATE_QUEUED != request->state)
 			continue;
 
+		if (batch_size <= worker->tasks.values_num && (request->value.result_ptr != last_result ||
+				ZBX_PREPROCESSING_DEPENDENT_MAX <= worker->tasks.values_num))
+		{
+			break;
+		}
+
 		if (NULL != request->steps && ZBX_PREPROC_VALIDATE_NOT_SUPPORTED == request->steps[0].type)
 			process_notsupported = 1;
 
@@ -333,17 +438,34 @@ static void	*preprocessor_get_next_task(zbx_preprocessing_manager_t *manager, zb
 			continue;
 		}
 
-		task = iterator.current;
+		/* values of the same item are left for the next batch */
+		if (SUCCEED == preprocessor_batch_has_item(&worker->tasks, request->value.itemid))
+			continue;
+
 		request->state = REQUEST_STATE_PROCESSING;
-		message->code = ZBX_IPC_PREPROCESSOR_REQUEST;
-		message->size = preprocessor_create_task(manager, request, &message->data);
+		task_size = preprocessor_create_task(manager, request, request->value.result_ptr == last_result, &task);
+		zbx_preprocessor_pack_batch_item(&message->data, &data_alloc, &data_offset, task, task_size);
+		zbx_free(task);
 		request_free_steps(request);
-		break;
+
+		zbx_vector_ptr_append(&worker->tasks, iterator.current);
+
+		/* dependent items share master item result */
+		last_result = (1 < request->value.result_ptr->refcount ? request->value.result_ptr : NULL);
 	}
+
+	if (0 == worker->tasks.values_num)
+	{
+		ret = FAIL;
+		goto out;
+	}
+
+	message->code = ZBX_IPC_PREPROCESSOR_REQUEST;
+	message->size = data_offset;
 out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() values:%d", __func__, worker->tasks.values_num);
 
-	return task;
+	return ret;
 }
 
 static void	preproc_item_result_free(zbx_preproc_item_value_t *value)
@@ -414,7 +536,7 @@ static zbx_preprocessing_worker_t	*preprocessor_get_free_worker(zbx_preprocessin
 
 	for (i = 0; i < manager->worker_count; i++)
 	{
-		if (NULL == manager->workers[i].task)
+		if (NULL == manager->workers[i].task && 0 == manager->workers[i].tasks.values_num)
 			return &manager->workers[i];
 	}
 
@@ -433,13 +555,12 @@ static zbx_preprocessing_worker_t	*preprocessor_get_free_worker(zbx_preprocessin
 static void	preprocessor_assign_tasks(zbx_preprocessing_manager_t *manager)
 {
 	zbx_preprocessing_worker_t	*worker;
-	void				*data;
 	zbx_ipc_message_t		message;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	while (NULL != (worker = preprocessor_get_free_worker(manager)) &&
-			NULL != (data = preprocessor_get_next_task(manager, &message)))
+			SUCCEED == preprocessor_get_next_task(manager, worker, &message))
 	{
 		if (FAIL == zbx_ipc_client_send(worker->client, message.code, message.data, message.size))
 		{
@@ -447,7 +568,6 @@ static void	preprocessor_assign_tasks(zbx_preprocessing_manager_t *manager)
 			exit(EXIT_FAILURE);
 		}
 
-		worker->task = data;
 		zbx_ipc_message_clean(&message);
 	}
 
@@ -639,6 +759,172 @@ static void	preprocessor_copy_value(zbx_preproc_item_value_t *target, zbx_prepro
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_update_history                                      *
+ *                                                                            *
+ * Purpose: replace item preprocessing history with the new history returned  *
+ *          by preprocessing                                                  *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             itemid  - [IN] the item identifier                             *
+ *             history - [IN/OUT] the new preprocessing history, the history  *
+ *                                records are moved to manager cache          *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_update_history(zbx_preprocessing_manager_t *manager, zbx_uint64_t itemid,
+		zbx_vector_ptr_t *history)
+{
+	zbx_preproc_history_t	*vault;
+
+	if (NULL != (vault = (zbx_preproc_history_t *)zbx_hashset_search(&manager->history_cache, &itemid)))
+		zbx_vector_ptr_clear_ext(&vault->history, (zbx_clean_func_t)zbx_preproc_op_history_free);
+
+	if (0 != history->values_num)
+	{
+		if (NULL == vault)
+		{
+			zbx_preproc_history_t	history_local;
+
+			history_local.itemid = itemid;
+			vault = (zbx_preproc_history_t *)zbx_hashset_insert(&manager->history_cache, &history_local,
+					sizeof(history_local));
+			zbx_vector_ptr_create(&vault->history);
+		}
+
+		zbx_vector_ptr_append_array(&vault->history, history->values, history->values_num);
+		zbx_vector_ptr_clear(history);
+	}
+	else
+	{
+		if (NULL != vault)
+		{
+			zbx_vector_ptr_destroy(&vault->history);
+			zbx_hashset_remove_direct(&manager->history_cache, vault);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_is_inline_step                                      *
+ *                                                                            *
+ * Purpose: check if preprocessing step is cheap enough to be executed by     *
+ *          manager itself                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_is_inline_step(unsigned char type)
+{
+	switch (type)
+	{
+		case ZBX_PREPROC_MULTIPLIER:
+		case ZBX_PREPROC_RTRIM:
+		case ZBX_PREPROC_LTRIM:
+		case ZBX_PREPROC_TRIM:
+		case ZBX_PREPROC_BOOL2DEC:
+		case ZBX_PREPROC_OCT2DEC:
+		case ZBX_PREPROC_HEX2DEC:
+		case ZBX_PREPROC_DELTA_VALUE:
+		case ZBX_PREPROC_DELTA_SPEED:
+		case ZBX_PREPROC_VALIDATE_RANGE:
+		case ZBX_PREPROC_THROTTLE_VALUE:
+		case ZBX_PREPROC_THROTTLE_TIMED_VALUE:
+			return SUCCEED;
+		default:
+			return FAIL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_is_inline_request                                   *
+ *                                                                            *
+ * Purpose: check if preprocessing request can be processed by manager        *
+ *          without passing it to worker                                      *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             request - [IN] preprocessing request                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_is_inline_request(zbx_preprocessing_manager_t *manager,
+		const zbx_preprocessing_request_t *request)
+{
+	int	i;
+
+	if (ITEM_STATE_NOTSUPPORTED == request->value.state || 0 == request->steps_num)
+		return FAIL;
+
+	for (i = 0; i < request->steps_num; i++)
+	{
+		if (SUCCEED != preprocessor_is_inline_step(request->steps[i].type))
+			return FAIL;
+	}
+
+	/* value of the same item is still being processed by worker, the history is not ready yet */
+	if (NULL != zbx_hashset_search(&manager->linked_items, &request->value.itemid))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_execute_inline                                      *
+ *                                                                            *
+ * Purpose: execute preprocessing steps of request by manager                 *
+ *                                                                            *
+ * Parameters: manager     - [IN] preprocessing manager                       *
+ *             request     - [IN] preprocessing request                       *
+ *             enqueued_at - [IN] position of request in value queue          *
+ *                                                                            *
+ * Comments: The request is marked as done and its dependent items are        *
+ *           enqueued after it, like with results returned by workers.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_execute_inline(zbx_preprocessing_manager_t *manager, zbx_preprocessing_request_t *request,
+		zbx_list_item_t *enqueued_at)
+{
+	zbx_variant_t		value, value_in;
+	zbx_vector_ptr_t	history_in, history_out;
+	zbx_preproc_history_t	*vault;
+	char			*error = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid: " ZBX_FS_UI64, __func__, request->value.itemid);
+
+	zbx_vector_ptr_create(&history_in);
+	zbx_vector_ptr_create(&history_out);
+
+	/* the request value is referenced from item result, work on a copy */
+	preprocessor_get_request_value(request, &value_in);
+	zbx_variant_copy(&value, &value_in);
+
+	if (NULL != (vault = (zbx_preproc_history_t *)zbx_hashset_search(&manager->history_cache,
+			&request->value.itemid)))
+	{
+		zbx_vector_ptr_append_array(&history_in, vault->history.values, vault->history.values_num);
+		zbx_vector_ptr_clear(&vault->history);
+	}
+
+	zbx_item_preproc_execute(request->value_type, &value, request->value.ts, request->steps, request->steps_num,
+			&history_in, &history_out, &error);
+	request_free_steps(request);
+
+	preprocessor_update_history(manager, request->value.itemid, &history_out);
+	preprocessor_set_request_state_done(manager, request, enqueued_at);
+	manager->preproc_num--;
+
+	if (FAIL != preprocessor_set_variant_result(request, &value, error))
+		preprocessor_enqueue_dependent(manager, &request->value, enqueued_at);
+
+	zbx_variant_clear(&value);
+
+	zbx_vector_ptr_clear_ext(&history_in, (zbx_clean_func_t)zbx_preproc_op_history_free);
+	zbx_vector_ptr_destroy(&history_in);
+	zbx_vector_ptr_destroy(&history_out);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_enqueue                                             *
@@ -758,14 +1044,22 @@ static void	preprocessor_enqueue(zbx_preprocessing_manager_t *manager, zbx_prepr
 			zbx_list_iterator_next(&manager->priority_tail);
 	}
 
-	if (REQUEST_STATE_QUEUED == request->state)
-		preprocessor_link_items(manager, enqueued_at, item);
+	manager->queued_num++;
 
-	/* if no preprocessing is needed, dependent items are enqueued */
-	if (REQUEST_STATE_DONE == request->state)
+	if (REQUEST_STATE_QUEUED == request->state)
+	{
+		/* lightweight steps are executed right away instead of passing the value to worker */
+		if (SUCCEED == preprocessor_is_inline_request(manager, request))
+			preprocessor_execute_inline(manager, request, enqueued_at);
+		else
+			preprocessor_link_items(manager, enqueued_at, item);
+	}
+	else if (REQUEST_STATE_DONE == request->state)
+	{
+		/* if no preprocessing is needed, dependent items are enqueued */
 		preprocessor_enqueue_dependent(manager, value, enqueued_at);
+	}
 
-	manager->queued_num++;
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -808,8 +1102,10 @@ static void	preprocessor_enqueue_dependent(zbx_preprocessing_manager_t *manager,
 				preprocessor_enqueue(manager, &value, master);
 			}
 
+			/* The queue is not flushed here - dependent items without preprocessing or with */
+			/* inline preprocessing are enqueued recursively and flushing could free master  */
+			/* item of the outer call. Callers flush the queue after enqueuing values.       */
 			preprocessor_assign_tasks(manager);
-			preprocessing_flush_queue(manager);
 		}
 	}
 
@@ -847,6 +1143,99 @@ static void	preprocessor_add_request(zbx_preprocessing_manager_t *manager, zbx_i
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+#ifdef ZBX_IPC_RING_ENABLED
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_drain_ring                                          *
+ *                                                                            *
+ * Purpose: handle preprocessing requests queued in shared memory ring of     *
+ *          data gathering process                                            *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             ring    - [IN] the ring buffer                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the ring was drained                               *
+ *               FAIL    - the ring has more data, it must be drained again   *
+ *                         after handling other messages                      *
+ *                                                                            *
+ * Comments: Producer sends wakeup message only when it writes into drained   *
+ *           ring, so ring with remaining data must be tracked by manager.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_drain_ring(zbx_preprocessing_manager_t *manager, zbx_ipc_ring_t *ring)
+{
+	int			i;
+	zbx_ipc_message_t	request;
+
+	request.code = ZBX_IPC_PREPROCESSOR_REQUEST;
+
+	for (i = 0; i < ZBX_PREPROCESSING_RING_BATCH; i++)
+	{
+		if (NULL == (request.data = zbx_ipc_ring_peek(ring, &request.size)))
+			return SUCCEED;
+
+		/* the values are unpacked directly from shared memory, the record is released */
+		/* only after it has been processed so producer cannot overwrite it            */
+		preprocessor_add_request(manager, &request);
+		zbx_ipc_ring_pop(ring);
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_wakeup_ring                                         *
+ *                                                                            *
+ * Purpose: handle ring wakeup message from data gathering process            *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             message - [IN] the message with producer process server_num    *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_wakeup_ring(zbx_preprocessing_manager_t *manager, const zbx_ipc_message_t *message)
+{
+	int		index;
+	zbx_ipc_ring_t	*ring;
+
+	memcpy(&index, message->data, sizeof(index));
+
+	if (NULL == (ring = zbx_preprocessor_get_ring(index, process_num - 1)))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	if (FAIL == zbx_vector_ptr_search(&manager->pending_rings, ring, ZBX_DEFAULT_PTR_COMPARE_FUNC) &&
+			FAIL == preprocessor_drain_ring(manager, ring))
+	{
+		zbx_vector_ptr_append(&manager->pending_rings, ring);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_drain_pending_rings                                 *
+ *                                                                            *
+ * Purpose: continue processing rings that were not drained                   *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_drain_pending_rings(zbx_preprocessing_manager_t *manager)
+{
+	int	i;
+
+	for (i = 0; i < manager->pending_rings.values_num;)
+	{
+		if (SUCCEED == preprocessor_drain_ring(manager, (zbx_ipc_ring_t *)manager->pending_rings.values[i]))
+			zbx_vector_ptr_remove_noorder(&manager->pending_rings, i);
+		else
+			i++;
+	}
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_add_test_request                                    *
@@ -1031,11 +1420,11 @@ out:
  *                                                                            *
  * Function: preprocessor_add_result                                          *
  *                                                                            *
- * Purpose: handle preprocessing result                                       *
+ * Purpose: handle preprocessing results                                      *
  *                                                                            *
  * Parameters: manager - [IN] preprocessing manager                           *
  *             client  - [IN] IPC client                                      *
- *             message - [IN] packed preprocessing result                     *
+ *             message - [IN] packed preprocessing results of worker batch    *
  *                                                                            *
  ******************************************************************************/
 static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client,
@@ -1046,57 +1435,43 @@ static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ip
 	zbx_variant_t			value;
 	char				*error;
 	zbx_vector_ptr_t		history;
-	zbx_preproc_history_t		*vault;
 	zbx_list_item_t			*node;
+	const unsigned char		*result;
+	zbx_uint32_t			offset = 0;
+	int				i;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	worker = preprocessor_get_worker_by_client(manager, client);
-	node = (zbx_list_item_t *)worker->task;
-	request = (zbx_preprocessing_request_t *)node->data;
-
 	zbx_vector_ptr_create(&history);
-	zbx_preprocessor_unpack_result(&value, &history, &error, message->data);
-
-	if (NULL != (vault = (zbx_preproc_history_t *)zbx_hashset_search(&manager->history_cache,
-			&request->value.itemid)))
-	{
-		zbx_vector_ptr_clear_ext(&vault->history, (zbx_clean_func_t)zbx_preproc_op_history_free);
-	}
 
-	if (0 != history.values_num)
+	/* the queued items are not flushed until all batch results are processed */
+	for (i = 0; i < worker->tasks.values_num; i++)
 	{
-		if (NULL == vault)
+		if (NULL == (result = zbx_preprocessor_unpack_batch_item(message->data, message->size, &offset)))
 		{
-			zbx_preproc_history_t	history_local;
-
-			history_local.itemid = request->value.itemid;
-			vault = (zbx_preproc_history_t *)zbx_hashset_insert(&manager->history_cache, &history_local,
-					sizeof(history_local));
-			zbx_vector_ptr_create(&vault->history);
+			THIS_SHOULD_NEVER_HAPPEN;
+			exit(EXIT_FAILURE);
 		}
 
-		zbx_vector_ptr_append_array(&vault->history, history.values, history.values_num);
-		zbx_vector_ptr_clear(&history);
-	}
-	else
-	{
-		if (NULL != vault)
-		{
-			zbx_vector_ptr_destroy(&vault->history);
-			zbx_hashset_remove_direct(&manager->history_cache, vault);
-		}
-	}
+		node = (zbx_list_item_t *)worker->tasks.values[i];
+		request = (zbx_preprocessing_request_t *)node->data;
 
-	preprocessor_set_request_state_done(manager, request, worker->task);
+		zbx_preprocessor_unpack_result(&value, &history, &error, result);
 
-	if (FAIL != preprocessor_set_variant_result(request, &value, error))
-		preprocessor_enqueue_dependent(manager, &request->value, worker->task);
+		preprocessor_update_history(manager, request->value.itemid, &history);
 
-	worker->task = NULL;
-	zbx_variant_clear(&value);
+		preprocessor_set_request_state_done(manager, request, node);
 
-	manager->preproc_num--;
+		if (FAIL != preprocessor_set_variant_result(request, &value, error))
+			preprocessor_enqueue_dependent(manager, &request->value, node);
+
+		zbx_variant_clear(&value);
+
+		manager->preproc_num--;
+	}
+
+	zbx_vector_ptr_clear(&worker->tasks);
 
 	preprocessor_assign_tasks(manager);
 	preprocessing_flush_queue(manager);
@@ -1156,18 +1531,57 @@ static void	preprocessor_flush_test_result(zbx_preprocessing_manager_t *manager,
  ******************************************************************************/
 static void	preprocessor_get_diag_stats(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client)
 {
-	unsigned char	*data;
-	zbx_uint32_t	data_len;
+	unsigned char			*data;
+	zbx_uint32_t			data_len;
+	zbx_preproc_cache_stats_t	cache_stats;
+	int				i;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	data_len = zbx_preprocessor_pack_diag_stats(&data, manager->queued_num, manager->preproc_num);
+	/* lightweight steps executed by manager itself can use regexp and jsonpath caches */
+	zbx_regexp_cache_get_stats(&cache_stats.regexp_hits, &cache_stats.regexp_misses);
+	zbx_jsonpath_cache_get_stats(&cache_stats.jsonpath_hits, &cache_stats.jsonpath_misses);
+	cache_stats.script_hits = 0;
+	cache_stats.script_misses = 0;
+
+	for (i = 0; i < manager->worker_count; i++)
+	{
+		cache_stats.regexp_hits += manager->workers[i].cache_stats.regexp_hits;
+		cache_stats.regexp_misses += manager->workers[i].cache_stats.regexp_misses;
+		cache_stats.script_hits += manager->workers[i].cache_stats.script_hits;
+		cache_stats.script_misses += manager->workers[i].cache_stats.script_misses;
+		cache_stats.jsonpath_hits += manager->workers[i].cache_stats.jsonpath_hits;
+		cache_stats.jsonpath_misses += manager->workers[i].cache_stats.jsonpath_misses;
+	}
+
+	data_len = zbx_preprocessor_pack_diag_stats(&data, manager->queued_num, manager->preproc_num, &cache_stats);
 	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_DIAG_STATS_RESULT, data, data_len);
 	zbx_free(data);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_update_cache_stats                                  *
+ *                                                                            *
+ * Purpose: store compiled data cache statistics reported by preprocessing    *
+ *          worker                                                            *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client                                      *
+ *             message - [IN] packed cache statistics                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_update_cache_stats(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
+{
+	zbx_preprocessing_worker_t	*worker;
+
+	worker = preprocessor_get_worker_by_client(manager, client);
+	zbx_preprocessor_unpack_cache_stats(&worker->cache_stats, message->data);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preproc_sort_item_by_values_desc                                 *
@@ -1257,14 +1671,20 @@ static void	preprocessor_get_top_items(zbx_preprocessing_manager_t *manager, zbx
  ******************************************************************************/
 static void	preprocessor_init_manager(zbx_preprocessing_manager_t *manager)
 {
+	int	i;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() workers: %d", __func__, CONFIG_PREPROCESSOR_FORKS);
 
 	memset(manager, 0, sizeof(zbx_preprocessing_manager_t));
 
 	manager->workers = (zbx_preprocessing_worker_t *)zbx_calloc(NULL, CONFIG_PREPROCESSOR_FORKS,
 			sizeof(zbx_preprocessing_worker_t));
+
+	for (i = 0; i < CONFIG_PREPROCESSOR_FORKS; i++)
+		zbx_vector_ptr_create(&manager->workers[i].tasks);
 	zbx_list_create(&manager->queue);
 	zbx_list_create(&manager->direct_queue);
+	zbx_vector_ptr_create(&manager->pending_rings);
 	zbx_hashset_create_ext(&manager->item_config, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
 			(zbx_clean_func_t)preproc_item_clear,
 			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
@@ -1331,6 +1751,10 @@ static void	preprocessor_destroy_manager(zbx_preprocessing_manager_t *manager)
 {
 	zbx_preprocessing_request_t		*request;
 	zbx_preprocessing_direct_request_t	*direct_request;
+	int					i;
+
+	for (i = 0; i < CONFIG_PREPROCESSOR_FORKS; i++)
+		zbx_vector_ptr_destroy(&manager->workers[i].tasks);
 
 	zbx_free(manager->workers);
 
@@ -1339,6 +1763,7 @@ static void	preprocessor_destroy_manager(zbx_preprocessing_manager_t *manager)
 		preprocessor_free_direct_request(direct_request);
 
 	zbx_list_destroy(&manager->direct_queue);
+	zbx_vector_ptr_destroy(&manager->pending_rings);
 
 	while (SUCCEED == zbx_list_pop(&manager->queue, (void **)&request))
 		preprocessor_free_request(request);
@@ -1357,7 +1782,8 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 	zbx_ipc_client_t		*client;
 	zbx_ipc_message_t		*message;
 	zbx_preprocessing_manager_t	manager;
-	int				ret;
+	int				ret, timeout = ZBX_PREPROCESSING_MANAGER_DELAY;
+	char				service_name[ZBX_PREPROCESSING_SERVICE_LEN];
 	double				time_stat, time_idle = 0, time_now, time_flush, sec;
 
 #define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
@@ -1374,7 +1800,10 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 
 	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
 
-	if (FAIL == zbx_ipc_service_start(&service, ZBX_IPC_SERVICE_PREPROCESSING, &error))
+	/* each manager serves its own share of items with its own preprocessing workers */
+	zbx_preprocessor_get_service_name(process_num - 1, service_name, sizeof(service_name));
+
+	if (FAIL == zbx_ipc_service_start(&service, service_name, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot start preprocessing service: %s", error);
 		zbx_free(error);
@@ -1405,8 +1834,12 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 			manager.processed_num = 0;
 		}
 
+#ifdef ZBX_IPC_RING_ENABLED
+		preprocessor_drain_pending_rings(&manager);
+		timeout = (0 == manager.pending_rings.values_num ? ZBX_PREPROCESSING_MANAGER_DELAY : 0);
+#endif
 		update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
-		ret = zbx_ipc_service_recv(&service, ZBX_PREPROCESSING_MANAGER_DELAY, &client, &message);
+		ret = zbx_ipc_service_recv(&service, timeout, &client, &message);
 		update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
 		sec = zbx_time();
 		zbx_update_env(sec);
@@ -1443,6 +1876,14 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 				case ZBX_IPC_PREPROCESSOR_TOP_ITEMS:
 					preprocessor_get_top_items(&manager, client, message);
 					break;
+				case ZBX_IPC_PREPROCESSOR_CACHE_STATS:
+					preprocessor_update_cache_stats(&manager, client, message);
+					break;
+#ifdef ZBX_IPC_RING_ENABLED
+				case ZBX_IPC_PREPROCESSOR_RING_WAKEUP:
+					preprocessor_wakeup_ring(&manager, message);
+					break;
+#endif
 			}
 
 			zbx_ipc_message_free(message);
@@ -25,6 +25,7 @@
 #include "zbxserialize.h"
 #include "preprocessing.h"
 #include "zbxembed.h"
+#include "zbxregexp.h"
 
 #include "sysinfo.h"
 #include "preproc_worker.h"
@@ -32,328 +33,196 @@
 #include "preproc_history.h"
 
 extern unsigned char	process_type, program_type;
-extern int		server_num, process_num;
+extern int		server_num, process_num, CONFIG_PREPROCMAN_FORKS;
 
-#define ZBX_PREPROC_VALUE_PREVIEW_LEN		100
+#define ZBX_PREPROC_CACHE_STATS_PERIOD		1	/* cache statistics reporting period in seconds */
 
 zbx_es_t	es_engine;
 
+/* unpacked item value preprocessing task */
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	unsigned char		value_type;
+	zbx_timespec_t		*ts;
+	zbx_variant_t		value;
+	zbx_vector_ptr_t	history_in;
+	zbx_preproc_op_t	*steps;
+	int			steps_num;
+}
+zbx_preproc_worker_task_t;
+
 /******************************************************************************
  *                                                                            *
- * Function: worker_format_value                                              *
+ * Function: worker_preprocess_value                                          *
  *                                                                            *
- * Purpose: formats value in text format                                      *
+ * Purpose: handle item value preprocessing task                              *
  *                                                                            *
- * Parameters: value     - [IN] the value to format                           *
- *             value_str - [OUT] the formatted value                          *
+ * Parameters: task - [IN] unpacked preprocessing task, freed afterwards      *
+ *             data - [OUT] packed preprocessing result                       *
  *                                                                            *
- * Comments: Control characters are replaced with '.' and truncated if it's   *
- *           larger than ZBX_PREPROC_VALUE_PREVIEW_LEN characters.            *
+ * Return value: The packed preprocessing result size.                        *
  *                                                                            *
  ******************************************************************************/
-static void	worker_format_value(const zbx_variant_t *value, char **value_str)
+static zbx_uint32_t	worker_preprocess_value(zbx_preproc_worker_task_t *task, unsigned char **data)
 {
-	int		len, i;
-	const char	*value_desc;
+	zbx_uint32_t		size;
+	zbx_variant_t		value_start;
+	int			ret;
+	char			*error = NULL;
+	zbx_vector_ptr_t	history_out;
 
-	value_desc = zbx_variant_value_desc(value);
+	zbx_vector_ptr_create(&history_out);
 
-	if (ZBX_PREPROC_VALUE_PREVIEW_LEN < zbx_strlen_utf8(value_desc))
-	{
-		/* truncate value and append '...' */
-		len = zbx_strlen_utf8_nchars(value_desc, ZBX_PREPROC_VALUE_PREVIEW_LEN - ZBX_CONST_STRLEN("..."));
-		*value_str = zbx_malloc(NULL, len + ZBX_CONST_STRLEN("...") + 1);
-		memcpy(*value_str, value_desc, len);
-		memcpy(*value_str + len, "...", ZBX_CONST_STRLEN("...") + 1);
-	}
-	else
-	{
-		*value_str = zbx_malloc(NULL, (len = strlen(value_desc)) + 1);
-		memcpy(*value_str, value_desc, len + 1);
-	}
+	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+		zbx_variant_copy(&value_start, &task->value);
+
+	ret = zbx_item_preproc_execute(task->value_type, &task->value, task->ts, task->steps, task->steps_num,
+			&task->history_in, &history_out, &error);
 
-	/* replace control characters */
-	for (i = 0; i < len; i++)
+	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
-		if (0 != iscntrl((*value_str)[i]))
-			(*value_str)[i] = '.';
+		const char	*result;
+
+		result = (SUCCEED == ret ? zbx_variant_value_desc(&task->value) : error);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s(): %s", __func__, zbx_variant_value_desc(&value_start));
+		zabbix_log(LOG_LEVEL_DEBUG, "%s: %s %s",__func__, zbx_result_string(ret), result);
+		zbx_variant_clear(&value_start);
 	}
-}
 
-/******************************************************************************
- *                                                                            *
- * Function: worker_format_result                                             *
- *                                                                            *
- * Purpose: formats one preprocessing step result                             *
- *                                                                            *
- * Parameters: step   - [IN] the preprocessing step number                    *
- *             result - [IN] the preprocessing step result                    *
- *             error  - [IN] the preprocessing step error (can be NULL)       *
- *             out    - [OUT] the formatted string                            *
- *                                                                            *
- ******************************************************************************/
-static void	worker_format_result(int step, const zbx_preproc_result_t *result, const char *error, char **out)
-{
-	char	*actions[] = {"", " (discard value)", " (set value)", " (set error)"};
+	size = zbx_preprocessor_pack_result(data, &task->value, &history_out, error);
+	zbx_variant_clear(&task->value);
+	zbx_free(error);
+	zbx_free(task->ts);
+	zbx_free(task->steps);
 
-	if (NULL == error)
-	{
-		char	*value_str;
+	zbx_vector_ptr_clear_ext(&history_out, (zbx_clean_func_t)zbx_preproc_op_history_free);
+	zbx_vector_ptr_destroy(&history_out);
 
-		worker_format_value(&result->value, &value_str);
-		*out = zbx_dsprintf(NULL, "%d. Result%s: %s\n", step, actions[result->action], value_str);
-		zbx_free(value_str);
-	}
-	else
-	{
-		*out = zbx_dsprintf(NULL, "%d. Failed%s: %s\n", step, actions[result->action], error);
-		zbx_rtrim(*out, ZBX_WHITESPACE);
-	}
+	zbx_vector_ptr_clear_ext(&task->history_in, (zbx_clean_func_t)zbx_preproc_op_history_free);
+	zbx_vector_ptr_destroy(&task->history_in);
+
+	return size;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: worker_format_error                                              *
+ * Function: worker_open_document                                             *
  *                                                                            *
- * Purpose: formats preprocessing error message                               *
+ * Purpose: open master value shared by the specified batch tasks, so that    *
+ *          their first preprocessing steps use the same parsed document      *
  *                                                                            *
- * Parameters: value        - [IN] the input value                            *
- *             results      - [IN] the preprocessing step results             *
- *             results_num  - [IN] the number of executed steps               *
- *             errmsg       - [IN] the error message of last executed step    *
- *             error        - [OUT] the formatted error message               *
+ * Parameters: tasks - [IN] the batch tasks                                   *
+ *             start - [IN] the first task sharing the value                  *
+ *             end   - [IN] the task after the last task sharing the value    *
+ *             value - [IN] the shared value                                  *
  *                                                                            *
  ******************************************************************************/
-static void	worker_format_error(const zbx_variant_t *value, zbx_preproc_result_t *results, int results_num,
-		const char *errmsg, char **error)
+static void	worker_open_document(const zbx_vector_ptr_t *tasks, int start, int end, const zbx_variant_t *value)
 {
-	char			*value_str, *err_step;
-	int			i;
-	size_t			error_alloc = 512, error_offset = 0;
-	zbx_vector_str_t	results_str;
-	zbx_db_mock_field_t	field;
+	const zbx_preproc_op_t	**steps;
+	int			i, steps_num = 0;
 
-	zbx_vector_str_create(&results_str);
+	steps = (const zbx_preproc_op_t **)zbx_malloc(NULL, sizeof(zbx_preproc_op_t *) * (end - start));
 
-	/* add header to error message */
-	*error = zbx_malloc(NULL, error_alloc);
-	worker_format_value(value, &value_str);
-	zbx_snprintf_alloc(error, &error_alloc, &error_offset, "Preprocessing failed for: %s\n", value_str);
-	zbx_free(value_str);
-
-	zbx_db_mock_field_init(&field, ZBX_TYPE_CHAR, ITEM_ERROR_LEN);
-
-	zbx_db_mock_field_append(&field, *error);
-	zbx_db_mock_field_append(&field, "...\n");
-
-	/* format the last (failed) step */
-	worker_format_result(results_num, &results[results_num - 1], errmsg, &err_step);
-	zbx_vector_str_append(&results_str, err_step);
-
-	if (SUCCEED == zbx_db_mock_field_append(&field, err_step))
+	for (i = start; i < end; i++)
 	{
-		/* format the first steps */
-		for (i = results_num - 2; i >= 0; i--)
-		{
-			worker_format_result(i + 1, &results[i], NULL, &err_step);
+		const zbx_preproc_worker_task_t	*task = (const zbx_preproc_worker_task_t *)tasks->values[i];
 
-			if (SUCCEED != zbx_db_mock_field_append(&field, err_step))
-			{
-				zbx_free(err_step);
-				break;
-			}
-
-			zbx_vector_str_append(&results_str, err_step);
-		}
+		if (0 != task->steps_num)
+			steps[steps_num++] = &task->steps[0];
 	}
 
-	/* add steps to error message */
-
-	if (results_str.values_num < results_num)
-		zbx_strcpy_alloc(error, &error_alloc, &error_offset, "...\n");
-
-	for (i = results_str.values_num - 1; i >= 0; i--)
-		zbx_strcpy_alloc(error, &error_alloc, &error_offset, results_str.values[i]);
-
-	/* truncate formatted error if necessary */
-	if (ITEM_ERROR_LEN < zbx_strlen_utf8(*error))
-	{
-		char	*ptr;
-
-		ptr = (*error) + zbx_db_strlen_n(*error, ITEM_ERROR_LEN - 3);
-		for (i = 0; i < 3; i++)
-			*ptr++ = '.';
-		*ptr = '\0';
-	}
-
-	zbx_vector_str_clear_ext(&results_str, zbx_str_free);
-	zbx_vector_str_destroy(&results_str);
+	zbx_item_preproc_document_open(value, steps, steps_num);
+	zbx_free(steps);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: worker_item_preproc_execute                                      *
+ * Function: worker_preprocess_batch                                          *
  *                                                                            *
- * Purpose: execute preprocessing steps                                       *
+ * Purpose: handle batch of item value preprocessing tasks                    *
  *                                                                            *
- * Parameters: value_type    - [IN] the item value type                       *
- *             value         - [IN/OUT] the value to process                  *
- *             ts            - [IN] the value timestamp                       *
- *             steps         - [IN] the preprocessing steps to execute        *
- *             steps_num     - [IN] the number of preprocessing steps         *
- *             history_in    - [IN] the preprocessing history                 *
- *             history_out   - [OUT] the new preprocessing history            *
- *             results       - [OUT] the preprocessing step results           *
- *             results_num   - [OUT] the number of step results               *
- *             error         - [OUT] error message                            *
+ * Parameters: socket  - [IN] IPC socket                                      *
+ *             message - [IN] packed preprocessing tasks                      *
  *                                                                            *
- * Return value: SUCCEED - the preprocessing steps finished successfully      *
- *               FAIL - otherwise, error contains the error message           *
+ * Comments: The results are returned in a single message in the same order   *
+ *           as the tasks.                                                    *
+ *           Dependent items sharing master value follow the first of them in *
+ *           batch without value, the master value is parsed once for all of  *
+ *           them.                                                            *
  *                                                                            *
  ******************************************************************************/
-static int	worker_item_preproc_execute(unsigned char value_type, zbx_variant_t *value, const zbx_timespec_t *ts,
-		zbx_preproc_op_t *steps, int steps_num, zbx_vector_ptr_t *history_in, zbx_vector_ptr_t *history_out,
-		zbx_preproc_result_t *results, int *results_num, char **error)
+static void	worker_preprocess_batch(zbx_ipc_socket_t *socket, zbx_ipc_message_t *message)
 {
-	int		i, ret = SUCCEED;
+	const unsigned char		*packed;
+	unsigned char			*data = NULL, *result = NULL;
+	zbx_uint32_t			offset = 0, data_alloc = 0, data_offset = 0, result_size;
+	zbx_vector_ptr_t		tasks;
+	zbx_preproc_worker_task_t	*task;
+	zbx_variant_t			shared_value;
+	int				i, j, k;
 
-	for (i = 0; i < steps_num; i++)
-	{
-		zbx_preproc_op_t	*op = &steps[i];
-		zbx_variant_t		history_value;
-		zbx_timespec_t		history_ts;
-
-		zbx_preproc_history_pop_value(history_in, i, &history_value, &history_ts);
+	zbx_vector_ptr_create(&tasks);
 
-		if (FAIL == (ret = zbx_item_preproc(value_type, value, ts, op, &history_value, &history_ts, error)))
-		{
-			results[i].action = op->error_handler;
-			ret = zbx_item_preproc_handle_error(value, op, error);
-			zbx_variant_clear(&history_value);
-		}
-		else
-			results[i].action = ZBX_PREPROC_FAIL_DEFAULT;
+	while (NULL != (packed = zbx_preprocessor_unpack_batch_item(message->data, message->size, &offset)))
+	{
+		task = (zbx_preproc_worker_task_t *)zbx_malloc(NULL, sizeof(zbx_preproc_worker_task_t));
+		zbx_vector_ptr_create(&task->history_in);
+		zbx_preprocessor_unpack_task(&task->itemid, &task->value_type, &task->ts, &task->value,
+				&task->history_in, &task->steps, &task->steps_num, packed);
+		zbx_vector_ptr_append(&tasks, task);
+	}
 
-		if (SUCCEED == ret)
+	for (i = 0; i < tasks.values_num; i = j)
+	{
+		for (j = i + 1; j < tasks.values_num; j++)
 		{
-			if (NULL == *error)
-			{
-				/* result history is kept to report results of steps before failing step, */
-				/* which means it can be omitted for the last step.                       */
-				if (i != steps_num - 1)
-					zbx_variant_copy(&results[i].value, value);
-				else
-					zbx_variant_set_none(&results[i].value);
-			}
-			else
-			{
-				/* preprocessing step successfully extracted error, set it */
-				results[i].action = ZBX_PREPROC_FAIL_FORCE_ERROR;
-				ret = FAIL;
-			}
+			if (ZBX_VARIANT_NONE != ((zbx_preproc_worker_task_t *)tasks.values[j])->value.type)
+				break;
 		}
 
-		if (SUCCEED != ret)
+		if (1 < j - i)
 		{
-			break;
+			task = (zbx_preproc_worker_task_t *)tasks.values[i];
+			zbx_variant_copy(&shared_value, &task->value);
+			worker_open_document(&tasks, i, j, &shared_value);
 		}
 
-		if (ZBX_VARIANT_NONE != history_value.type)
+		for (k = i; k < j; k++)
 		{
-			/* the value is byte copied to history_out vector and doesn't have to be cleared */
-			zbx_preproc_history_add_value(history_out, i, &history_value, &history_ts);
-		}
-
-		if (ZBX_VARIANT_NONE == value->type)
-			break;
-	}
+			task = (zbx_preproc_worker_task_t *)tasks.values[k];
 
-	*results_num = (i == steps_num ? i : i + 1);
-
-	return ret;
-}
-
-/******************************************************************************
- *                                                                            *
- * Function: worker_preprocess_value                                          *
- *                                                                            *
- * Purpose: handle item value preprocessing task                              *
- *                                                                            *
- * Parameters: socket  - [IN] IPC socket                                      *
- *             message - [IN] packed preprocessing task                       *
- *                                                                            *
- ******************************************************************************/
-static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t *message)
-{
-	zbx_uint32_t		size = 0;
-	unsigned char		*data = NULL, value_type;
-	zbx_uint64_t		itemid;
-	zbx_variant_t		value, value_start;
-	int			i, steps_num, results_num, ret;
-	char			*errmsg = NULL, *error = NULL;
-	zbx_timespec_t		*ts;
-	zbx_preproc_op_t	*steps;
-	zbx_vector_ptr_t	history_in, history_out;
-	zbx_preproc_result_t	*results;
-
-	zbx_vector_ptr_create(&history_in);
-	zbx_vector_ptr_create(&history_out);
-
-	zbx_preprocessor_unpack_task(&itemid, &value_type, &ts, &value, &history_in, &steps, &steps_num,
-			message->data);
+			if (1 < j - i)
+			{
+				if (k != i)
+					zbx_variant_copy(&task->value, &shared_value);
 
-	zbx_variant_copy(&value_start, &value);
-	results = (zbx_preproc_result_t *)zbx_malloc(NULL, sizeof(zbx_preproc_result_t) * steps_num);
-	memset(results, 0, sizeof(zbx_preproc_result_t) * steps_num);
+				zbx_item_preproc_document_bind(&task->value);
+			}
 
-	if (FAIL == (ret = worker_item_preproc_execute(value_type, &value, ts, steps, steps_num, &history_in,
-			&history_out, results, &results_num, &errmsg)) && 0 != results_num)
-	{
-		int action = results[results_num - 1].action;
+			result_size = worker_preprocess_value(task, &result);
+			zbx_preprocessor_pack_batch_item(&data, &data_alloc, &data_offset, result, result_size);
+			zbx_free(result);
+		}
 
-		if (ZBX_PREPROC_FAIL_SET_ERROR != action && ZBX_PREPROC_FAIL_FORCE_ERROR != action)
+		if (1 < j - i)
 		{
-			worker_format_error(&value_start, results, results_num, errmsg, &error);
-			zbx_free(errmsg);
+			zbx_item_preproc_document_close();
+			zbx_variant_clear(&shared_value);
 		}
-		else
-			error = errmsg;
 	}
 
-	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
-	{
-		const char	*result;
+	zbx_vector_ptr_clear_ext(&tasks, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&tasks);
 
-		result = (SUCCEED == ret ? zbx_variant_value_desc(&value) : error);
-		zabbix_log(LOG_LEVEL_DEBUG, "%s(): %s", __func__, zbx_variant_value_desc(&value_start));
-		zabbix_log(LOG_LEVEL_DEBUG, "%s: %s %s",__func__, zbx_result_string(ret), result);
-	}
-
-	size = zbx_preprocessor_pack_result(&data, &value, &history_out, error);
-	zbx_variant_clear(&value);
-	zbx_free(error);
-	zbx_free(ts);
-	zbx_free(steps);
-
-	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_PREPROCESSOR_RESULT, data, size))
+	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_PREPROCESSOR_RESULT, data, data_offset))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot send preprocessing result");
 		exit(EXIT_FAILURE);
 	}
 
 	zbx_free(data);
-
-	zbx_variant_clear(&value_start);
-
-	for (i = 0; i < results_num; i++)
-		zbx_variant_clear(&results[i].value);
-	zbx_free(results);
-
-	zbx_vector_ptr_clear_ext(&history_out, (zbx_clean_func_t)zbx_preproc_op_history_free);
-	zbx_vector_ptr_destroy(&history_out);
-
-	zbx_vector_ptr_clear_ext(&history_in, (zbx_clean_func_t)zbx_preproc_op_history_free);
-	zbx_vector_ptr_destroy(&history_in);
 }
 
 /******************************************************************************
@@ -422,12 +291,51 @@ static void	worker_test_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t *messa
 	zbx_vector_ptr_destroy(&history_in);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_report_cache_stats                                        *
+ *                                                                            *
+ * Purpose: report changed compiled regexp, script and jsonpath cache         *
+ *          statistics to preprocessing manager                               *
+ *                                                                            *
+ * Parameters: socket      - [IN] IPC socket                                  *
+ *             cache_stats - [IN/OUT] the last reported cache statistics      *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_report_cache_stats(zbx_ipc_socket_t *socket, zbx_preproc_cache_stats_t *cache_stats)
+{
+	zbx_preproc_cache_stats_t	stats;
+	unsigned char			*data;
+	zbx_uint32_t			size;
+
+	zbx_regexp_cache_get_stats(&stats.regexp_hits, &stats.regexp_misses);
+	zbx_es_cache_get_stats(&stats.script_hits, &stats.script_misses);
+	zbx_jsonpath_cache_get_stats(&stats.jsonpath_hits, &stats.jsonpath_misses);
+
+	if (0 == memcmp(&stats, cache_stats, sizeof(stats)))
+		return;
+
+	size = zbx_preprocessor_pack_cache_stats(&data, &stats);
+
+	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_PREPROCESSOR_CACHE_STATS, data, size))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send preprocessing cache statistics");
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_free(data);
+
+	*cache_stats = stats;
+}
+
 ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 {
-	pid_t			ppid;
-	char			*error = NULL;
-	zbx_ipc_socket_t	socket;
-	zbx_ipc_message_t	message;
+	pid_t				ppid;
+	char				*error = NULL, service_name[ZBX_PREPROCESSING_SERVICE_LEN];
+	zbx_ipc_socket_t		socket;
+	zbx_ipc_message_t		message;
+	zbx_preproc_cache_stats_t	cache_stats;
+	time_t				time_stats = 0;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -437,9 +345,14 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 
 	zbx_es_init(&es_engine);
 
+	memset(&cache_stats, 0, sizeof(cache_stats));
 	zbx_ipc_message_init(&message);
 
-	if (FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN, &error))
+	/* workers are distributed evenly between preprocessing managers */
+	zbx_preprocessor_get_service_name((process_num - 1) % CONFIG_PREPROCMAN_FORKS, service_name,
+			sizeof(service_name));
+
+	if (FAIL == zbx_ipc_socket_open(&socket, service_name, SEC_PER_MIN, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
 		zbx_free(error);
@@ -472,7 +385,7 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 		switch (message.code)
 		{
 			case ZBX_IPC_PREPROCESSOR_REQUEST:
-				worker_preprocess_value(&socket, &message);
+				worker_preprocess_batch(&socket, &message);
 				break;
 			case ZBX_IPC_PREPROCESSOR_TEST_REQUEST:
 				worker_test_value(&socket, &message);
@@ -480,6 +393,12 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 		}
 
 		zbx_ipc_message_clean(&message);
+
+		if (ZBX_PREPROC_CACHE_STATS_PERIOD <= time(NULL) - time_stats)
+		{
+			worker_report_cache_stats(&socket, &cache_stats);
+			time_stats = time(NULL);
+		}
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -23,6 +23,7 @@
 #include "zbxserver.h"
 #include "zbxserialize.h"
 #include "zbxipcservice.h"
+#include "memalloc.h"
 
 #include "preproc.h"
 #include "preprocessing.h"
@@ -44,9 +45,24 @@ zbx_packed_field_t;
 #define PACKED_FIELD(value, size)	\
 		(zbx_packed_field_t){(value), (size), (0 == (size) ? PACKED_FIELD_STRING : PACKED_FIELD_RAW)};
 
-static zbx_ipc_message_t	cached_message;
+/* values cached for each preprocessing manager, allocated on first use */
+static zbx_ipc_message_t	*cached_messages = NULL;
 static int			cached_values;
 
+extern int		server_num, CONFIG_PREPROCMAN_FORKS;
+extern zbx_uint64_t	CONFIG_PREPROCESSING_RING_SIZE;
+
+#ifdef ZBX_IPC_RING_ENABLED
+#define ZBX_PREPROCESSING_RING_WAIT_NS	100000	/* time to wait for free ring space, in nanoseconds */
+
+static zbx_mem_info_t	*preproc_ring_mem = NULL;
+
+/* shared memory rings of data gathering processes, indexed by server_num and */
+/* preprocessing manager, processes without rings send values over socket     */
+static zbx_ipc_ring_t	**preproc_rings = NULL;
+static int		preproc_rings_num = 0;
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: message_pack_data                                                *
@@ -513,6 +529,75 @@ zbx_uint32_t	zbx_preprocessor_pack_task(unsigned char **data, zbx_uint64_t itemi
 	return size;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_pack_batch_item                                 *
+ *                                                                            *
+ * Purpose: append packed task or result to batch exchanged between           *
+ *          preprocessing manager and worker                                  *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the batch buffer                        *
+ *             data_alloc  - [IN/OUT] the batch buffer size                   *
+ *             data_offset - [IN/OUT] the batch data size                     *
+ *             item        - [IN] the packed task or result                   *
+ *             item_size   - [IN] the packed task or result size              *
+ *                                                                            *
+ * Comments: Batch is a sequence of packed items, each prefixed with its      *
+ *           size.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_preprocessor_pack_batch_item(unsigned char **data, zbx_uint32_t *data_alloc, zbx_uint32_t *data_offset,
+		const unsigned char *item, zbx_uint32_t item_size)
+{
+	zbx_uint32_t	size;
+	unsigned char	*ptr;
+
+	size = *data_offset + (zbx_uint32_t)sizeof(zbx_uint32_t) + item_size;
+
+	if (size > *data_alloc)
+	{
+		while (size > *data_alloc)
+			*data_alloc = (0 == *data_alloc ? ZBX_KIBIBYTE : *data_alloc * 2);
+
+		*data = (unsigned char *)zbx_realloc(*data, *data_alloc);
+	}
+
+	ptr = *data + *data_offset;
+	ptr += zbx_serialize_value(ptr, item_size);
+	memcpy(ptr, item, item_size);
+
+	*data_offset = size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_unpack_batch_item                               *
+ *                                                                            *
+ * Purpose: get the next packed task or result from batch                     *
+ *                                                                            *
+ * Parameters: data      - [IN] the batch data                                *
+ *             data_size - [IN] the batch data size                           *
+ *             offset    - [IN/OUT] the offset of the next item in batch      *
+ *                                                                            *
+ * Return value: The packed item or NULL if all items have been read.         *
+ *                                                                            *
+ ******************************************************************************/
+const unsigned char	*zbx_preprocessor_unpack_batch_item(const unsigned char *data, zbx_uint32_t data_size,
+		zbx_uint32_t *offset)
+{
+	const unsigned char	*item;
+	zbx_uint32_t		item_size;
+
+	if (*offset >= data_size)
+		return NULL;
+
+	item = data + *offset;
+	item += zbx_deserialize_value(item, &item_size);
+	*offset += (zbx_uint32_t)sizeof(zbx_uint32_t) + item_size;
+
+	return item;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_pack_result                                     *
@@ -609,6 +694,39 @@ zbx_uint32_t	zbx_preprocessor_pack_test_result(unsigned char **data, const zbx_p
 	return size;
 }
 
+/* the size of serialized compiled data cache statistics */
+#define PREPROC_CACHE_STATS_SIZE	(6 * sizeof(zbx_uint64_t))
+
+static zbx_uint32_t	preprocessor_serialize_cache_stats(unsigned char *ptr,
+		const zbx_preproc_cache_stats_t *cache_stats)
+{
+	unsigned char	*start = ptr;
+
+	ptr += zbx_serialize_uint64(ptr, cache_stats->regexp_hits);
+	ptr += zbx_serialize_uint64(ptr, cache_stats->regexp_misses);
+	ptr += zbx_serialize_uint64(ptr, cache_stats->script_hits);
+	ptr += zbx_serialize_uint64(ptr, cache_stats->script_misses);
+	ptr += zbx_serialize_uint64(ptr, cache_stats->jsonpath_hits);
+	ptr += zbx_serialize_uint64(ptr, cache_stats->jsonpath_misses);
+
+	return ptr - start;
+}
+
+static zbx_uint32_t	preprocessor_deserialize_cache_stats(const unsigned char *ptr,
+		zbx_preproc_cache_stats_t *cache_stats)
+{
+	const unsigned char	*start = ptr;
+
+	ptr += zbx_deserialize_uint64(ptr, &cache_stats->regexp_hits);
+	ptr += zbx_deserialize_uint64(ptr, &cache_stats->regexp_misses);
+	ptr += zbx_deserialize_uint64(ptr, &cache_stats->script_hits);
+	ptr += zbx_deserialize_uint64(ptr, &cache_stats->script_misses);
+	ptr += zbx_deserialize_uint64(ptr, &cache_stats->jsonpath_hits);
+	ptr += zbx_deserialize_uint64(ptr, &cache_stats->jsonpath_misses);
+
+	return ptr - start;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_pack_diag_stats                                 *
@@ -619,13 +737,14 @@ zbx_uint32_t	zbx_preprocessor_pack_test_result(unsigned char **data, const zbx_p
  *             values_num         - [IN] the number of queued values          *
  *             values_preproc_num - [IN] the number of queued values with     *
  *                                       preprocessing steps                  *
- *             data               - [IN] IPC data buffer                      *
+ *             cache_stats        - [IN] the compiled data cache statistics   *
  *                                                                            *
  ******************************************************************************/
-zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_num, int values_preproc_num)
+zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_num, int values_preproc_num,
+		const zbx_preproc_cache_stats_t *cache_stats)
 {
 	unsigned char	*ptr;
-	zbx_uint32_t	data_len = 0;
+	zbx_uint32_t	data_len = PREPROC_CACHE_STATS_SIZE;
 
 	zbx_serialize_prepare_value(data_len, values_num);
 	zbx_serialize_prepare_value(data_len, values_preproc_num);
@@ -634,11 +753,30 @@ zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_n
 
 	ptr = *data;
 	ptr += zbx_serialize_value(ptr, values_num);
-	(void)zbx_serialize_value(ptr, values_preproc_num);
+	ptr += zbx_serialize_value(ptr, values_preproc_num);
+	(void)preprocessor_serialize_cache_stats(ptr, cache_stats);
 
 	return data_len;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_pack_cache_stats                                *
+ *                                                                            *
+ * Purpose: pack preprocessing worker compiled data cache statistics into a   *
+ *          single buffer that can be used in IPC                             *
+ *                                                                            *
+ * Parameters: data        - [OUT] memory buffer for packed data              *
+ *             cache_stats - [IN] the compiled data cache statistics          *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_preprocessor_pack_cache_stats(unsigned char **data, const zbx_preproc_cache_stats_t *cache_stats)
+{
+	*data = (unsigned char *)zbx_malloc(NULL, PREPROC_CACHE_STATS_SIZE);
+
+	return preprocessor_serialize_cache_stats(*data, cache_stats);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_pack_top_request                                *
@@ -891,15 +1029,34 @@ void	zbx_preprocessor_unpack_test_result(zbx_vector_ptr_t *results, zbx_vector_p
  * Parameters: values_num         - [OUT] the number of queued values         *
  *             values_preproc_num - [OUT] the number of queued values with    *
  *                                       preprocessing steps                  *
+ *             cache_stats        - [OUT] the compiled data cache statistics  *
  *             data               - [IN] IPC data buffer                      *
  *                                                                            *
  ******************************************************************************/
-void	zbx_preprocessor_unpack_diag_stats(int *values_num, int *values_preproc_num, const unsigned char *data)
+void	zbx_preprocessor_unpack_diag_stats(int *values_num, int *values_preproc_num,
+		zbx_preproc_cache_stats_t *cache_stats, const unsigned char *data)
 {
 	const unsigned char	*offset = data;
 
 	offset += zbx_deserialize_int(offset, values_num);
-	(void)zbx_deserialize_int(offset, values_preproc_num);
+	offset += zbx_deserialize_int(offset, values_preproc_num);
+	(void)preprocessor_deserialize_cache_stats(offset, cache_stats);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_unpack_cache_stats                              *
+ *                                                                            *
+ * Purpose: unpack preprocessing worker compiled data cache statistics from   *
+ *          IPC data buffer                                                   *
+ *                                                                            *
+ * Parameters: cache_stats - [OUT] the compiled data cache statistics         *
+ *             data        - [IN] IPC data buffer                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_preprocessor_unpack_cache_stats(zbx_preproc_cache_stats_t *cache_stats, const unsigned char *data)
+{
+	(void)preprocessor_deserialize_cache_stats(data, cache_stats);
 }
 
 /******************************************************************************
@@ -950,46 +1107,298 @@ void	zbx_preprocessor_unpack_top_result(zbx_vector_ptr_t *items, const unsigned
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_get_service_name                                *
+ *                                                                            *
+ * Purpose: get IPC service name of the specified preprocessing manager       *
+ *                                                                            *
+ * Parameters: manager_index - [IN] the preprocessing manager index, starting *
+ *                                  with 0                                    *
+ *             name          - [OUT] the service name                         *
+ *             name_len      - [IN] the service name buffer size              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_preprocessor_get_service_name(int manager_index, char *name, size_t name_len)
+{
+	/* the first manager keeps the original service name */
+	if (0 == manager_index)
+		zbx_strlcpy(name, ZBX_IPC_SERVICE_PREPROCESSING, name_len);
+	else
+		zbx_snprintf(name, name_len, ZBX_IPC_SERVICE_PREPROCESSING "%d", manager_index + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_manager_index                                   *
+ *                                                                            *
+ * Purpose: get index of preprocessing manager responsible for the item       *
+ *                                                                            *
+ * Comments: Dependent items are preprocessed by the manager of their master  *
+ *           item, so all values of an item are processed by the same manager *
+ *           and the item value order is kept.                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_get_manager_index(zbx_uint64_t itemid)
+{
+	return (int)(itemid % (zbx_uint64_t)CONFIG_PREPROCMAN_FORKS);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_send                                                *
  *                                                                            *
  * Purpose: sends command to preprocessor manager                             *
  *                                                                            *
- * Parameters: code     - [IN] message code                                   *
- *             data     - [IN] message data                                   *
- *             size     - [IN] message data size                              *
- *             response - [OUT] response message (can be NULL if response is  *
- *                              not requested)                                *
+ * Parameters: manager_index - [IN] the preprocessing manager index           *
+ *             code          - [IN] message code                              *
+ *             data          - [IN] message data                              *
+ *             size          - [IN] message data size                         *
+ *             response      - [OUT] response message (can be NULL if         *
+ *                                   response is not requested)               *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_send(zbx_uint32_t code, unsigned char *data, zbx_uint32_t size,
+static void	preprocessor_send(int manager_index, zbx_uint32_t code, unsigned char *data, zbx_uint32_t size,
 		zbx_ipc_message_t *response)
 {
 	char			*error = NULL;
-	static zbx_ipc_socket_t	socket = {0};
+	static zbx_ipc_socket_t	*sockets = NULL;
+	zbx_ipc_socket_t	*socket;
 
-	/* each process has a permanent connection to preprocessing manager */
-	if (0 == socket.fd && FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN,
-			&error))
+	if (NULL == sockets)
 	{
-		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
-		exit(EXIT_FAILURE);
+		sockets = (zbx_ipc_socket_t *)zbx_calloc(NULL, (size_t)CONFIG_PREPROCMAN_FORKS,
+				sizeof(zbx_ipc_socket_t));
 	}
 
-	if (FAIL == zbx_ipc_socket_write(&socket, code, data, size))
+	socket = &sockets[manager_index];
+
+	/* each process has a permanent connection to preprocessing managers */
+	if (0 == socket->fd)
+	{
+		char	service[ZBX_PREPROCESSING_SERVICE_LEN];
+
+		zbx_preprocessor_get_service_name(manager_index, service, sizeof(service));
+
+		if (FAIL == zbx_ipc_socket_open(socket, service, SEC_PER_MIN, &error))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (FAIL == zbx_ipc_socket_write(socket, code, data, size))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 
-	if (NULL != response && FAIL == zbx_ipc_socket_read(&socket, response))
+	if (NULL != response && FAIL == zbx_ipc_socket_read(socket, response))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot receive data from preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 }
 
+#ifdef ZBX_IPC_RING_ENABLED
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_is_ring_producer                                    *
+ *                                                                            *
+ * Purpose: check if process of the specified type sends item values to       *
+ *          preprocessing manager                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_is_ring_producer(unsigned char type)
+{
+	switch (type)
+	{
+		case ZBX_PROCESS_TYPE_POLLER:
+		case ZBX_PROCESS_TYPE_UNREACHABLE:
+		case ZBX_PROCESS_TYPE_IPMIMANAGER:
+		case ZBX_PROCESS_TYPE_PINGER:
+		case ZBX_PROCESS_TYPE_JAVAPOLLER:
+		case ZBX_PROCESS_TYPE_HTTPPOLLER:
+		case ZBX_PROCESS_TYPE_TRAPPER:
+		case ZBX_PROCESS_TYPE_SNMPTRAPPER:
+		case ZBX_PROCESS_TYPE_PROXYPOLLER:
+		case ZBX_PROCESS_TYPE_HISTORYPOLLER:
+			return SUCCEED;
+		default:
+			return FAIL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_send_ring                                           *
+ *                                                                            *
+ * Purpose: pass packed item values to preprocessing manager through the      *
+ *          shared memory ring of current process                             *
+ *                                                                            *
+ * Parameters: ring          - [IN] the ring buffer                           *
+ *             manager_index - [IN] the preprocessing manager index           *
+ *             data          - [IN] the packed item values                    *
+ *             size          - [IN] the packed item values size               *
+ *                                                                            *
+ * Return value: SUCCEED - the values were written to ring buffer             *
+ *               FAIL    - the values are too large for ring buffer, they     *
+ *                         must be sent over socket                           *
+ *                                                                            *
+ * Comments: The socket is used only to wake up preprocessing manager when    *
+ *           ring buffer had been drained.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_send_ring(zbx_ipc_ring_t *ring, int manager_index, unsigned char *data,
+		zbx_uint32_t size)
+{
+	struct timespec	ts = {0, ZBX_PREPROCESSING_RING_WAIT_NS};
+	int		wakeup;
+
+	if (zbx_ipc_ring_max_record(ring) < size)
+	{
+		/* wait until manager takes all values from ring to keep item values in order */
+		while (SUCCEED != zbx_ipc_ring_is_empty(ring))
+			nanosleep(&ts, NULL);
+
+		return FAIL;
+	}
+
+	/* the ring is full - manager is already woken up and is processing the queued data */
+	while (SUCCEED != zbx_ipc_ring_write(ring, data, size, &wakeup))
+		nanosleep(&ts, NULL);
+
+	if (1 == wakeup)
+	{
+		preprocessor_send(manager_index, ZBX_IPC_PREPROCESSOR_RING_WAKEUP, (unsigned char *)&server_num,
+				sizeof(server_num), NULL);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_get_ring                                        *
+ *                                                                            *
+ * Purpose: get shared memory ring between the specified process and          *
+ *          preprocessing manager                                             *
+ *                                                                            *
+ * Parameters: producer_num  - [IN] the process server_num                    *
+ *             manager_index - [IN] the preprocessing manager index           *
+ *                                                                            *
+ * Return value: The ring buffer or NULL if the process has no ring.          *
+ *                                                                            *
+ ******************************************************************************/
+zbx_ipc_ring_t	*zbx_preprocessor_get_ring(int producer_num, int manager_index)
+{
+	int	index = producer_num * CONFIG_PREPROCMAN_FORKS + manager_index;
+
+	if (0 > producer_num || index >= preproc_rings_num)
+		return NULL;
+
+	return preproc_rings[index];
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_init_rings                                      *
+ *                                                                            *
+ * Purpose: allocate shared memory rings for passing item values from data    *
+ *          gathering processes to preprocessing managers                     *
+ *                                                                            *
+ * Parameters: processes_num    - [IN] the number of forked processes         *
+ *             get_process_info - [IN] callback to get process type by its    *
+ *                                     server_num                             *
+ *             error            - [OUT] the error message                     *
+ *                                                                            *
+ * Return value: SUCCEED - the rings were allocated or are disabled           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Must be called before forking processes, so that the rings are   *
+ *           inherited by children.                                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_init_rings(int processes_num, int (*get_process_info)(int local_server_num,
+		unsigned char *local_process_type, int *local_process_num), char **error)
+{
+#ifdef ZBX_IPC_RING_ENABLED
+	int		i, process_num, rings_num = 0, ret = FAIL;
+	unsigned char	type;
+	zbx_uint64_t	size;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (0 == CONFIG_PREPROCESSING_RING_SIZE)
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
+	for (i = 1; i <= processes_num; i++)
+	{
+		if (SUCCEED == get_process_info(i, &type, &process_num) && SUCCEED == preprocessor_is_ring_producer(type))
+			rings_num += CONFIG_PREPROCMAN_FORKS;
+	}
+
+	if (0 == rings_num)
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
+	size = zbx_mem_required_size(rings_num, "preprocessing rings", "PreprocessingRingSize") +
+			rings_num * zbx_mem_required_chunk_size(zbx_ipc_ring_required_size(
+			(zbx_uint32_t)CONFIG_PREPROCESSING_RING_SIZE));
+
+	if (SUCCEED != zbx_mem_create(&preproc_ring_mem, size, "preprocessing rings", "PreprocessingRingSize", 0,
+			error))
+	{
+		goto out;
+	}
+
+	preproc_rings_num = (processes_num + 1) * CONFIG_PREPROCMAN_FORKS;
+	preproc_rings = (zbx_ipc_ring_t **)zbx_calloc(NULL, (size_t)preproc_rings_num, sizeof(zbx_ipc_ring_t *));
+
+	for (i = 1; i <= processes_num; i++)
+	{
+		int	j;
+
+		if (SUCCEED != get_process_info(i, &type, &process_num) || SUCCEED != preprocessor_is_ring_producer(type))
+			continue;
+
+		for (j = 0; j < CONFIG_PREPROCMAN_FORKS; j++)
+		{
+			zbx_ipc_ring_t	*ring;
+
+			ring = (zbx_ipc_ring_t *)zbx_mem_malloc(preproc_ring_mem, NULL, zbx_ipc_ring_required_size(
+					(zbx_uint32_t)CONFIG_PREPROCESSING_RING_SIZE));
+			zbx_ipc_ring_init(ring, (zbx_uint32_t)CONFIG_PREPROCESSING_RING_SIZE);
+			preproc_rings[i * CONFIG_PREPROCMAN_FORKS + j] = ring;
+		}
+	}
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rings:%d", __func__, rings_num);
+
+	return ret;
+#else
+	ZBX_UNUSED(processes_num);
+	ZBX_UNUSED(get_process_info);
+
+	if (0 != CONFIG_PREPROCESSING_RING_SIZE)
+	{
+		*error = zbx_strdup(*error, "shared memory rings are not supported by the compiler used to build"
+				" this binary, set \"PreprocessingRingSize\" to 0");
+		return FAIL;
+	}
+
+	return SUCCEED;
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocess_item_value                                        *
@@ -1015,6 +1424,7 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigne
 					.error = error, .item_flags = item_flags, .state = state, .ts = ts};
 	zbx_result_ptr_t		result_ptr = {.result = result};
 	size_t				value_len = 0, len;
+	zbx_ipc_message_t		*message;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1045,10 +1455,18 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigne
 
 	value.result_ptr = &result_ptr;
 
-	if (0 == preprocessor_pack_value(&cached_message, &value))
+	if (NULL == cached_messages)
+	{
+		cached_messages = (zbx_ipc_message_t *)zbx_calloc(NULL, (size_t)CONFIG_PREPROCMAN_FORKS,
+				sizeof(zbx_ipc_message_t));
+	}
+
+	message = &cached_messages[preprocessor_get_manager_index(itemid)];
+
+	if (0 == preprocessor_pack_value(message, &value))
 	{
 		zbx_preprocessor_flush();
-		preprocessor_pack_value(&cached_message, &value);
+		preprocessor_pack_value(message, &value);
 	}
 
 	if (MAX_VALUES_LOCAL < ++cached_values)
@@ -1061,41 +1479,65 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigne
  *                                                                            *
  * Function: zbx_preprocessor_flush                                           *
  *                                                                            *
- * Purpose: send flush command to preprocessing manager                       *
+ * Purpose: send flush command to preprocessing managers                      *
  *                                                                            *
  ******************************************************************************/
 void	zbx_preprocessor_flush(void)
 {
-	if (0 < cached_message.size)
+	int	i;
+
+	if (0 == cached_values)
+		return;
+
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
 	{
-		preprocessor_send(ZBX_IPC_PREPROCESSOR_REQUEST, cached_message.data, cached_message.size, NULL);
+		zbx_ipc_message_t	*message = &cached_messages[i];
+#ifdef ZBX_IPC_RING_ENABLED
+		zbx_ipc_ring_t		*ring;
+#endif
+		if (0 == message->size)
+			continue;
+#ifdef ZBX_IPC_RING_ENABLED
+		if (NULL == (ring = zbx_preprocessor_get_ring(server_num, i)) ||
+				SUCCEED != preprocessor_send_ring(ring, i, message->data, message->size))
+#endif
+		{
+			preprocessor_send(i, ZBX_IPC_PREPROCESSOR_REQUEST, message->data, message->size, NULL);
+		}
 
-		zbx_ipc_message_clean(&cached_message);
-		zbx_ipc_message_init(&cached_message);
-		cached_values = 0;
+		zbx_ipc_message_clean(message);
+		zbx_ipc_message_init(message);
 	}
+
+	cached_values = 0;
 }
 
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_get_queue_size                                  *
  *                                                                            *
- * Purpose: get queue size (enqueued value count) of preprocessing manager    *
+ * Purpose: get queue size (enqueued value count) of preprocessing managers   *
  *                                                                            *
  * Return value: enqueued item count                                          *
  *                                                                            *
  ******************************************************************************/
 zbx_uint64_t	zbx_preprocessor_get_queue_size(void)
 {
-	zbx_uint64_t		size;
+	zbx_uint64_t		size, total = 0;
 	zbx_ipc_message_t	message;
+	int			i;
 
-	zbx_ipc_message_init(&message);
-	preprocessor_send(ZBX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
-	memcpy(&size, message.data, sizeof(zbx_uint64_t));
-	zbx_ipc_message_clean(&message);
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
+	{
+		zbx_ipc_message_init(&message);
+		preprocessor_send(i, ZBX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
+		memcpy(&size, message.data, sizeof(zbx_uint64_t));
+		zbx_ipc_message_clean(&message);
 
-	return size;
+		total += size;
+	}
+
+	return total;
 }
 
 /******************************************************************************
@@ -1221,6 +1663,7 @@ int	zbx_preprocessor_test(unsigned char value_type, const char *value, const zbx
 
 	size = preprocessor_pack_test_request(&data, value_type, value, ts, history, steps);
 
+	/* test requests are not bound to items and are handled by the first manager */
 	if (SUCCEED != zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_TEST_REQUEST,
 			SEC_PER_MIN, data, size, &result, error))
 	{
@@ -1243,23 +1686,74 @@ out:
  *                                                                            *
  * Purpose: get preprocessing manager diagnostic statistics                   *
  *                                                                            *
+ * Parameters: values_num         - [OUT] the number of queued values         *
+ *             values_preproc_num - [OUT] the number of queued values with    *
+ *                                        preprocessing steps                 *
+ *             cache_stats        - [OUT] the compiled data cache statistics  *
+ *             managers           - [OUT] the queued and preprocessed value   *
+ *                                        counts of each manager              *
+ *             error              - [OUT] the error message                   *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num, char **error)
+int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num,
+		zbx_preproc_cache_stats_t *cache_stats, zbx_vector_uint64_pair_t *managers, char **error)
 {
-	unsigned char	*result;
+	unsigned char			*result;
+	int				i, manager_values_num, manager_values_preproc_num;
+	zbx_preproc_cache_stats_t	manager_cache_stats;
+	zbx_uint64_pair_t		pair;
+	char				service[ZBX_PREPROCESSING_SERVICE_LEN];
+
+	*values_num = 0;
+	*values_preproc_num = 0;
+	memset(cache_stats, 0, sizeof(zbx_preproc_cache_stats_t));
 
-	if (SUCCEED != zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_DIAG_STATS,
-			SEC_PER_MIN, NULL, 0, &result, error))
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
 	{
-		return FAIL;
-	}
+		zbx_preprocessor_get_service_name(i, service, sizeof(service));
 
-	zbx_preprocessor_unpack_diag_stats(values_num, values_preproc_num, result);
-	zbx_free(result);
+		if (SUCCEED != zbx_ipc_async_exchange(service, ZBX_IPC_PREPROCESSOR_DIAG_STATS, SEC_PER_MIN, NULL, 0,
+				&result, error))
+		{
+			return FAIL;
+		}
+
+		zbx_preprocessor_unpack_diag_stats(&manager_values_num, &manager_values_preproc_num,
+				&manager_cache_stats, result);
+		zbx_free(result);
+
+		*values_num += manager_values_num;
+		*values_preproc_num += manager_values_preproc_num;
+		cache_stats->regexp_hits += manager_cache_stats.regexp_hits;
+		cache_stats->regexp_misses += manager_cache_stats.regexp_misses;
+		cache_stats->script_hits += manager_cache_stats.script_hits;
+		cache_stats->script_misses += manager_cache_stats.script_misses;
+		cache_stats->jsonpath_hits += manager_cache_stats.jsonpath_hits;
+		cache_stats->jsonpath_misses += manager_cache_stats.jsonpath_misses;
+
+		pair.first = (zbx_uint64_t)manager_values_num;
+		pair.second = (zbx_uint64_t)manager_values_preproc_num;
+		zbx_vector_uint64_pair_append(managers, pair);
+	}
 
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_compare_item_stats                                  *
+ *                                                                            *
+ * Purpose: compare item statistics by queued value count in descending order *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_compare_item_stats(const void *d1, const void *d2)
+{
+	const zbx_preproc_item_stats_t	*i1 = *(const zbx_preproc_item_stats_t * const *)d1;
+	const zbx_preproc_item_stats_t	*i2 = *(const zbx_preproc_item_stats_t * const *)d2;
+
+	return i2->values_num - i1->values_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_get_top_items                                   *
@@ -1269,20 +1763,38 @@ int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num, ch
  ******************************************************************************/
 int	zbx_preprocessor_get_top_items(int limit, zbx_vector_ptr_t *items, char **error)
 {
-	int		ret;
+	int		i, ret = SUCCEED;
 	unsigned char	*data, *result;
 	zbx_uint32_t	data_len;
+	char		service[ZBX_PREPROCESSING_SERVICE_LEN];
 
 	data_len = zbx_preprocessor_pack_top_items_request(&data, limit);
 
-	if (SUCCEED != (ret = zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_TOP_ITEMS,
-			SEC_PER_MIN, data, data_len, &result, error)))
+	/* items are not shared between managers, so the top of each manager can be simply merged */
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
 	{
-		goto out;
+		zbx_preprocessor_get_service_name(i, service, sizeof(service));
+
+		if (SUCCEED != (ret = zbx_ipc_async_exchange(service, ZBX_IPC_PREPROCESSOR_TOP_ITEMS, SEC_PER_MIN, data,
+				data_len, &result, error)))
+		{
+			goto out;
+		}
+
+		zbx_preprocessor_unpack_top_result(items, result);
+		zbx_free(result);
 	}
 
-	zbx_preprocessor_unpack_top_result(items, result);
-	zbx_free(result);
+	if (1 < CONFIG_PREPROCMAN_FORKS)
+	{
+		zbx_vector_ptr_sort(items, preprocessor_compare_item_stats);
+
+		while (limit < items->values_num)
+		{
+			zbx_free(items->values[items->values_num - 1]);
+			zbx_vector_ptr_remove(items, items->values_num - 1);
+		}
+	}
 out:
 	zbx_free(data);
 
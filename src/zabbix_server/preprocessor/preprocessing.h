@@ -25,8 +25,10 @@
 #include "dbcache.h"
 #include "preproc.h"
 #include "zbxalgo.h"
+#include "zbxipcservice.h"
 
 #define ZBX_IPC_SERVICE_PREPROCESSING	"preprocessing"
+#define ZBX_PREPROCESSING_SERVICE_LEN	32
 
 #define ZBX_IPC_PREPROCESSOR_WORKER		1
 #define ZBX_IPC_PREPROCESSOR_REQUEST		2
@@ -38,6 +40,8 @@
 #define ZBX_IPC_PREPROCESSOR_DIAG_STATS_RESULT	8
 #define ZBX_IPC_PREPROCESSOR_TOP_ITEMS		9
 #define ZBX_IPC_PREPROCESSOR_TOP_ITEMS_RESULT	10
+#define ZBX_IPC_PREPROCESSOR_CACHE_STATS	11
+#define ZBX_IPC_PREPROCESSOR_RING_WAKEUP	12
 
 typedef struct {
 	AGENT_RESULT	*result;
@@ -64,6 +68,11 @@ zbx_uint32_t	zbx_preprocessor_pack_task(unsigned char **data, zbx_uint64_t itemi
 zbx_uint32_t	zbx_preprocessor_pack_result(unsigned char **data, zbx_variant_t *value,
 		const zbx_vector_ptr_t *history, char *error);
 
+void	zbx_preprocessor_pack_batch_item(unsigned char **data, zbx_uint32_t *data_alloc, zbx_uint32_t *data_offset,
+		const unsigned char *item, zbx_uint32_t item_size);
+const unsigned char	*zbx_preprocessor_unpack_batch_item(const unsigned char *data, zbx_uint32_t data_size,
+		zbx_uint32_t *offset);
+
 zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsigned char *data);
 void	zbx_preprocessor_unpack_task(zbx_uint64_t *itemid, unsigned char *value_type, zbx_timespec_t **ts,
 		zbx_variant_t *value, zbx_vector_ptr_t *history, zbx_preproc_op_t **steps,
@@ -80,9 +89,15 @@ zbx_uint32_t	zbx_preprocessor_pack_test_result(unsigned char **data, const zbx_p
 void	zbx_preprocessor_unpack_test_result(zbx_vector_ptr_t *results, zbx_vector_ptr_t *history,
 		char **error, const unsigned char *data);
 
-zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_num, int values_preproc_num);
+zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_num, int values_preproc_num,
+		const zbx_preproc_cache_stats_t *cache_stats);
+
+void	zbx_preprocessor_unpack_diag_stats(int *values_num, int *values_preproc_num,
+		zbx_preproc_cache_stats_t *cache_stats, const unsigned char *data);
+
+zbx_uint32_t	zbx_preprocessor_pack_cache_stats(unsigned char **data, const zbx_preproc_cache_stats_t *cache_stats);
 
-void	zbx_preprocessor_unpack_diag_stats(int *values_num, int *values_preproc_num, const unsigned char *data);
+void	zbx_preprocessor_unpack_cache_stats(zbx_preproc_cache_stats_t *cache_stats, const unsigned char *data);
 
 zbx_uint32_t	zbx_preprocessor_pack_top_items_request(unsigned char **data, int limit);
 
@@ -93,4 +108,10 @@ zbx_uint32_t	zbx_preprocessor_pack_top_items_result(unsigned char **data, zbx_pr
 
 void	zbx_preprocessor_unpack_top_result(zbx_vector_ptr_t *items, const unsigned char *data);
 
+void	zbx_preprocessor_get_service_name(int manager_index, char *name, size_t name_len);
+
+#ifdef ZBX_IPC_RING_ENABLED
+zbx_ipc_ring_t	*zbx_preprocessor_get_ring(int producer_num, int manager_index);
+#endif
+
 #endif /* ZABBIX_PREPROCESSING_H */
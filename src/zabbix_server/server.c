@@ -71,12 +71,14 @@
 #include "setproctitle.h"
 #include "zbxcrypto.h"
 #include "zbxipcservice.h"
+#include "preproc.h"
 #include "zbxhistory.h"
 #include "postinit.h"
 #include "export.h"
 #include "zbxvault.h"
 #include "zbxdiag.h"
 #include "zbxtrends.h"
+#include "zbxembed.h"
 
 #ifdef HAVE_OPENIPMI
 #include "ipmi/ipmi_manager.h"
@@ -216,6 +218,8 @@ int	CONFIG_MAX_HOUSEKEEPER_DELETE	= 5000;		/* applies for every separate field v
 int	CONFIG_HISTSYNCER_FORKS		= 4;
 int	CONFIG_HISTSYNCER_FREQUENCY	= 1;
 int	CONFIG_CONFSYNCER_FORKS		= 1;
+int	CONFIG_CONF_CACHE_SYNC_SLICE	= 0;
+int	CONFIG_CONF_CACHE_FULL_SYNC	= 0;
 int	CONFIG_CONFSYNCER_FREQUENCY	= 60;
 
 int	CONFIG_VMWARE_FORKS		= 0;
@@ -231,6 +235,8 @@ zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE		= ZBX_GIBIBYTE;
+zbx_uint64_t	CONFIG_PREPROCESSING_RING_SIZE	= 0;
+int		CONFIG_MAX_CACHED_SCRIPTS	= 128;
 
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
@@ -322,6 +328,10 @@ static char	*CONFIG_SOCKET_PATH	= NULL;
 char	*CONFIG_HISTORY_STORAGE_URL		= NULL;
 char	*CONFIG_HISTORY_STORAGE_OPTS		= NULL;
 int	CONFIG_HISTORY_STORAGE_PIPELINES	= 0;
+int	CONFIG_HISTORY_STORAGE_REFRESH		= 0;
+int	CONFIG_HISTORY_STORAGE_STREAMS		= 4;
+int	CONFIG_HISTORY_STORAGE_AGGREGATE	= 0;
+int	CONFIG_HISTORY_PIPELINING		= 0;
 
 char	*CONFIG_STATS_ALLOWED_IP	= NULL;
 
@@ -610,6 +620,20 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (CONFIG_PREPROCESSOR_FORKS < CONFIG_PREPROCMAN_FORKS)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"StartPreprocessors\" configuration parameter must not be less than"
+				" \"StartPreprocessorManagers\"");
+		err = 1;
+	}
+
+	if (0 != CONFIG_PREPROCESSING_RING_SIZE && 64 * ZBX_KIBIBYTE > CONFIG_PREPROCESSING_RING_SIZE)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"PreprocessingRingSize\" configuration parameter must be either 0"
+				" or not less than 64KB");
+		err = 1;
+	}
+
 	if (NULL != CONFIG_SOURCE_IP && SUCCEED != is_supported_ip(CONFIG_SOURCE_IP))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SourceIP\" configuration parameter: '%s'", CONFIG_SOURCE_IP);
@@ -639,6 +663,8 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	err |= (FAIL == check_cfg_feature_str("HistoryStorageTypes", CONFIG_HISTORY_STORAGE_OPTS, "cURL library"));
 	err |= (FAIL == check_cfg_feature_int("HistoryStorageDateIndex", CONFIG_HISTORY_STORAGE_PIPELINES,
 			"cURL library"));
+	err |= (FAIL == check_cfg_feature_int("HistoryStorageAggregate", CONFIG_HISTORY_STORAGE_AGGREGATE,
+			"cURL library"));
 	err |= (FAIL == check_cfg_feature_str("VaultToken", CONFIG_VAULTTOKEN, "cURL library"));
 	err |= (FAIL == check_cfg_feature_str("VaultDBPath", CONFIG_VAULTDBPATH, "cURL library"));
 
@@ -740,6 +766,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			1},
 		{"CacheSize",			&CONFIG_CONF_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"CacheUpdateSliceSize",	&CONFIG_CONF_CACHE_SYNC_SLICE,		TYPE_INT,
+			PARM_OPT,	0,			1000000},
+		{"CacheUpdateFullFrequency",	&CONFIG_CONF_CACHE_FULL_SYNC,		TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_DAY},
 		{"HistoryCacheSize",		&CONFIG_HISTORY_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
@@ -750,6 +780,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"ValueCacheSize",		&CONFIG_VALUE_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"PreprocessingRingSize",	&CONFIG_PREPROCESSING_RING_SIZE,	TYPE_UINT64,
+			PARM_OPT,	0,			ZBX_GIBIBYTE},
+		{"MaxCachedScripts",		&CONFIG_MAX_CACHED_SCRIPTS,		TYPE_INT,
+			PARM_OPT,	1,			65535},
 		{"CacheUpdateFrequency",	&CONFIG_CONFSYNCER_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
@@ -884,12 +918,22 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1,			100},
 		{"StartPreprocessors",		&CONFIG_PREPROCESSOR_FORKS,		TYPE_INT,
 			PARM_OPT,	1,			1000},
+		{"StartPreprocessorManagers",	&CONFIG_PREPROCMAN_FORKS,		TYPE_INT,
+			PARM_OPT,	1,			100},
 		{"HistoryStorageURL",		&CONFIG_HISTORY_STORAGE_URL,		TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"HistoryStorageTypes",		&CONFIG_HISTORY_STORAGE_OPTS,		TYPE_STRING_LIST,
 			PARM_OPT,	0,			0},
 		{"HistoryStorageDateIndex",	&CONFIG_HISTORY_STORAGE_PIPELINES,	TYPE_INT,
 			PARM_OPT,	0,			1},
+		{"HistoryStorageRefresh",	&CONFIG_HISTORY_STORAGE_REFRESH,	TYPE_INT,
+			PARM_OPT,	0,			2},
+		{"HistoryStorageStreams",	&CONFIG_HISTORY_STORAGE_STREAMS,	TYPE_INT,
+			PARM_OPT,	1,			64},
+		{"HistoryStorageAggregate",	&CONFIG_HISTORY_STORAGE_AGGREGATE,	TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_YEAR},
+		{"HistoryPipelining",		&CONFIG_HISTORY_PIPELINING,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"ExportDir",			&CONFIG_EXPORT_DIR,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"ExportType",			&CONFIG_EXPORT_TYPE,			TYPE_STRING_LIST,
@@ -1162,6 +1206,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 
 	zbx_free_config();
 
+	zbx_es_cache_set_size(CONFIG_MAX_CACHED_SCRIPTS);
+
 	if (SUCCEED != init_database_cache(&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
@@ -1211,6 +1257,14 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (NULL != CONFIG_HISTORY_STORAGE_URL && 0 != CONFIG_HISTORY_STORAGE_AGGREGATE &&
+			0 == CONFIG_HISTORY_STORAGE_REFRESH)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "\"HistoryStorageAggregate\" configuration parameter is ignored:"
+				" recently written values are not visible to history storage with"
+				" \"HistoryStorageRefresh\" set to 0");
+	}
+
 	if (SUCCEED != zbx_tfc_init(&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize trends read cache: %s", error);
@@ -1280,6 +1334,13 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	threads = (pid_t *)zbx_calloc(threads, threads_num, sizeof(pid_t));
 	threads_flags = (int *)zbx_calloc(threads_flags, threads_num, sizeof(int));
 
+	if (SUCCEED != zbx_preprocessor_init_rings(threads_num, get_process_info_by_thread, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize preprocessing rings: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (0 != CONFIG_TRAPPER_FORKS)
 	{
 		if (FAIL == zbx_tcp_listen(&listen_sock, CONFIG_LISTEN_IP, (unsigned short)CONFIG_LISTEN_PORT))
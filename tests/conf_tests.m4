@@ -41,6 +41,8 @@ AC_DEFUN([CONF_TESTS],[
 		tests/zabbix_server/trapper/Makefile
 		tests/libs/zbxregexp/Makefile
 		tests/libs/zbxtrends/Makefile
+		tests/libs/zbxipcservice/Makefile
+		tests/libs/zbxmemory/Makefile
 		tests/mocks/Makefile
 		tests/mocks/configcache/Makefile
 		tests/mocks/valuecache/Makefile
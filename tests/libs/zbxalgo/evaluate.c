@@ -19,9 +19,129 @@
 
 #include "zbxmocktest.h"
 #include "zbxmockdata.h"
+#include "zbxmockutil.h"
 
 #include "zbxalgo.h"
 
+typedef struct
+{
+	zbx_uint64_t	functionid;
+	const char	*value;
+}
+zbx_mock_function_t;
+
+static zbx_mock_function_t	*mock_functions = NULL;
+static int			mock_functions_num = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_read_functions                                              *
+ *                                                                            *
+ * Purpose: read function values and {TRIGGER.VALUE} from test case data      *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_read_functions(void)
+{
+	zbx_mock_handle_t	hfunctions, hfunction;
+	zbx_mock_error_t	err;
+	int			functions_alloc = 0;
+
+	mock_functions_num = 0;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.functions"))
+	{
+		hfunctions = zbx_mock_get_parameter_handle("in.functions");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hfunctions, &hfunction))))
+		{
+			if (ZBX_MOCK_SUCCESS != err)
+				fail_msg("Cannot read function value: %s", zbx_mock_error_string(err));
+
+			if (mock_functions_num == functions_alloc)
+			{
+				functions_alloc += 8;
+				mock_functions = (zbx_mock_function_t *)zbx_realloc(mock_functions,
+						sizeof(zbx_mock_function_t) * functions_alloc);
+			}
+
+			mock_functions[mock_functions_num].functionid = zbx_mock_get_object_member_uint64(hfunction,
+					"functionid");
+			mock_functions[mock_functions_num++].value = zbx_mock_get_object_member_string(hfunction,
+					"value");
+		}
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.trigger_value"))
+	{
+		mock_functions = (zbx_mock_function_t *)zbx_realloc(mock_functions,
+				sizeof(zbx_mock_function_t) * (mock_functions_num + 1));
+		mock_functions[mock_functions_num].functionid = ZBX_EVAL_TRIGGER_VALUE_ID;
+		mock_functions[mock_functions_num++].value = zbx_mock_get_parameter_string("in.trigger_value");
+	}
+}
+
+static const char	*mock_function_value(zbx_uint64_t functionid, void *data)
+{
+	int	i;
+
+	ZBX_UNUSED(data);
+
+	for (i = 0; i < mock_functions_num; i++)
+	{
+		if (mock_functions[i].functionid == functionid)
+			return mock_functions[i].value;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_substitute_functions                                        *
+ *                                                                            *
+ * Purpose: substitute function references and {TRIGGER.VALUE} macros with   *
+ *          their values the same way as server does before text evaluation   *
+ *                                                                            *
+ ******************************************************************************/
+static char	*mock_substitute_functions(const char *expression)
+{
+	const char	*br = expression, *bl, *value;
+	char		*out = NULL;
+	size_t		out_alloc = 0, out_offset = 0;
+	zbx_uint64_t	functionid;
+
+	while (NULL != (bl = strchr(br, '{')))
+	{
+		zbx_strncpy_alloc(&out, &out_alloc, &out_offset, br, bl - br);
+
+		if (NULL == (br = strchr(bl, '}')))
+			fail_msg("Invalid function reference in expression \"%s\"", expression);
+
+		br++;
+
+		if (0 == strncmp(bl, "{TRIGGER.VALUE}", br - bl))
+			functionid = ZBX_EVAL_TRIGGER_VALUE_ID;
+		else if (SUCCEED != is_uint64_n(bl + 1, br - bl - 2, &functionid))
+			fail_msg("Invalid function reference in expression \"%s\"", expression);
+
+		if (NULL == (value = mock_function_value(functionid, NULL)))
+			fail_msg("Function {" ZBX_FS_UI64 "} value is not defined", functionid);
+
+		if (SUCCEED != is_double_suffix(value, ZBX_FLAG_DOUBLE_SUFFIX) || '-' == *value)
+		{
+			zbx_chrcpy_alloc(&out, &out_alloc, &out_offset, '(');
+			zbx_strcpy_alloc(&out, &out_alloc, &out_offset, value);
+			zbx_chrcpy_alloc(&out, &out_alloc, &out_offset, ')');
+		}
+		else
+			zbx_strcpy_alloc(&out, &out_alloc, &out_offset, value);
+	}
+
+	zbx_strcpy_alloc(&out, &out_alloc, &out_offset, br);
+
+	return out;
+}
+
 void	zbx_mock_test_entry(void **state)
 {
 	zbx_mock_error_t	error;
@@ -29,8 +149,11 @@ void	zbx_mock_test_entry(void **state)
 
 	double			expected_value, actual_value;
 	const char		*tmp, *expected_param_value_string, *expression;
-	char			actual_error[256];
+	char			actual_error[256], *text;
 	int			expected_result = FAIL, actual_result = FAIL;
+	unsigned char		*code;
+	size_t			code_size;
+	zbx_vector_ptr_t	unknown_msgs, *punknown_msgs = NULL;
 
 	ZBX_UNUSED(state);
 
@@ -79,8 +202,33 @@ void	zbx_mock_test_entry(void **state)
 				zbx_mock_error_string(error));
 	}
 
-	if (expected_result != (actual_result = evaluate(&actual_value, expression, actual_error,
-			sizeof(actual_error), NULL)))
+	mock_read_functions();
+
+	zbx_vector_ptr_create(&unknown_msgs);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.unknown"))
+	{
+		zbx_mock_handle_t	hmsgs, hmsg;
+		const char		*msg;
+
+		hmsgs = zbx_mock_get_parameter_handle("in.unknown");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (error = (zbx_mock_vector_element(hmsgs, &hmsg))))
+		{
+			if (ZBX_MOCK_SUCCESS != error || ZBX_MOCK_SUCCESS != (error = zbx_mock_string(hmsg, &msg)))
+				fail_msg("Cannot read unknown value message: %s", zbx_mock_error_string(error));
+
+			zbx_vector_ptr_append(&unknown_msgs, (void *)msg);
+		}
+
+		punknown_msgs = &unknown_msgs;
+	}
+
+	text = mock_substitute_functions(expression);
+	actual_result = evaluate(&actual_value, text, actual_error, sizeof(actual_error), punknown_msgs);
+	zbx_free(text);
+
+	if (expected_result != actual_result)
 	{
 		fail_msg("Got %s instead of %s as a result. Error: %s", zbx_sysinfo_ret_string(actual_result),
 			zbx_sysinfo_ret_string(expected_result), actual_error);
@@ -99,4 +247,47 @@ void	zbx_mock_test_entry(void **state)
 		if (0 != strcmp(actual_error, expected_param_value_string))
 			fail_msg("Got\n'%s' instead of\n'%s' as a value.", actual_error, expected_param_value_string);
 	}
+
+	/* compiled expression must give the same result as text evaluation */
+	if (SUCCEED != zbx_eval_compile(expression, &code, &code_size))
+		goto out;
+
+	actual_result = zbx_eval_execute(code, mock_function_value, NULL, &actual_value, actual_error,
+			sizeof(actual_error), punknown_msgs);
+	zbx_free(code);
+
+	if (NOTSUPPORTED == actual_result)
+	{
+		if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.compiled") &&
+				0 == strcmp(zbx_mock_get_parameter_string("out.compiled"), "SUCCEED"))
+		{
+			fail_msg("Compiled expression fell back to text evaluation");
+		}
+
+		goto out;
+	}
+
+	if (expected_result != actual_result)
+	{
+		fail_msg("Got %s instead of %s as a result of compiled expression. Error: %s",
+				zbx_sysinfo_ret_string(actual_result), zbx_sysinfo_ret_string(expected_result),
+				actual_error);
+	}
+
+	if (SUCCEED == expected_result)
+	{
+		if (0 != zbx_double_compare(actual_value, expected_value))
+		{
+			fail_msg("Compiled expression value %f not equal expected %f.", actual_value,
+					expected_value);
+		}
+	}
+	else if (0 != strcmp(actual_error, expected_param_value_string))
+	{
+		fail_msg("Got\n'%s' instead of\n'%s' as a compiled expression error.", actual_error,
+				expected_param_value_string);
+	}
+out:
+	zbx_vector_ptr_destroy(&unknown_msgs);
+	zbx_free(mock_functions);
 }
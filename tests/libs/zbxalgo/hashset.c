@@ -0,0 +1,299 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+#define HASHSET_TEST_SETS_NUM	2
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	value;
+}
+zbx_hashset_test_entry_t;
+
+static int	clean_calls;
+
+static zbx_hash_t	hashset_test_hash_mod4(const void *data)
+{
+	return (zbx_hash_t)(*(const zbx_uint64_t *)data % 4);
+}
+
+static zbx_hash_t	hashset_test_hash_max(const void *data)
+{
+	/* map all entries to the last cells to test probing wraparound */
+	return (zbx_hash_t)0xffffffff - (zbx_hash_t)(*(const zbx_uint64_t *)data % 2);
+}
+
+static void	hashset_test_clean(void *data)
+{
+	ZBX_UNUSED(data);
+	clean_calls++;
+}
+
+static zbx_hash_func_t	hashset_test_get_hash_func(const char *str)
+{
+	if (0 == strcmp(str, "default"))
+		return ZBX_DEFAULT_UINT64_HASH_FUNC;
+	if (0 == strcmp(str, "mod4"))
+		return hashset_test_hash_mod4;
+	if (0 == strcmp(str, "max"))
+		return hashset_test_hash_max;
+
+	fail_msg("unknown hash function: %s", str);
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hashset_test_check                                               *
+ *                                                                            *
+ * Purpose: checks that hashset contents match the reference set              *
+ *                                                                            *
+ ******************************************************************************/
+static void	hashset_test_check(zbx_hashset_t *hs, const zbx_vector_uint64_t *ids, const char *prefix)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_hashset_test_entry_t	*entry, local;
+	zbx_vector_uint64_t		visited;
+	int				i;
+	char				msg[MAX_STRING_LEN];
+
+	zbx_snprintf(msg, sizeof(msg), "%s: number of entries", prefix);
+	zbx_mock_assert_int_eq(msg, ids->values_num, hs->num_data);
+
+	for (i = 0; i < ids->values_num; i++)
+	{
+		local.id = ids->values[i];
+
+		if (NULL == (entry = (zbx_hashset_test_entry_t *)zbx_hashset_search(hs, &local)))
+			fail_msg("%s: cannot find entry " ZBX_FS_UI64, prefix, local.id);
+
+		zbx_snprintf(msg, sizeof(msg), "%s: entry " ZBX_FS_UI64 " value", prefix, local.id);
+		zbx_mock_assert_uint64_eq(msg, local.id * 2, entry->value);
+	}
+
+	zbx_vector_uint64_create(&visited);
+	zbx_hashset_iter_reset(hs, &iter);
+
+	while (NULL != (entry = (zbx_hashset_test_entry_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_uint64_append(&visited, entry->id);
+
+	zbx_vector_uint64_sort(&visited, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_snprintf(msg, sizeof(msg), "%s: number of iterated entries", prefix);
+	zbx_mock_assert_int_eq(msg, ids->values_num, visited.values_num);
+
+	for (i = 0; i < ids->values_num; i++)
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s: iterated entry", prefix);
+		zbx_mock_assert_uint64_eq(msg, ids->values[i], visited.values[i]);
+	}
+
+	zbx_vector_uint64_destroy(&visited);
+}
+
+static void	hashset_test_insert(zbx_hashset_t *hs, zbx_vector_uint64_t *ids, zbx_uint64_t id)
+{
+	zbx_hashset_test_entry_t	local, *entry;
+
+	local.id = id;
+	local.value = id * 2;
+
+	if (NULL == (entry = (zbx_hashset_test_entry_t *)zbx_hashset_insert(hs, &local, sizeof(local))))
+		fail_msg("cannot insert entry " ZBX_FS_UI64, id);
+
+	zbx_mock_assert_uint64_eq("inserted entry", id, entry->id);
+
+	if (NULL != ids && FAIL == zbx_vector_uint64_bsearch(ids, id, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+	{
+		zbx_vector_uint64_append(ids, id);
+		zbx_vector_uint64_sort(ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+}
+
+static void	hashset_test_remove(zbx_hashset_t *hs, zbx_vector_uint64_t *ids, zbx_uint64_t id, int direct)
+{
+	zbx_hashset_test_entry_t	local, *entry;
+	int				index;
+
+	local.id = id;
+
+	if (0 == direct)
+		zbx_hashset_remove(hs, &local);
+	else if (NULL != (entry = (zbx_hashset_test_entry_t *)zbx_hashset_search(hs, &local)))
+		zbx_hashset_remove_direct(hs, entry);
+
+	if (NULL != ids && FAIL != (index = zbx_vector_uint64_bsearch(ids, id, ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		zbx_vector_uint64_remove(ids, index);
+}
+
+static void	hashset_test_iter_remove(zbx_hashset_t *hs, zbx_vector_uint64_t *ids, zbx_uint64_t mod)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_hashset_test_entry_t	*entry;
+	int				index;
+
+	zbx_hashset_iter_reset(hs, &iter);
+
+	while (NULL != (entry = (zbx_hashset_test_entry_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (0 != entry->id % mod)
+			continue;
+
+		if (NULL != ids && FAIL != (index = zbx_vector_uint64_bsearch(ids, entry->id,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		{
+			zbx_vector_uint64_remove(ids, index);
+		}
+
+		zbx_hashset_iter_remove(&iter);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hashset_test_step                                                *
+ *                                                                            *
+ * Purpose: executes single test step on the hashset, updating reference set  *
+ *          if given                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	hashset_test_step(zbx_hashset_t *hs, zbx_vector_uint64_t *ids, zbx_mock_handle_t hstep)
+{
+	const char		*op;
+	zbx_uint64_t		id, from = 0, to = 0, step = 1;
+	zbx_mock_handle_t	hstep_size;
+
+	op = zbx_mock_get_object_member_string(hstep, "op");
+
+	if (0 == strcmp(op, "insert") || 0 == strcmp(op, "remove") || 0 == strcmp(op, "remove_direct"))
+	{
+		from = zbx_mock_get_object_member_uint64(hstep, "from");
+		to = zbx_mock_get_object_member_uint64(hstep, "to");
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "step", &hstep_size) &&
+				ZBX_MOCK_SUCCESS != zbx_mock_uint64(hstep_size, &step))
+		{
+			fail_msg("Cannot read step size");
+		}
+	}
+
+	if (0 == strcmp(op, "insert"))
+	{
+		for (id = from; id <= to; id += step)
+			hashset_test_insert(hs, ids, id);
+	}
+	else if (0 == strcmp(op, "remove"))
+	{
+		for (id = from; id <= to; id += step)
+			hashset_test_remove(hs, ids, id, 0);
+	}
+	else if (0 == strcmp(op, "remove_direct"))
+	{
+		for (id = from; id <= to; id += step)
+			hashset_test_remove(hs, ids, id, 1);
+	}
+	else if (0 == strcmp(op, "iter_remove"))
+	{
+		hashset_test_iter_remove(hs, ids, zbx_mock_get_object_member_uint64(hstep, "mod"));
+	}
+	else if (0 == strcmp(op, "reserve"))
+	{
+		zbx_mock_assert_int_eq("reserve", SUCCEED, zbx_hashset_reserve(hs,
+				(int)zbx_mock_get_object_member_uint64(hstep, "num")));
+	}
+	else if (0 == strcmp(op, "clear"))
+	{
+		zbx_hashset_clear(hs);
+
+		if (NULL != ids)
+			zbx_vector_uint64_clear(ids);
+	}
+	else
+		fail_msg("unknown operation: %s", op);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_hashset_t		hs[HASHSET_TEST_SETS_NUM];
+	const char		*names[HASHSET_TEST_SETS_NUM] = {"chained", "open"};
+	zbx_vector_uint64_t	ids;
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_mock_error_t	err;
+	zbx_hash_func_t		hash_func;
+	size_t			init_size;
+	int			i, step_num = 0, num_data;
+	char			prefix[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	hash_func = hashset_test_get_hash_func(zbx_mock_get_parameter_string("in.hash"));
+	init_size = (size_t)zbx_mock_get_parameter_uint64("in.init_size");
+
+	zbx_hashset_create_ext(&hs[0], init_size, hash_func, ZBX_DEFAULT_UINT64_COMPARE_FUNC, hashset_test_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create_open_ext(&hs[1], init_size, hash_func, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			hashset_test_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	zbx_vector_uint64_create(&ids);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read step: %s", zbx_mock_error_string(err));
+
+		step_num++;
+
+		/* the reference set is updated only with the first hashset */
+		for (i = 0; i < HASHSET_TEST_SETS_NUM; i++)
+		{
+			num_data = hs[i].num_data;
+			clean_calls = 0;
+
+			hashset_test_step(&hs[i], 0 == i ? &ids : NULL, hstep);
+
+			zbx_snprintf(prefix, sizeof(prefix), "%s hashset, step %d", names[i], step_num);
+			hashset_test_check(&hs[i], &ids, prefix);
+
+			/* steps either add or remove entries, every removed entry must be cleaned once */
+			zbx_mock_assert_int_eq(prefix, MAX(num_data - hs[i].num_data, 0), clean_calls);
+		}
+	}
+
+	zbx_mock_assert_int_eq("number of entries", (int)zbx_mock_get_parameter_uint64("out.num_data"),
+			ids.values_num);
+
+	for (i = 0; i < HASHSET_TEST_SETS_NUM; i++)
+	{
+		clean_calls = 0;
+		zbx_hashset_destroy(&hs[i]);
+		zbx_mock_assert_int_eq("cleaned entries", ids.values_num, clean_calls);
+	}
+
+	zbx_vector_uint64_destroy(&ids);
+}
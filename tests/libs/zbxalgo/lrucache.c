@@ -0,0 +1,147 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+typedef struct
+{
+	zbx_lrucache_link_t	link;
+	zbx_uint64_t		id;
+	zbx_uint64_t		*value;
+}
+zbx_lrucache_test_entry_t;
+
+static int	clean_calls;
+
+static zbx_hash_t	lrucache_test_hash(const void *data)
+{
+	const zbx_lrucache_test_entry_t	*entry = (const zbx_lrucache_test_entry_t *)data;
+
+	return ZBX_DEFAULT_UINT64_HASH_FUNC(&entry->id);
+}
+
+static int	lrucache_test_compare(const void *d1, const void *d2)
+{
+	const zbx_lrucache_test_entry_t	*e1 = (const zbx_lrucache_test_entry_t *)d1;
+	const zbx_lrucache_test_entry_t	*e2 = (const zbx_lrucache_test_entry_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->id, e2->id);
+
+	return 0;
+}
+
+static void	lrucache_test_clean(void *data)
+{
+	zbx_lrucache_test_entry_t	*entry = (zbx_lrucache_test_entry_t *)data;
+
+	zbx_free(entry->value);
+	clean_calls++;
+}
+
+static zbx_lrucache_t	cache = ZBX_LRUCACHE_INITIALIZER(0, lrucache_test_hash, lrucache_test_compare,
+		lrucache_test_clean);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: lrucache_test_get                                                *
+ *                                                                            *
+ * Purpose: gets entry from cache, inserting it if necessary                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	lrucache_test_get(zbx_uint64_t id)
+{
+	zbx_lrucache_test_entry_t	local, *entry;
+
+	local.id = id;
+
+	if (NULL == (entry = (zbx_lrucache_test_entry_t *)zbx_lrucache_search(&cache, &local)))
+	{
+		local.value = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t));
+		*local.value = id * 2;
+		entry = (zbx_lrucache_test_entry_t *)zbx_lrucache_insert(&cache, &local, sizeof(local));
+	}
+
+	zbx_mock_assert_uint64_eq("entry id", id, entry->id);
+	zbx_mock_assert_uint64_eq("entry value", id * 2, *entry->value);
+	zbx_mock_assert_ptr_eq("most recently used entry", entry, cache.head);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hids, hid;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		id;
+	zbx_lrucache_link_t	*link;
+	int			inserted, i = 0;
+	char			msg[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	cache.max_size = (int)zbx_mock_get_parameter_uint64("in.max_size");
+
+	hids = zbx_mock_get_parameter_handle("in.ids");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hids, &hid)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != zbx_mock_uint64(hid, &id))
+			fail_msg("Cannot read id: %s", zbx_mock_error_string(err));
+
+		lrucache_test_get(id);
+	}
+
+	zbx_mock_assert_uint64_eq("hits", zbx_mock_get_parameter_uint64("out.hits"), cache.hits);
+	zbx_mock_assert_uint64_eq("misses", zbx_mock_get_parameter_uint64("out.misses"), cache.misses);
+	zbx_mock_assert_uint64_eq("evictions", zbx_mock_get_parameter_uint64("out.evictions"), cache.evictions);
+	zbx_mock_assert_int_eq("cleaned evicted entries", (int)cache.evictions, clean_calls);
+
+	/* the cached entries from the most to the least recently used */
+	hids = zbx_mock_get_parameter_handle("out.ids");
+	link = cache.head;
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hids, &hid)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != zbx_mock_uint64(hid, &id))
+			fail_msg("Cannot read id: %s", zbx_mock_error_string(err));
+
+		if (NULL == link)
+			fail_msg("cache has less entries than expected");
+
+		zbx_snprintf(msg, sizeof(msg), "cached entry #%d", i++);
+		zbx_mock_assert_uint64_eq(msg, id, ((zbx_lrucache_test_entry_t *)link)->id);
+
+		if (NULL != link->next)
+			zbx_mock_assert_ptr_eq("previous entry link", link, link->next->prev);
+		else
+			zbx_mock_assert_ptr_eq("least recently used entry", link, cache.tail);
+
+		link = link->next;
+	}
+
+	if (NULL != link)
+		fail_msg("cache has more entries than expected");
+
+	inserted = (int)cache.misses;
+	zbx_lrucache_destroy(&cache);
+	zbx_mock_assert_int_eq("cleaned entries", inserted, clean_calls);
+}
@@ -40,7 +40,7 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
 	{
 		for (i = chunk->first_value; i <= chunk->last_value; i++)
-			vc_history_record_vector_append(values, value_type, &chunk->slots[i]);
+			vc_history_record_vector_append(values, value_type, &vch_chunk_slots(chunk, value_type)[i]);
 	}
 
 	return SUCCEED;
@@ -104,3 +104,22 @@ int	zbx_vc_get_cache_state(int *mode, zbx_uint64_t *hits, zbx_uint64_t *misses)
 
 	return SUCCEED;
 }
+
+int	zbx_vc_pack_unpack_values(const zbx_history_record_t *values, int values_num, unsigned char value_type,
+		zbx_history_record_t *unpacked, int *packed_size_max)
+{
+	unsigned char	*data;
+	int		size;
+
+	*packed_size_max = (values_num * ZBX_VC_PACKED_VALUE_BITS + 7) / 8;
+
+	/* allocate twice the maximum packed size to detect overflows without corrupting memory */
+	data = (unsigned char *)zbx_calloc(NULL, 2, (size_t)*packed_size_max);
+
+	size = vc_pack_values(values, values_num, value_type, data);
+	vc_unpack_values(data, values_num, value_type, unpacked);
+
+	zbx_free(data);
+
+	return size;
+}
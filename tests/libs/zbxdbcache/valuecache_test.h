@@ -26,5 +26,7 @@ int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int
 int	zbx_vc_get_item_state(zbx_uint64_t itemid, int *status, int *active_range, int *values_total,
 		int *db_cached_from);
 int	zbx_vc_get_cache_state(int *mode, zbx_uint64_t *hits, zbx_uint64_t *misses);
+int	zbx_vc_pack_unpack_values(const zbx_history_record_t *values, int values_num, unsigned char value_type,
+		zbx_history_record_t *unpacked, int *packed_size_max);
 
 #endif
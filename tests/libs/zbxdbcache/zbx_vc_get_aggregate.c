@@ -0,0 +1,273 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vcmock_aggregate_values                                          *
+ *                                                                            *
+ * Purpose: aggregates values returned by zbx_vc_get_values() in the same way *
+ *          as trigger functions did before in-cache aggregation              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vcmock_aggregate_values(const zbx_vector_history_record_t *values, unsigned char value_type, int func,
+		zbx_vc_aggregate_t *aggr)
+{
+	int	i;
+
+	memset(aggr, 0, sizeof(zbx_vc_aggregate_t));
+	aggr->func = func;
+	aggr->values_num = values->values_num;
+
+	if (ZBX_VC_AGGREGATE_COUNT == func || 0 == values->values_num)
+		return;
+
+	if (ITEM_VALUE_TYPE_UINT64 == value_type && ZBX_VC_AGGREGATE_AVG != func)
+	{
+		aggr->value.ui64 = values->values[0].value.ui64;
+
+		for (i = 1; i < values->values_num; i++)
+		{
+			zbx_uint64_t	value = values->values[i].value.ui64;
+
+			switch (func)
+			{
+				case ZBX_VC_AGGREGATE_SUM:
+					aggr->value.ui64 += value;
+					break;
+				case ZBX_VC_AGGREGATE_MIN:
+					if (value < aggr->value.ui64)
+						aggr->value.ui64 = value;
+					break;
+				case ZBX_VC_AGGREGATE_MAX:
+					if (value > aggr->value.ui64)
+						aggr->value.ui64 = value;
+					break;
+			}
+		}
+
+		return;
+	}
+
+	aggr->value.dbl = (ITEM_VALUE_TYPE_UINT64 == value_type ? (double)values->values[0].value.ui64 :
+			values->values[0].value.dbl);
+
+	for (i = 1; i < values->values_num; i++)
+	{
+		double	value = (ITEM_VALUE_TYPE_UINT64 == value_type ? (double)values->values[i].value.ui64 :
+				values->values[i].value.dbl);
+
+		switch (func)
+		{
+			case ZBX_VC_AGGREGATE_SUM:
+			case ZBX_VC_AGGREGATE_AVG:
+				aggr->value.dbl += value;
+				break;
+			case ZBX_VC_AGGREGATE_MIN:
+				if (value < aggr->value.dbl)
+					aggr->value.dbl = value;
+				break;
+			case ZBX_VC_AGGREGATE_MAX:
+				if (value > aggr->value.dbl)
+					aggr->value.dbl = value;
+				break;
+		}
+	}
+
+	if (ZBX_VC_AGGREGATE_AVG == func)
+		aggr->value.dbl /= values->values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vcmock_check_aggregate                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vcmock_check_aggregate(const char *prefix, unsigned char value_type, const zbx_vc_aggregate_t *expected,
+		const zbx_vc_aggregate_t *returned)
+{
+	zbx_mock_assert_int_eq(prefix, expected->values_num, returned->values_num);
+
+	if (ZBX_VC_AGGREGATE_COUNT == expected->func || 0 == expected->values_num)
+		return;
+
+	if (ITEM_VALUE_TYPE_UINT64 == value_type && ZBX_VC_AGGREGATE_AVG != expected->func)
+		zbx_mock_assert_uint64_eq(prefix, expected->value.ui64, returned->value.ui64);
+	else
+		zbx_mock_assert_double_eq(prefix, expected->value.dbl, returned->value.dbl);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vcmock_read_aggregate                                            *
+ *                                                                            *
+ * Purpose: reads expected aggregate from out.<function> parameter            *
+ *                                                                            *
+ * Return value: SUCCEED - the expected aggregate was read                    *
+ *               FAIL    - the parameter is not defined                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vcmock_read_aggregate(const char *name, unsigned char value_type, int values_num,
+		zbx_vc_aggregate_t *aggr)
+{
+	char		path[MAX_STRING_LEN];
+	const char	*data;
+
+	zbx_snprintf(path, sizeof(path), "out.%s", name);
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists(path))
+		return FAIL;
+
+	data = zbx_mock_get_parameter_string(path);
+
+	if (ZBX_VC_AGGREGATE_COUNT == aggr->func)
+	{
+		aggr->values_num = atoi(data);
+		return SUCCEED;
+	}
+
+	aggr->values_num = values_num;
+
+	if (ITEM_VALUE_TYPE_UINT64 == value_type && ZBX_VC_AGGREGATE_AVG != aggr->func)
+	{
+		if (FAIL == is_uint64(data, &aggr->value.ui64))
+			fail_msg("Invalid %s value \"%s\"", path, data);
+	}
+	else
+		aggr->value.dbl = atof(data);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ * Comments: Every aggregate function is calculated in cache and compared     *
+ *           with aggregation of values returned by zbx_vc_get_values(), and  *
+ *           with out.<function> values when they are defined.                *
+ *           If in.test.storage aggregate period is defined, the history      *
+ *           storage aggregation is emulated and the number of storage        *
+ *           requests is compared with out.storage value.                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	const char			*functions[] = {"sum", "avg", "min", "max", "count"};
+	char				*error = NULL, prefix[MAX_STRING_LEN];
+	int				err, seconds, count, func;
+	zbx_vector_history_record_t	values;
+	zbx_timespec_t			ts;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+	zbx_mock_handle_t		handle, hitem;
+	zbx_mock_error_t		mock_err;
+	zbx_vc_aggregate_t		returned[ARRSIZE(functions)], expected;
+
+	ZBX_UNUSED(state);
+
+	/* set small cache size to force smaller cache free request size (5% of cache size) */
+	CONFIG_VALUE_CACHE_SIZE = ZBX_KIBIBYTE;
+
+	err = zbx_locks_create(&error);
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, err);
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+
+	zbx_vcmock_ds_init();
+	zbx_history_record_vector_create(&values);
+
+	/* precache values */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.precache", &handle))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+		{
+			zbx_vcmock_set_time(hitem, "time");
+			zbx_vcmock_set_mode(hitem, "cache mode");
+			zbx_vcmock_set_cache_size(hitem, "cache size");
+
+			zbx_vcmock_get_request_params(hitem, &itemid, &value_type, &seconds, &count, &ts);
+			zbx_vc_precache_values(itemid, value_type, seconds, count, &ts);
+		}
+	}
+
+	/* aggregate in cache first, so the values are not cached by zbx_vc_get_values() request */
+
+	handle = zbx_mock_get_parameter_handle("in.test");
+	zbx_vcmock_set_time(handle, "time");
+	zbx_vcmock_set_mode(handle, "cache mode");
+	zbx_vcmock_set_storage_aggregate(handle, "storage aggregate");
+
+	zbx_vcmock_get_request_params(handle, &itemid, &value_type, &seconds, &count, &ts);
+
+	for (func = 0; func < (int)ARRSIZE(functions); func++)
+	{
+		zbx_snprintf(prefix, sizeof(prefix), "zbx_vc_get_aggregate(%s)", functions[func]);
+		err = zbx_vc_get_aggregate(itemid, value_type, func, seconds, count, &ts, &returned[func]);
+		zbx_mock_assert_result_eq(prefix, SUCCEED, err);
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.storage"))
+	{
+		zbx_mock_assert_int_eq("history storage aggregate requests",
+				(int)zbx_mock_get_parameter_uint64("out.storage"), zbx_vcmock_get_storage_aggregate_calls());
+	}
+
+	err = zbx_vc_get_values(itemid, value_type, &values, seconds, count, &ts);
+	zbx_vc_flush_stats();
+	zbx_mock_assert_result_eq("zbx_vc_get_values() return value", SUCCEED, err);
+
+	/* validate results */
+
+	for (func = 0; func < (int)ARRSIZE(functions); func++)
+	{
+		zbx_snprintf(prefix, sizeof(prefix), "%s of zbx_vc_get_values()", functions[func]);
+		vcmock_aggregate_values(&values, value_type, func, &expected);
+		vcmock_check_aggregate(prefix, value_type, &expected, &returned[func]);
+
+		if (SUCCEED == vcmock_read_aggregate(functions[func], value_type, values.values_num, &expected))
+		{
+			zbx_snprintf(prefix, sizeof(prefix), "expected %s", functions[func]);
+			vcmock_check_aggregate(prefix, value_type, &expected, &returned[func]);
+		}
+	}
+
+	/* cleanup */
+
+	zbx_history_record_vector_destroy(&values, value_type);
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
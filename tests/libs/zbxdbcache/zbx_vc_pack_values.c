@@ -0,0 +1,94 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ * Comments: Values are compared by their bit representation, so NaN and      *
+ *           negative zero must be restored exactly.                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vector_history_record_t	values;
+	zbx_history_record_t		*unpacked;
+	unsigned char			value_type;
+	int				i, size, size_max;
+	zbx_uint64_t			expected_bits, returned_bits, max_size;
+	char				prefix[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_parameter_string("in.type"));
+
+	zbx_history_record_vector_create(&values);
+	zbx_vcmock_read_values(zbx_mock_get_parameter_handle("in.values"), value_type, &values);
+
+	if (0 == values.values_num)
+		fail_msg("in.values parameter must contain at least one value");
+
+	unpacked = (zbx_history_record_t *)zbx_calloc(NULL, (size_t)values.values_num, sizeof(zbx_history_record_t));
+
+	size = zbx_vc_pack_unpack_values(values.values, values.values_num, value_type, unpacked, &size_max);
+
+	if (size > size_max)
+		fail_msg("packed size %d exceeds the maximum packed size %d", size, size_max);
+
+	/* optional check that encoding actually reduces the size of regular data */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.max_size") &&
+			(zbx_uint64_t)size > (max_size = zbx_mock_get_parameter_uint64("out.max_size")))
+	{
+		fail_msg("packed size %d exceeds expected maximum size " ZBX_FS_UI64, size, max_size);
+	}
+
+	for (i = 0; i < values.values_num; i++)
+	{
+		zbx_snprintf(prefix, sizeof(prefix), "value #%d", i);
+
+		zbx_mock_assert_int_eq(prefix, values.values[i].timestamp.sec, unpacked[i].timestamp.sec);
+		zbx_mock_assert_int_eq(prefix, values.values[i].timestamp.ns, unpacked[i].timestamp.ns);
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			memcpy(&expected_bits, &values.values[i].value.dbl, sizeof(expected_bits));
+			memcpy(&returned_bits, &unpacked[i].value.dbl, sizeof(returned_bits));
+		}
+		else
+		{
+			expected_bits = values.values[i].value.ui64;
+			returned_bits = unpacked[i].value.ui64;
+		}
+
+		zbx_mock_assert_uint64_eq(prefix, expected_bits, returned_bits);
+	}
+
+	zbx_free(unpacked);
+	zbx_history_record_vector_destroy(&values, value_type);
+}
@@ -0,0 +1,447 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "log.h"
+#include "zbxalgo.h"
+#include "zbxjson.h"
+#include "zbxhistory.h"
+#include "../../../src/libs/zbxhistory/history.h"
+#include "../../../src/libs/zbxalgo/vectorimpl.h"
+
+int	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
+void	__wrap_zbx_history_sql_wait(zbx_vector_uint64_t *itemids);
+
+int	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error)
+{
+	ZBX_UNUSED(hist);
+	ZBX_UNUSED(value_type);
+	ZBX_UNUSED(error);
+
+	return SUCCEED;
+}
+
+void	__wrap_zbx_history_sql_wait(zbx_vector_uint64_t *itemids)
+{
+	ZBX_UNUSED(itemids);
+}
+
+#if defined(HAVE_LIBCURL) && LIBCURL_VERSION_NUM >= 0x071c00
+
+extern char	*CONFIG_HISTORY_STORAGE_URL;
+
+#define ZBX_ELASTIC_MOCK_URL	"http://localhost:9200"
+#define ZBX_ELASTIC_MOCK_PIT_ID	"pit"
+
+typedef struct
+{
+	int		clock;
+	int		ns;
+	zbx_uint64_t	value;
+	int		index;
+}
+zbx_elastic_mock_value_t;
+
+ZBX_VECTOR_DECL(elastic_mock_value, zbx_elastic_mock_value_t)
+ZBX_VECTOR_IMPL(elastic_mock_value, zbx_elastic_mock_value_t)
+
+static zbx_vector_elastic_mock_value_t	storage;
+static size_t				(*write_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+static void				*write_data;
+static const char			*post_data, *url, *method;
+static int				requests_num, pits_num, dummy;
+
+CURL		*__wrap_curl_easy_init(void);
+CURLcode	__wrap_curl_easy_setopt(CURL *easyhandle, int opt, void *val);
+CURLcode	__wrap_curl_easy_perform(CURL *easyhandle);
+void		__wrap_curl_easy_cleanup(CURL *easyhandle);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_mock_value_compare                                       *
+ *                                                                            *
+ * Purpose: sorts values by timestamp in descending order, values with equal  *
+ *          timestamps keep the storage order                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	elastic_mock_value_compare(const void *d1, const void *d2)
+{
+	const zbx_elastic_mock_value_t	*v1 = (const zbx_elastic_mock_value_t *)d1;
+	const zbx_elastic_mock_value_t	*v2 = (const zbx_elastic_mock_value_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(v2->clock, v1->clock);
+	ZBX_RETURN_IF_NOT_EQUAL(v2->ns, v1->ns);
+	ZBX_RETURN_IF_NOT_EQUAL(v1->index, v2->index);
+
+	return 0;
+}
+
+static void	elastic_mock_read_values(const char *path, zbx_vector_elastic_mock_value_t *values)
+{
+	zbx_mock_handle_t		hvalues, hvalue;
+	zbx_mock_error_t		err;
+	zbx_elastic_mock_value_t	value;
+
+	hvalues = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hvalues, &hvalue)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read %s element: %s", path, zbx_mock_error_string(err));
+
+		value.clock = (int)zbx_mock_get_object_member_uint64(hvalue, "clock");
+		value.ns = (int)zbx_mock_get_object_member_uint64(hvalue, "ns");
+		value.value = zbx_mock_get_object_member_uint64(hvalue, "value");
+		value.index = values->values_num;
+
+		zbx_vector_elastic_mock_value_append(values, value);
+	}
+}
+
+static int	elastic_mock_get_int(const struct zbx_json_parse *jp, const char *name, int *value)
+{
+	char	buf[MAX_ID_LEN + 1];
+
+	if (SUCCEED != zbx_json_value_by_name(jp, name, buf, sizeof(buf), NULL))
+		return FAIL;
+
+	*value = atoi(buf);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_mock_search                                              *
+ *                                                                            *
+ * Purpose: emulates search request of item history values                    *
+ *                                                                            *
+ * Comments: Supports page size, clock range, point in time and search_after  *
+ *           parameters of the request, other parameters are ignored.         *
+ *           In point in time the storage order of values is used as          *
+ *           tiebreaker.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	elastic_mock_search(const char *query, struct zbx_json *response)
+{
+	struct zbx_json_parse		jp, jp_after, jp_filter, jp_clause, jp_range, jp_clock, jp_pit;
+	const char			*p = NULL;
+	char				buf[MAX_ID_LEN + 1];
+	int				i, size, start = 0, end = 0, hits_num = 0, pit = 0;
+	zbx_elastic_mock_value_t	after;
+
+	if (SUCCEED != zbx_json_open(query, &jp))
+		fail_msg("Cannot parse search request: %s", zbx_json_strerror());
+
+	if (SUCCEED == zbx_json_brackets_by_name(&jp, "pit", &jp_pit))
+	{
+		if (SUCCEED != zbx_json_value_by_name(&jp_pit, "id", buf, sizeof(buf), NULL) ||
+				0 != strcmp(buf, ZBX_ELASTIC_MOCK_PIT_ID) || 0 == pits_num)
+		{
+			fail_msg("Search request with invalid point in time: %s", query);
+		}
+
+		zbx_mock_assert_str_eq("point in time search url", ZBX_ELASTIC_MOCK_URL "/_search", url);
+		pit = 1;
+	}
+
+	if (SUCCEED != elastic_mock_get_int(&jp, "size", &size))
+		fail_msg("Search request without page size: %s", query);
+
+	if (SUCCEED == zbx_json_brackets_by_name(&jp, "query", &jp_clause) &&
+			SUCCEED == zbx_json_brackets_by_name(&jp_clause, "bool", &jp_filter) &&
+			SUCCEED == zbx_json_brackets_by_name(&jp_filter, "filter", &jp_filter))
+	{
+		while (NULL != (p = zbx_json_next(&jp_filter, p)))
+		{
+			if (SUCCEED == zbx_json_brackets_open(p, &jp_clause) &&
+					SUCCEED == zbx_json_brackets_by_name(&jp_clause, "range", &jp_range) &&
+					SUCCEED == zbx_json_brackets_by_name(&jp_range, "clock", &jp_clock))
+			{
+				elastic_mock_get_int(&jp_clock, "gt", &start);
+				elastic_mock_get_int(&jp_clock, "lte", &end);
+			}
+		}
+	}
+
+	if (SUCCEED == zbx_json_brackets_by_name(&jp, "search_after", &jp_after))
+	{
+		if (NULL == (p = zbx_json_next_value(&jp_after, NULL, buf, sizeof(buf), NULL)))
+			fail_msg("Invalid search_after parameter: %s", query);
+
+		after.clock = atoi(buf);
+
+		if (NULL == (p = zbx_json_next_value(&jp_after, p, buf, sizeof(buf), NULL)))
+			fail_msg("Invalid search_after parameter: %s", query);
+
+		after.ns = atoi(buf);
+
+		if (0 != pit)
+		{
+			if (NULL == (p = zbx_json_next_value(&jp_after, p, buf, sizeof(buf), NULL)))
+				fail_msg("Invalid search_after parameter: %s", query);
+
+			after.index = atoi(buf);
+		}
+		else
+			after.index = INT_MAX;
+	}
+	else
+		after.clock = 0;
+
+	if (0 != pit)
+		zbx_json_addstring(response, "pit_id", ZBX_ELASTIC_MOCK_PIT_ID, ZBX_JSON_TYPE_STRING);
+
+	zbx_json_addobject(response, "hits");
+	zbx_json_addarray(response, "hits");
+
+	for (i = 0; i < storage.values_num && hits_num < size; i++)
+	{
+		const zbx_elastic_mock_value_t	*value = &storage.values[i];
+
+		if ((0 != start && value->clock <= start) || (0 != end && value->clock > end))
+			continue;
+
+		/* all values with sort values equal to search_after are skipped, like done by storage */
+		if (0 != after.clock && (value->clock > after.clock || (value->clock == after.clock &&
+				(value->ns > after.ns || (value->ns == after.ns && value->index <= after.index)))))
+		{
+			continue;
+		}
+
+		zbx_json_addobject(response, NULL);
+		zbx_json_addobject(response, "fields");
+		zbx_json_addarray(response, "clock");
+		zbx_json_addint64(response, NULL, value->clock);
+		zbx_json_close(response);
+		zbx_json_addarray(response, "ns");
+		zbx_json_addint64(response, NULL, value->ns);
+		zbx_json_close(response);
+		zbx_json_addarray(response, "value");
+		zbx_json_adduint64(response, NULL, value->value);
+		zbx_json_close(response);
+		zbx_json_close(response);
+		zbx_json_addarray(response, "sort");
+		zbx_json_addint64(response, NULL, value->clock);
+		zbx_json_addint64(response, NULL, value->ns);
+
+		if (0 != pit)
+			zbx_json_addint64(response, NULL, value->index);
+
+		zbx_json_close(response);
+		zbx_json_close(response);
+
+		hits_num++;
+	}
+
+	zbx_json_close(response);
+	zbx_json_close(response);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_mock_pit                                                 *
+ *                                                                            *
+ * Purpose: emulates opening and closing point in time                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	elastic_mock_pit(struct zbx_json *response)
+{
+	struct zbx_json_parse	jp;
+	char			buf[MAX_ID_LEN + 1];
+
+	if (NULL != method && 0 == strcmp(method, "DELETE"))
+	{
+		zbx_mock_assert_str_eq("point in time close url", ZBX_ELASTIC_MOCK_URL "/_pit", url);
+
+		if (SUCCEED != zbx_json_open(post_data, &jp) ||
+				SUCCEED != zbx_json_value_by_name(&jp, "id", buf, sizeof(buf), NULL))
+		{
+			fail_msg("Invalid point in time close request: %s", post_data);
+		}
+
+		zbx_mock_assert_str_eq("closed point in time id", ZBX_ELASTIC_MOCK_PIT_ID, buf);
+		zbx_mock_assert_int_eq("number of open points in time", 1, pits_num);
+
+		pits_num--;
+		zbx_json_addraw(response, "succeeded", "true");
+		zbx_json_addint64(response, "num_freed", 1);
+
+		return;
+	}
+
+	zbx_mock_assert_int_eq("number of open points in time", 0, pits_num);
+
+	pits_num++;
+	zbx_json_addstring(response, "id", ZBX_ELASTIC_MOCK_PIT_ID, ZBX_JSON_TYPE_STRING);
+}
+
+CURL	*__wrap_curl_easy_init(void)
+{
+	return (CURL *)&dummy;
+}
+
+CURLcode	__wrap_curl_easy_setopt(CURL *easyhandle, int opt, void *val)
+{
+	ZBX_UNUSED(easyhandle);
+
+	switch (opt)
+	{
+		case CURLOPT_WRITEFUNCTION:
+			write_cb = val;
+			break;
+		case CURLOPT_WRITEDATA:
+			write_data = val;
+			break;
+		case CURLOPT_POSTFIELDS:
+			post_data = (const char *)val;
+			break;
+		case CURLOPT_URL:
+			url = (const char *)val;
+			break;
+		case CURLOPT_CUSTOMREQUEST:
+			method = (const char *)val;
+			break;
+	}
+
+	return CURLE_OK;
+}
+
+CURLcode	__wrap_curl_easy_perform(CURL *easyhandle)
+{
+	struct zbx_json	response;
+
+	ZBX_UNUSED(easyhandle);
+
+	requests_num++;
+
+	zbx_json_init(&response, ZBX_JSON_STAT_BUF_LEN);
+
+	if (NULL != strstr(url, "/_pit"))
+		elastic_mock_pit(&response);
+	else
+		elastic_mock_search(post_data, &response);
+
+	write_cb(response.buffer, 1, response.buffer_size, write_data);
+	zbx_json_free(&response);
+
+	return CURLE_OK;
+}
+
+void	__wrap_curl_easy_cleanup(CURL *easyhandle)
+{
+	ZBX_UNUSED(easyhandle);
+}
+
+static int	history_record_compare(const void *d1, const void *d2)
+{
+	const zbx_history_record_t	*r1 = (const zbx_history_record_t *)d1;
+	const zbx_history_record_t	*r2 = (const zbx_history_record_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r2->timestamp.sec, r1->timestamp.sec);
+	ZBX_RETURN_IF_NOT_EQUAL(r2->timestamp.ns, r1->timestamp.ns);
+	ZBX_RETURN_IF_NOT_EQUAL(r1->value.ui64, r2->value.ui64);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ * Comments: The values are read in pages of ZBX_ELASTIC_PAGE_SIZE values,    *
+ *           which is reduced for tests. The expected values must be sorted   *
+ *           by timestamp in descending order and values with equal           *
+ *           timestamps by value in ascending order.                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_history_iface_t		hist;
+	zbx_vector_history_record_t	values;
+	zbx_vector_elastic_mock_value_t	expected;
+	zbx_mock_handle_t		handle;
+	char				*error = NULL, prefix[MAX_STRING_LEN];
+	int				i;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_HISTORY_STORAGE_URL = ZBX_ELASTIC_MOCK_URL;
+
+	zbx_vector_elastic_mock_value_create(&storage);
+	elastic_mock_read_values("in.history", &storage);
+	zbx_vector_elastic_mock_value_sort(&storage, elastic_mock_value_compare);
+
+	if (SUCCEED != zbx_history_elastic_init(&hist, ITEM_VALUE_TYPE_UINT64, &error))
+		fail_msg("Cannot initialize history storage: %s", error);
+
+	zbx_history_record_vector_create(&values);
+
+	zbx_mock_assert_result_eq("get_values() return value", SUCCEED, hist.get_values(&hist,
+			zbx_mock_get_parameter_uint64("in.itemid"), (int)zbx_mock_get_parameter_uint64("in.start"),
+			(int)zbx_mock_get_parameter_uint64("in.count"), (int)zbx_mock_get_parameter_uint64("in.end"),
+			&values));
+
+	zbx_vector_elastic_mock_value_create(&expected);
+	elastic_mock_read_values("out.values", &expected);
+
+	zbx_mock_assert_int_eq("number of values", expected.values_num, values.values_num);
+
+	zbx_vector_history_record_sort(&values, history_record_compare);
+
+	for (i = 0; i < expected.values_num; i++)
+	{
+		zbx_snprintf(prefix, sizeof(prefix), "value #%d clock", i);
+		zbx_mock_assert_int_eq(prefix, expected.values[i].clock, values.values[i].timestamp.sec);
+		zbx_snprintf(prefix, sizeof(prefix), "value #%d ns", i);
+		zbx_mock_assert_int_eq(prefix, expected.values[i].ns, values.values[i].timestamp.ns);
+		zbx_snprintf(prefix, sizeof(prefix), "value #%d", i);
+		zbx_mock_assert_uint64_eq(prefix, expected.values[i].value, values.values[i].value.ui64);
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("out.requests", &handle))
+	{
+		zbx_mock_assert_int_eq("number of requests", (int)zbx_mock_get_parameter_uint64("out.requests"),
+				requests_num);
+	}
+
+	zbx_mock_assert_int_eq("number of points in time left open", 0, pits_num);
+
+	zbx_vector_elastic_mock_value_destroy(&expected);
+	zbx_history_record_vector_destroy(&values, ITEM_VALUE_TYPE_UINT64);
+	zbx_vector_elastic_mock_value_destroy(&storage);
+
+	hist.destroy(&hist);
+}
+
+#else
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+
+#endif
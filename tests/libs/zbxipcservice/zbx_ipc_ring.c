@@ -0,0 +1,164 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxipcservice.h"
+
+#ifdef ZBX_IPC_RING_ENABLED
+
+/* record data is filled with bytes derived from record sequence number, */
+/* so records read in wrong order or damaged by wrap-around are detected */
+static void	mock_fill_record(unsigned char *data, zbx_uint32_t size, int seq)
+{
+	zbx_uint32_t	i;
+
+	for (i = 0; i < size; i++)
+		data[i] = (unsigned char)(seq * 31 + i);
+}
+
+static void	mock_ring_write(zbx_ipc_ring_t *ring, zbx_mock_handle_t hstep, int *write_seq)
+{
+	zbx_uint32_t		size;
+	unsigned char		*data;
+	int			expected_ret, ret, wakeup = -1;
+	zbx_mock_handle_t	hwakeup;
+
+	size = (zbx_uint32_t)zbx_mock_get_object_member_uint64(hstep, "size");
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+
+	data = (unsigned char *)zbx_malloc(NULL, size + 1);
+	mock_fill_record(data, size, *write_seq);
+
+	ret = zbx_ipc_ring_write(ring, data, size, &wakeup);
+	zbx_free(data);
+
+	zbx_mock_assert_result_eq("zbx_ipc_ring_write()", expected_ret, ret);
+
+	if (SUCCEED != ret)
+		return;
+
+	(*write_seq)++;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "wakeup", &hwakeup))
+	{
+		const char	*value;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hwakeup, &value))
+			fail_msg("Cannot read step wakeup value");
+
+		zbx_mock_assert_int_eq("zbx_ipc_ring_write() wakeup", atoi(value), wakeup);
+	}
+}
+
+static void	mock_ring_read(zbx_ipc_ring_t *ring, zbx_mock_handle_t hstep, int *read_seq)
+{
+	zbx_uint32_t	size, expected_size;
+	unsigned char	*data, *expected_data;
+
+	expected_size = (zbx_uint32_t)zbx_mock_get_object_member_uint64(hstep, "size");
+
+	if (NULL == (data = zbx_ipc_ring_peek(ring, &size)))
+		fail_msg("Expected record of size %u but the ring buffer is empty", expected_size);
+
+	zbx_mock_assert_uint64_eq("zbx_ipc_ring_peek() record size", expected_size, size);
+
+	expected_data = (unsigned char *)zbx_malloc(NULL, size + 1);
+	mock_fill_record(expected_data, size, *read_seq);
+
+	if (0 != memcmp(data, expected_data, size))
+		fail_msg("Record #%d data does not match written data", *read_seq);
+
+	zbx_free(expected_data);
+
+	zbx_ipc_ring_pop(ring);
+	(*read_seq)++;
+}
+
+static void	mock_ring_empty(zbx_ipc_ring_t *ring, zbx_mock_handle_t hstep)
+{
+	zbx_uint32_t	size;
+	int		expected_ret;
+
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+	zbx_mock_assert_result_eq("zbx_ipc_ring_is_empty()", expected_ret, zbx_ipc_ring_is_empty(ring));
+
+	if (SUCCEED == expected_ret)
+		zbx_mock_assert_ptr_eq("zbx_ipc_ring_peek()", NULL, zbx_ipc_ring_peek(ring, &size));
+	else
+		zbx_mock_assert_ptr_ne("zbx_ipc_ring_peek()", NULL, zbx_ipc_ring_peek(ring, &size));
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_ipc_ring_t		*ring;
+	zbx_uint32_t		size;
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_mock_error_t	err;
+	const char		*op;
+	int			write_seq = 0, read_seq = 0;
+
+	ZBX_UNUSED(state);
+
+	size = (zbx_uint32_t)zbx_mock_get_parameter_uint64("in.size");
+	ring = (zbx_ipc_ring_t *)zbx_malloc(NULL, zbx_ipc_ring_required_size(size));
+	zbx_ipc_ring_init(ring, size);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.max_record"))
+	{
+		zbx_mock_assert_uint64_eq("zbx_ipc_ring_max_record()", zbx_mock_get_parameter_uint64("out.max_record"),
+				zbx_ipc_ring_max_record(ring));
+	}
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read ring buffer operation: %s", zbx_mock_error_string(err));
+
+		op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "write"))
+			mock_ring_write(ring, hstep, &write_seq);
+		else if (0 == strcmp(op, "read"))
+			mock_ring_read(ring, hstep, &read_seq);
+		else if (0 == strcmp(op, "empty"))
+			mock_ring_empty(ring, hstep);
+		else
+			fail_msg("Unknown ring buffer operation \"%s\"", op);
+	}
+
+	zbx_free(ring);
+}
+
+#else
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxalgo.h"
+#include "zbxjson.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Function: read_paths                                                       *
+ *                                                                            *
+ * Purpose: read jsonpaths from test case data, repeating the list to check   *
+ *          queries exceeding compiled jsonpath cache size                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	read_paths(zbx_vector_str_t *paths)
+{
+	zbx_mock_handle_t	hpaths, hpath;
+	zbx_mock_error_t	err;
+	const char		*path;
+	int			i, repeat = 1, paths_num;
+
+	hpaths = zbx_mock_get_parameter_handle("in.paths");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hpaths, &hpath))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hpath, &path)))
+			fail_msg("Cannot read jsonpath: %s", zbx_mock_error_string(err));
+
+		zbx_vector_str_append(paths, (char *)path);
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.repeat"))
+		repeat = (int)zbx_mock_get_parameter_uint64("in.repeat");
+
+	paths_num = paths->values_num;
+
+	while (0 < --repeat)
+	{
+		for (i = 0; i < paths_num; i++)
+			zbx_vector_str_append(paths, paths->values[i]);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*data;
+	struct zbx_json_parse	jp;
+	zbx_vector_str_t	paths;
+	char			**outputs, **errors, *output, msg[MAX_STRING_LEN];
+	int			i, ret;
+
+	ZBX_UNUSED(state);
+
+	data = zbx_mock_get_parameter_string("in.data");
+	if (FAIL == zbx_json_open(data, &jp))
+		fail_msg("Invalid json data: %s", zbx_json_strerror());
+
+	zbx_vector_str_create(&paths);
+	read_paths(&paths);
+
+	outputs = (char **)zbx_calloc(NULL, (size_t)paths.values_num, sizeof(char *));
+	errors = (char **)zbx_calloc(NULL, (size_t)paths.values_num, sizeof(char *));
+
+	zbx_jsonpath_query_multi(&jp, (const char **)paths.values, paths.values_num, outputs, errors);
+
+	/* multi-path query must return the same results as querying each path separately */
+	for (i = 0; i < paths.values_num; i++)
+	{
+		output = NULL;
+		ret = zbx_jsonpath_query(&jp, paths.values[i], &output);
+
+		printf("\tpath #%d '%s': %s\n", i, paths.values[i], SUCCEED == ret ? ZBX_NULL2EMPTY_STR(output) :
+				zbx_json_strerror());
+
+		zbx_snprintf(msg, sizeof(msg), "path #%d '%s' error", i, paths.values[i]);
+
+		if (SUCCEED == ret)
+		{
+			zbx_mock_assert_ptr_eq(msg, NULL, errors[i]);
+
+			zbx_snprintf(msg, sizeof(msg), "path #%d '%s' result", i, paths.values[i]);
+
+			if (NULL == output)
+			{
+				zbx_mock_assert_ptr_eq(msg, NULL, outputs[i]);
+			}
+			else
+			{
+				zbx_mock_assert_ptr_ne(msg, NULL, outputs[i]);
+				zbx_mock_assert_str_eq(msg, output, outputs[i]);
+			}
+		}
+		else
+		{
+			zbx_mock_assert_ptr_ne(msg, NULL, errors[i]);
+			zbx_mock_assert_str_eq(msg, zbx_json_strerror(), errors[i]);
+			zbx_mock_assert_ptr_eq(msg, NULL, outputs[i]);
+		}
+
+		zbx_free(output);
+		zbx_free(outputs[i]);
+		zbx_free(errors[i]);
+	}
+
+	zbx_free(errors);
+	zbx_free(outputs);
+	zbx_vector_str_destroy(&paths);
+}
@@ -0,0 +1,261 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "memalloc.h"
+
+typedef struct
+{
+	const char	*group;
+	unsigned char	*ptr;
+	zbx_uint64_t	size;
+	int		seq;
+}
+zbx_mock_object_t;
+
+static zbx_mock_object_t	*objects = NULL;
+static int			objects_num = 0, objects_alloc = 0, objects_seq = 0;
+
+/* object data is filled with bytes derived from object sequence number, */
+/* so objects overlapping or damaged by reallocation are detected        */
+static void	mock_fill_object(zbx_mock_object_t *object)
+{
+	zbx_uint64_t	i;
+
+	for (i = 0; i < object->size; i++)
+		object->ptr[i] = (unsigned char)(object->seq * 31 + i);
+}
+
+static void	mock_check_object(const zbx_mock_object_t *object, zbx_uint64_t size)
+{
+	zbx_uint64_t	i;
+
+	for (i = 0; i < size; i++)
+	{
+		if (object->ptr[i] != (unsigned char)(object->seq * 31 + i))
+			fail_msg("object #%d of size " ZBX_FS_UI64 " is damaged at offset " ZBX_FS_UI64, object->seq,
+					object->size, i);
+	}
+}
+
+static int	mock_alloc_object(zbx_mem_info_t *mem, const char *group, zbx_uint64_t size)
+{
+	zbx_mock_object_t	*object;
+	unsigned char		*ptr;
+
+	if (NULL == (ptr = (unsigned char *)zbx_mem_malloc(mem, NULL, size)))
+		return FAIL;
+
+	if (objects_num == objects_alloc)
+	{
+		objects_alloc += 1024;
+		objects = (zbx_mock_object_t *)zbx_realloc(objects, sizeof(zbx_mock_object_t) * objects_alloc);
+	}
+
+	object = &objects[objects_num++];
+	object->group = group;
+	object->ptr = ptr;
+	object->size = size;
+	object->seq = objects_seq++;
+	mock_fill_object(object);
+
+	return SUCCEED;
+}
+
+static void	mock_free_object(zbx_mem_info_t *mem, int index)
+{
+	mock_check_object(&objects[index], objects[index].size);
+	zbx_mem_free(mem, objects[index].ptr);
+
+	memmove(&objects[index], &objects[index + 1], sizeof(zbx_mock_object_t) * (objects_num - index - 1));
+	objects_num--;
+}
+
+static void	mock_step_alloc(zbx_mem_info_t *mem, zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hnum, hret;
+	const char		*group;
+	zbx_uint64_t		size, num = 1, i;
+	int			expected_ret = SUCCEED, ret = SUCCEED;
+
+	group = zbx_mock_get_object_member_string(hstep, "group");
+	size = zbx_mock_get_object_member_uint64(hstep, "size");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "num", &hnum))
+		num = zbx_mock_get_object_member_uint64(hstep, "num");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "return", &hret))
+		expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+
+	for (i = 0; i < num && SUCCEED == ret; i++)
+		ret = mock_alloc_object(mem, group, size);
+
+	zbx_mock_assert_result_eq("allocation result", expected_ret, ret);
+}
+
+static void	mock_step_fill(zbx_mem_info_t *mem, zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hmin;
+	const char		*group;
+	zbx_uint64_t		size, num = 0;
+
+	group = zbx_mock_get_object_member_string(hstep, "group");
+	size = zbx_mock_get_object_member_uint64(hstep, "size");
+
+	while (SUCCEED == mock_alloc_object(mem, group, size))
+		num++;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "min", &hmin) &&
+			zbx_mock_get_object_member_uint64(hstep, "min") > num)
+	{
+		fail_msg("only " ZBX_FS_UI64 " objects of size " ZBX_FS_UI64 " were allocated", num, size);
+	}
+}
+
+static void	mock_step_free(zbx_mem_info_t *mem, zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hkeep;
+	const char		*group;
+	zbx_uint64_t		keep = 0;
+	int			i;
+
+	group = zbx_mock_get_object_member_string(hstep, "group");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "keep", &hkeep))
+		keep = zbx_mock_get_object_member_uint64(hstep, "keep");
+
+	/* keep the most recently allocated objects of the group */
+	for (i = objects_num - 1; 0 <= i; i--)
+	{
+		if (0 != strcmp(objects[i].group, group))
+			continue;
+
+		if (0 != keep)
+			keep--;
+		else
+			mock_free_object(mem, i);
+	}
+}
+
+static void	mock_step_realloc(zbx_mem_info_t *mem, zbx_mock_handle_t hstep)
+{
+	const char	*group;
+	zbx_uint64_t	size;
+	unsigned char	*ptr;
+	int		i;
+
+	group = zbx_mock_get_object_member_string(hstep, "group");
+	size = zbx_mock_get_object_member_uint64(hstep, "size");
+
+	for (i = 0; i < objects_num; i++)
+	{
+		if (0 != strcmp(objects[i].group, group))
+			continue;
+
+		mock_check_object(&objects[i], objects[i].size);
+
+		if (NULL == (ptr = (unsigned char *)zbx_mem_realloc(mem, objects[i].ptr, size)))
+			fail_msg("cannot reallocate object #%d to size " ZBX_FS_UI64, objects[i].seq, size);
+
+		objects[i].ptr = ptr;
+		mock_check_object(&objects[i], MIN(size, objects[i].size));
+
+		objects[i].size = size;
+		mock_fill_object(&objects[i]);
+	}
+}
+
+static void	mock_step_stats(zbx_mem_info_t *mem, zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hvalue;
+	zbx_mem_stats_t		stats;
+
+	zbx_mem_get_stats(mem, &stats);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "slabs", &hvalue))
+	{
+		zbx_mock_assert_uint64_eq("number of slabs", zbx_mock_get_object_member_uint64(hstep, "slabs"),
+				stats.slabs_num);
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "slab_objects", &hvalue))
+	{
+		zbx_mock_assert_uint64_eq("number of slab objects",
+				zbx_mock_get_object_member_uint64(hstep, "slab_objects"), stats.slab_objects);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mem_info_t		*mem;
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_mem_stats_t		stats;
+	zbx_uint64_t		free_size;
+	char			*error = NULL;
+	const char		*op;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != zbx_mem_create(&mem, zbx_mock_get_parameter_uint64("in.size"), "test", "TestSize", 1,
+			&error))
+	{
+		fail_msg("cannot create memory: %s", error);
+	}
+
+	free_size = mem->free_size;
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "alloc"))
+			mock_step_alloc(mem, hstep);
+		else if (0 == strcmp(op, "fill"))
+			mock_step_fill(mem, hstep);
+		else if (0 == strcmp(op, "free"))
+			mock_step_free(mem, hstep);
+		else if (0 == strcmp(op, "realloc"))
+			mock_step_realloc(mem, hstep);
+		else if (0 == strcmp(op, "stats"))
+			mock_step_stats(mem, hstep);
+		else
+			fail_msg("unknown step operation: %s", op);
+	}
+
+	/* all memory must be returned to a single free chunk after freeing remaining objects */
+
+	while (0 != objects_num)
+		mock_free_object(mem, objects_num - 1);
+
+	zbx_mem_get_stats(mem, &stats);
+
+	zbx_mock_assert_uint64_eq("used size", 0, stats.used_size);
+	zbx_mock_assert_uint64_eq("free size", free_size, stats.free_size);
+	zbx_mock_assert_uint64_eq("number of slabs", 0, stats.slabs_num);
+	zbx_mock_assert_uint64_eq("number of free chunks", 1, stats.free_chunks);
+
+	zbx_free(objects);
+}
@@ -0,0 +1,127 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxprometheus.h"
+#include "log.h"
+
+static void	mock_str_eq(const char *prefix, const char *expected, const char *returned)
+{
+	if (NULL == expected || NULL == returned)
+		zbx_mock_assert_ptr_eq(prefix, expected, returned);
+	else
+		zbx_mock_assert_str_eq(prefix, expected, returned);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_check_query                                                 *
+ *                                                                            *
+ * Purpose: checks that indexed data query returns the same result as         *
+ *          filtered data parsing                                             *
+ *                                                                            *
+ * Parameters: prom   - [IN] the indexed prometheus data                      *
+ *             data   - [IN] the prometheus data                              *
+ *             hquery - [IN] the query (params, optional output and result)   *
+ *             num    - [IN] the query number                                 *
+ *                                                                            *
+ * Comments: Pattern query is performed if output is set, otherwise data is   *
+ *           converted to json.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_query(zbx_prometheus_t *prom, const char *data, zbx_mock_handle_t hquery, int num)
+{
+	zbx_mock_handle_t	houtput, hresult;
+	const char		*params, *output = NULL;
+	char			*value = NULL, *error = NULL, *index_value = NULL, *index_error = NULL,
+				msg[MAX_STRING_LEN];
+	int			ret, index_ret;
+
+	params = zbx_mock_get_object_member_string(hquery, "params");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hquery, "output", &houtput))
+		output = zbx_mock_get_object_member_string(hquery, "output");
+
+	if (NULL != output)
+	{
+		ret = zbx_prometheus_pattern(data, params, output, &value, &error);
+		index_ret = zbx_prometheus_index_pattern(prom, params, output, &index_value, &index_error);
+	}
+	else
+	{
+		ret = zbx_prometheus_to_json(data, params, &value, &error);
+		index_ret = zbx_prometheus_index_to_json(prom, params, &index_value, &index_error);
+	}
+
+	zbx_snprintf(msg, sizeof(msg), "query #%d return value", num);
+	zbx_mock_assert_result_eq(msg, ret, index_ret);
+
+	zbx_snprintf(msg, sizeof(msg), "query #%d value", num);
+	mock_str_eq(msg, value, index_value);
+
+	zbx_snprintf(msg, sizeof(msg), "query #%d error", num);
+	mock_str_eq(msg, error, index_error);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hquery, "result", &hresult))
+	{
+		zbx_snprintf(msg, sizeof(msg), "query #%d expected value", num);
+		mock_str_eq(msg, zbx_mock_get_object_member_string(hquery, "result"), index_value);
+	}
+
+	zbx_free(value);
+	zbx_free(error);
+	zbx_free(index_value);
+	zbx_free(index_error);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hqueries, hquery;
+	const char		*data;
+	char			*error = NULL;
+	zbx_prometheus_t	*prom = NULL;
+	int			ret, expected_ret, num = 0;
+
+	ZBX_UNUSED(state);
+
+	data = zbx_mock_get_parameter_string("in.data");
+
+	if (SUCCEED != (ret = zbx_prometheus_index_create(&prom, data, &error)))
+		zabbix_log(LOG_LEVEL_DEBUG, "Error: %s", error);
+
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.index"));
+	zbx_mock_assert_result_eq("zbx_prometheus_index_create() return value", expected_ret, ret);
+
+	if (SUCCEED != ret)
+	{
+		zbx_free(error);
+		return;
+	}
+
+	hqueries = zbx_mock_get_parameter_handle("in.queries");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hqueries, &hquery))
+		mock_check_query(prom, data, hquery, ++num);
+
+	zbx_prometheus_index_free(prom);
+}
@@ -51,9 +51,13 @@ void	__wrap___zbx_mem_free(const char *file, int line, zbx_mem_info_t *info, voi
 void	__wrap_zbx_mem_dump_stats(int level, zbx_mem_info_t *info);
 int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
-int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history);
+int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history, zbx_vector_uint64_t *failed_itemids);
 int	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
 int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
+void	__wrap_zbx_history_sql_wait(zbx_vector_uint64_t *itemids);
+int	__wrap_zbx_history_aggregate_available(int value_type, int func, int seconds);
+int	__wrap_zbx_history_get_aggregate(zbx_uint64_t itemid, int value_type, int func, int start,
+		const zbx_timespec_t *end, history_value_t *value, int *values_num);
 time_t	__wrap_time(time_t *ptr);
 void	__wrap_zbx_timespec(zbx_timespec_t *ts);
 
@@ -636,13 +640,14 @@ int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start
 	return SUCCEED;
 }
 
-int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history)
+int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history, zbx_vector_uint64_t *failed_itemids)
 {
 	int			i;
 	zbx_vcmock_ds_item_t	*item, item_local;
 	zbx_history_record_t	src, dst;
 
 	ZBX_UNUSED(history);
+	ZBX_UNUSED(failed_itemids);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -685,6 +690,129 @@ int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char val
 	return SUCCEED;
 }
 
+void	__wrap_zbx_history_sql_wait(zbx_vector_uint64_t *itemids)
+{
+	ZBX_UNUSED(itemids);
+}
+
+/*
+ * history storage aggregation emulation, disabled unless aggregate period is set
+ */
+
+static int	vcmock_aggregate_period = 0;
+static int	vcmock_aggregate_calls = 0;
+
+int	__wrap_zbx_history_aggregate_available(int value_type, int func, int seconds)
+{
+	if (0 == vcmock_aggregate_period || seconds < vcmock_aggregate_period)
+		return FAIL;
+
+	if (ZBX_HISTORY_AGGREGATE_COUNT != func && ITEM_VALUE_TYPE_FLOAT != value_type &&
+			ITEM_VALUE_TYPE_UINT64 != value_type)
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+int	__wrap_zbx_history_get_aggregate(zbx_uint64_t itemid, int value_type, int func, int start,
+		const zbx_timespec_t *end, history_value_t *value, int *values_num)
+{
+	zbx_vcmock_ds_item_t	*item;
+	zbx_timespec_t		ts_start = {start, end->ns};
+	history_value_t		*rec_value;
+	double			dbl;
+	int			i;
+
+	vcmock_aggregate_calls++;
+
+	memset(value, 0, sizeof(history_value_t));
+	*values_num = 0;
+
+	if (NULL == (item = (zbx_vcmock_ds_item_t *)zbx_hashset_search(&vc_ds.items, &itemid)))
+		return SUCCEED;
+
+	for (i = 0; i < item->data.values_num; i++)
+	{
+		if (0 >= zbx_timespec_compare(&item->data.values[i].timestamp, &ts_start) ||
+				0 < zbx_timespec_compare(&item->data.values[i].timestamp, end))
+		{
+			continue;
+		}
+
+		rec_value = &item->data.values[i].value;
+
+		if (ZBX_HISTORY_AGGREGATE_COUNT == func)
+		{
+			(*values_num)++;
+			continue;
+		}
+
+		if (ITEM_VALUE_TYPE_UINT64 == value_type && ZBX_HISTORY_AGGREGATE_AVG != func)
+		{
+			if (0 == (*values_num)++)
+				value->ui64 = rec_value->ui64;
+			else if (ZBX_HISTORY_AGGREGATE_SUM == func)
+				value->ui64 += rec_value->ui64;
+			else if (ZBX_HISTORY_AGGREGATE_MIN == func && rec_value->ui64 < value->ui64)
+				value->ui64 = rec_value->ui64;
+			else if (ZBX_HISTORY_AGGREGATE_MAX == func && rec_value->ui64 > value->ui64)
+				value->ui64 = rec_value->ui64;
+
+			continue;
+		}
+
+		dbl = (ITEM_VALUE_TYPE_UINT64 == value_type ? (double)rec_value->ui64 : rec_value->dbl);
+
+		if (0 == (*values_num)++)
+			value->dbl = dbl;
+		else if (ZBX_HISTORY_AGGREGATE_SUM == func || ZBX_HISTORY_AGGREGATE_AVG == func)
+			value->dbl += dbl;
+		else if (ZBX_HISTORY_AGGREGATE_MIN == func && dbl < value->dbl)
+			value->dbl = dbl;
+		else if (ZBX_HISTORY_AGGREGATE_MAX == func && dbl > value->dbl)
+			value->dbl = dbl;
+	}
+
+	if (ZBX_HISTORY_AGGREGATE_AVG == func && 0 != *values_num)
+		value->dbl /= *values_num;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vcmock_set_storage_aggregate                                 *
+ *                                                                            *
+ * Purpose: sets the minimum period aggregated by emulated history storage   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vcmock_set_storage_aggregate(zbx_mock_handle_t hitem, const char *key)
+{
+	zbx_mock_handle_t	hperiod;
+
+	vcmock_aggregate_calls = 0;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hitem, key, &hperiod))
+		vcmock_aggregate_period = atoi(zbx_mock_get_object_member_string(hitem, key));
+	else
+		vcmock_aggregate_period = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vcmock_get_storage_aggregate_calls                           *
+ *                                                                            *
+ * Purpose: returns the number of aggregate requests to emulated history      *
+ *          storage since the aggregate period was set                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vcmock_get_storage_aggregate_calls(void)
+{
+	return vcmock_aggregate_calls;
+}
+
 /*
  * cache allocator size limit handling
  */
@@ -0,0 +1,227 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+#include "dbcache.h"
+#include "zbxembed.h"
+
+#include "../../../src/zabbix_server/preprocessor/item_preproc.h"
+
+zbx_es_t	es_engine;
+
+typedef struct
+{
+	zbx_preproc_op_t	*steps;
+	int			steps_num;
+	int			ret;
+	char			*value;
+	char			*error;
+}
+zbx_mock_item_t;
+
+static int	str_to_preproc_type(const char *str)
+{
+	if (0 == strcmp(str, "ZBX_PREPROC_RTRIM"))
+		return ZBX_PREPROC_RTRIM;
+	if (0 == strcmp(str, "ZBX_PREPROC_MULTIPLIER"))
+		return ZBX_PREPROC_MULTIPLIER;
+	if (0 == strcmp(str, "ZBX_PREPROC_STR_REPLACE"))
+		return ZBX_PREPROC_STR_REPLACE;
+	if (0 == strcmp(str, "ZBX_PREPROC_XPATH"))
+		return ZBX_PREPROC_XPATH;
+	if (0 == strcmp(str, "ZBX_PREPROC_JSONPATH"))
+		return ZBX_PREPROC_JSONPATH;
+	if (0 == strcmp(str, "ZBX_PREPROC_PROMETHEUS_PATTERN"))
+		return ZBX_PREPROC_PROMETHEUS_PATTERN;
+	if (0 == strcmp(str, "ZBX_PREPROC_PROMETHEUS_TO_JSON"))
+		return ZBX_PREPROC_PROMETHEUS_TO_JSON;
+
+	fail_msg("unknown preprocessing step type: %s", str);
+	return FAIL;
+}
+
+static void	read_items(zbx_mock_item_t **items, int *items_num)
+{
+	zbx_mock_handle_t	hitems, hitem, hsteps, hstep, hparams;
+	int			steps_alloc;
+	zbx_preproc_op_t	*op;
+
+	*items = NULL;
+	*items_num = 0;
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hitems, &hitem))
+	{
+		zbx_mock_item_t	*item;
+
+		*items = (zbx_mock_item_t *)zbx_realloc(*items, sizeof(zbx_mock_item_t) * (*items_num + 1));
+		item = &(*items)[(*items_num)++];
+		memset(item, 0, sizeof(zbx_mock_item_t));
+		steps_alloc = 0;
+
+		hsteps = zbx_mock_get_object_member_handle(hitem, "steps");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+		{
+			if (item->steps_num == steps_alloc)
+			{
+				steps_alloc += 4;
+				item->steps = (zbx_preproc_op_t *)zbx_realloc(item->steps,
+						sizeof(zbx_preproc_op_t) * steps_alloc);
+			}
+
+			op = &item->steps[item->steps_num++];
+			op->type = str_to_preproc_type(zbx_mock_get_object_member_string(hstep, "type"));
+			op->error_handler = ZBX_PREPROC_FAIL_DEFAULT;
+			op->error_handler_params = "";
+
+			if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "params", &hparams))
+				op->params = (char *)zbx_mock_get_object_member_string(hstep, "params");
+			else
+				op->params = "";
+		}
+	}
+}
+
+static int	execute_item(unsigned char value_type, const zbx_variant_t *value, const zbx_timespec_t *ts,
+		zbx_mock_item_t *item, int bind, char **result, char **error)
+{
+	zbx_variant_t	item_value, history_value;
+	zbx_timespec_t	history_ts;
+	int		i, ret = SUCCEED;
+
+	zbx_variant_copy(&item_value, value);
+
+	if (0 != bind)
+		zbx_item_preproc_document_bind(&item_value);
+
+	*error = NULL;
+
+	for (i = 0; i < item->steps_num && SUCCEED == ret; i++)
+	{
+		zbx_variant_set_none(&history_value);
+		history_ts.sec = 0;
+		history_ts.ns = 0;
+
+		if (FAIL == (ret = zbx_item_preproc(value_type, &item_value, ts, &item->steps[i], &history_value,
+				&history_ts, error)))
+		{
+			ret = zbx_item_preproc_handle_error(&item_value, &item->steps[i], error);
+		}
+
+		zbx_variant_clear(&history_value);
+	}
+
+	*result = (ZBX_VARIANT_NONE == item_value.type ? NULL : zbx_strdup(NULL, zbx_variant_value_desc(&item_value)));
+	zbx_variant_clear(&item_value);
+
+	return ret;
+}
+
+static void	mock_str_eq(const char *prefix, const char *expected, const char *returned)
+{
+	if (NULL == expected || NULL == returned)
+		zbx_mock_assert_ptr_eq(prefix, expected, returned);
+	else
+		zbx_mock_assert_str_eq(prefix, expected, returned);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	handle;
+	zbx_variant_t		value;
+	unsigned char		value_type;
+	zbx_timespec_t		ts;
+	zbx_mock_item_t		*items;
+	const zbx_preproc_op_t	**steps;
+	int			i, items_num, steps_num = 0, ret;
+	zbx_uint64_t		hits, misses, lookups;
+	char			*result, *error, buffer[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	handle = zbx_mock_get_parameter_handle("in.value");
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(handle, "value_type"));
+	zbx_strtime_to_timespec(zbx_mock_get_object_member_string(handle, "time"), &ts);
+	zbx_variant_set_str(&value, zbx_strdup(NULL, zbx_mock_get_object_member_string(handle, "data")));
+
+	read_items(&items, &items_num);
+
+	steps = (const zbx_preproc_op_t **)zbx_malloc(NULL, sizeof(zbx_preproc_op_t *) * items_num);
+
+	for (i = 0; i < items_num; i++)
+	{
+		if (0 != items[i].steps_num)
+			steps[steps_num++] = &items[i].steps[0];
+	}
+
+	/* preprocess values bound to the shared document */
+
+	zbx_item_preproc_document_open(&value, steps, steps_num);
+	zbx_jsonpath_cache_get_stats(&hits, &misses);
+	lookups = hits + misses;
+
+	for (i = 0; i < items_num; i++)
+	{
+		items[i].ret = execute_item(value_type, &value, &ts, &items[i], 1, &items[i].value,
+				&items[i].error);
+	}
+
+	zbx_jsonpath_cache_get_stats(&hits, &misses);
+	zbx_item_preproc_document_close();
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.jsonpath_lookups"))
+	{
+		zbx_mock_assert_uint64_eq("jsonpath cache lookups with shared document",
+				zbx_mock_get_parameter_uint64("out.jsonpath_lookups"), hits + misses - lookups);
+	}
+
+	/* results must match preprocessing without shared document */
+
+	for (i = 0; i < items_num; i++)
+	{
+		ret = execute_item(value_type, &value, &ts, &items[i], 0, &result, &error);
+
+		zbx_snprintf(buffer, sizeof(buffer), "item #%d return value", i + 1);
+		zbx_mock_assert_result_eq(buffer, ret, items[i].ret);
+
+		zbx_snprintf(buffer, sizeof(buffer), "item #%d value", i + 1);
+		mock_str_eq(buffer, result, items[i].value);
+
+		zbx_snprintf(buffer, sizeof(buffer), "item #%d error", i + 1);
+		mock_str_eq(buffer, error, items[i].error);
+
+		zbx_free(result);
+		zbx_free(error);
+		zbx_free(items[i].value);
+		zbx_free(items[i].error);
+		zbx_free(items[i].steps);
+	}
+
+	zbx_free(items);
+	zbx_free(steps);
+	zbx_variant_clear(&value);
+}
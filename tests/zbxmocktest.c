@@ -67,6 +67,8 @@ int	CONFIG_MAX_HOUSEKEEPER_DELETE	= 5000;		/* applies for every separate field v
 int	CONFIG_HISTSYNCER_FORKS		= 4;
 int	CONFIG_HISTSYNCER_FREQUENCY	= 1;
 int	CONFIG_CONFSYNCER_FORKS		= 1;
+int	CONFIG_CONF_CACHE_SYNC_SLICE	= 0;
+int	CONFIG_CONF_CACHE_FULL_SYNC	= 0;
 int	CONFIG_CONFSYNCER_FREQUENCY	= 60;
 
 int	CONFIG_VMWARE_FORKS		= 0;
@@ -82,6 +84,7 @@ zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * 0;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 0;
+zbx_uint64_t	CONFIG_PREPROCESSING_RING_SIZE	= 0;
 
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
@@ -173,6 +176,10 @@ char	*CONFIG_SOCKET_PATH			= NULL;
 char	*CONFIG_HISTORY_STORAGE_URL		= NULL;
 char	*CONFIG_HISTORY_STORAGE_OPTS		= NULL;
 int	CONFIG_HISTORY_STORAGE_PIPELINES	= 0;
+int	CONFIG_HISTORY_STORAGE_REFRESH		= 0;
+int	CONFIG_HISTORY_STORAGE_STREAMS		= 4;
+int	CONFIG_HISTORY_STORAGE_AGGREGATE	= 0;
+int	CONFIG_HISTORY_PIPELINING		= 0;
 
 const char	title_message[] = "mock_title_message";
 const char	*usage_message[] = {"mock_usage_message", NULL};